@@ -37,6 +37,7 @@ typedef unsigned char cab_UBYTE; /* 8 bits  */
 typedef UINT16        cab_UWORD; /* 16 bits */
 typedef UINT32        cab_ULONG; /* 32 bits */
 typedef INT32         cab_LONG;  /* 32 bits */
+typedef UINT64        cab_UQUAD; /* 64 bits */
 
 typedef UINT32        cab_off_t;
 
@@ -45,6 +46,7 @@ typedef UINT32        cab_off_t;
 # define CHAR_BIT (8)
 #endif
 #define CAB_ULONG_BITS (sizeof(cab_ULONG) * CHAR_BIT)
+#define CAB_UQUAD_BITS (sizeof(cab_UQUAD) * CHAR_BIT)
 
 /* structure offsets */
 #define cfhead_Signature         (0x00)
@@ -214,7 +216,7 @@ struct LZXstate {
 };
 
 struct lzx_bits {
-  cab_ULONG bb;
+  cab_UQUAD bb;
   int bl;
   cab_UBYTE *ip;
 };
@@ -227,6 +229,11 @@ struct lzx_bits {
 #define CAB_BLOCKMAX (32768)
 #define CAB_INPUTMAX (CAB_BLOCKMAX+6144)
 
+/* The LZX and MSZIP bit buffers read up to 8 bytes past the last byte they
+ * decode, plus LZX tolerates 2 bytes of overrun at the end of a block.
+ */
+#define CAB_INPUTSLACK (16)
+
 struct cab_file {
   struct cab_file *next;               /* next file in sequence          */
   struct cab_folder *folder;           /* folder that contains this file */
@@ -272,7 +279,7 @@ typedef struct cds_forward {
   cab_UWORD outlen;                /* (high level) amount of data to use up */
   cab_UWORD split;                 /* at which split in current folder?     */
   int (*decompress)(int, int, struct cds_forward *); /* chosen compress fn  */
-  cab_UBYTE inbuf[CAB_INPUTMAX+2]; /* +2 for lzx bitbuffer overflows!       */
+  cab_UBYTE inbuf[CAB_INPUTMAX+CAB_INPUTSLACK]; /* bitbuffer overflows */
   cab_UBYTE outbuf[CAB_BLOCKMAX];
   cab_UBYTE q_length_base[27], q_length_extra[27], q_extra_bits[42];
   cab_ULONG q_position_base[42];
@@ -381,10 +388,12 @@ typedef struct cds_forward {
  * READ_BITS(var,n)  takes N bits from the buffer and puts them in var
  *
  * ENSURE_BITS(n)    ensures there are at least N bits in the bit buffer.
- *                   it can guarantee up to 17 bits (i.e. it can read in
- *                   16 new bits when there is down to 1 bit in the buffer,
- *                   and it can read 32 bits when there are 0 bits in the
- *                   buffer).
+ *                   when it has to read, it tops the 64-bit buffer up to
+ *                   at least 49 bits, so a symbol, its length footer and
+ *                   its verbatim bits usually need only one refill. This
+ *                   reads up to 8 bytes ahead of the data actually used,
+ *                   so inpos alone no longer tells how much input was
+ *                   consumed; see CAB_INPUTSLACK.
  * PEEK_BITS(n)      extracts (without removing) N bits from the bit buffer
  * REMOVE_BITS(n)    removes N bits from the bit buffer
  *
@@ -396,13 +405,17 @@ typedef struct cds_forward {
 #define INIT_BITSTREAM do { bitsleft = 0; bitbuf = 0; } while (0)
 
 /* Quantum reads bytes in normal order; LZX is little-endian order */
-#define ENSURE_BITS(n)                                                    \
-  while (bitsleft < (n)) {                                                \
-    bitbuf |= ((inpos[1]<<8)|inpos[0]) << (CAB_ULONG_BITS-16 - bitsleft); \
-    bitsleft += 16; inpos+=2;                                             \
-  }
+#define ENSURE_BITS(n) do {                                               \
+  if (bitsleft < (n)) {                                                   \
+    do {                                                                  \
+      bitbuf |= (cab_UQUAD)((inpos[1]<<8)|inpos[0])                       \
+                << (CAB_UQUAD_BITS-16 - bitsleft);                        \
+      bitsleft += 16; inpos+=2;                                           \
+    } while (bitsleft <= (int)CAB_UQUAD_BITS - 16);                       \
+  }                                                                       \
+} while (0)
 
-#define PEEK_BITS(n)   (bitbuf >> (CAB_ULONG_BITS - (n)))
+#define PEEK_BITS(n)   (bitbuf >> (CAB_UQUAD_BITS - (n)))
 #define REMOVE_BITS(n) ((bitbuf <<= (n)), (bitsleft -= (n)))
 
 #define READ_BITS(v,n) do {                                             \
@@ -440,10 +453,10 @@ typedef struct cds_forward {
   ENSURE_BITS(16);                                                      \
   hufftbl = SYMTABLE(tbl);                                              \
   if ((i = hufftbl[PEEK_BITS(TABLEBITS(tbl))]) >= MAXSYMBOLS(tbl)) {    \
-    j = 1 << (CAB_ULONG_BITS - TABLEBITS(tbl));                         \
+    j = CAB_UQUAD_BITS - TABLEBITS(tbl);                                \
     do {                                                                \
-      j >>= 1; i <<= 1; i |= (bitbuf & j) ? 1 : 0;                      \
-      if (!j) { return DECR_ILLEGALDATA; }                              \
+      j--; i <<= 1; i |= (bitbuf >> j) & 1;                             \
+      if (j <= CAB_UQUAD_BITS - 17) { return DECR_ILLEGALDATA; }        \
     } while ((i = hufftbl[i]) >= MAXSYMBOLS(tbl));                      \
   }                                                                     \
   j = LENTABLE(tbl)[(var) = i];                                         \
@@ -142,7 +142,7 @@ typedef struct fdi_cds_fwd {
   cab_UBYTE *outpos;               /* (high level) start of data to use up  */
   cab_UWORD outlen;                /* (high level) amount of data to use up */
   int (*decompress)(int, int, struct fdi_cds_fwd *); /* chosen compress fn  */
-  cab_UBYTE inbuf[CAB_INPUTMAX+2]; /* +2 for lzx bitbuffer overflows!       */
+  cab_UBYTE inbuf[CAB_INPUTMAX+CAB_INPUTSLACK]; /* bitbuffer overflows */
   cab_UBYTE outbuf[CAB_BLOCKMAX];
   union {
     struct ZIPstate zip;
@@ -166,6 +166,12 @@ typedef struct fdi_cds_fwd {
 #define ZIPNEEDBITS(n) {while(k<(n)){cab_LONG c=*(ZIP(inpos)++);\
     b|=((cab_ULONG)c)<<k;k+=8;}}
 #define ZIPDUMPBITS(n) {b>>=(n);k-=(n);}
+/* tops a 64-bit buffer up to at least 57 bits, enough for a whole
+ * length/distance pair; whole bytes left over are handed back with
+ * ZIPRETURNBITS before the buffer is stored in the 32-bit ZIP(bb) */
+#define ZIPFILLBITS() {while(k<=56){\
+    b|=((cab_UQUAD)*(ZIP(inpos)++))<<k;k+=8;}}
+#define ZIPRETURNBITS() {ZIP(inpos)-=k>>3;k&=7;b&=(1<<k)-1;}
 
 /* endian-neutral reading of little-endian data */
 #define EndGetI32(a)  ((((a)[3])<<24)|(((a)[2])<<16)|(((a)[1])<<8)|((a)[0]))
@@ -259,6 +265,24 @@ static void QTMupdatemodel(struct QTMmodel *model, int sym) {
   }
 }
 
+/*************************************************************************
+ * fdi_copy_match (internal)
+ *
+ * Copies an LZ77 match. The result is the same as copying one byte at a
+ * time from the front, so an overlapping match repeats its source, but
+ * non-overlapping ranges and byte runs are copied in one go.
+ */
+static inline void fdi_copy_match(cab_UBYTE *dst, const cab_UBYTE *src, cab_ULONG len)
+{
+  if (src > dst) { memmove(dst, src, len); return; }
+  if ((cab_ULONG)(dst - src) >= len) { memcpy(dst, src, len); return; }
+  if (dst - src == 1) { memset(dst, *src, len); return; }
+  if (dst - src >= 8) {
+    for (; len >= 8; len -= 8, dst += 8, src += 8) memcpy(dst, src, 8);
+  }
+  while (len--) *dst++ = *src++;
+}
+
 /*************************************************************************
  * make_decode_table (internal)
  *
@@ -275,6 +299,10 @@ static void QTMupdatemodel(struct QTMmodel *model, int sym) {
  * RETURNS
  *   OK:    0
  *   error: 1
+ *
+ * NOTES
+ *   The symbols are bucketed by code length first, so each length only
+ *   walks its own symbols instead of the whole length table.
  */
 static int make_decode_table(cab_ULONG nsyms, cab_ULONG nbits,
                              const cab_UBYTE *length, cab_UWORD *table) {
@@ -286,19 +314,33 @@ static int make_decode_table(cab_ULONG nsyms, cab_ULONG nbits,
   cab_ULONG table_mask  = 1 << nbits;
   cab_ULONG bit_mask    = table_mask >> 1; /* don't do 0 length codes */
   cab_ULONG next_symbol = bit_mask; /* base of allocation for long codes */
+  cab_UWORD count[17], start[17], sorted[LZX_MAINTREE_MAXSYMBOLS];
+  cab_ULONG idx, n;
+
+  /* sort the symbols by code length, keeping symbol order within a length */
+  memset(count, 0, sizeof(count));
+  for (sym = 0; sym < nsyms; sym++) {
+    if (length[sym] > 16) return 1;
+    count[length[sym]]++;
+  }
+  start[1] = 0;
+  for (idx = 1; idx < 16; idx++) start[idx + 1] = start[idx] + count[idx];
+  for (sym = 0; sym < nsyms; sym++) {
+    if (length[sym]) sorted[start[length[sym]]++] = sym;
+  }
+  idx = 0;
 
   /* fill entries for codes short enough for a direct mapping */
   while (bit_num <= nbits) {
-    for (sym = 0; sym < nsyms; sym++) {
-      if (length[sym] == bit_num) {
-        leaf = pos;
+    for (n = count[bit_num]; n > 0; n--) {
+      sym = sorted[idx++];
+      leaf = pos;
 
-        if((pos += bit_mask) > table_mask) return 1; /* table overrun */
+      if((pos += bit_mask) > table_mask) return 1; /* table overrun */
 
-        /* fill all possible lookups of this symbol with the symbol itself */
-        fill = bit_mask;
-        while (fill-- > 0) table[leaf++] = sym;
-      }
+      /* fill all possible lookups of this symbol with the symbol itself */
+      fill = bit_mask;
+      while (fill-- > 0) table[leaf++] = sym;
     }
     bit_mask >>= 1;
     bit_num++;
@@ -315,24 +357,23 @@ static int make_decode_table(cab_ULONG nsyms, cab_ULONG nbits,
     bit_mask = 1 << 15;
 
     while (bit_num <= 16) {
-      for (sym = 0; sym < nsyms; sym++) {
-        if (length[sym] == bit_num) {
-          leaf = pos >> 16;
-          for (fill = 0; fill < bit_num - nbits; fill++) {
-            /* if this path hasn't been taken yet, 'allocate' two entries */
-            if (table[leaf] == 0) {
-              table[(next_symbol << 1)] = 0;
-              table[(next_symbol << 1) + 1] = 0;
-              table[leaf] = next_symbol++;
-            }
-            /* follow the path and select either left or right for next bit */
-            leaf = table[leaf] << 1;
-            if ((pos >> (15-fill)) & 1) leaf++;
+      for (n = count[bit_num]; n > 0; n--) {
+        sym = sorted[idx++];
+        leaf = pos >> 16;
+        for (fill = 0; fill < bit_num - nbits; fill++) {
+          /* if this path hasn't been taken yet, 'allocate' two entries */
+          if (table[leaf] == 0) {
+            table[(next_symbol << 1)] = 0;
+            table[(next_symbol << 1) + 1] = 0;
+            table[leaf] = next_symbol++;
           }
-          table[leaf] = sym;
-
-          if ((pos += bit_mask) > table_mask) return 1; /* table overflow */
+          /* follow the path and select either left or right for next bit */
+          leaf = table[leaf] << 1;
+          if ((pos >> (15-fill)) & 1) leaf++;
         }
+        table[leaf] = sym;
+
+        if ((pos += bit_mask) > table_mask) return 1; /* table overflow */
       }
       bit_mask >>= 1;
       bit_num++;
@@ -1066,7 +1107,7 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
   cab_ULONG w;              /* current window position */
   const struct Ziphuft *t;  /* pointer to table entry */
   cab_ULONG ml, md;         /* masks for bl and bd bits */
-  register cab_ULONG b;     /* bit buffer */
+  register cab_UQUAD b;     /* bit buffer */
   register cab_ULONG k;     /* number of bits in bit buffer */
 
   /* make local copies of globals */
@@ -1080,7 +1121,9 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
 
   for(;;)
   {
-    ZIPNEEDBITS((cab_ULONG)bl)
+    /* a literal/length code, its extra bits, a distance code and its extra
+     * bits take at most 15 + 5 + 15 + 13 bits, so one refill covers them */
+    ZIPFILLBITS()
     if((e = (t = tl + (b & ml))->e) > 16)
       do
       {
@@ -1088,11 +1131,20 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
           return 1;
         ZIPDUMPBITS(t->b)
         e -= 16;
-        ZIPNEEDBITS(e)
       } while ((e = (t = t->v.t + (b & Zipmask[e]))->e) > 16);
     ZIPDUMPBITS(t->b)
     if (e == 16)                /* then it's a literal */
+    {
       CAB(outbuf)[w++] = (cab_UBYTE)t->v.n;
+
+      /* the next literal is usually short enough to decode from what is
+       * left in the buffer without going round the loop */
+      if (k >= (cab_ULONG)bl && (t = tl + (b & ml))->e == 16)
+      {
+        ZIPDUMPBITS(t->b)
+        CAB(outbuf)[w++] = (cab_UBYTE)t->v.n;
+      }
+    }
     else                        /* it's an EOB or a length */
     {
       /* exit if end of block */
@@ -1100,22 +1152,18 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
         break;
 
       /* get length of block to copy */
-      ZIPNEEDBITS(e)
       n = t->v.n + (b & Zipmask[e]);
       ZIPDUMPBITS(e);
 
       /* decode distance of block to copy */
-      ZIPNEEDBITS((cab_ULONG)bd)
       if ((e = (t = td + (b & md))->e) > 16)
         do {
           if (e == 99)
             return 1;
           ZIPDUMPBITS(t->b)
           e -= 16;
-          ZIPNEEDBITS(e)
         } while ((e = (t = t->v.t + (b & Zipmask[e]))->e) > 16);
       ZIPDUMPBITS(t->b)
-      ZIPNEEDBITS(e)
       d = w - t->v.n - (b & Zipmask[e]);
       ZIPDUMPBITS(e)
       do
@@ -1124,14 +1172,18 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
         e = ZIPWSIZE - max(d, w);
         e = min(e, n);
         n -= e;
-        do
-        {
-          CAB(outbuf)[w++] = CAB(outbuf)[d++];
-        } while (--e);
+        if (!e)
+          return 1;             /* window overrun */
+        fdi_copy_match(CAB(outbuf) + w, CAB(outbuf) + d, e);
+        w += e;
+        d += e;
       } while (n);
     }
   }
 
+  /* hand back the bytes the wide buffer read ahead */
+  ZIPRETURNBITS()
+
   /* restore the globals from the locals */
   ZIP(window_posn) = w;              /* restore global window pointer */
   ZIP(bb) = b;                       /* restore global bit buffer */
@@ -1170,13 +1222,20 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
     return 1;                   /* error in compressed data */
   ZIPDUMPBITS(16)
 
-  /* read and output the compressed data */
-  while(n--)
+  if (w + n > ZIPWSIZE)
+    return 1;
+
+  /* read and output the compressed data; k is a multiple of 8 here, so
+   * once the bit buffer is drained the rest can be copied straight over */
+  while(n && k)
   {
-    ZIPNEEDBITS(8)
     CAB(outbuf)[w++] = (cab_UBYTE)b;
     ZIPDUMPBITS(8)
+    n--;
   }
+  memcpy(CAB(outbuf) + w, ZIP(inpos), n);
+  ZIP(inpos) += n;
+  w += n;
 
   /* restore the globals from the locals */
   ZIP(window_posn) = w;              /* restore global window pointer */
@@ -1561,7 +1620,7 @@ static int fdi_lzx_read_lens(cab_UBYTE *lens, cab_ULONG first, cab_ULONG last, s
   cab_ULONG i,j, x,y;
   int z;
 
-  register cab_ULONG bitbuf = lb->bb;
+  register cab_UQUAD bitbuf = lb->bb;
   register int bitsleft = lb->bl;
   cab_UBYTE *inpos = lb->ip;
   cab_UWORD *hufftbl;
@@ -1616,7 +1675,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
   cab_ULONG R1 = LZX(R1);
   cab_ULONG R2 = LZX(R2);
 
-  register cab_ULONG bitbuf;
+  register cab_UQUAD bitbuf;
   register int bitsleft;
   cab_ULONG match_offset, i,j,k; /* ijk used in READ_HUFFSYM macro */
   struct lzx_bits lb; /* used in READ_LENGTHS macro */
@@ -1669,7 +1728,10 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
       case LZX_BLOCKTYPE_UNCOMPRESSED:
         LZX(intel_started) = 1; /* because we can't assume otherwise */
         ENSURE_BITS(16); /* get up to 16 pad bits into the buffer */
-        if (bitsleft > 16) inpos -= 2; /* and align the bitstream! */
+        /* and align the bitstream: only the partial word is padding, give
+         * back every whole word the bit buffer has read ahead */
+        inpos -= ((bitsleft - 1) >> 4) << 1;
+        INIT_BITSTREAM;
         R0 = inpos[0]|(inpos[1]<<8)|(inpos[2]<<16)|(inpos[3]<<24);inpos+=4;
         R1 = inpos[0]|(inpos[1]<<8)|(inpos[2]<<16)|(inpos[3]<<24);inpos+=4;
         R2 = inpos[0]|(inpos[1]<<8)|(inpos[2]<<16)|(inpos[3]<<24);inpos+=4;
@@ -1686,11 +1748,11 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
        * 16 bits in size. In this case, the READ_HUFFSYM() macro used
        * in building the tables will exhaust the buffer, so we should
        * allow for this, but not allow those accidentally read bits to
-       * be used (so we check that there are at least 16 bits
-       * remaining - in this boundary case they aren't really part of
+       * be used (so whole words still sitting unused in the bit buffer
+       * don't count - in this boundary case they aren't really part of
        * the compressed data)
        */
-      if (inpos > (endinp+2) || bitsleft < 16) return DECR_ILLEGALDATA;
+      if (inpos - ((bitsleft >> 4) << 1) > endinp) return DECR_ILLEGALDATA;
     }
 
     while ((this_run = LZX(block_remaining)) > 0 && togo > 0) {
@@ -1768,14 +1830,15 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
               if (copy_length < match_length) {
                 match_length -= copy_length;
                 window_posn += copy_length;
-                while (copy_length-- > 0) *rundest++ = *runsrc++;
+                fdi_copy_match(rundest, runsrc, copy_length);
+                rundest += copy_length;
                 runsrc = window;
               }
             }
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_match(rundest, runsrc, match_length);
           }
         }
         break;
@@ -1857,14 +1920,15 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
               if (copy_length < match_length) {
                 match_length -= copy_length;
                 window_posn += copy_length;
-                while (copy_length-- > 0) *rundest++ = *runsrc++;
+                fdi_copy_match(rundest, runsrc, copy_length);
+                rundest += copy_length;
                 runsrc = window;
               }
             }
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_match(rundest, runsrc, match_length);
           }
         }
         break;
@@ -934,6 +934,470 @@ static void test_FDICopy(void)
     FDIDestroy(hfdi);
 }
 
+/* FDICopy output is compared against the source data instead of written out */
+static struct
+{
+    const BYTE *expected;
+    DWORD size, pos;
+    BOOL mismatch;
+} copy_check;
+
+static UINT CDECL fdi_check_write(INT_PTR hf, void *pv, UINT cb)
+{
+    if (hf != (INT_PTR)&copy_check || cb > copy_check.size - copy_check.pos ||
+        memcmp(copy_check.expected + copy_check.pos, pv, cb))
+        copy_check.mismatch = TRUE;
+    copy_check.pos += min(cb, copy_check.size - copy_check.pos);
+    return cb;
+}
+
+static int CDECL fdi_check_close(INT_PTR hf)
+{
+    if (hf == (INT_PTR)&copy_check) return 0;
+    return fdi_close(hf);
+}
+
+static INT_PTR CDECL fdi_check_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        ok(info->cb == copy_check.size, "expected %lu, got %ld\n", copy_check.size, info->cb);
+        copy_check.pos = 0;
+        copy_check.mismatch = FALSE;
+        return (INT_PTR)&copy_check;
+
+    case fdintCLOSE_FILE_INFO:
+        return TRUE;
+
+    default:
+        return 0;
+    }
+}
+
+/* a mix of repeated words, byte runs and noise, so that the compressors
+ * emit literals, short and long matches and stored blocks */
+static void fill_test_data(BYTE *data, DWORD size, DWORD seed)
+{
+    static const char *words[] = { "kernel32", "ntdll", "GetProcAddress", " ", "\r\n",
+                                   "0123456789", "wine", "cabinet", "\xff\xfe" };
+    const char *word = "";
+    DWORD pos = 0, len, i;
+
+    while (pos < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        len = min((seed >> 16) & 0xfff, size - pos);
+        switch ((seed >> 8) & 3)
+        {
+        case 0:
+            for (i = 0; i < len; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                data[pos + i] = seed >> 16;
+            }
+            break;
+        case 1:
+            memset(data + pos, seed >> 24, len);
+            break;
+        default:
+            for (i = 0; i < len; i++)
+            {
+                if (!*word)
+                {
+                    seed = seed * 1103515245 + 12345;
+                    word = words[(seed >> 16) % ARRAY_SIZE(words)];
+                }
+                data[pos + i] = *word++;
+            }
+            break;
+        }
+        pos += len;
+    }
+}
+
+/* puts data into extract.cab as file.dat with the given compression, returns
+ * FALSE if the cabinet doesn't actually use it */
+static BOOL create_compressed_cab(const BYTE *data, DWORD size, TCOMP comp)
+{
+    static char file_dat[] = "file.dat";
+    char path[MAX_PATH], cab[MAX_PATH];
+    struct CFHEADER header;
+    struct CFFOLDER folder;
+    CCAB cabParams;
+    HANDLE file;
+    DWORD count;
+    HFCI hfci;
+    ERF erf;
+    BOOL res;
+
+    file = CreateFileA(file_dat, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to create %s\n", file_dat);
+    WriteFile(file, data, size, &count, NULL);
+    CloseHandle(file);
+
+    set_cab_parameters(&cabParams);
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek, fci_delete,
+                     get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+    lstrcatA(path, file_dat);
+    res = FCIAddFile(hfci, path, file_dat, FALSE, get_next_cabinet, progress,
+                     get_open_info, comp);
+    ok(res, "Expected FCIAddFile to succeed\n");
+    res = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(res, "Failed to flush the cabinet\n");
+    FCIDestroy(hfci);
+    DeleteFileA(file_dat);
+
+    lstrcpyA(cab, cabParams.szCabPath);
+    lstrcatA(cab, cabParams.szCab);
+    file = CreateFileA(cab, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to open %s\n", cab);
+    res = ReadFile(file, &header, sizeof(header), &count, NULL) && count == sizeof(header) &&
+          ReadFile(file, &folder, sizeof(folder), &count, NULL) && count == sizeof(folder);
+    CloseHandle(file);
+    ok(res, "failed to read the cabinet header\n");
+    ok(!header.flags, "unexpected flags %#x\n", header.flags);
+
+    return res && (folder.typeCompress & tcompMASK_TYPE) == (comp & tcompMASK_TYPE);
+}
+
+static BOOL extract_compressed_cab(const BYTE *data, DWORD size)
+{
+    char name[] = "extract.cab";
+    char path[MAX_PATH];
+    HFDI hfdi;
+    ERF erf;
+    BOOL ret;
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_check_write, fdi_check_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    copy_check.expected = data;
+    copy_check.size = size;
+    copy_check.pos = 0;
+    copy_check.mismatch = TRUE;
+    ret = FDICopy(hfdi, name, path, 0, fdi_check_notify, NULL, NULL);
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    FDIDestroy(hfdi);
+
+    return ret && !copy_check.mismatch && copy_check.pos == size;
+}
+
+/* Cabinets holding the 40000 bytes from fill_sample_data() as file.dat,
+ * since FCI can't create them. Both use a 32 KiB window. The LZX one has
+ * verbatim, uncompressed and aligned offset blocks, the aligned offset one
+ * crossing a frame boundary; the Quantum one uses every selector. */
+static const BYTE lzx_cab[] =
+{
+    0x4d, 0x53, 0x43, 0x46, 0x00, 0x00, 0x00, 0x00, 0xc9, 0x06, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x01, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x34, 0x12, 0x00, 0x00,
+    0x45, 0x00, 0x00, 0x00, 0x02, 0x00, 0x03, 0x0f, 0x40, 0x9c, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6c, 0x22, 0xba, 0x59, 0x20, 0x00,
+    0x66, 0x69, 0x6c, 0x65, 0x2e, 0x64, 0x61, 0x74, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xa2, 0x04, 0x00, 0x80, 0x03, 0x10, 0x02, 0xe8, 0x00, 0x00, 0x00,
+    0x00, 0x66, 0x13, 0x00, 0x00, 0x07, 0x45, 0xae, 0x86, 0xfa, 0x1f, 0xa5,
+    0x5c, 0x0a, 0x27, 0x81, 0x4b, 0x2a, 0x52, 0x51, 0x94, 0x0c, 0x9f, 0x8c,
+    0x0f, 0x0a, 0x60, 0xe4, 0x54, 0xea, 0x71, 0x6a, 0x72, 0x84, 0xb8, 0x4e,
+    0x5e, 0xab, 0x95, 0x4e, 0x57, 0x57, 0xab, 0xe4, 0x06, 0x42, 0xd5, 0x00,
+    0x00, 0x00, 0x00, 0xaa, 0x04, 0xc0, 0xc0, 0x0f, 0x6a, 0x7e, 0xa2, 0x03,
+    0xe7, 0x77, 0xed, 0x41, 0xbb, 0xd0, 0xdc, 0x96, 0x71, 0xe3, 0x0e, 0x1d,
+    0x94, 0x90, 0x20, 0x76, 0x2c, 0x7b, 0x38, 0x84, 0xfb, 0x00, 0x00, 0x00,
+    0x00, 0x80, 0x10, 0x14, 0x00, 0x32, 0xd4, 0xb8, 0xf3, 0x8b, 0x38, 0x62,
+    0x1f, 0x73, 0xb5, 0x67, 0x0f, 0xb0, 0xe3, 0x71, 0xf1, 0x58, 0xd0, 0xc9,
+    0x2a, 0xb3, 0x61, 0xd5, 0xc2, 0x26, 0x21, 0x1a, 0x9a, 0x16, 0xa2, 0x8e,
+    0x09, 0xb1, 0x60, 0xc3, 0xc7, 0xae, 0xed, 0x19, 0x48, 0x36, 0xd7, 0xae,
+    0x5c, 0x70, 0x66, 0x87, 0x4c, 0xa5, 0xbf, 0x50, 0x9c, 0x33, 0xf8, 0x6f,
+    0x96, 0x57, 0x47, 0x21, 0x63, 0x82, 0xee, 0x3b, 0x63, 0x0f, 0x6d, 0xff,
+    0x3e, 0x8b, 0x97, 0x61, 0x38, 0xd0, 0xe3, 0xbf, 0x65, 0xd9, 0x2b, 0x3b,
+    0x76, 0x1f, 0x2e, 0x94, 0x6e, 0xfc, 0x9c, 0xc3, 0x25, 0xf8, 0x67, 0x20,
+    0x1e, 0x3e, 0xa4, 0x54, 0x4e, 0x04, 0x60, 0xfb, 0x3c, 0x42, 0x3a, 0x63,
+    0x7f, 0xd6, 0x21, 0xb7, 0x93, 0x3e, 0x25, 0x1e, 0x32, 0x03, 0xb9, 0xfc,
+    0xd6, 0xcb, 0x1a, 0x82, 0x78, 0x46, 0x93, 0x10, 0x21, 0x81, 0x40, 0x50,
+    0x2c, 0xcf, 0x52, 0xa8, 0xb8, 0x08, 0xc0, 0xf1, 0x10, 0x7b, 0xa5, 0xf7,
+    0x68, 0x92, 0xae, 0xdb, 0x7f, 0x4b, 0xc8, 0xca, 0x6b, 0xba, 0xa7, 0x73,
+    0x32, 0x85, 0xac, 0xde, 0x73, 0x52, 0x3a, 0x7c, 0x0d, 0x59, 0xb9, 0x3a,
+    0xfd, 0x75, 0x92, 0x23, 0x73, 0xbf, 0x6d, 0x1e, 0xff, 0xbf, 0x20, 0x90,
+    0x67, 0x79, 0x51, 0x81, 0xea, 0x3b, 0x6d, 0x04, 0xe4, 0x08, 0x41, 0x64,
+    0x7e, 0x9e, 0x8b, 0xa3, 0xee, 0xfc, 0x6f, 0x03, 0x31, 0x7e, 0x7a, 0x02,
+    0x9e, 0x41, 0x01, 0xf5, 0x0d, 0x10, 0x15, 0x69, 0x42, 0xb3, 0xce, 0x58,
+    0x6a, 0xda, 0x85, 0xef, 0xf2, 0xae, 0x43, 0xbf, 0xeb, 0x5a, 0x13, 0xb9,
+    0x48, 0x8b, 0xf1, 0xff, 0x32, 0xde, 0xd8, 0xaf, 0x05, 0xaa, 0x38, 0x05,
+    0xf1, 0x79, 0x1a, 0xe1, 0xdc, 0xa2, 0xea, 0xd8, 0xf7, 0xfe, 0xa0, 0x30,
+    0x75, 0x12, 0x00, 0x00, 0xc0, 0x68, 0x01, 0x00, 0x00, 0x2d, 0x00, 0x00,
+    0x00, 0x5a, 0x00, 0x00, 0x00, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74,
+    0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e,
+    0x20, 0x54, 0x68, 0x4a, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62,
+    0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d,
+    0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20,
+    0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68,
+    0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77,
+    0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20,
+    0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a,
+    0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68, 0x65, 0x20, 0x71,
+    0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66,
+    0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65,
+    0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64,
+    0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63,
+    0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20,
+    0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74,
+    0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e,
+    0x20, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62,
+    0x72, 0x6f, 0x77, 0x6e, 0x20, 0x00, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d,
+    0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20,
+    0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68,
+    0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77,
+    0x6e, 0x20, 0x66, 0x6f, 0x84, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20,
+    0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a,
+    0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68, 0x65, 0x20, 0x71,
+    0x75, 0x69, 0x63, 0x6b, 0x20, 0x09, 0x40, 0x8d, 0x9e, 0xe3, 0xb8, 0xa5,
+    0x44, 0x00, 0x00, 0xb0, 0xa4, 0x00, 0x00, 0x6e, 0xee, 0x46, 0x10, 0xb3,
+    0x08, 0x86, 0x41, 0xcd, 0x10, 0xa2, 0x70, 0xaa, 0x08, 0x0d, 0xbf, 0x63,
+    0xc1, 0xe2, 0x51, 0x0a, 0xff, 0x1e, 0xaf, 0xaa, 0x2a, 0x3b, 0xb6, 0x57,
+    0x04, 0xd0, 0xff, 0x62, 0xc1, 0xb0, 0x80, 0xc4, 0x7b, 0x3f, 0x06, 0x5a,
+    0x44, 0x28, 0x20, 0x0d, 0x23, 0xed, 0xd0, 0x10, 0xec, 0x17, 0x10, 0xf8,
+    0x40, 0x08, 0x06, 0xae, 0x08, 0x0a, 0xc0, 0x00, 0x80, 0xa8, 0x02, 0x00,
+    0x00, 0xa1, 0x29, 0x30, 0xa0, 0x1f, 0x75, 0x31, 0x94, 0xb3, 0xbf, 0x2a,
+    0x20, 0x8a, 0xfa, 0xa1, 0xb4, 0x47, 0x8a, 0x08, 0x60, 0x45, 0x1c, 0x6f,
+    0x0e, 0x22, 0xf6, 0x00, 0xc0, 0xa0, 0x08, 0x80, 0x04, 0x0c, 0x00, 0x03,
+    0x80, 0x2f, 0x78, 0xf4, 0x9e, 0x7e, 0x3c, 0x35, 0x64, 0x51, 0x79, 0x4e,
+    0xfa, 0x8a, 0x4b, 0x95, 0xf0, 0xe0, 0xc0, 0x07, 0xa7, 0x9e, 0xfe, 0x59,
+    0xca, 0xfe, 0xc3, 0xac, 0x38, 0x88, 0x15, 0x74, 0x4a, 0x26, 0x52, 0x38,
+    0x31, 0x39, 0xae, 0x5c, 0x66, 0x07, 0x12, 0xd9, 0x0d, 0x6a, 0x70, 0xf0,
+    0x66, 0x37, 0xee, 0x4d, 0x9b, 0x40, 0xe3, 0x5b, 0x94, 0x89, 0x40, 0x09,
+    0x17, 0x3d, 0x15, 0x04, 0x35, 0x64, 0x58, 0xce, 0x8a, 0x33, 0x61, 0x5e,
+    0xf8, 0x44, 0x21, 0x83, 0x7a, 0x30, 0xc7, 0xad, 0xda, 0xe5, 0x9a, 0x25,
+    0x10, 0xd0, 0x16, 0x45, 0x22, 0x45, 0xc2, 0x4d, 0x4f, 0x16, 0x41, 0x22,
+    0x19, 0x98, 0xb3, 0xfe, 0x4c, 0x88, 0x17, 0x1e, 0x51, 0xf1, 0xa0, 0x36,
+    0xcc, 0x66, 0xab, 0x44, 0xb9, 0x45, 0x09, 0x08, 0xb4, 0x70, 0x91, 0x53,
+    0x91, 0x50, 0xd3, 0x86, 0x45, 0xac, 0x48, 0x13, 0xe6, 0x85, 0x3f, 0x14,
+    0xe2, 0xa8, 0x47, 0x73, 0x3c, 0xaa, 0x0d, 0xae, 0xd9, 0x02, 0x51, 0x6d,
+    0x51, 0x24, 0x02, 0x24, 0x5c, 0xf4, 0x54, 0x11, 0xd4, 0x92, 0x61, 0x39,
+    0x2b, 0xcf, 0x84, 0x78, 0xe1, 0x11, 0x85, 0x0f, 0xea, 0xc3, 0x1c, 0xb6,
+    0x6a, 0x94, 0x6b, 0x94, 0x40, 0x40, 0x5b, 0x17, 0x89, 0x15, 0x09, 0x35,
+    0x3d, 0x58, 0x04, 0x8a, 0x64, 0x61, 0xce, 0xf8, 0x33, 0x21, 0x5e, 0x7a,
+    0x44, 0xc7, 0x83, 0xbc, 0x60, 0xc2, 0x99, 0x82, 0x5f, 0xbf, 0x2c, 0x7f,
+    0x79, 0x2b, 0x7d, 0xb9, 0x7c, 0x2f, 0x5a, 0xee, 0xb0, 0xbc, 0x84, 0xfb,
+    0xd9, 0xe2, 0x8b, 0xea, 0xff, 0xf3, 0x13, 0xb2, 0x08, 0xd9, 0xed, 0xf6,
+    0xe1, 0xbf, 0x77, 0x36, 0x37, 0x37, 0xa1, 0x4a, 0x94, 0xea, 0xe1, 0x73,
+    0x77, 0x56, 0x34, 0x75, 0xa1, 0xe3, 0xf4, 0xbd, 0x7b, 0x36, 0x07, 0x08,
+    0x35, 0xe5, 0x4d, 0xae, 0x67, 0x26, 0xe1, 0xeb, 0x4f, 0x9e, 0xcb, 0x8c,
+    0xde, 0x7f, 0xd1, 0xac, 0x50, 0xca, 0x77, 0x1e, 0x9f, 0xf6, 0x5a, 0x7f,
+    0xf7, 0x23, 0x88, 0x4e, 0x6b, 0x5a, 0x9e, 0xf5, 0x8b, 0x5d, 0x3a, 0x4c,
+    0x9e, 0xf5, 0x71, 0x1a, 0xed, 0x45, 0x8d, 0x65, 0x91, 0xb6, 0xa7, 0x26,
+    0xe1, 0x45, 0x16, 0xff, 0x97, 0x08, 0x07, 0x7c, 0xe7, 0x73, 0x33, 0x73,
+    0x6c, 0x87, 0x93, 0xdc, 0xc9, 0x87, 0xcc, 0x54, 0xac, 0x32, 0xb9, 0xb7,
+    0xdd, 0x43, 0xc7, 0x50, 0xd3, 0xfa, 0xa1, 0x36, 0xff, 0x3c, 0x2e, 0x6f,
+    0xd9, 0xed, 0x2f, 0x79, 0xa0, 0xa7, 0xb9, 0xc2, 0x51, 0x11, 0x4c, 0x59,
+    0x64, 0x85, 0x70, 0x49, 0x86, 0xc7, 0xdd, 0x77, 0x0f, 0x93, 0x65, 0xa3,
+    0x6f, 0xce, 0x6b, 0xdc, 0x2c, 0xa2, 0xd9, 0x6e, 0xec, 0xc3, 0x77, 0xdd,
+    0x96, 0x4d, 0xbe, 0x39, 0xab, 0x73, 0x73, 0x2e, 0xe7, 0xa7, 0xfd, 0x73,
+    0x09, 0x2d, 0x96, 0xdf, 0xd8, 0xef, 0xee, 0xc2, 0xee, 0x0b, 0x35, 0xcd,
+    0x67, 0x4c, 0xc2, 0xc6, 0x83, 0x05, 0xc3, 0x11, 0x47, 0xd5, 0x45, 0xa7,
+    0xc6, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0xd2, 0x01, 0x40, 0x1c, 0x7b,
+    0x94, 0x33, 0x1d, 0x7b, 0xff, 0x79, 0x42, 0x42, 0xa8, 0x21, 0x6f, 0xb2,
+    0x08, 0xee, 0x83, 0x26, 0xe1, 0x5c, 0x16, 0xf2, 0xb8, 0x5f, 0xca, 0x1b,
+    0x47, 0xf3, 0xbd, 0x01, 0xbb, 0x93, 0x2e, 0xec, 0xb3, 0xe9, 0xf6, 0x79,
+    0xe0, 0x00, 0x80, 0x00, 0x64, 0x1c, 0x02, 0x00, 0x00, 0x68, 0x01, 0x00,
+    0x00, 0x0e, 0x01, 0x00, 0x00, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69,
+    0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78,
+    0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20,
+    0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67,
+    0x2e, 0x20, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20,
+    0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75,
+    0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65,
+    0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54,
+    0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f,
+    0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73,
+    0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61,
+    0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68, 0x65, 0x20,
+    0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20,
+    0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76,
+    0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20,
+    0x64, 0x6f, 0x67, 0x2e, 0x20, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69,
+    0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78,
+    0x20, 0x01, 0x20, 0x02, 0xdb, 0x00, 0x6a, 0x00, 0x00, 0x00, 0xa8, 0x00,
+    0x00, 0x0c, 0x66, 0xe5, 0x38, 0x9f, 0x05, 0xfc, 0x3f, 0x58, 0xe1, 0x24,
+    0x88, 0x20, 0x22, 0x6b, 0x03, 0x4c, 0xaa, 0xc6, 0xae, 0x70, 0xe1, 0x40,
+    0x55, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x01, 0xcd, 0x0c, 0x14, 0x3b,
+    0xf0, 0x8f, 0xe5, 0x42, 0xe0, 0xf0, 0xa6, 0x5d, 0x25, 0x45, 0xf8, 0xef,
+    0x28, 0xe2, 0xba, 0x80, 0xaa, 0x80, 0x00, 0x00, 0x00, 0x00, 0x60, 0x03,
+    0x86, 0xc7, 0x8b, 0xcd, 0x77, 0x29, 0xde, 0x12, 0x90, 0x2f, 0xfb, 0x63,
+    0xf8, 0xd5, 0x6f, 0x18, 0x90, 0xdb, 0xf6, 0x3c, 0x78, 0xc3, 0x49, 0x90,
+    0x05, 0x3d, 0xae, 0x13, 0x74, 0x0a, 0x1d, 0x2c, 0x11, 0xcf, 0x85, 0x5a,
+    0xa6, 0x8e, 0x84, 0xac, 0x3c, 0x9e, 0x13, 0x8f, 0x61, 0xb7, 0x6d, 0xc4,
+    0x83, 0x30, 0x9c, 0x0a, 0x59, 0xd7, 0xe3, 0x31, 0x41, 0xa1, 0xd0, 0xc8,
+    0x12, 0xfa, 0x5c, 0xa8, 0x65, 0xe3, 0x48, 0xc1, 0xca, 0xe6, 0x39, 0xf6,
+    0x18, 0x78, 0xdb, 0x49, 0x3c, 0x05, 0xc3, 0xae, 0x90, 0x74, 0x3d, 0x1d,
+    0x13, 0x11, 0x0a, 0x85, 0x2c, 0xa6, 0xcf, 0x84, 0x5a, 0x3c, 0x8e, 0x13,
+    0xac, 0x61, 0x9e, 0x6e, 0x8f, 0xf0, 0xef, 0xce, 0x84, 0x08, 0x5c, 0x79,
+    0x42, 0x44, 0xf9, 0x4d, 0x09, 0x2b, 0x4f, 0xd4, 0xf3, 0xfb, 0x42, 0xe2,
+    0x7b, 0x4f, 0x47, 0x78, 0xaf, 0xf5, 0x6a, 0xd9, 0xe8, 0x23, 0x1b, 0xee,
+    0x64, 0x37, 0xbf, 0xff, 0x6e, 0x37, 0xd1, 0x80, 0xff
+};
+
+static const BYTE quantum_cab[] =
+{
+    0x4d, 0x53, 0x43, 0x46, 0x00, 0x00, 0x00, 0x00, 0xdf, 0x02, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x01, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x34, 0x12, 0x00, 0x00,
+    0x45, 0x00, 0x00, 0x00, 0x02, 0x00, 0x42, 0x0f, 0x40, 0x9c, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6c, 0x22, 0xba, 0x59, 0x20, 0x00,
+    0x66, 0x69, 0x6c, 0x65, 0x2e, 0x64, 0x61, 0x74, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x28, 0x02, 0x00, 0x80, 0xcf, 0xba, 0x70, 0xa9, 0xce, 0xcc, 0xd6,
+    0xec, 0xb2, 0xf6, 0x3c, 0xd2, 0xfe, 0xd8, 0xbd, 0x75, 0xf1, 0xd4, 0x6f,
+    0x33, 0xc6, 0x1b, 0x08, 0xfd, 0x32, 0x5e, 0xab, 0x12, 0x5a, 0x72, 0x4b,
+    0x76, 0x89, 0x44, 0xff, 0xa1, 0x7b, 0x3c, 0x31, 0x7e, 0xa8, 0x9f, 0x96,
+    0x6c, 0x34, 0x30, 0x9a, 0xc9, 0xe1, 0x8c, 0xca, 0x84, 0xca, 0x9e, 0x75,
+    0xb4, 0xe3, 0x65, 0x9a, 0x41, 0x41, 0x93, 0x62, 0x8c, 0xc7, 0x9d, 0x9f,
+    0xe8, 0xd1, 0xb2, 0x17, 0x1e, 0x59, 0x62, 0xc3, 0xcd, 0x0d, 0xce, 0x59,
+    0x9b, 0xe6, 0xf2, 0x5d, 0xb8, 0xdb, 0xd4, 0xbf, 0x43, 0x6d, 0x46, 0xe3,
+    0x44, 0xe0, 0x11, 0xe7, 0x8c, 0x64, 0x06, 0x74, 0xc3, 0x53, 0x27, 0x98,
+    0x36, 0x58, 0x47, 0x51, 0x94, 0x70, 0x34, 0xa1, 0xfb, 0x27, 0x2d, 0xab,
+    0x1a, 0xa1, 0xab, 0xc3, 0xc4, 0xf9, 0x8b, 0x31, 0x9e, 0x02, 0xb8, 0x88,
+    0xd7, 0x5c, 0x89, 0x79, 0xaf, 0xd8, 0xde, 0x60, 0xc1, 0x63, 0x66, 0xc4,
+    0xc0, 0xb0, 0xae, 0x60, 0xfc, 0xf8, 0x38, 0x36, 0xf8, 0x69, 0xdd, 0x06,
+    0xb3, 0xce, 0x52, 0x06, 0x3b, 0x24, 0xc2, 0x64, 0x45, 0x8e, 0xb0, 0xc6,
+    0x7a, 0xb3, 0x9d, 0x46, 0x1a, 0xac, 0xe7, 0x3d, 0x12, 0x13, 0x3d, 0x13,
+    0x08, 0xde, 0x23, 0xf6, 0x08, 0xa6, 0x82, 0x10, 0xc4, 0x52, 0x68, 0x8c,
+    0x03, 0xeb, 0x1b, 0xdc, 0x63, 0x75, 0x4c, 0x33, 0xb3, 0x32, 0x80, 0x47,
+    0x75, 0x18, 0xde, 0x06, 0x56, 0x0c, 0x41, 0x29, 0x20, 0xde, 0x0d, 0x31,
+    0x2f, 0x67, 0x73, 0xa0, 0x20, 0xb9, 0x4b, 0xe8, 0xde, 0x67, 0x4b, 0xac,
+    0xe0, 0xa1, 0xe0, 0xf1, 0x76, 0x39, 0x68, 0x84, 0x69, 0x06, 0xa6, 0x79,
+    0x46, 0xac, 0xfc, 0x50, 0x1a, 0xf1, 0x2b, 0xc3, 0xb4, 0x14, 0x19, 0x9c,
+    0x16, 0x22, 0x83, 0x0f, 0xbf, 0x14, 0xe4, 0x77, 0x15, 0x82, 0x2d, 0x0d,
+    0xc5, 0xe1, 0x60, 0x33, 0x81, 0xe0, 0x19, 0x25, 0x15, 0xac, 0xab, 0xae,
+    0x47, 0x5b, 0xf9, 0x87, 0x54, 0x83, 0x6b, 0x30, 0x2e, 0x18, 0xde, 0x99,
+    0x93, 0x0b, 0x19, 0x87, 0x17, 0x6f, 0x65, 0x82, 0x3c, 0xf2, 0xe5, 0xce,
+    0x39, 0x11, 0xf5, 0x90, 0x7b, 0xc1, 0x7b, 0x92, 0x57, 0x7a, 0xad, 0xd9,
+    0x9b, 0x6b, 0x1a, 0x90, 0xd9, 0xc0, 0x5f, 0x01, 0x55, 0xb8, 0x64, 0xdc,
+    0xfc, 0xf9, 0x18, 0xa7, 0x18, 0xc5, 0x45, 0x44, 0x36, 0xf3, 0xae, 0xe6,
+    0x82, 0xb4, 0xb6, 0xe7, 0x8c, 0xcf, 0x98, 0x0f, 0xf1, 0x33, 0x4c, 0x9d,
+    0x40, 0xac, 0xa8, 0x37, 0x18, 0x58, 0x1c, 0x78, 0x06, 0x32, 0xf4, 0x19,
+    0x5d, 0xe4, 0x1f, 0x9d, 0x9b, 0x1d, 0x4e, 0x42, 0xfc, 0xfd, 0xba, 0xe7,
+    0xf9, 0x36, 0x76, 0x7c, 0x60, 0xb1, 0x16, 0x50, 0x6f, 0xc8, 0xf0, 0x9d,
+    0x45, 0x29, 0x9b, 0x4a, 0x65, 0x04, 0xb5, 0xc7, 0x93, 0x7f, 0x66, 0x33,
+    0x8a, 0x61, 0x9f, 0xd7, 0x25, 0x29, 0x08, 0x35, 0x93, 0x2b, 0x6e, 0xb4,
+    0xe3, 0x15, 0xa7, 0xca, 0x73, 0x8e, 0x2b, 0x4d, 0x73, 0x07, 0xd9, 0x9f,
+    0x79, 0x38, 0xb2, 0x7f, 0xe6, 0x3a, 0xb8, 0xd7, 0x65, 0xe5, 0xc8, 0xc3,
+    0x0e, 0x7a, 0x7d, 0x7c, 0x02, 0xb7, 0x36, 0xe8, 0x63, 0x88, 0xf7, 0x9c,
+    0xb2, 0x0f, 0x83, 0xba, 0x26, 0x67, 0x72, 0xc7, 0x30, 0x40, 0xe6, 0x66,
+    0x0e, 0x25, 0x3a, 0xec, 0x8b, 0x8c, 0xf5, 0xcb, 0x4e, 0x6e, 0xcf, 0xa3,
+    0x7c, 0xe7, 0x3b, 0x04, 0x1b, 0x8d, 0xd0, 0x1b, 0xa3, 0x31, 0x99, 0x29,
+    0xe4, 0x1b, 0x99, 0xe0, 0x62, 0xb1, 0x6c, 0xe6, 0x19, 0x43, 0x5b, 0xbe,
+    0x7d, 0x59, 0x53, 0x79, 0x47, 0x49, 0x43, 0xcf, 0xe2, 0xd4, 0xec, 0x49,
+    0x8b, 0x76, 0x3f, 0xc0, 0xec, 0xc1, 0xd9, 0xc1, 0x91, 0x3f, 0x3c, 0x11,
+    0xcb, 0x89, 0x2e, 0xee, 0xd1, 0xec, 0xaa, 0x32, 0x0d, 0x80, 0xf3, 0xec,
+    0xa6, 0x8c, 0x9e, 0x81, 0xe7, 0x63, 0x3e, 0xc5, 0xd3, 0x2c, 0x05, 0x23,
+    0x52, 0x2f, 0x96, 0xc0, 0x83, 0x56, 0x63, 0x0b, 0xb9, 0x9e, 0xde, 0xac,
+    0xdd, 0xc0, 0x08, 0x32, 0x00, 0x00, 0x00, 0x00, 0x00, 0x62, 0x00, 0x40,
+    0x1c, 0xd5, 0xa0, 0xc1, 0x25, 0xb0, 0x62, 0x82, 0xeb, 0xbc, 0x01, 0x48,
+    0x98, 0xfc, 0xcc, 0xf8, 0xf1, 0x61, 0x33, 0x9e, 0xf1, 0x6d, 0xf4, 0x68,
+    0x71, 0xb1, 0x8c, 0xc9, 0x49, 0xaa, 0xc6, 0xae, 0x91, 0xbc, 0x9b, 0x24,
+    0xf7, 0x28, 0x01, 0xac, 0x63, 0xc0, 0x79, 0xe4, 0x4d, 0x47, 0x53, 0xc3,
+    0x8b, 0x24, 0x61, 0x47, 0x94, 0x2e, 0x35, 0x2c, 0xe5, 0x72, 0x6a, 0x58,
+    0x0d, 0xa1, 0xa9, 0x87, 0x5e, 0x6e, 0x20, 0xd9, 0x41, 0xaa, 0xe9, 0x6e,
+    0xa8, 0x56, 0x24, 0xb6, 0x59, 0x73, 0x9c, 0xaf, 0xee, 0x5b, 0xa3, 0x67,
+    0x78, 0x73, 0x1e, 0x1c, 0x8b, 0x79, 0x2b, 0x21, 0xde, 0x68, 0xe8, 0x04,
+    0x10, 0x0b, 0x00
+};
+
+static void fill_sample_data(BYTE *data, DWORD size)
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog. ";
+    DWORD i, seed = 0xcab;
+
+    for (i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        if (i >= 8000 && i < 8600) data[i] = 0;
+        else if (!((seed >> 16) % 293)) data[i] = seed >> 24;
+        else data[i] = text[i % (sizeof(text) - 1)];
+    }
+}
+
+static void write_sample_cab(const BYTE *cab, DWORD size)
+{
+    HANDLE file;
+    DWORD count;
+
+    file = CreateFileA("extract.cab", GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to create extract.cab\n");
+    WriteFile(file, cab, size, &count, NULL);
+    ok(count == size, "wrote %lu bytes\n", count);
+    CloseHandle(file);
+}
+
+static void test_FDICopy_compressed(void)
+{
+    static const DWORD size = 1024 * 1024;
+    BYTE *data;
+
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    fill_test_data(data, size, 0xcab);
+
+    ok(create_compressed_cab(data, size, tcompTYPE_MSZIP), "cabinet isn't MSZIP compressed\n");
+    ok(extract_compressed_cab(data, size), "extracted data doesn't match\n");
+
+    fill_sample_data(data, 40000);
+    write_sample_cab(lzx_cab, sizeof(lzx_cab));
+    ok(extract_compressed_cab(data, 40000), "extracted LZX data doesn't match\n");
+    write_sample_cab(quantum_cab, sizeof(quantum_cab));
+    ok(extract_compressed_cab(data, 40000), "extracted Quantum data doesn't match\n");
+
+    DeleteFileA("extract.cab");
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+static void benchmark_FDICopy(void)
+{
+    static const struct
+    {
+        const char *name;
+        TCOMP comp;
+    }
+    tests[] =
+    {
+        { "MSZIP", tcompTYPE_MSZIP },
+        { "LZX", TCOMPfromLZXWindow(21) },
+        { "Quantum", TCOMPfromTypeLevelMemory(tcompTYPE_QUANTUM, 7, 21) },
+    };
+    static const DWORD size = 16 * 1024 * 1024;
+    DWORD i, j, start, elapsed;
+    BYTE *data;
+
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    fill_test_data(data, size, 0xbe4c);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        if (!create_compressed_cab(data, size, tests[i].comp))
+        {
+            skip("%s compression is not supported\n", tests[i].name);
+            continue;
+        }
+
+        start = GetTickCount();
+        for (j = 0; j < 4; j++)
+            ok(extract_compressed_cab(data, size), "%s: extracted data doesn't match\n", tests[i].name);
+        elapsed = GetTickCount() - start;
+        trace("%s: %lu MiB in %lu ms\n", tests[i].name, 4 * size >> 20, elapsed);
+    }
+
+    DeleteFileA("extract.cab");
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
 
 START_TEST(fdi)
 {
@@ -947,4 +1411,6 @@ START_TEST(fdi)
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+    test_FDICopy_compressed();
+    if (winetest_interactive) benchmark_FDICopy();
 }
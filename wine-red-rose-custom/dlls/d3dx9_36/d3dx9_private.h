@@ -231,6 +231,7 @@ void get_aligned_rect(uint32_t left, uint32_t top, uint32_t right, uint32_t bott
 
 unsigned short float_32_to_16(const float in);
 float float_16_to_32(const unsigned short in);
+void d3dx_math_enable_simd(BOOL enable);
 
 /* debug helpers */
 const char *debug_d3dxparameter_class(D3DXPARAMETER_CLASS c);
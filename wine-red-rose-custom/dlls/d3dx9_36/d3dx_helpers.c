@@ -28,6 +28,9 @@
 #include "bcdec.h"
 #define STB_DXT_IMPLEMENTATION
 #include "stb_dxt.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3dx);
@@ -1756,6 +1759,97 @@ void copy_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch,
     }
 }
 
+/*
+ * Conversions between 32 bpp formats with 8-bit channels (e.g. B8G8R8A8 to
+ * R8G8B8X8) only move bytes around, which lets us process a whole row at a
+ * time instead of going through get_relevant_argb_components() per pixel.
+ */
+struct d3dx_swizzle_info
+{
+    unsigned int src_shift[4];
+    unsigned int dst_shift[4];
+    BOOL process_channel[4];
+    uint32_t fill;
+};
+
+static BOOL d3dx_init_swizzle_info(const struct pixel_format_desc *src_format,
+        const struct pixel_format_desc *dst_format, uint32_t filter_flags, D3DCOLOR color_key,
+        struct d3dx_swizzle_info *info)
+{
+    unsigned int i;
+
+    if (color_key || !format_types_match(src_format, dst_format) || !filter_flags_match(filter_flags)
+            || src_format->bytes_per_pixel != 4 || dst_format->bytes_per_pixel != 4)
+        return FALSE;
+
+    memset(info, 0, sizeof(*info));
+    for (i = 0; i < 4; ++i)
+    {
+        if ((src_format->bits[i] && src_format->bits[i] != 8) || (dst_format->bits[i] && dst_format->bits[i] != 8))
+            return FALSE;
+        if (!dst_format->bits[i])
+            continue;
+
+        if (src_format->bits[i])
+        {
+            info->process_channel[i] = TRUE;
+            info->src_shift[i] = src_format->shift[i];
+            info->dst_shift[i] = dst_format->shift[i];
+        }
+        else
+        {
+            info->fill |= 0xffu << dst_format->shift[i];
+        }
+    }
+
+    return TRUE;
+}
+
+static void d3dx_swizzle_row(const struct d3dx_swizzle_info *info, const BYTE *src, BYTE *dst, unsigned int count)
+{
+    unsigned int i;
+
+#ifdef __SSE2__
+    {
+        const __m128i byte_mask = _mm_set1_epi32(0xff), fill = _mm_set1_epi32(info->fill);
+        __m128i src_shift[4], dst_shift[4];
+
+        for (i = 0; i < 4; ++i)
+        {
+            src_shift[i] = _mm_cvtsi32_si128(info->src_shift[i]);
+            dst_shift[i] = _mm_cvtsi32_si128(info->dst_shift[i]);
+        }
+
+        for (; count >= 4; count -= 4, src += 16, dst += 16)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i *)src), out = fill;
+
+            for (i = 0; i < 4; ++i)
+            {
+                if (!info->process_channel[i])
+                    continue;
+                out = _mm_or_si128(out, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(in, src_shift[i]), byte_mask),
+                        dst_shift[i]));
+            }
+            _mm_storeu_si128((__m128i *)dst, out);
+        }
+    }
+#endif
+
+    for (; count; --count, src += 4, dst += 4)
+    {
+        uint32_t in, out = info->fill;
+
+        memcpy(&in, src, sizeof(in));
+        for (i = 0; i < 4; ++i)
+        {
+            if (info->process_channel[i])
+                out |= ((in >> info->src_shift[i]) & 0xff) << info->dst_shift[i];
+        }
+        memcpy(dst, &out, sizeof(out));
+    }
+}
+
 /************************************************************
  * convert_argb_pixels
  *
@@ -1770,8 +1864,9 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
 {
     struct argb_conversion_info conv_info, ck_conv_info;
     const struct pixel_format_desc *ck_format = NULL;
+    struct d3dx_swizzle_info swizzle_info;
     DWORD channels[4];
-    BOOL src_pma, dst_pma, src_srgb, dst_srgb;
+    BOOL src_pma, dst_pma, src_srgb, dst_srgb, swizzle;
     UINT min_width, min_height, min_depth;
     UINT x, y, z;
 
@@ -1797,6 +1892,7 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
         ck_format = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_B8G8R8A8_UNORM);
         init_argb_conversion_info(src_format, ck_format, &ck_conv_info);
     }
+    swizzle = d3dx_init_swizzle_info(src_format, dst_format, filter_flags, color_key, &swizzle_info);
 
     for (z = 0; z < min_depth; z++) {
         const BYTE *src_slice_ptr = src + z * src_slice_pitch;
@@ -1806,7 +1902,16 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
             const BYTE *src_ptr = src_slice_ptr + y * src_row_pitch;
             BYTE *dst_ptr = dst_slice_ptr + y * dst_row_pitch;
 
-            for (x = 0; x < min_width; x++) {
+            x = 0;
+            if (swizzle)
+            {
+                d3dx_swizzle_row(&swizzle_info, src_ptr, dst_ptr, min_width);
+                src_ptr += min_width * src_format->bytes_per_pixel;
+                dst_ptr += min_width * dst_format->bytes_per_pixel;
+                x = min_width;
+            }
+
+            for (; x < min_width; x++) {
                 if (format_types_match(src_format, dst_format) && filter_flags_match(filter_flags)
                         && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
                 {
@@ -1973,51 +2078,156 @@ static void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT s
     }
 }
 
-struct d3dx_bcn_decompression_context
+/*
+ * Work on large textures is split into chunks of rows (of pixels or of
+ * compressed blocks) which are handed out to the thread pool. The calling
+ * thread processes chunks as well, so nothing is lost if the pool is busy.
+ */
+#define D3DX_PARALLEL_MAX_WORKERS 16
+#define D3DX_PARALLEL_MIN_CHUNK_ITEMS 4096
+
+struct d3dx_parallel_job
+{
+    void (*func)(void *ctx, unsigned int first, unsigned int count);
+    void *ctx;
+    unsigned int row_count;
+    unsigned int chunk_size;
+    LONG next_chunk;
+    LONG pending;
+    HANDLE done_event;
+};
+
+static void d3dx_parallel_job_process(struct d3dx_parallel_job *job)
+{
+    unsigned int first;
+
+    while ((first = (InterlockedIncrement(&job->next_chunk) - 1) * job->chunk_size) < job->row_count)
+        job->func(job->ctx, first, min(job->chunk_size, job->row_count - first));
+}
+
+static void CALLBACK d3dx_parallel_job_callback(TP_CALLBACK_INSTANCE *instance, void *ctx)
+{
+    struct d3dx_parallel_job *job = ctx;
+
+    d3dx_parallel_job_process(job);
+    if (!InterlockedDecrement(&job->pending))
+        SetEventWhenCallbackReturns(instance, job->done_event);
+}
+
+static unsigned int d3dx_get_parallel_worker_count(void)
+{
+    static LONG worker_count;
+    SYSTEM_INFO info;
+    LONG count;
+
+    if ((count = ReadNoFence(&worker_count)))
+        return count;
+
+    GetSystemInfo(&info);
+    count = min(max(info.dwNumberOfProcessors, 1), D3DX_PARALLEL_MAX_WORKERS);
+    InterlockedExchange(&worker_count, count);
+    return count;
+}
+
+/*
+ * Calls func for each of row_count rows, possibly from several threads.
+ * row_cost is the number of "items" (pixels or blocks) in a single row, and
+ * is used to keep chunks large enough to be worth the dispatch overhead.
+ */
+static void d3dx_run_parallel(unsigned int row_count, unsigned int row_cost,
+        void (*func)(void *ctx, unsigned int first, unsigned int count), void *ctx)
+{
+    unsigned int i, chunk_size, chunk_count, worker_count;
+    struct d3dx_parallel_job job;
+
+    chunk_size = max(D3DX_PARALLEL_MIN_CHUNK_ITEMS / max(row_cost, 1), 1);
+    chunk_count = (row_count + chunk_size - 1) / chunk_size;
+    worker_count = min(d3dx_get_parallel_worker_count(), chunk_count);
+
+    if (worker_count <= 1 || !(job.done_event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        func(ctx, 0, row_count);
+        return;
+    }
+
+    /* Hand out roughly four chunks per worker to smooth out uneven rows. */
+    chunk_size = max(chunk_size, (row_count + worker_count * 4 - 1) / (worker_count * 4));
+
+    TRACE("Processing %u rows in chunks of %u on %u threads.\n", row_count, chunk_size, worker_count);
+
+    job.func = func;
+    job.ctx = ctx;
+    job.row_count = row_count;
+    job.chunk_size = chunk_size;
+    job.next_chunk = 0;
+    job.pending = worker_count;
+
+    for (i = 1; i < worker_count; ++i)
+    {
+        if (!TrySubmitThreadpoolCallback(d3dx_parallel_job_callback, &job, NULL))
+        {
+            WARN("Failed to submit thread pool callback, error %lu.\n", GetLastError());
+            InterlockedAdd(&job.pending, -(LONG)(worker_count - i));
+            break;
+        }
+    }
+
+    d3dx_parallel_job_process(&job);
+    if (InterlockedDecrement(&job.pending))
+        WaitForSingleObject(job.done_event, INFINITE);
+    CloseHandle(job.done_event);
+}
+
+struct d3dx_bcn_decompression_job
 {
     void (*decompress_bcn_block)(const void *, void *, int);
     const struct pixel_format_desc *compressed_format_desc;
-    struct d3dx_pixels *compressed_pixels;
+    const struct d3dx_pixels *compressed_pixels;
 
     const struct pixel_format_desc *decompressed_format_desc;
-    uint8_t cur_block_decompressed[192];
-    uint32_t cur_block_row_pitch;
-    int32_t cur_block_x;
-    int32_t cur_block_y;
-    int32_t cur_block_z;
+    BYTE *dst_data;
+    uint32_t dst_row_pitch;
+    uint32_t dst_slice_pitch;
+
+    /* Offset of the destination origin inside the compressed block grid. */
+    uint32_t x_offset;
+    uint32_t y_offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t block_row_count;
 };
 
-static void d3dx_init_bcn_decompression_context(struct d3dx_bcn_decompression_context *context,
-        struct d3dx_pixels *pixels, const struct pixel_format_desc *desc, const struct pixel_format_desc *dst_desc)
+static void d3dx_init_bcn_decompression_job(struct d3dx_bcn_decompression_job *job,
+        const struct d3dx_pixels *pixels, const struct pixel_format_desc *desc, const struct pixel_format_desc *dst_desc)
 {
-    memset(context, 0, sizeof(*context));
+    memset(job, 0, sizeof(*job));
     switch (desc->format)
     {
     case D3DX_PIXEL_FORMAT_DXT1_UNORM:
     case D3DX_PIXEL_FORMAT_BC1_UNORM_SRGB:
-        context->decompress_bcn_block = bcdec_bc1;
+        job->decompress_bcn_block = bcdec_bc1;
         break;
 
     case D3DX_PIXEL_FORMAT_DXT2_UNORM:
     case D3DX_PIXEL_FORMAT_DXT3_UNORM:
     case D3DX_PIXEL_FORMAT_BC2_UNORM_SRGB:
-        context->decompress_bcn_block = bcdec_bc2;
+        job->decompress_bcn_block = bcdec_bc2;
         break;
 
     case D3DX_PIXEL_FORMAT_DXT4_UNORM:
     case D3DX_PIXEL_FORMAT_DXT5_UNORM:
     case D3DX_PIXEL_FORMAT_BC3_UNORM_SRGB:
-        context->decompress_bcn_block = bcdec_bc3;
+        job->decompress_bcn_block = bcdec_bc3;
         break;
 
     case D3DX_PIXEL_FORMAT_BC4_UNORM:
     case D3DX_PIXEL_FORMAT_BC4_SNORM:
-        context->decompress_bcn_block = bcdec_bc4;
+        job->decompress_bcn_block = bcdec_bc4;
         break;
 
     case D3DX_PIXEL_FORMAT_BC5_UNORM:
     case D3DX_PIXEL_FORMAT_BC5_SNORM:
-        context->decompress_bcn_block = bcdec_bc5;
+        job->decompress_bcn_block = bcdec_bc5;
         break;
 
     default:
@@ -2025,47 +2235,71 @@ static void d3dx_init_bcn_decompression_context(struct d3dx_bcn_decompression_co
         break;
     }
 
-    context->compressed_format_desc = desc;
-    context->compressed_pixels = pixels;
-
-    context->decompressed_format_desc = dst_desc;
-    context->cur_block_row_pitch = dst_desc->bytes_per_pixel * desc->block_width;
-    context->cur_block_x = context->cur_block_y = context->cur_block_z = -1;
+    job->compressed_format_desc = desc;
+    job->compressed_pixels = pixels;
+    job->decompressed_format_desc = dst_desc;
 }
 
-static void d3dx_fetch_bcn_texel(struct d3dx_bcn_decompression_context *context, int32_t x, int32_t y, int32_t z, void *texel)
-{
-    const struct pixel_format_desc *decomp_fmt_desc = context->decompressed_format_desc;
-    const struct pixel_format_desc *comp_fmt_desc = context->compressed_format_desc;
-    const int32_t y_aligned = (y & ~(comp_fmt_desc->block_height - 1));
-    const int32_t x_aligned = (x & ~(comp_fmt_desc->block_width - 1));
-    uint32_t pixel_offset;
-
-    if (z != context->cur_block_z || (x_aligned != context->cur_block_x) || (y_aligned != context->cur_block_y))
-    {
-        const BYTE *block_ptr = context->compressed_pixels->data;
+/*
+ * Decompresses whole rows of blocks. Blocks entirely inside the destination
+ * are decoded in place, partially covered blocks go through a temporary
+ * buffer and only the covered texels are copied out.
+ */
+static void d3dx_decompress_bcn_block_rows(void *ctx, unsigned int first, unsigned int count)
+{
+    const struct d3dx_bcn_decompression_job *job = ctx;
+    const struct pixel_format_desc *comp_fmt_desc = job->compressed_format_desc;
+    const uint32_t bpp = job->decompressed_format_desc->bytes_per_pixel;
+    const uint32_t block_w = comp_fmt_desc->block_width, block_h = comp_fmt_desc->block_height;
+    const uint32_t first_block_x = job->x_offset / block_w;
+    const uint32_t end_block_x = (job->x_offset + job->width + block_w - 1) / block_w;
+    const uint32_t first_block_y = job->y_offset / block_h;
+    const struct d3dx_pixels *pixels = job->compressed_pixels;
+    uint8_t block[4 * 4 * 4];
+    unsigned int i;
+
+    for (i = first; i < first + count; ++i)
+    {
+        const uint32_t z = i / job->block_row_count, block_y = first_block_y + i % job->block_row_count;
+        const BYTE *src_ptr = (const BYTE *)pixels->data + z * pixels->slice_pitch + block_y * pixels->row_pitch;
+        const int32_t y = block_y * block_h - job->y_offset;
+        const uint32_t row_start = max(y, 0), row_end = min(y + (int32_t)block_h, (int32_t)job->height);
+        BYTE *dst_row = job->dst_data + z * job->dst_slice_pitch + row_start * job->dst_row_pitch;
+        uint32_t block_x, row;
+
+        src_ptr += first_block_x * comp_fmt_desc->block_byte_count;
+        for (block_x = first_block_x; block_x < end_block_x; ++block_x)
+        {
+            const int32_t x = block_x * block_w - job->x_offset;
+            const uint32_t col_start = max(x, 0), col_end = min(x + (int32_t)block_w, (int32_t)job->width);
+            BYTE *dst_ptr = dst_row + col_start * bpp;
 
-        block_ptr += z * context->compressed_pixels->slice_pitch;
-        block_ptr += (y / comp_fmt_desc->block_height) * context->compressed_pixels->row_pitch;
-        block_ptr += (x / comp_fmt_desc->block_width) * comp_fmt_desc->block_byte_count;
-        context->decompress_bcn_block(block_ptr, context->cur_block_decompressed, context->cur_block_row_pitch);
-        context->cur_block_x = (x & (comp_fmt_desc->block_width));
-        context->cur_block_y = (y & (comp_fmt_desc->block_height));
-        context->cur_block_z = z;
+            if (row_end - row_start == block_h && col_end - col_start == block_w)
+            {
+                job->decompress_bcn_block(src_ptr, dst_ptr, job->dst_row_pitch);
+            }
+            else
+            {
+                job->decompress_bcn_block(src_ptr, block, block_w * bpp);
+                for (row = row_start; row < row_end; ++row)
+                {
+                    memcpy(dst_ptr, &block[(row - y) * block_w * bpp + (col_start - x) * bpp],
+                            (col_end - col_start) * bpp);
+                    dst_ptr += job->dst_row_pitch;
+                }
+            }
+            src_ptr += comp_fmt_desc->block_byte_count;
+        }
     }
-
-    pixel_offset = (y & (comp_fmt_desc->block_height - 1)) * context->cur_block_row_pitch;
-    pixel_offset += (x & (comp_fmt_desc->block_width - 1)) * decomp_fmt_desc->bytes_per_pixel;
-    memcpy(texel, context->cur_block_decompressed + pixel_offset, decomp_fmt_desc->bytes_per_pixel);
 }
 
 static HRESULT d3dx_pixels_decompress(struct d3dx_pixels *pixels, const struct pixel_format_desc *desc,
         BOOL is_dst, void **out_memory, uint32_t *out_row_pitch, uint32_t *out_slice_pitch,
         const struct pixel_format_desc **out_desc)
 {
-    uint32_t x, y, z, uncompressed_slice_pitch, uncompressed_row_pitch;
+    uint32_t uncompressed_slice_pitch, uncompressed_row_pitch;
     const struct pixel_format_desc *uncompressed_desc = NULL;
-    struct d3dx_bcn_decompression_context context;
+    struct d3dx_bcn_decompression_job job;
     const struct volume *size = &pixels->size;
     BYTE *uncompressed_mem;
 
@@ -2131,25 +2365,23 @@ static HRESULT d3dx_pixels_decompress(struct d3dx_pixels *pixels, const struct p
             goto exit;
     }
 
+    /*
+     * Pixels of the destination rectangle are overwritten by the caller, but
+     * decompressing them too keeps every block on the fast path.
+     */
     TRACE("Decompressing pixels.\n");
-    d3dx_init_bcn_decompression_context(&context, pixels, desc, uncompressed_desc);
-    for (z = 0; z < size->depth; ++z)
-    {
-        for (y = 0; y < size->height; ++y)
-        {
-            BYTE *ptr = &uncompressed_mem[(z * uncompressed_slice_pitch) + (y * uncompressed_row_pitch)];
-            for (x = 0; x < size->width; ++x)
-            {
-                const POINT pt = { x, y };
-
-                if (!is_dst)
-                    d3dx_fetch_bcn_texel(&context, x + pixels->unaligned_rect.left, y + pixels->unaligned_rect.top, z, ptr);
-                else if (!PtInRect(&pixels->unaligned_rect, pt))
-                    d3dx_fetch_bcn_texel(&context, x, y, z, ptr);
-                ptr += uncompressed_desc->bytes_per_pixel;
-            }
-        }
-    }
+    d3dx_init_bcn_decompression_job(&job, pixels, desc, uncompressed_desc);
+    job.dst_data = uncompressed_mem;
+    job.dst_row_pitch = uncompressed_row_pitch;
+    job.dst_slice_pitch = uncompressed_slice_pitch;
+    job.x_offset = is_dst ? 0 : pixels->unaligned_rect.left;
+    job.y_offset = is_dst ? 0 : pixels->unaligned_rect.top;
+    job.width = size->width;
+    job.height = size->height;
+    job.block_row_count = (job.y_offset + size->height + desc->block_height - 1) / desc->block_height
+            - job.y_offset / desc->block_height;
+    d3dx_run_parallel(size->depth * job.block_row_count, (size->width + desc->block_width - 1) / desc->block_width,
+            d3dx_decompress_bcn_block_rows, &job);
 
 exit:
     *out_memory = uncompressed_mem;
@@ -2251,12 +2483,49 @@ static void d3dx_compress_bc5_block(const void *src_data, uint32_t src_row_pitch
     stb_compress_bc5_block(dst_data, (const unsigned char *)tmp_buf);
 }
 
+struct d3dx_bcn_compression_job
+{
+    void (*compress_bcn_block)(const void *, uint32_t, uint8_t, uint8_t, void *);
+    const struct pixel_format_desc *src_desc;
+    const struct d3dx_pixels *src_pixels;
+    const struct pixel_format_desc *dst_desc;
+    const struct d3dx_pixels *dst_pixels;
+    uint32_t block_row_count;
+};
+
+static void d3dx_compress_bcn_block_rows(void *ctx, unsigned int first, unsigned int count)
+{
+    const struct d3dx_bcn_compression_job *job = ctx;
+    const struct pixel_format_desc *dst_desc = job->dst_desc;
+    const struct d3dx_pixels *src_pixels = job->src_pixels;
+    unsigned int i;
+    uint32_t x;
+
+    for (i = first; i < first + count; ++i)
+    {
+        const uint32_t z = i / job->block_row_count, y = (i % job->block_row_count) * dst_desc->block_height;
+        const BYTE *src_ptr = ((const BYTE *)src_pixels->data) + z * src_pixels->slice_pitch + y * src_pixels->row_pitch;
+        BYTE *dst_ptr = ((BYTE *)job->dst_pixels->data) + z * job->dst_pixels->slice_pitch
+                + (y / dst_desc->block_height) * job->dst_pixels->row_pitch;
+        uint8_t tmp_src_height = min(dst_desc->block_height, src_pixels->size.height - y);
+
+        for (x = 0; x < src_pixels->size.width; x += dst_desc->block_width)
+        {
+            uint8_t tmp_src_width = min(dst_desc->block_width, src_pixels->size.width - x);
+
+            job->compress_bcn_block(src_ptr, src_pixels->row_pitch, tmp_src_width, tmp_src_height, dst_ptr);
+            src_ptr += (job->src_desc->bytes_per_pixel * dst_desc->block_width);
+            dst_ptr += dst_desc->block_byte_count;
+        }
+    }
+}
+
 static HRESULT d3dx_pixels_compress(struct d3dx_pixels *src_pixels,
         const struct pixel_format_desc *src_desc, struct d3dx_pixels *dst_pixels,
         const struct pixel_format_desc *dst_desc)
 {
     void (*compress_bcn_block)(const void *, uint32_t, uint8_t, uint8_t, void *) = NULL;
-    uint32_t x, y, z;
+    struct d3dx_bcn_compression_job job;
 
     /* Pick a compression function. */
     switch (dst_desc->format)
@@ -2296,27 +2565,15 @@ static HRESULT d3dx_pixels_compress(struct d3dx_pixels *src_pixels,
     assert(compress_bcn_block);
 
     TRACE("Compressing pixels.\n");
-    for (z = 0; z < src_pixels->size.depth; ++z)
-    {
-        const BYTE *src_slice = ((const BYTE *)src_pixels->data) + (z * src_pixels->slice_pitch);
-        BYTE *dst_slice = ((BYTE *)dst_pixels->data) + (z * dst_pixels->slice_pitch);
-
-        for (y = 0; y < src_pixels->size.height; y += dst_desc->block_height)
-        {
-            BYTE *dst_ptr = &dst_slice[(y / dst_desc->block_height) * dst_pixels->row_pitch];
-            uint8_t tmp_src_height = min(dst_desc->block_height, src_pixels->size.height - y);
-            const BYTE *src_ptr = &src_slice[y * src_pixels->row_pitch];
-
-            for (x = 0; x < src_pixels->size.width; x += dst_desc->block_width)
-            {
-                uint8_t tmp_src_width = min(dst_desc->block_width, src_pixels->size.width - x);
-
-                compress_bcn_block(src_ptr, src_pixels->row_pitch, tmp_src_width, tmp_src_height, dst_ptr);
-                src_ptr += (src_desc->bytes_per_pixel * dst_desc->block_width);
-                dst_ptr += dst_desc->block_byte_count;
-            }
-        }
-    }
+    job.compress_bcn_block = compress_bcn_block;
+    job.src_desc = src_desc;
+    job.src_pixels = src_pixels;
+    job.dst_desc = dst_desc;
+    job.dst_pixels = dst_pixels;
+    job.block_row_count = (src_pixels->size.height + dst_desc->block_height - 1) / dst_desc->block_height;
+    d3dx_run_parallel(src_pixels->size.depth * job.block_row_count,
+            (src_pixels->size.width + dst_desc->block_width - 1) / dst_desc->block_width,
+            d3dx_compress_bcn_block_rows, &job);
 
     return S_OK;
 }
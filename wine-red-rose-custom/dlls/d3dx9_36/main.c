@@ -33,6 +33,8 @@ BOOL WINAPI D3DXCheckVersion(UINT d3d_sdk_ver, UINT d3dx_sdk_ver)
 
 DWORD WINAPI D3DXCpuOptimizations(BOOL enable)
 {
-    FIXME("%#x - stub\n", enable);
+    TRACE("enable %#x.\n", enable);
+
+    d3dx_math_enable_simd(enable);
     return 0;
 }
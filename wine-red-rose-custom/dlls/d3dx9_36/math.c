@@ -41,6 +41,306 @@ struct ID3DXMatrixStackImpl
 
 static const unsigned int INITIAL_STACK_SIZE = 32;
 
+/*_________________SIMD helpers_________________*/
+
+/*
+ * Matrix products and the *Array transforms have SSE2 and AVX versions,
+ * picked at runtime. They evaluate every dot product in the same order as
+ * the scalar code and never use FMA, so the results are identical.
+ */
+enum d3dx_simd_level
+{
+    D3DX_SIMD_NONE,
+    D3DX_SIMD_SSE2,
+    D3DX_SIMD_AVX,
+};
+
+static LONG d3dx_simd_enabled = TRUE;
+
+void d3dx_math_enable_simd(BOOL enable)
+{
+    InterlockedExchange(&d3dx_simd_enabled, !!enable);
+}
+
+static enum d3dx_simd_level d3dx_get_simd_level(void)
+{
+    static LONG simd_level = -1;
+    LONG level;
+
+    if (!ReadNoFence(&d3dx_simd_enabled))
+        return D3DX_SIMD_NONE;
+    if ((level = ReadNoFence(&simd_level)) != -1)
+        return level;
+
+    level = D3DX_SIMD_NONE;
+#if defined(__i386__) || defined(__x86_64__)
+    if (IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE))
+        level = D3DX_SIMD_SSE2;
+    if (IsProcessorFeaturePresent(PF_AVX_INSTRUCTIONS_AVAILABLE))
+        level = D3DX_SIMD_AVX;
+#endif
+    TRACE("Using SIMD level %ld.\n", level);
+    InterlockedExchange(&simd_level, level);
+    return level;
+}
+
+/* Describes how the *Array functions map their input onto a 4x4 matrix. */
+struct d3dx_transform_desc
+{
+    unsigned int in_size;   /* Number of input components, 2 to 4. */
+    unsigned int out_size;  /* Number of output components, 2 to 4. */
+    BOOL normal;            /* Leave out the translation row. */
+    BOOL coord;             /* Divide the result by w. */
+};
+
+static const struct d3dx_transform_desc vec2_transform_desc = {2, 4, FALSE, FALSE};
+static const struct d3dx_transform_desc vec2_transform_coord_desc = {2, 2, FALSE, TRUE};
+static const struct d3dx_transform_desc vec2_transform_normal_desc = {2, 2, TRUE, FALSE};
+static const struct d3dx_transform_desc vec3_transform_desc = {3, 4, FALSE, FALSE};
+static const struct d3dx_transform_desc vec3_transform_coord_desc = {3, 3, FALSE, TRUE};
+static const struct d3dx_transform_desc vec3_transform_normal_desc = {3, 3, TRUE, FALSE};
+static const struct d3dx_transform_desc vec4_transform_desc = {4, 4, FALSE, FALSE};
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+#define D3DX_SIMD_SSE2_TARGET __attribute__((target("sse2")))
+#define D3DX_SIMD_AVX_TARGET __attribute__((target("avx")))
+
+#define D3DX_IN(j) ((const float *)((const char *)in + (SIZE_T)instride * (j)))
+#define D3DX_OUT(j) ((float *)((char *)out + (SIZE_T)outstride * (j)))
+
+/*
+ * Elements are only processed in batches when the input and output ranges
+ * don't overlap. Otherwise an output element may alias a later input, and
+ * we have to read and write elements strictly in order.
+ */
+static BOOL d3dx_arrays_overlap(const void *out, UINT outstride, const void *in, UINT instride,
+        UINT elements, const struct d3dx_transform_desc *desc)
+{
+    const char *out_end = (const char *)out + (SIZE_T)outstride * (elements - 1) + desc->out_size * sizeof(float);
+    const char *in_end = (const char *)in + (SIZE_T)instride * (elements - 1) + desc->in_size * sizeof(float);
+
+    return (const char *)out < in_end && (const char *)in < out_end;
+}
+
+static inline D3DX_SIMD_SSE2_TARGET __m128 d3dx_transform_sse2(const __m128 *rows, const float *in,
+        const struct d3dx_transform_desc *desc)
+{
+    __m128 r;
+
+    r = _mm_mul_ps(_mm_set1_ps(in[0]), rows[0]);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[1]), rows[1]));
+    if (desc->in_size > 2)
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[2]), rows[2]));
+    if (desc->in_size > 3)
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[3]), rows[3]));
+    else if (!desc->normal)
+        r = _mm_add_ps(r, rows[3]);
+    if (desc->coord)
+        r = _mm_div_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+    return r;
+}
+
+static inline D3DX_SIMD_SSE2_TARGET void d3dx_store_sse2(float *out, __m128 v, unsigned int size)
+{
+    switch (size)
+    {
+        case 4:
+            _mm_storeu_ps(out, v);
+            break;
+        case 3:
+            _mm_storel_pi((__m64 *)out, v);
+            _mm_store_ss(out + 2, _mm_movehl_ps(v, v));
+            break;
+        default:
+            _mm_storel_pi((__m64 *)out, v);
+            break;
+    }
+}
+
+static D3DX_SIMD_SSE2_TARGET void d3dx_matrix_multiply_sse2(D3DXMATRIX *out,
+        const D3DXMATRIX *m1, const D3DXMATRIX *m2, BOOL transpose)
+{
+    __m128 b0 = _mm_loadu_ps(m2->m[0]), b1 = _mm_loadu_ps(m2->m[1]);
+    __m128 b2 = _mm_loadu_ps(m2->m[2]), b3 = _mm_loadu_ps(m2->m[3]);
+    __m128 r[4];
+    unsigned int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        r[i] = _mm_mul_ps(_mm_set1_ps(m1->m[i][0]), b0);
+        r[i] = _mm_add_ps(r[i], _mm_mul_ps(_mm_set1_ps(m1->m[i][1]), b1));
+        r[i] = _mm_add_ps(r[i], _mm_mul_ps(_mm_set1_ps(m1->m[i][2]), b2));
+        r[i] = _mm_add_ps(r[i], _mm_mul_ps(_mm_set1_ps(m1->m[i][3]), b3));
+    }
+    if (transpose)
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+    for (i = 0; i < 4; ++i)
+        _mm_storeu_ps(out->m[i], r[i]);
+}
+
+static D3DX_SIMD_SSE2_TARGET void d3dx_transform_array_sse2(float *out, UINT outstride, const float *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements, const struct d3dx_transform_desc *desc)
+{
+    const __m128 rows[4] = {_mm_loadu_ps(matrix->m[0]), _mm_loadu_ps(matrix->m[1]),
+            _mm_loadu_ps(matrix->m[2]), _mm_loadu_ps(matrix->m[3])};
+    UINT i = 0;
+
+    if (!d3dx_arrays_overlap(out, outstride, in, instride, elements, desc))
+    {
+        for (; i + 4 <= elements; i += 4)
+        {
+            __m128 r0 = d3dx_transform_sse2(rows, D3DX_IN(i), desc);
+            __m128 r1 = d3dx_transform_sse2(rows, D3DX_IN(i + 1), desc);
+            __m128 r2 = d3dx_transform_sse2(rows, D3DX_IN(i + 2), desc);
+            __m128 r3 = d3dx_transform_sse2(rows, D3DX_IN(i + 3), desc);
+
+            d3dx_store_sse2(D3DX_OUT(i), r0, desc->out_size);
+            d3dx_store_sse2(D3DX_OUT(i + 1), r1, desc->out_size);
+            d3dx_store_sse2(D3DX_OUT(i + 2), r2, desc->out_size);
+            d3dx_store_sse2(D3DX_OUT(i + 3), r3, desc->out_size);
+        }
+    }
+    for (; i < elements; ++i)
+        d3dx_store_sse2(D3DX_OUT(i), d3dx_transform_sse2(rows, D3DX_IN(i), desc), desc->out_size);
+}
+
+static inline D3DX_SIMD_AVX_TARGET __m256 d3dx_set_m128_avx(__m128 lo, __m128 hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+static inline D3DX_SIMD_AVX_TARGET __m256 d3dx_load_row_avx(const float *row)
+{
+    __m128 r = _mm_loadu_ps(row);
+
+    return d3dx_set_m128_avx(r, r);
+}
+
+static inline D3DX_SIMD_AVX_TARGET __m256 d3dx_broadcast_pair_avx(float lo, float hi)
+{
+    return d3dx_set_m128_avx(_mm_set1_ps(lo), _mm_set1_ps(hi));
+}
+
+/* Transforms two elements at once, one in each 128-bit lane. */
+static inline D3DX_SIMD_AVX_TARGET __m256 d3dx_transform_avx(const __m256 *rows, const float *in0,
+        const float *in1, const struct d3dx_transform_desc *desc)
+{
+    __m256 r;
+
+    r = _mm256_mul_ps(d3dx_broadcast_pair_avx(in0[0], in1[0]), rows[0]);
+    r = _mm256_add_ps(r, _mm256_mul_ps(d3dx_broadcast_pair_avx(in0[1], in1[1]), rows[1]));
+    if (desc->in_size > 2)
+        r = _mm256_add_ps(r, _mm256_mul_ps(d3dx_broadcast_pair_avx(in0[2], in1[2]), rows[2]));
+    if (desc->in_size > 3)
+        r = _mm256_add_ps(r, _mm256_mul_ps(d3dx_broadcast_pair_avx(in0[3], in1[3]), rows[3]));
+    else if (!desc->normal)
+        r = _mm256_add_ps(r, rows[3]);
+    if (desc->coord)
+        r = _mm256_div_ps(r, _mm256_permute_ps(r, _MM_SHUFFLE(3, 3, 3, 3)));
+    return r;
+}
+
+static D3DX_SIMD_AVX_TARGET void d3dx_matrix_multiply_avx(D3DXMATRIX *out,
+        const D3DXMATRIX *m1, const D3DXMATRIX *m2, BOOL transpose)
+{
+    __m256 b0 = d3dx_load_row_avx(m2->m[0]), b1 = d3dx_load_row_avx(m2->m[1]);
+    __m256 b2 = d3dx_load_row_avx(m2->m[2]), b3 = d3dx_load_row_avx(m2->m[3]);
+    __m128 r[4];
+    __m256 v;
+    unsigned int i;
+
+    for (i = 0; i < 4; i += 2)
+    {
+        v = _mm256_mul_ps(d3dx_broadcast_pair_avx(m1->m[i][0], m1->m[i + 1][0]), b0);
+        v = _mm256_add_ps(v, _mm256_mul_ps(d3dx_broadcast_pair_avx(m1->m[i][1], m1->m[i + 1][1]), b1));
+        v = _mm256_add_ps(v, _mm256_mul_ps(d3dx_broadcast_pair_avx(m1->m[i][2], m1->m[i + 1][2]), b2));
+        v = _mm256_add_ps(v, _mm256_mul_ps(d3dx_broadcast_pair_avx(m1->m[i][3], m1->m[i + 1][3]), b3));
+        r[i] = _mm256_castps256_ps128(v);
+        r[i + 1] = _mm256_extractf128_ps(v, 1);
+    }
+    if (transpose)
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+    for (i = 0; i < 4; ++i)
+        _mm_storeu_ps(out->m[i], r[i]);
+    _mm256_zeroupper();
+}
+
+static D3DX_SIMD_AVX_TARGET void d3dx_transform_array_avx(float *out, UINT outstride, const float *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements, const struct d3dx_transform_desc *desc)
+{
+    const __m256 rows[4] = {d3dx_load_row_avx(matrix->m[0]), d3dx_load_row_avx(matrix->m[1]),
+            d3dx_load_row_avx(matrix->m[2]), d3dx_load_row_avx(matrix->m[3])};
+    UINT i = 0;
+
+    if (!d3dx_arrays_overlap(out, outstride, in, instride, elements, desc))
+    {
+        for (; i + 4 <= elements; i += 4)
+        {
+            __m256 r01 = d3dx_transform_avx(rows, D3DX_IN(i), D3DX_IN(i + 1), desc);
+            __m256 r23 = d3dx_transform_avx(rows, D3DX_IN(i + 2), D3DX_IN(i + 3), desc);
+
+            d3dx_store_sse2(D3DX_OUT(i), _mm256_castps256_ps128(r01), desc->out_size);
+            d3dx_store_sse2(D3DX_OUT(i + 1), _mm256_extractf128_ps(r01, 1), desc->out_size);
+            d3dx_store_sse2(D3DX_OUT(i + 2), _mm256_castps256_ps128(r23), desc->out_size);
+            d3dx_store_sse2(D3DX_OUT(i + 3), _mm256_extractf128_ps(r23, 1), desc->out_size);
+        }
+    }
+    for (; i < elements; ++i)
+    {
+        const __m128 row[4] = {_mm256_castps256_ps128(rows[0]), _mm256_castps256_ps128(rows[1]),
+                _mm256_castps256_ps128(rows[2]), _mm256_castps256_ps128(rows[3])};
+
+        d3dx_store_sse2(D3DX_OUT(i), d3dx_transform_sse2(row, D3DX_IN(i), desc), desc->out_size);
+    }
+    _mm256_zeroupper();
+}
+
+#undef D3DX_OUT
+#undef D3DX_IN
+
+#endif
+
+static BOOL d3dx_matrix_multiply_simd(D3DXMATRIX *out, const D3DXMATRIX *m1, const D3DXMATRIX *m2, BOOL transpose)
+{
+    switch (d3dx_get_simd_level())
+    {
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+        case D3DX_SIMD_AVX:
+            d3dx_matrix_multiply_avx(out, m1, m2, transpose);
+            return TRUE;
+        case D3DX_SIMD_SSE2:
+            d3dx_matrix_multiply_sse2(out, m1, m2, transpose);
+            return TRUE;
+#endif
+        default:
+            return FALSE;
+    }
+}
+
+/* Returns FALSE if the caller should fall back to the scalar code. */
+static BOOL d3dx_transform_array(void *out, UINT outstride, const void *in, UINT instride,
+        const D3DXMATRIX *matrix, UINT elements, const struct d3dx_transform_desc *desc)
+{
+    switch (d3dx_get_simd_level())
+    {
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+        case D3DX_SIMD_AVX:
+            if (elements)
+                d3dx_transform_array_avx(out, outstride, in, instride, matrix, elements, desc);
+            return TRUE;
+        case D3DX_SIMD_SSE2:
+            if (elements)
+                d3dx_transform_array_sse2(out, outstride, in, instride, matrix, elements, desc);
+            return TRUE;
+#endif
+        default:
+            return FALSE;
+    }
+}
+
 /*_________________D3DXColor____________________*/
 
 D3DXCOLOR* WINAPI D3DXColorAdjustContrast(D3DXCOLOR *pout, const D3DXCOLOR *pc, FLOAT s)
@@ -397,6 +697,9 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, c
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+    if (d3dx_matrix_multiply_simd(pout, pm1, pm2, FALSE))
+        return pout;
+
     for (i=0; i<4; i++)
     {
         for (j=0; j<4; j++)
@@ -416,6 +719,9 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiplyTranspose(D3DXMATRIX *pout, const D3DXMATRI
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+    if (d3dx_matrix_multiply_simd(pout, pm1, pm2, TRUE))
+        return pout;
+
     for (i = 0; i < 4; i++)
         for (j = 0; j < 4; j++)
             temp.m[j][i] = pm1->m[i][0] * pm2->m[0][j] + pm1->m[i][1] * pm2->m[1][j] + pm1->m[i][2] * pm2->m[2][j] + pm1->m[i][3] * pm2->m[3][j];
@@ -1294,6 +1600,9 @@ D3DXPLANE* WINAPI D3DXPlaneTransformArray(D3DXPLANE* out, UINT outstride, const
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec4_transform_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXPlaneTransform(
             (D3DXPLANE*)((char*)out + outstride * i),
@@ -1697,6 +2006,9 @@ D3DXVECTOR4* WINAPI D3DXVec2TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec2_transform_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec2Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1728,6 +2040,9 @@ D3DXVECTOR2* WINAPI D3DXVec2TransformCoordArray(D3DXVECTOR2* out, UINT outstride
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec2_transform_coord_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec2TransformCoord(
             (D3DXVECTOR2*)((char*)out + outstride * i),
@@ -1754,6 +2069,9 @@ D3DXVECTOR2* WINAPI D3DXVec2TransformNormalArray(D3DXVECTOR2* out, UINT outstrid
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec2_transform_normal_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec2TransformNormal(
             (D3DXVECTOR2*)((char*)out + outstride * i),
@@ -1825,40 +2143,66 @@ D3DXVECTOR3* WINAPI D3DXVec3Normalize(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv)
     return pout;
 }
 
+static void d3dx_get_projection_matrix(D3DXMATRIX *m, const D3DXMATRIX *projection, const D3DXMATRIX *view,
+        const D3DXMATRIX *world)
+{
+    D3DXMatrixIdentity(m);
+    if (world)
+        D3DXMatrixMultiply(m, m, world);
+    if (view)
+        D3DXMatrixMultiply(m, m, view);
+    if (projection)
+        D3DXMatrixMultiply(m, m, projection);
+}
+
+static void d3dx_project_viewport(D3DXVECTOR3 *out, const D3DVIEWPORT9 *viewport)
+{
+    out->x = viewport->X + (1.0f + out->x) * viewport->Width / 2.0f;
+    out->y = viewport->Y + (1.0f - out->y) * viewport->Height / 2.0f;
+    out->z = viewport->MinZ + out->z * (viewport->MaxZ - viewport->MinZ);
+}
+
 D3DXVECTOR3* WINAPI D3DXVec3Project(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv, const D3DVIEWPORT9 *pviewport, const D3DXMATRIX *pprojection, const D3DXMATRIX *pview, const D3DXMATRIX *pworld)
 {
     D3DXMATRIX m;
 
     TRACE("pout %p, pv %p, pviewport %p, pprojection %p, pview %p, pworld %p\n", pout, pv, pviewport, pprojection, pview, pworld);
 
-    D3DXMatrixIdentity(&m);
-    if (pworld) D3DXMatrixMultiply(&m, &m, pworld);
-    if (pview) D3DXMatrixMultiply(&m, &m, pview);
-    if (pprojection) D3DXMatrixMultiply(&m, &m, pprojection);
-
+    d3dx_get_projection_matrix(&m, pprojection, pview, pworld);
     D3DXVec3TransformCoord(pout, pv, &m);
 
     if (pviewport)
-    {
-        pout->x = pviewport->X +  ( 1.0f + pout->x ) * pviewport->Width / 2.0f;
-        pout->y = pviewport->Y +  ( 1.0f - pout->y ) * pviewport->Height / 2.0f;
-        pout->z = pviewport->MinZ + pout->z * ( pviewport->MaxZ - pviewport->MinZ );
-    }
+        d3dx_project_viewport(pout, pviewport);
     return pout;
 }
 
 D3DXVECTOR3* WINAPI D3DXVec3ProjectArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DVIEWPORT9* viewport, const D3DXMATRIX* projection, const D3DXMATRIX* view, const D3DXMATRIX* world, UINT elements)
 {
+    D3DXMATRIX m;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, viewport %p, projection %p, view %p, world %p, elements %u\n",
         out, outstride, in, instride, viewport, projection, view, world, elements);
 
+    /* The combined matrix is the same for every element. */
+    d3dx_get_projection_matrix(&m, projection, view, world);
+
+    if (d3dx_transform_array(out, outstride, in, instride, &m, elements, &vec3_transform_coord_desc))
+    {
+        if (viewport)
+        {
+            for (i = 0; i < elements; ++i)
+                d3dx_project_viewport((D3DXVECTOR3*)((char*)out + outstride * i), viewport);
+        }
+        return out;
+    }
+
     for (i = 0; i < elements; ++i) {
-        D3DXVec3Project(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            viewport, projection, view, world);
+        D3DXVECTOR3 *pout = (D3DXVECTOR3*)((char*)out + outstride * i);
+
+        D3DXVec3TransformCoord(pout, (const D3DXVECTOR3*)((const char*)in + instride * i), &m);
+        if (viewport)
+            d3dx_project_viewport(pout, viewport);
     }
     return out;
 }
@@ -1883,6 +2227,9 @@ D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec3_transform_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1916,6 +2263,9 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec3_transform_coord_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformCoord(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -1944,6 +2294,9 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformNormalArray(D3DXVECTOR3* out, UINT outstrid
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec3_transform_normal_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformNormal(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -1953,6 +2306,18 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformNormalArray(D3DXVECTOR3* out, UINT outstrid
     return out;
 }
 
+static void d3dx_unproject(D3DXVECTOR3 *out, const D3DXVECTOR3 *v, const D3DVIEWPORT9 *viewport, const D3DXMATRIX *m)
+{
+    *out = *v;
+    if (viewport)
+    {
+        out->x = 2.0f * (out->x - viewport->X) / viewport->Width - 1.0f;
+        out->y = 1.0f - 2.0f * (out->y - viewport->Y) / viewport->Height;
+        out->z = (out->z - viewport->MinZ) / (viewport->MaxZ - viewport->MinZ);
+    }
+    D3DXVec3TransformCoord(out, out, m);
+}
+
 D3DXVECTOR3 * WINAPI D3DXVec3Unproject(D3DXVECTOR3 *out, const D3DXVECTOR3 *v,
         const D3DVIEWPORT9 *viewport, const D3DXMATRIX *projection, const D3DXMATRIX *view,
         const D3DXMATRIX *world)
@@ -1962,38 +2327,30 @@ D3DXVECTOR3 * WINAPI D3DXVec3Unproject(D3DXVECTOR3 *out, const D3DXVECTOR3 *v,
     TRACE("out %p, v %p, viewport %p, projection %p, view %p, world %p.\n",
             out, v, viewport, projection, view, world);
 
-    D3DXMatrixIdentity(&m);
-    if (world)
-        D3DXMatrixMultiply(&m, &m, world);
-    if (view)
-        D3DXMatrixMultiply(&m, &m, view);
-    if (projection)
-        D3DXMatrixMultiply(&m, &m, projection);
+    d3dx_get_projection_matrix(&m, projection, view, world);
     D3DXMatrixInverse(&m, NULL, &m);
 
-    *out = *v;
-    if (viewport)
-    {
-        out->x = 2.0f * (out->x - viewport->X) / viewport->Width - 1.0f;
-        out->y = 1.0f - 2.0f * (out->y - viewport->Y) / viewport->Height;
-        out->z = (out->z - viewport->MinZ) / (viewport->MaxZ - viewport->MinZ);
-    }
-    D3DXVec3TransformCoord(out, out, &m);
+    d3dx_unproject(out, v, viewport, &m);
     return out;
 }
 
 D3DXVECTOR3* WINAPI D3DXVec3UnprojectArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DVIEWPORT9* viewport, const D3DXMATRIX* projection, const D3DXMATRIX* view, const D3DXMATRIX* world, UINT elements)
 {
+    D3DXMATRIX m;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, viewport %p, projection %p, view %p, world %p, elements %u\n",
         out, outstride, in, instride, viewport, projection, view, world, elements);
 
+    /* Invert the combined matrix once rather than once per element. */
+    d3dx_get_projection_matrix(&m, projection, view, world);
+    D3DXMatrixInverse(&m, NULL, &m);
+
     for (i = 0; i < elements; ++i) {
-        D3DXVec3Unproject(
+        d3dx_unproject(
             (D3DXVECTOR3*)((char*)out + outstride * i),
             (const D3DXVECTOR3*)((const char*)in + instride * i),
-            viewport, projection, view, world);
+            viewport, &m);
     }
     return out;
 }
@@ -2090,6 +2447,9 @@ D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_transform_array(out, outstride, in, instride, matrix, elements, &vec4_transform_desc))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec4Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
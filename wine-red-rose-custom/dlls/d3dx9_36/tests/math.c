@@ -4582,6 +4582,69 @@ static void test_D3DXSHProjectCubeMap(void)
     DestroyWindow(window);
 }
 
+static void test_transform_performance(void)
+{
+    static const unsigned int count = 1 << 20, iterations = 16;
+    LARGE_INTEGER frequency, start, end;
+    D3DXVECTOR4 *in, *out;
+    D3DXMATRIX mat, mat2, res;
+    unsigned int i, j;
+
+    if (!winetest_interactive)
+    {
+        skip("Skipping math performance tests.\n");
+        return;
+    }
+
+    in = malloc(count * sizeof(*in));
+    out = malloc(count * sizeof(*out));
+    for (i = 0; i < count; ++i)
+    {
+        in[i].x = i * 0.5f;
+        in[i].y = -(float)i;
+        in[i].z = 1.0f / (i + 1);
+        in[i].w = 1.0f;
+    }
+    D3DXMatrixPerspectiveFovLH(&mat, D3DX_PI / 4.0f, 4.0f / 3.0f, 1.0f, 1000.0f);
+    D3DXMatrixRotationYawPitchRoll(&mat2, 0.1f, 0.2f, 0.3f);
+
+    QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&start);
+    for (j = 0; j < iterations; ++j)
+    {
+        for (i = 0; i < count; ++i)
+            D3DXVec3TransformCoord((D3DXVECTOR3 *)&out[i], (D3DXVECTOR3 *)&in[i], &mat);
+    }
+    QueryPerformanceCounter(&end);
+    trace("D3DXVec3TransformCoord: %.1f Mvectors/s.\n",
+            (double)count * iterations * frequency.QuadPart / (end.QuadPart - start.QuadPart) / 1e6);
+
+    QueryPerformanceCounter(&start);
+    for (j = 0; j < iterations; ++j)
+        D3DXVec3TransformCoordArray((D3DXVECTOR3 *)out, sizeof(*out), (D3DXVECTOR3 *)in, sizeof(*in), &mat, count);
+    QueryPerformanceCounter(&end);
+    trace("D3DXVec3TransformCoordArray: %.1f Mvectors/s.\n",
+            (double)count * iterations * frequency.QuadPart / (end.QuadPart - start.QuadPart) / 1e6);
+
+    QueryPerformanceCounter(&start);
+    for (j = 0; j < iterations; ++j)
+        D3DXVec4TransformArray(out, sizeof(*out), in, sizeof(*in), &mat, count);
+    QueryPerformanceCounter(&end);
+    trace("D3DXVec4TransformArray: %.1f Mvectors/s.\n",
+            (double)count * iterations * frequency.QuadPart / (end.QuadPart - start.QuadPart) / 1e6);
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; ++i)
+        D3DXMatrixMultiply(&res, &mat2, &mat);
+    QueryPerformanceCounter(&end);
+    trace("D3DXMatrixMultiply: %.1f Mmatrices/s.\n",
+            (double)count * frequency.QuadPart / (end.QuadPart - start.QuadPart) / 1e6);
+
+    free(out);
+    free(in);
+}
+
 START_TEST(math)
 {
     D3DXColorTest();
@@ -4612,4 +4675,5 @@ START_TEST(math)
     test_D3DXSHRotateZ();
     test_D3DXSHScale();
     test_D3DXSHProjectCubeMap();
+    test_transform_performance();
 }
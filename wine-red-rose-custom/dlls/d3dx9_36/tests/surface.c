@@ -2665,6 +2665,69 @@ static void test_D3DXSaveSurfaceToFile(IDirect3DDevice9 *device)
     IDirect3DSurface9_Release(surface);
 }
 
+static void test_load_surface_performance(IDirect3DDevice9 *device)
+{
+    static const struct
+    {
+        const char *name;
+        D3DFORMAT src_format;
+        D3DFORMAT dst_format;
+    }
+    tests[] =
+    {
+        {"A8R8G8B8 -> X8B8G8R8", D3DFMT_A8R8G8B8, D3DFMT_X8B8G8R8},
+        {"A8R8G8B8 -> DXT1",     D3DFMT_A8R8G8B8, D3DFMT_DXT1},
+        {"A8R8G8B8 -> DXT5",     D3DFMT_A8R8G8B8, D3DFMT_DXT5},
+        {"DXT5 -> A8R8G8B8",     D3DFMT_DXT5,     D3DFMT_A8R8G8B8},
+    };
+    static const unsigned int size = 4096;
+    LARGE_INTEGER frequency, start, end;
+    IDirect3DSurface9 *src, *dst;
+    D3DLOCKED_RECT lock_rect;
+    unsigned int i, x, y;
+    HRESULT hr;
+
+    if (!winetest_interactive)
+    {
+        skip("Skipping surface load performance test.\n");
+        return;
+    }
+
+    QueryPerformanceFrequency(&frequency);
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        winetest_push_context("Test %s", tests[i].name);
+
+        hr = IDirect3DDevice9_CreateOffscreenPlainSurface(device, size, size, tests[i].src_format,
+                D3DPOOL_SCRATCH, &src, NULL);
+        ok(hr == D3D_OK, "Got unexpected hr %#lx.\n", hr);
+        hr = IDirect3DDevice9_CreateOffscreenPlainSurface(device, size, size, tests[i].dst_format,
+                D3DPOOL_SCRATCH, &dst, NULL);
+        ok(hr == D3D_OK, "Got unexpected hr %#lx.\n", hr);
+
+        hr = IDirect3DSurface9_LockRect(src, &lock_rect, NULL, 0);
+        ok(hr == D3D_OK, "Got unexpected hr %#lx.\n", hr);
+        for (y = 0; y < (tests[i].src_format == D3DFMT_DXT5 ? size / 4 : size); ++y)
+        {
+            DWORD *row = (DWORD *)((BYTE *)lock_rect.pBits + y * lock_rect.Pitch);
+
+            for (x = 0; x < size; ++x)
+                row[x] = (x * 0x10203) ^ (y * 0x30201) ^ 0x80000000;
+        }
+        IDirect3DSurface9_UnlockRect(src);
+
+        QueryPerformanceCounter(&start);
+        hr = D3DXLoadSurfaceFromSurface(dst, NULL, NULL, src, NULL, NULL, D3DX_FILTER_NONE, 0);
+        QueryPerformanceCounter(&end);
+        ok(hr == D3D_OK, "Got unexpected hr %#lx.\n", hr);
+        trace("%ux%u: %.3f ms.\n", size, size, (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart);
+
+        IDirect3DSurface9_Release(dst);
+        IDirect3DSurface9_Release(src);
+        winetest_pop_context();
+    }
+}
+
 START_TEST(surface)
 {
     HWND wnd;
@@ -2701,6 +2764,7 @@ START_TEST(surface)
     test_D3DXLoadSurface(device);
     test_D3DXSaveSurfaceToFileInMemory(device);
     test_D3DXSaveSurfaceToFile(device);
+    test_load_surface_performance(device);
 
     check_release((IUnknown*)device, 0);
     check_release((IUnknown*)d3d, 0);
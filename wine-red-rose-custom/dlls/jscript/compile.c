@@ -414,6 +414,41 @@ static HRESULT push_instr_uint(compiler_ctx_t *ctx, jsop_t op, unsigned arg)
     return S_OK;
 }
 
+static HRESULT alloc_instr_cache(compiler_ctx_t *ctx, unsigned flags, unsigned *ret)
+{
+    instr_cache_t *cache;
+
+    if(ctx->code->caches_size == ctx->code->cache_cnt) {
+        unsigned new_size = ctx->code->caches_size ? ctx->code->caches_size*2 : 8;
+        instr_cache_t *new_caches;
+
+        new_caches = realloc(ctx->code->caches, new_size*sizeof(*new_caches));
+        if(!new_caches)
+            return E_OUTOFMEMORY;
+
+        ctx->code->caches = new_caches;
+        ctx->code->caches_size = new_size;
+    }
+
+    cache = ctx->code->caches + ctx->code->cache_cnt;
+    memset(cache, 0, sizeof(*cache));
+    cache->flags = flags;
+    *ret = ctx->code->cache_cnt++;
+    return S_OK;
+}
+
+static HRESULT push_instr_bstr_cache(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg, unsigned flags)
+{
+    unsigned cache;
+    HRESULT hres;
+
+    hres = alloc_instr_cache(ctx, flags, &cache);
+    if(FAILED(hres))
+        return hres;
+
+    return push_instr_bstr_uint(ctx, op, arg, cache);
+}
+
 static HRESULT compile_binary_expression(compiler_ctx_t *ctx, binary_expression_t *expr, jsop_t op)
 {
     HRESULT hres;
@@ -449,7 +484,7 @@ static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_
     if(FAILED(hres))
         return hres;
 
-    return push_instr_bstr(ctx, OP_member, expr->identifier);
+    return push_instr_bstr_cache(ctx, OP_member, expr->identifier, 0);
 }
 
 #define LABEL_FLAG 0x80000000
@@ -518,7 +553,7 @@ static HRESULT emit_identifier_ref(compiler_ctx_t *ctx, const WCHAR *identifier,
     int local_ref;
     if(bind_local(ctx, identifier, &local_ref))
         return push_instr_int(ctx, OP_local_ref, local_ref);
-    return push_instr_bstr_uint(ctx, OP_identid, identifier, flags);
+    return push_instr_bstr_cache(ctx, OP_identid, identifier, flags);
 }
 
 static HRESULT emit_identifier(compiler_ctx_t *ctx, const WCHAR *identifier)
@@ -526,7 +561,7 @@ static HRESULT emit_identifier(compiler_ctx_t *ctx, const WCHAR *identifier)
     int local_ref;
     if(bind_local(ctx, identifier, &local_ref))
         return push_instr_int(ctx, OP_local, local_ref);
-    return push_instr_bstr(ctx, OP_ident, identifier);
+    return push_instr_bstr_cache(ctx, OP_ident, identifier, 0);
 }
 
 static HRESULT emit_member_expression(compiler_ctx_t *ctx, expression_t *expr)
@@ -588,6 +623,7 @@ static void pop_compiler_statement_ctx(compiler_ctx_t *ctx, statement_ctx_t *sta
 
 static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *expr, unsigned flags)
 {
+    unsigned instr, cache;
     HRESULT hres;
 
     if(expr->type == EXPR_IDENT) {
@@ -599,7 +635,17 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
     if(FAILED(hres))
         return hres;
 
-    return push_instr_uint(ctx, OP_memberid, flags);
+    hres = alloc_instr_cache(ctx, 0, &cache);
+    if(FAILED(hres))
+        return hres;
+
+    instr = push_instr(ctx, OP_memberid);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].uint = flags;
+    instr_ptr(ctx, instr)->u.arg[1].uint = cache;
+    return S_OK;
 }
 
 static HRESULT compile_increment_expression(compiler_ctx_t *ctx, unary_expression_t *expr, jsop_t op, int n)
@@ -2467,6 +2513,10 @@ void release_bytecode(bytecode_t *code)
         SysFreeString(code->bstr_pool[i]);
     for(i=0; i < code->str_cnt; i++)
         jsstr_release(code->str_pool[i]);
+    for(i=0; i < code->cache_cnt; i++) {
+        if(code->caches[i].name)
+            jsstr_release(code->caches[i].name);
+    }
 
     if(code->named_item)
         release_named_item(code->named_item);
@@ -2474,6 +2524,7 @@ void release_bytecode(bytecode_t *code)
     heap_pool_free(&code->heap);
     free(code->bstr_pool);
     free(code->str_pool);
+    free(code->caches);
     free(code->instrs);
     free(code);
 }
@@ -25,6 +25,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(jscript);
+WINE_DECLARE_DEBUG_CHANNEL(jsgc);
 
 static const GUID GUID_JScriptTypeInfo = {0xc59c6b12,0xf6c1,0x11cf,{0x88,0x35,0x00,0xa0,0xc9,0x11,0xe8,0xb2}};
 
@@ -211,6 +212,119 @@ static inline unsigned get_props_idx(jsdisp_t *This, unsigned hash)
     return (hash*GOLDEN_RATIO) & (This->buf_size-1);
 }
 
+/*
+ * Objects which got the same property names allocated in the same order share
+ * a shape. Since a property never changes its slot in the props array, a shape
+ * and a name are enough to know the DISPID without hashing the name, which is
+ * what the interpreter's inline caches rely on. Objects with many properties
+ * don't share shapes; they get a new unique shape id whenever a property is
+ * allocated instead. Shape ids are unique across script contexts.
+ */
+#define SHAPE_MAX_PROPS  64
+#define SHAPE_MAX_COUNT  0x10000
+
+struct shape {
+    struct shape *parent;
+    struct shape *next;
+    UINT64 id;
+    unsigned hash;
+    WCHAR name[1];
+};
+
+static LONG64 last_shape_id;
+
+static inline unsigned get_shape_bucket(script_ctx_t *ctx, struct shape *parent, unsigned hash)
+{
+    return ((unsigned)((ULONG_PTR)parent >> 4) ^ hash) * GOLDEN_RATIO & (ctx->shapes_size - 1);
+}
+
+static HRESULT resize_shapes(script_ctx_t *ctx)
+{
+    struct shape **shapes, *shape, *next;
+    unsigned i, bucket, old_size = ctx->shapes_size;
+
+    shapes = calloc(old_size ? old_size * 2 : 64, sizeof(*shapes));
+    if(!shapes)
+        return E_OUTOFMEMORY;
+    ctx->shapes_size = old_size ? old_size * 2 : 64;
+
+    for(i = 0; i < old_size; i++) {
+        for(shape = ctx->shapes[i]; shape; shape = next) {
+            next = shape->next;
+            bucket = get_shape_bucket(ctx, shape->parent, shape->hash);
+            shape->next = shapes[bucket];
+            shapes[bucket] = shape;
+        }
+    }
+
+    free(ctx->shapes);
+    ctx->shapes = shapes;
+    return S_OK;
+}
+
+static struct shape *get_shape_transition(script_ctx_t *ctx, struct shape *parent, dispex_prop_t *prop)
+{
+    struct shape *shape;
+    unsigned bucket;
+    size_t len;
+
+    if(ctx->shapes_size) {
+        for(shape = ctx->shapes[get_shape_bucket(ctx, parent, prop->hash)]; shape; shape = shape->next) {
+            if(shape->parent == parent && shape->hash == prop->hash && !wcscmp(shape->name, prop->name))
+                return shape;
+        }
+    }
+
+    if(ctx->shapes_cnt >= SHAPE_MAX_COUNT)
+        return NULL;
+    if(ctx->shapes_cnt == ctx->shapes_size && FAILED(resize_shapes(ctx)))
+        return NULL;
+
+    len = wcslen(prop->name);
+    shape = malloc(offsetof(struct shape, name[len + 1]));
+    if(!shape)
+        return NULL;
+    shape->parent = parent;
+    shape->id = InterlockedIncrement64(&last_shape_id);
+    shape->hash = prop->hash;
+    memcpy(shape->name, prop->name, (len + 1) * sizeof(WCHAR));
+
+    bucket = get_shape_bucket(ctx, parent, prop->hash);
+    shape->next = ctx->shapes[bucket];
+    ctx->shapes[bucket] = shape;
+    ctx->shapes_cnt++;
+    return shape;
+}
+
+/* called after prop was appended to This->props */
+static void update_shape(jsdisp_t *This, dispex_prop_t *prop)
+{
+    struct shape *shape = NULL;
+
+    /* objects without a shape, but with properties, stay unique */
+    if((This->shape || This->prop_cnt == 1) && This->prop_cnt <= SHAPE_MAX_PROPS)
+        shape = get_shape_transition(This->ctx, This->shape, prop);
+
+    This->shape = shape;
+    This->shape_id = shape ? shape->id : InterlockedIncrement64(&last_shape_id);
+}
+
+void release_shapes(script_ctx_t *ctx)
+{
+    struct shape *shape, *next;
+    unsigned i;
+
+    for(i = 0; i < ctx->shapes_size; i++) {
+        for(shape = ctx->shapes[i]; shape; shape = next) {
+            next = shape->next;
+            free(shape);
+        }
+    }
+    free(ctx->shapes);
+    ctx->shapes = NULL;
+    ctx->shapes_size = ctx->shapes_cnt = 0;
+}
+
 static inline HRESULT resize_props(jsdisp_t *This)
 {
     dispex_prop_t *props;
@@ -260,6 +374,8 @@ static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_
     bucket = get_props_idx(This, prop->hash);
     prop->bucket_next = This->props[bucket].bucket_head;
     This->props[bucket].bucket_head = This->prop_cnt++;
+
+    update_shape(This, prop);
     return prop;
 }
 
@@ -1020,7 +1136,21 @@ static void unlink_jsdisp(jsdisp_t *jsdisp)
  * This collection process has to be done periodically, but can be pretty expensive so there
  * has to be a balance between reclaiming dangling objects and performance.
  *
+ * To keep the pauses short, objects are split in two generations. New objects go to the young
+ * generation, and every GC_YOUNG_ALLOCS allocations a young collection runs the same passes on
+ * the young objects alone. Only links between young objects are speculatively released, so any
+ * ref held by an old object counts as an "external ref" there. The refcounts themselves thus
+ * record all old-to-young pointers, and no write barrier is needed. Young objects surviving the
+ * collection are promoted to the old generation. Dangling cycles that involve old objects are
+ * left to full collections, which run on a timer once enough objects got promoted, and when
+ * requested explicitly (CollectGarbage, closing the script).
+ *
  */
+#define GC_YOUNG_ALLOCS         8192
+#define GC_FULL_INTERVAL        30000   /* ms */
+#define GC_FULL_MAX_INTERVAL    300000  /* ms */
+#define GC_FULL_PROMOTED        1024
+
 struct gc_stack_chunk {
     jsdisp_t *objects[1020];
     struct gc_stack_chunk *prev;
@@ -1065,7 +1195,27 @@ static jsdisp_t *gc_stack_pop(struct gc_ctx *gc_ctx)
     return obj;
 }
 
-HRESULT gc_run(script_ctx_t *ctx)
+static BOOL gc_full_needed(struct thread_data *thread_data)
+{
+    DWORD elapsed = GetTickCount() - thread_data->gc_last_tick;
+
+    /* Young collections take care of short-lived garbage. Unless much got promoted since, the
+       old generation is only checked once in a while. */
+    if(elapsed > GC_FULL_MAX_INTERVAL)
+        return TRUE;
+    return elapsed > GC_FULL_INTERVAL && thread_data->gc_promoted >= GC_FULL_PROMOTED;
+}
+
+static void gc_clear_marks(struct list *objects)
+{
+    jsdisp_t *obj;
+
+    LIST_FOR_EACH_ENTRY(obj, objects, jsdisp_t, entry)
+        obj->gc_marked = FALSE;
+}
+
+/* Runs the collection on the given list of objects, see the comment above. */
+static HRESULT gc_collect(struct thread_data *thread_data, struct list *objects, unsigned *survivors)
 {
     /* Save original refcounts in a linked list of chunks */
     struct chunk
@@ -1073,7 +1223,6 @@ HRESULT gc_run(script_ctx_t *ctx)
         struct chunk *next;
         LONG ref[1020];
     } *head, *chunk;
-    struct thread_data *thread_data = ctx->thread_data;
     jsdisp_t *obj, *obj2, *link, *link2;
     dispex_prop_t *prop, *props_end;
     struct gc_ctx gc_ctx = { 0 };
@@ -1081,21 +1230,16 @@ HRESULT gc_run(script_ctx_t *ctx)
     HRESULT hres = S_OK;
     struct list *iter;
 
-    /* Prevent recursive calls from side-effects during unlinking (e.g. CollectGarbage from host object's Release) */
-    if(thread_data->gc_is_unlinking)
-        return S_OK;
-
-    thread_data->gc_is_unlinking = TRUE;
-    cc_api.collect();
-    thread_data->gc_is_unlinking = FALSE;
+    *survivors = 0;
 
     if(!(head = malloc(sizeof(*head))))
         return E_OUTOFMEMORY;
     head->next = NULL;
     chunk = head;
 
-    /* 1. Save actual refcounts and decrease them speculatively as-if we unlinked the objects */
-    LIST_FOR_EACH_ENTRY(obj, &thread_data->objects, jsdisp_t, entry) {
+    /* 1. Save actual refcounts and decrease them speculatively as-if we unlinked the objects.
+          Only links to objects in the list (which are marked first) are taken into account. */
+    LIST_FOR_EACH_ENTRY(obj, objects, jsdisp_t, entry) {
         if(chunk_idx == ARRAY_SIZE(chunk->ref)) {
             if(!(chunk->next = malloc(sizeof(*chunk)))) {
                 do {
@@ -1103,24 +1247,26 @@ HRESULT gc_run(script_ctx_t *ctx)
                     free(head);
                     head = chunk;
                 } while(head);
+                gc_clear_marks(objects);
                 return E_OUTOFMEMORY;
             }
             chunk = chunk->next; chunk_idx = 0;
             chunk->next = NULL;
         }
         chunk->ref[chunk_idx++] = obj->ref;
+        obj->gc_marked = TRUE;
     }
-    LIST_FOR_EACH_ENTRY(obj, &thread_data->objects, jsdisp_t, entry) {
+    LIST_FOR_EACH_ENTRY(obj, objects, jsdisp_t, entry) {
         for(prop = obj->props, props_end = prop + obj->prop_cnt; prop < props_end; prop++) {
             switch(prop->type) {
             case PROP_JSVAL:
-                if(is_object_instance(prop->u.val) && (link = to_jsdisp(get_object(prop->u.val))))
+                if(is_object_instance(prop->u.val) && (link = to_jsdisp(get_object(prop->u.val))) && link->gc_marked)
                     link->ref--;
                 break;
             case PROP_ACCESSOR:
-                if(prop->u.accessor.getter)
+                if(prop->u.accessor.getter && prop->u.accessor.getter->gc_marked)
                     prop->u.accessor.getter->ref--;
-                if(prop->u.accessor.setter)
+                if(prop->u.accessor.setter && prop->u.accessor.setter->gc_marked)
                     prop->u.accessor.setter->ref--;
                 break;
             default:
@@ -1128,15 +1274,14 @@ HRESULT gc_run(script_ctx_t *ctx)
             }
         }
 
-        if(obj->prototype)
+        if(obj->prototype && obj->prototype->gc_marked)
             obj->prototype->ref--;
         if(obj->builtin_info->gc_traverse)
             obj->builtin_info->gc_traverse(&gc_ctx, GC_TRAVERSE_SPECULATIVELY, obj);
-        obj->gc_marked = TRUE;
     }
 
     /* 2. Clear mark on objects with non-zero "external refcount" and all objects accessible from them */
-    LIST_FOR_EACH_ENTRY(obj, &thread_data->objects, jsdisp_t, entry) {
+    LIST_FOR_EACH_ENTRY(obj, objects, jsdisp_t, entry) {
         if(!obj->gc_marked || (!obj->ref && !obj->proxy))
             continue;
 
@@ -1221,7 +1366,7 @@ HRESULT gc_run(script_ctx_t *ctx)
 
     /* Restore */
     chunk = head; chunk_idx = 0;
-    LIST_FOR_EACH_ENTRY(obj, &thread_data->objects, jsdisp_t, entry) {
+    LIST_FOR_EACH_ENTRY(obj, objects, jsdisp_t, entry) {
         obj->ref = chunk->ref[chunk_idx++];
         if(chunk_idx == ARRAY_SIZE(chunk->ref)) {
             struct chunk *next = chunk->next;
@@ -1231,35 +1376,127 @@ HRESULT gc_run(script_ctx_t *ctx)
     }
     free(chunk);
 
-    if(FAILED(hres))
+    if(FAILED(hres)) {
+        gc_clear_marks(objects);
         return hres;
+    }
 
     /* 3. Remove all the links from the marked objects, since they are dangling */
     thread_data->gc_is_unlinking = TRUE;
 
-    iter = list_head(&thread_data->objects);
+    iter = list_head(objects);
     while(iter) {
         obj = LIST_ENTRY(iter, jsdisp_t, entry);
         if(!obj->gc_marked) {
-            iter = list_next(&thread_data->objects, iter);
+            (*survivors)++;
+            iter = list_next(objects, iter);
             continue;
         }
 
         /* Grab it since it gets removed when unlinked */
         jsdisp_addref(obj);
         unlink_jsdisp(obj);
+        thread_data->gc_stats.collected++;
 
         /* Releasing unlinked object should not delete any other object,
            so we can safely obtain the next pointer now */
-        iter = list_next(&thread_data->objects, iter);
+        iter = list_next(objects, iter);
         jsdisp_release(obj);
     }
 
     thread_data->gc_is_unlinking = FALSE;
+    return S_OK;
+}
+
+static UINT64 gc_time(void)
+{
+    LARGE_INTEGER counter, freq;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&freq);
+    return counter.QuadPart * 1000000 / freq.QuadPart;
+}
+
+HRESULT gc_run(script_ctx_t *ctx)
+{
+    struct thread_data *thread_data = ctx->thread_data;
+    UINT64 start, pause;
+    unsigned survivors;
+    HRESULT hres;
+
+    /* Prevent recursive calls from side-effects during unlinking (e.g. CollectGarbage from host object's Release) */
+    if(thread_data->gc_is_unlinking)
+        return S_OK;
+
+    start = gc_time();
+
+    thread_data->gc_is_unlinking = TRUE;
+    cc_api.collect();
+    thread_data->gc_is_unlinking = FALSE;
+
+    /* A full collection covers both generations */
+    list_move_tail(&thread_data->objects, &thread_data->young_objects);
+    thread_data->gc_young_allocs = 0;
+
+    hres = gc_collect(thread_data, &thread_data->objects, &survivors);
+    if(FAILED(hres))
+        return hres;
+
+    thread_data->gc_promoted = 0;
     thread_data->gc_last_tick = GetTickCount();
+
+    pause = gc_time() - start;
+    thread_data->gc_stats.full_runs++;
+    thread_data->gc_stats.full_time += pause;
+    thread_data->gc_stats.max_full_pause = max(thread_data->gc_stats.max_full_pause, pause);
+    TRACE_(jsgc)("full collection: %u objects left, pause %I64u us\n", survivors, pause);
+    return S_OK;
+}
+
+HRESULT gc_run_young(script_ctx_t *ctx)
+{
+    struct thread_data *thread_data = ctx->thread_data;
+    UINT64 start, pause;
+    unsigned survivors;
+    HRESULT hres;
+
+    if(thread_data->gc_is_unlinking)
+        return S_OK;
+
+    start = gc_time();
+    thread_data->gc_young_allocs = 0;
+
+    hres = gc_collect(thread_data, &thread_data->young_objects, &survivors);
+    if(FAILED(hres))
+        return hres;
+
+    /* Everything still alive is promoted to the old generation */
+    list_move_tail(&thread_data->objects, &thread_data->young_objects);
+    thread_data->gc_promoted += survivors;
+
+    pause = gc_time() - start;
+    thread_data->gc_stats.young_runs++;
+    thread_data->gc_stats.promoted += survivors;
+    thread_data->gc_stats.young_time += pause;
+    thread_data->gc_stats.max_young_pause = max(thread_data->gc_stats.max_young_pause, pause);
+    TRACE_(jsgc)("young collection: %u objects promoted, pause %I64u us\n", survivors, pause);
     return S_OK;
 }
 
+void gc_trace_stats(struct thread_data *thread_data)
+{
+    const struct gc_stats *stats = &thread_data->gc_stats;
+
+    if(!TRACE_ON(jsgc))
+        return;
+
+    TRACE_(jsgc)("young collections: %u, total %I64u us, max pause %I64u us, %u objects promoted\n",
+                 stats->young_runs, stats->young_time, stats->max_young_pause, stats->promoted);
+    TRACE_(jsgc)("full collections: %u, total %I64u us, max pause %I64u us\n",
+                 stats->full_runs, stats->full_time, stats->max_full_pause);
+    TRACE_(jsgc)("%u objects collected\n", stats->collected);
+}
+
 HRESULT gc_process_linked_obj(struct gc_ctx *gc_ctx, enum gc_traverse_op op, jsdisp_t *obj, jsdisp_t *link, void **unlink_ref)
 {
     if(op == GC_TRAVERSE_UNLINK) {
@@ -1268,9 +1505,10 @@ HRESULT gc_process_linked_obj(struct gc_ctx *gc_ctx, enum gc_traverse_op op, jsd
         return S_OK;
     }
 
-    if(op == GC_TRAVERSE_SPECULATIVELY)
-        link->ref--;
-    else if(link->gc_marked)
+    if(op == GC_TRAVERSE_SPECULATIVELY) {
+        if(link->gc_marked)
+            link->ref--;
+    }else if(link->gc_marked)
         return gc_stack_push(gc_ctx, link);
     return S_OK;
 }
@@ -1288,9 +1526,10 @@ HRESULT gc_process_linked_val(struct gc_ctx *gc_ctx, enum gc_traverse_op op, jsd
 
     if(!is_object_instance(*link) || !(jsdisp = to_jsdisp(get_object(*link))))
         return S_OK;
-    if(op == GC_TRAVERSE_SPECULATIVELY)
-        jsdisp->ref--;
-    else if(jsdisp->gc_marked)
+    if(op == GC_TRAVERSE_SPECULATIVELY) {
+        if(jsdisp->gc_marked)
+            jsdisp->ref--;
+    }else if(jsdisp->gc_marked)
         return gc_stack_push(gc_ctx, jsdisp);
     return S_OK;
 }
@@ -2841,8 +3080,9 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
 {
     unsigned i;
 
-    /* FIXME: Use better heuristics to decide when to run the GC */
-    if(GetTickCount() - ctx->thread_data->gc_last_tick > 30000)
+    if(++ctx->thread_data->gc_young_allocs >= GC_YOUNG_ALLOCS)
+        gc_run_young(ctx);
+    else if(gc_full_needed(ctx->thread_data))
         gc_run(ctx);
 
     TRACE("%p (%p)\n", dispex, prototype);
@@ -2852,6 +3092,8 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     dispex->builtin_info = builtin_info;
     dispex->extensible = TRUE;
     dispex->prop_cnt = 0;
+    dispex->shape = NULL;
+    dispex->shape_id = 0;
 
     dispex->props = calloc(1, sizeof(dispex_prop_t)*(dispex->buf_size=4));
     if(!dispex->props)
@@ -2869,7 +3111,7 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     script_addref(ctx);
     dispex->ctx = ctx;
 
-    list_add_tail(&ctx->thread_data->objects, &dispex->entry);
+    list_add_tail(&ctx->thread_data->young_objects, &dispex->entry);
     return S_OK;
 }
 
@@ -3223,6 +3465,38 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+static inline BOOL is_cacheable(jsdisp_t *jsdisp)
+{
+    /* Typed Arrays check every index against their length in jsdisp_get_id */
+    return jsdisp->builtin_info->class < FIRST_TYPEDARRAY_JSCLASS || jsdisp->builtin_info->class > LAST_TYPEDARRAY_JSCLASS;
+}
+
+/* Like jsdisp_get_id, but skips the name lookup if the object has the shape the cache was filled with. */
+HRESULT jsdisp_get_cached_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, prop_cache_t *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(cache->shape && cache->shape == jsdisp->shape_id && is_cacheable(jsdisp)) {
+        prop = &jsdisp->props[cache->id - 1];
+        hres = fix_overridden_prop(jsdisp, prop);
+        if(FAILED(hres))
+            return hres;
+        fix_protref_prop(jsdisp, prop);
+        if(prop->type != PROP_DELETED) {
+            *id = cache->id;
+            return S_OK;
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres) && !(flags & fdexNameCaseInsensitive) && is_cacheable(jsdisp)) {
+        cache->shape = jsdisp->shape_id;
+        cache->id = *id;
+    }
+    return hres;
+}
+
 HRESULT jsdisp_get_idx_id(jsdisp_t *jsdisp, DWORD idx, DISPID *id)
 {
     WCHAR name[11];
@@ -648,6 +648,18 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
     return hres;
 }
 
+static HRESULT disp_get_cached_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags,
+        prop_cache_t *cache, DISPID *id)
+{
+    jsdisp_t *jsdisp;
+
+    jsdisp = to_jsdisp(disp);
+    if(jsdisp)
+        return jsdisp_get_cached_id(jsdisp, name, flags, cache, id);
+
+    return disp_get_id(ctx, disp, name, name_bstr, flags, id);
+}
+
 static HRESULT disp_cmp(IDispatch *disp1, IDispatch *disp2, BOOL *ret)
 {
     IObjectIdentity *identity;
@@ -890,7 +902,7 @@ local_ref_t *lookup_local(const function_code_t *function, const WCHAR *identifi
 }
 
 /* ECMA-262 3rd Edition    10.1.4 */
-static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *ret)
+static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, prop_cache_t *cache, exprval_t *ret)
 {
     scope_chain_t *scope;
     named_item_t *item;
@@ -959,7 +971,10 @@ static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *re
         }
     }
 
-    hres = jsdisp_get_id(ctx->global, identifier, 0, &id);
+    if(cache)
+        hres = jsdisp_get_cached_id(ctx->global, identifier, 0, cache, &id);
+    else
+        hres = jsdisp_get_id(ctx->global, identifier, 0, &id);
     if(SUCCEEDED(hres)) {
         exprval_set_disp_ref(ret, to_disp(ctx->global), id);
         return S_OK;
@@ -1004,6 +1019,12 @@ static inline jsstr_t *get_op_str(script_ctx_t *ctx, int i)
     return frame->bytecode->instrs[frame->ip].u.arg[i].str;
 }
 
+static inline instr_cache_t *get_op_cache(script_ctx_t *ctx, int i)
+{
+    call_frame_t *frame = ctx->call_ctx;
+    return frame->bytecode->caches + frame->bytecode->instrs[frame->ip].u.arg[i].uint;
+}
+
 static inline double get_op_double(script_ctx_t *ctx)
 {
     call_frame_t *frame = ctx->call_ctx;
@@ -1462,6 +1483,7 @@ static HRESULT interp_array(script_ctx_t *ctx)
 static HRESULT interp_member(script_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
+    instr_cache_t *cache = get_op_cache(ctx, 1);
     IDispatch *obj;
     jsval_t v;
     DISPID id;
@@ -1473,7 +1495,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_cached_id(ctx, obj, arg, arg, 0, &cache->prop, &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1491,6 +1513,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
 static HRESULT interp_memberid(script_ctx_t *ctx)
 {
     const unsigned arg = get_op_uint(ctx, 0);
+    instr_cache_t *cache = get_op_cache(ctx, 1);
     jsval_t objv, namev;
     const WCHAR *name;
     jsstr_t *name_str;
@@ -1515,7 +1538,15 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    if(cache->name != name_str) {
+        /* the cache was filled for another name, start over */
+        if(cache->name)
+            jsstr_release(cache->name);
+        cache->name = jsstr_addref(name_str);
+        cache->prop.shape = 0;
+    }
+
+    hres = disp_get_cached_id(ctx, obj, name, NULL, arg, &cache->prop, &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
@@ -1625,7 +1656,7 @@ static HRESULT interp_call_eval(script_ctx_t *ctx)
     TRACE("%d %d\n", argn, do_ret);
 
     identifier = SysAllocString(L"eval");
-    hres = identifier_eval(ctx, identifier, &exprval);
+    hres = identifier_eval(ctx, identifier, NULL, &exprval);
     SysFreeString(identifier);
     if(FAILED(hres))
         return hres;
@@ -1665,12 +1696,12 @@ static HRESULT interp_this(script_ctx_t *ctx)
     return stack_push(ctx, jsval_disp(this_obj));
 }
 
-static HRESULT interp_identifier_ref(script_ctx_t *ctx, BSTR identifier, unsigned flags)
+static HRESULT interp_identifier_ref(script_ctx_t *ctx, BSTR identifier, unsigned flags, prop_cache_t *cache)
 {
     exprval_t exprval;
     HRESULT hres;
 
-    hres = identifier_eval(ctx, identifier, &exprval);
+    hres = identifier_eval(ctx, identifier, cache, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -1698,13 +1729,13 @@ static HRESULT interp_identifier_ref(script_ctx_t *ctx, BSTR identifier, unsigne
     return stack_push_exprval(ctx, &exprval);
 }
 
-static HRESULT identifier_value(script_ctx_t *ctx, BSTR identifier)
+static HRESULT identifier_value(script_ctx_t *ctx, BSTR identifier, prop_cache_t *cache)
 {
     exprval_t exprval;
     jsval_t v;
     HRESULT hres;
 
-    hres = identifier_eval(ctx, identifier, &exprval);
+    hres = identifier_eval(ctx, identifier, cache, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -1728,7 +1759,7 @@ static HRESULT interp_local_ref(script_ctx_t *ctx)
     TRACE("%s\n", debugstr_w(local_name(frame, arg)));
 
     if(!frame->base_scope || !frame->base_scope->frame)
-        return interp_identifier_ref(ctx, local_name(frame, arg), flags);
+        return interp_identifier_ref(ctx, local_name(frame, arg), flags, NULL);
 
     ref.type = EXPRVAL_STACK_REF;
     ref.u.off = local_off(frame, arg);
@@ -1744,7 +1775,7 @@ static HRESULT interp_local(script_ctx_t *ctx)
 
     if(!frame->base_scope || !frame->base_scope->frame) {
         TRACE("%s\n", debugstr_w(local_name(frame, arg)));
-        return identifier_value(ctx, local_name(frame, arg));
+        return identifier_value(ctx, local_name(frame, arg), NULL);
     }
 
     hres = jsval_copy(ctx->stack[local_off(frame, arg)], &copy);
@@ -1759,21 +1790,22 @@ static HRESULT interp_local(script_ctx_t *ctx)
 static HRESULT interp_ident(script_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
+    instr_cache_t *cache = get_op_cache(ctx, 1);
 
     TRACE("%s\n", debugstr_w(arg));
 
-    return identifier_value(ctx, arg);
+    return identifier_value(ctx, arg, &cache->prop);
 }
 
 /* ECMA-262 3rd Edition    10.1.4 */
 static HRESULT interp_identid(script_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
-    const unsigned flags = get_op_uint(ctx, 1);
+    instr_cache_t *cache = get_op_cache(ctx, 1);
 
-    TRACE("%s %x\n", debugstr_w(arg), flags);
+    TRACE("%s %x\n", debugstr_w(arg), cache->flags);
 
-    return interp_identifier_ref(ctx, arg, flags);
+    return interp_identifier_ref(ctx, arg, cache->flags, &cache->prop);
 }
 
 /* ECMA-262 3rd Edition    7.8.1 */
@@ -2314,7 +2346,7 @@ static HRESULT interp_delete_ident(script_ctx_t *ctx)
 
     TRACE("%s\n", debugstr_w(arg));
 
-    hres = identifier_eval(ctx, arg, &exprval);
+    hres = identifier_eval(ctx, arg, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -2424,7 +2456,7 @@ static HRESULT interp_typeofident(script_ctx_t *ctx)
 
     TRACE("%s\n", debugstr_w(arg));
 
-    hres = identifier_eval(ctx, arg, &exprval);
+    hres = identifier_eval(ctx, arg, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -3336,7 +3368,7 @@ static HRESULT bind_event_target(script_ctx_t *ctx, function_code_t *func, jsdis
     jsval_t v;
     HRESULT hres;
 
-    hres = identifier_eval(ctx, func->event_target, &exprval);
+    hres = identifier_eval(ctx, func->event_target, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -44,8 +44,8 @@
     X(func,       1, ARG_UINT,   0)        \
     X(gt,         1, 0,0)                  \
     X(gteq,       1, 0,0)                  \
-    X(ident,      1, ARG_BSTR,   0)        \
-    X(identid,    1, ARG_BSTR,   ARG_INT)  \
+    X(ident,      1, ARG_BSTR,   ARG_UINT) \
+    X(identid,    1, ARG_BSTR,   ARG_UINT) \
     X(in,         1, 0,0)                  \
     X(instanceof, 1, 0,0)                  \
     X(int,        1, ARG_INT,    0)        \
@@ -56,8 +56,8 @@
     X(lshift,     1, 0,0)                  \
     X(lt,         1, 0,0)                  \
     X(lteq,       1, 0,0)                  \
-    X(member,     1, ARG_BSTR,   0)        \
-    X(memberid,   1, ARG_UINT,   0)        \
+    X(member,     1, ARG_BSTR,   ARG_UINT) \
+    X(memberid,   1, ARG_UINT,   ARG_UINT) \
     X(minus,      1, 0,0)                  \
     X(mod,        1, 0,0)                  \
     X(mul,        1, 0,0)                  \
@@ -136,6 +136,14 @@ typedef struct {
     } u;
 } instr_t;
 
+/* Per-instruction property lookup cache, the last argument of member, memberid,
+ * ident and identid is its index in bytecode_t caches. */
+typedef struct {
+    prop_cache_t prop;
+    jsstr_t *name;   /* property name the cache was filled for (memberid) */
+    unsigned flags;  /* lookup flags (identid) */
+} instr_cache_t;
+
 typedef enum {
     PROPERTY_DEFINITION_VALUE,
     PROPERTY_DEFINITION_GETTER,
@@ -208,6 +216,10 @@ struct _bytecode_t {
     unsigned str_pool_size;
     unsigned str_cnt;
 
+    instr_cache_t *caches;
+    unsigned caches_size;
+    unsigned cache_cnt;
+
     struct list entry;
 };
 
@@ -152,7 +152,7 @@ typedef struct _script_ctx_t script_ctx_t;
 typedef struct _dispex_prop_t dispex_prop_t;
 typedef struct _property_desc_t property_desc_t;
 
-typedef struct {
+typedef struct heap_pool_t {
     void **blocks;
     DWORD block_cnt;
     DWORD last_block;
@@ -162,7 +162,7 @@ typedef struct {
 } heap_pool_t;
 
 void heap_pool_init(heap_pool_t*);
-void *heap_pool_alloc(heap_pool_t*,DWORD) __WINE_ALLOC_SIZE(2);
+void *heap_pool_alloc(heap_pool_t*,size_t) __WINE_ALLOC_SIZE(2);
 void *heap_pool_grow(heap_pool_t*,void*,DWORD,DWORD);
 void heap_pool_clear(heap_pool_t*);
 void heap_pool_free(heap_pool_t*);
@@ -247,14 +247,29 @@ typedef HRESULT (*builtin_setter_t)(script_ctx_t*,jsdisp_t*,jsval_t);
 
 HRESULT builtin_set_const(script_ctx_t*,jsdisp_t*,jsval_t);
 
+struct gc_stats {
+    unsigned young_runs;
+    unsigned full_runs;
+    unsigned collected;            /* objects unlinked as garbage */
+    unsigned promoted;             /* young objects that survived */
+    UINT64 young_time;             /* total pause times, in microseconds */
+    UINT64 full_time;
+    UINT64 max_young_pause;
+    UINT64 max_full_pause;
+};
+
 struct thread_data {
     LONG ref;
     LONG thread_id;
 
     BOOL gc_is_unlinking;
     DWORD gc_last_tick;
+    unsigned gc_young_allocs;      /* allocations since the last young collection */
+    unsigned gc_promoted;          /* promotions since the last full collection */
+    struct gc_stats gc_stats;
 
-    struct list objects;
+    struct list objects;           /* old generation */
+    struct list young_objects;     /* allocated since the last collection */
     struct rb_tree weak_refs;
 };
 
@@ -283,6 +298,8 @@ HRESULT create_named_item_script_obj(script_ctx_t*,named_item_t*);
 named_item_t *lookup_named_item(script_ctx_t*,const WCHAR*,unsigned);
 void release_named_item(named_item_t*);
 HRESULT gc_run(script_ctx_t*);
+HRESULT gc_run_young(script_ctx_t*);
+void gc_trace_stats(struct thread_data*);
 HRESULT gc_process_linked_obj(struct gc_ctx*,enum gc_traverse_op,jsdisp_t*,jsdisp_t*,void**);
 HRESULT gc_process_linked_val(struct gc_ctx*,enum gc_traverse_op,jsdisp_t*,jsval_t*);
 
@@ -325,6 +342,9 @@ struct jsdisp_t {
     jsdisp_t *prototype;
     IWineDispatchProxyPrivate *proxy;
 
+    struct shape *shape;
+    UINT64 shape_id;
+
     const builtin_info_t *builtin_info;
     struct list entry;
 };
@@ -367,6 +387,12 @@ void jsdisp_release(jsdisp_t*);
 
 #endif
 
+/* Inline cache entry used by the interpreter for jsdisp_get_cached_id */
+typedef struct {
+    UINT64 shape;
+    DISPID id;
+} prop_cache_t;
+
 enum jsdisp_enum_type {
     JSDISP_ENUM_ALL,
     JSDISP_ENUM_OWN,
@@ -376,6 +402,7 @@ enum jsdisp_enum_type {
 HRESULT create_dispex(script_ctx_t*,const builtin_info_t*,jsdisp_t*,jsdisp_t**);
 HRESULT init_dispex(jsdisp_t*,script_ctx_t*,const builtin_info_t*,jsdisp_t*);
 HRESULT init_dispex_from_constr(jsdisp_t*,script_ctx_t*,const builtin_info_t*,jsdisp_t*);
+void release_shapes(script_ctx_t*);
 HRESULT convert_to_proxy(script_ctx_t*,jsval_t*);
 void init_cc_api(IDispatch*);
 
@@ -397,6 +424,7 @@ HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*);
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*);
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*);
 HRESULT jsdisp_get_idx_id(jsdisp_t*,DWORD,DISPID*);
+HRESULT jsdisp_get_cached_id(jsdisp_t*,const WCHAR*,DWORD,prop_cache_t*,DISPID*);
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*);
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*);
 HRESULT jsdisp_delete_idx(jsdisp_t*,DWORD);
@@ -535,6 +563,12 @@ struct _script_ctx_t {
     unsigned stack_top;
     jsval_t acc;
 
+    struct shape **shapes;
+    unsigned shapes_size;
+    unsigned shapes_cnt;
+
+    struct regexp_cache *regexp_cache;
+
     jsstr_t *last_match;
     match_result_t match_parens[9];
     DWORD last_match_index;
@@ -621,6 +655,7 @@ struct match_state_t;
 HRESULT regexp_match_next(script_ctx_t*,jsdisp_t*,DWORD,jsstr_t*,struct match_state_t**);
 HRESULT parse_regexp_flags(const WCHAR*,DWORD,DWORD*);
 HRESULT regexp_string_match(script_ctx_t*,jsdisp_t*,jsstr_t*,jsval_t*);
+void release_regexp_cache(script_ctx_t*);
 
 BOOL bool_obj_value(jsdisp_t*);
 unsigned array_get_length(jsdisp_t*);
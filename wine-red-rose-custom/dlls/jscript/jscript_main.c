@@ -57,6 +57,7 @@ struct thread_data *get_thread_data(void)
             return NULL;
         thread_data->thread_id = GetCurrentThreadId();
         list_init(&thread_data->objects);
+        list_init(&thread_data->young_objects);
         rb_init(&thread_data->weak_refs, weak_refs_compare);
         TlsSetValue(jscript_tls, thread_data);
     }
@@ -70,6 +71,7 @@ void release_thread_data(struct thread_data *thread_data)
     if(--thread_data->ref)
         return;
 
+    gc_trace_stats(thread_data);
     free(thread_data);
     TlsSetValue(jscript_tls, NULL);
 }
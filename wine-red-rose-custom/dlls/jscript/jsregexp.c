@@ -550,7 +550,7 @@ static void RegExp_destructor(jsdisp_t *dispex)
     RegExpInstance *This = regexp_from_jsdisp(dispex);
 
     if(This->jsregexp)
-        regexp_destroy(This->jsregexp);
+        regexp_release(This->jsregexp);
     jsval_release(This->last_index_val);
     jsstr_release(This->str);
     free(This);
@@ -657,7 +657,8 @@ HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **r
     if(FAILED(hres))
         return hres;
 
-    regexp->jsregexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(regexp->str), flags, FALSE);
+    regexp->jsregexp = regexp_new_cached(&ctx->regexp_cache, ctx, &ctx->tmp_heap, str,
+            jsstr_length(regexp->str), flags);
     if(!regexp->jsregexp) {
         WARN("regexp_new failed\n");
         jsdisp_release(&regexp->dispex);
@@ -1027,3 +1028,25 @@ HRESULT parse_regexp_flags(const WCHAR *str, DWORD str_len, DWORD *ret)
     *ret = flags;
     return S_OK;
 }
+
+void regexp_report_error(void *cx, regexp_error_t error)
+{
+    script_ctx_t *ctx = cx;
+
+    switch(error) {
+    case REGEXP_ERROR_OUTOFMEMORY:
+        throw_error(ctx, E_OUTOFMEMORY, L"");
+        break;
+    case REGEXP_ERROR_BAD_QUANTIFIER:
+        throw_error(ctx, ctx->version < SCRIPTLANGUAGEVERSION_ES5 ? JS_E_REGEXP_SYNTAX : JS_E_UNEXPECTED_QUANTIFIER, L"");
+        break;
+    default:
+        throw_error(ctx, E_FAIL, L"");
+    }
+}
+
+void release_regexp_cache(script_ctx_t *ctx)
+{
+    regexp_cache_free(ctx->regexp_cache);
+    ctx->regexp_cache = NULL;
+}
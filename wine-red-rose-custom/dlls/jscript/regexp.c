@@ -31,21 +31,40 @@
  * the Initial Developer. All Rights Reserved.
  */
 
+/*
+ * This file is shared by jscript and vbscript (see PARENTSRC in
+ * dlls/vbscript/Makefile.in), so it must not depend on either of them.
+ * Errors are reported through regexp_report_error() and scratch memory
+ * comes from the caller's heap_pool_t, both provided by the embedding DLL.
+ */
+
 #include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <wchar.h>
+
+#include "windef.h"
+#include "winbase.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
 
-#include "jscript.h"
 #include "regexp.h"
 
 #include "wine/debug.h"
 
-WINE_DEFAULT_DEBUG_CHANNEL(jscript);
+WINE_DEFAULT_DEBUG_CHANNEL(regexp);
+
+typedef struct heap_pool_t heap_pool_t;
 
 /* FIXME: Better error handling */
-#define ReportRegExpError(a,b,c) throw_error((a)->context, E_FAIL, L"")
-#define ReportRegExpErrorHelper(a,b,c,d) throw_error((a)->context, E_FAIL, L"")
-#define JS_ReportErrorNumber(a,b,c,d) throw_error((a), E_FAIL, L"")
-#define JS_ReportErrorFlagsAndNumber(a,b,c,d,e,f) throw_error((a), E_FAIL, L"")
-#define JS_COUNT_OPERATION(a,b) throw_error((a), E_FAIL, L"")
+#define ReportRegExpError(a,b,c) regexp_report_error((a)->context, REGEXP_ERROR_FAIL)
+#define ReportRegExpErrorHelper(a,b,c,d) regexp_report_error((a)->context, REGEXP_ERROR_FAIL)
+#define JS_ReportErrorNumber(a,b,c,d) regexp_report_error((a), REGEXP_ERROR_FAIL)
+#define JS_ReportErrorFlagsAndNumber(a,b,c,d,e,f) regexp_report_error((a), REGEXP_ERROR_FAIL)
+#define JS_COUNT_OPERATION(a,b)
 
 
 typedef BYTE JSPackedBool;
@@ -290,7 +309,7 @@ struct RENode {
 #define CLASS_CACHE_SIZE    4
 
 typedef struct CompilerState {
-    script_ctx_t    *context;
+    void            *context;
     const WCHAR     *cpbegin;
     const WCHAR     *cpend;
     const WCHAR     *cp;
@@ -410,7 +429,7 @@ NewRENode(CompilerState *state, REOp op)
 
     ren = heap_pool_alloc(state->pool, sizeof(*ren));
     if (!ren) {
-        throw_error(state->context, E_OUTOFMEMORY, L"");
+        regexp_report_error(state->context, REGEXP_ERROR_OUTOFMEMORY);
         return NULL;
     }
     ren->op = op;
@@ -1620,7 +1639,7 @@ doSimple:
       case '*':
       case '+':
       case '?':
-        throw_error(state->context, state->context->version < SCRIPTLANGUAGEVERSION_ES5 ? JS_E_REGEXP_SYNTAX : JS_E_UNEXPECTED_QUANTIFIER, L"");
+        regexp_report_error(state->context, REGEXP_ERROR_BAD_QUANTIFIER);
         return FALSE;
       default:
 asFlat:
@@ -1942,7 +1961,7 @@ PushBackTrackState(REGlobalData *gData, REOp op,
         btincr = ((btincr+btsize-1)/btsize)*btsize;
         gData->backTrackStack = heap_pool_grow(gData->pool, gData->backTrackStack, btsize, btincr);
         if (!gData->backTrackStack) {
-            throw_error(gData->cx, E_OUTOFMEMORY, L"");
+            regexp_report_error(gData->cx, REGEXP_ERROR_OUTOFMEMORY);
             gData->ok = FALSE;
             return NULL;
         }
@@ -2110,7 +2129,7 @@ ProcessCharSet(REGlobalData *gData, RECharSet *charSet)
     byteLength = (charSet->length >> 3) + 1;
     charSet->u.bits = malloc(byteLength);
     if (!charSet->u.bits) {
-        throw_error(gData->cx, E_OUTOFMEMORY, L"");
+        regexp_report_error(gData->cx, REGEXP_ERROR_OUTOFMEMORY);
         gData->ok = FALSE;
         return FALSE;
     }
@@ -2298,7 +2317,7 @@ ReallocStateStack(REGlobalData *gData)
 
     gData->stateStack = heap_pool_grow(gData->pool, gData->stateStack, sz, sz);
     if (!gData->stateStack) {
-        throw_error(gData->cx, E_OUTOFMEMORY, L"");
+        regexp_report_error(gData->cx, REGEXP_ERROR_OUTOFMEMORY);
         gData->ok = FALSE;
         return FALSE;
     }
@@ -3067,8 +3086,50 @@ good:
     return x;
 }
 
+static const WCHAR *FindChar(const WCHAR *cp, const WCHAR *end, WCHAR ch)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    __m128i needle = _mm_set1_epi16(ch);
+    int mask;
+
+    while (end - cp >= 8) {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)cp), needle));
+        if (mask)
+            return cp + (__builtin_ctz(mask) >> 1);
+        cp += 8;
+    }
+#endif
+    for (; cp < end; cp++) {
+        if (*cp == ch)
+            return cp;
+    }
+    return NULL;
+}
+
+/*
+ * Find the next position at or after cp where the literal prefix of the
+ * pattern occurs. Positions that don't start with it can't match.
+ */
+static const WCHAR *FindPrefix(regexp_t *re, const WCHAR *cp, const WCHAR *end)
+{
+    const WCHAR *prefix = re->prefix;
+    DWORD len = re->prefix_len;
+
+    if ((size_t)(end - cp) < len)
+        return NULL;
+    end -= len - 1;
+
+    while ((cp = FindChar(cp, end, prefix[0]))) {
+        if (!memcmp(cp + 1, prefix + 1, (len - 1) * sizeof(WCHAR)))
+            return cp;
+        cp++;
+    }
+    return NULL;
+}
+
 static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
 {
+    regexp_t *re = gData->regexp;
     match_state_t *result;
     const WCHAR *cp = x->cp;
     const WCHAR *cp2;
@@ -3079,13 +3140,26 @@ static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
      * in order to detect end-of-input/line condition.
      */
     for (cp2 = cp; cp2 <= gData->cpend; cp2++) {
+        if (re->prefix_len && !(re->flags & REG_STICKY)) {
+            cp2 = FindPrefix(re, cp2, gData->cpend);
+            if (!cp2)
+                return NULL;
+            if (re->literal) {
+                gData->skipped = cp2 - cp;
+                x->cp = cp2 + re->prefix_len;
+                return x;
+            }
+        }
         gData->skipped = cp2 - cp;
         x->cp = cp2;
-        for (j = 0; j < gData->regexp->parenCount; j++)
+        for (j = 0; j < re->parenCount; j++)
             x->parens[j].index = -1;
         result = ExecuteREBytecode(gData, x);
-        if (!gData->ok || result || (gData->regexp->flags & REG_STICKY))
+        if (!gData->ok || result || (re->flags & REG_STICKY))
             return result;
+        /* Without the multiline flag, ^ only matches at the start of input. */
+        if (re->anchored && !(re->flags & REG_MULTILINE))
+            return NULL;
         gData->backTrackSP = gData->backTrackStack;
         gData->cursz = 0;
         gData->stateStackTop = 0;
@@ -3174,8 +3248,11 @@ HRESULT regexp_execute(regexp_t *regexp, void *cx, heap_pool_t *pool,
     return S_OK;
 }
 
-void regexp_destroy(regexp_t *re)
+void regexp_release(regexp_t *re)
 {
+    if (InterlockedDecrement(&re->ref))
+        return;
+
     if (re->classList) {
         UINT i;
         for (i = 0; i < re->classCount; i++) {
@@ -3185,9 +3262,53 @@ void regexp_destroy(regexp_t *re)
         }
         free(re->classList);
     }
+    free(re->source);
     free(re);
 }
 
+/*
+ * Look at the first instruction to find a literal all matches have to
+ * start with, so that MatchRegExp can skip to candidate positions instead
+ * of running the bytecode at every one of them.
+ */
+static void InitMatchPrefix(regexp_t *re)
+{
+    jsbytecode *pc = re->program;
+    size_t offset, length;
+
+    re->anchored = FALSE;
+    re->literal = FALSE;
+    re->prefix = NULL;
+    re->prefix_len = 0;
+
+    switch (*pc++) {
+      case REOP_BOL:
+        re->anchored = TRUE;
+        return;
+      case REOP_FLAT:
+        pc = ReadCompactIndex(pc, &offset);
+        pc = ReadCompactIndex(pc, &length);
+        re->prefix = re->source + offset;
+        re->prefix_len = length;
+        break;
+      case REOP_FLAT1:
+        re->prefix_char = *pc++;
+        re->prefix = &re->prefix_char;
+        re->prefix_len = 1;
+        break;
+      case REOP_UCFLAT1:
+        re->prefix_char = GET_ARG(pc);
+        pc += ARG_LEN;
+        re->prefix = &re->prefix_char;
+        re->prefix_len = 1;
+        break;
+      default:
+        return;
+    }
+
+    re->literal = *pc == REOP_END;
+}
+
 regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
         DWORD str_len, WORD flags, BOOL flat)
 {
@@ -3237,13 +3358,15 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     re = malloc(resize);
     if (!re)
         goto out;
+    re->ref = 1;
+    re->source = NULL;
 
     assert(state.classBitmapsMem <= CLASS_BITMAPS_MEM_LIMIT);
     re->classCount = state.classCount;
     if (re->classCount) {
         re->classList = malloc(re->classCount * sizeof(RECharSet));
         if (!re->classList) {
-            regexp_destroy(re);
+            regexp_release(re);
             re = NULL;
             goto out;
         }
@@ -3254,7 +3377,7 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     }
     endPC = EmitREBytecode(&state, re, state.treeDepth, re->program, state.result);
     if (!endPC) {
-        regexp_destroy(re);
+        regexp_release(re);
         re = NULL;
         goto out;
     }
@@ -3275,10 +3398,96 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
 
     re->flags = flags;
     re->parenCount = state.parenCount;
-    re->source = str;
+    re->source = malloc((str_len + 1) * sizeof(WCHAR));
+    if (!re->source) {
+        regexp_release(re);
+        re = NULL;
+        goto out;
+    }
+    memcpy(re->source, str, str_len * sizeof(WCHAR));
+    re->source[str_len] = 0;
     re->source_len = str_len;
+    InitMatchPrefix(re);
 
 out:
     heap_pool_clear(mark);
     return re;
 }
+
+#define REGEXP_CACHE_SIZE 16
+
+struct regexp_cache {
+    regexp_t *entries[REGEXP_CACHE_SIZE];
+    unsigned next;
+};
+
+/*
+ * Cached regexps may be shared between several users, so convert all the
+ * class bitmaps up front instead of lazily in InitMatch.
+ */
+static BOOL ConvertCharSets(void *cx, regexp_t *re)
+{
+    REGlobalData gData;
+    size_t i;
+
+    gData.cx = cx;
+    gData.regexp = re;
+    gData.ok = TRUE;
+
+    for (i = 0; i < re->classCount; i++) {
+        if (!re->classList[i].converted &&
+                !ProcessCharSet(&gData, &re->classList[i]))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+regexp_t *regexp_new_cached(struct regexp_cache **cache_ptr, void *cx, heap_pool_t *pool,
+        const WCHAR *str, DWORD str_len, WORD flags)
+{
+    struct regexp_cache *cache = *cache_ptr;
+    regexp_t *re;
+    unsigned i;
+
+    if (cache) {
+        for (i = 0; i < REGEXP_CACHE_SIZE; i++) {
+            re = cache->entries[i];
+            if (re && re->flags == flags && re->source_len == str_len &&
+                !memcmp(re->source, str, str_len * sizeof(WCHAR))) {
+                TRACE("cache hit %s\n", debugstr_wn(str, str_len));
+                return regexp_addref(re);
+            }
+        }
+    } else if (!(cache = *cache_ptr = calloc(1, sizeof(*cache)))) {
+        regexp_report_error(cx, REGEXP_ERROR_OUTOFMEMORY);
+        return NULL;
+    }
+
+    re = regexp_new(cx, pool, str, str_len, flags, FALSE);
+    if (!re)
+        return NULL;
+    if (!ConvertCharSets(cx, re)) {
+        regexp_release(re);
+        return NULL;
+    }
+
+    if (cache->entries[cache->next])
+        regexp_release(cache->entries[cache->next]);
+    cache->entries[cache->next] = regexp_addref(re);
+    cache->next = (cache->next + 1) % REGEXP_CACHE_SIZE;
+    return re;
+}
+
+void regexp_cache_free(struct regexp_cache *cache)
+{
+    unsigned i;
+
+    if (!cache)
+        return;
+
+    for (i = 0; i < REGEXP_CACHE_SIZE; i++) {
+        if (cache->entries[i])
+            regexp_release(cache->entries[i]);
+    }
+    free(cache);
+}
@@ -36,6 +36,25 @@
 #define REG_MULTILINE 0x04      /* treat ^ and $ as begin and end of line */
 #define REG_STICKY    0x08      /* only match starting at lastIndex */
 
+/*
+ * The engine is shared by jscript and vbscript. The embedding DLL provides
+ * the heap pool used for scratch memory and the error reporting callback.
+ */
+struct heap_pool_t;
+
+void *heap_pool_alloc(struct heap_pool_t*,size_t) __WINE_ALLOC_SIZE(2);
+void *heap_pool_grow(struct heap_pool_t*,void*,DWORD,DWORD);
+void heap_pool_clear(struct heap_pool_t*);
+struct heap_pool_t *heap_pool_mark(struct heap_pool_t*);
+
+typedef enum {
+    REGEXP_ERROR_FAIL,
+    REGEXP_ERROR_OUTOFMEMORY,
+    REGEXP_ERROR_BAD_QUANTIFIER
+} regexp_error_t;
+
+void regexp_report_error(void*,regexp_error_t);
+
 typedef struct RECapture {
     ptrdiff_t index;            /* start of contents, -1 for empty  */
     size_t length;              /* length of capture */
@@ -52,22 +71,44 @@ typedef struct match_state_t {
 typedef BYTE jsbytecode;
 
 typedef struct regexp_t {
+    LONG                ref;
     WORD                flags;         /* flags, see jsapi.h's REG_* defines */
+    BOOL                anchored;      /* starts with ^ */
+    BOOL                literal;       /* whole pattern is the prefix */
     size_t              parenCount;    /* number of parenthesized submatches */
     size_t              classCount;    /* count [...] bitmaps */
     struct RECharSet    *classList;    /* list of [...] bitmaps */
-    const WCHAR         *source;       /* locked source string, sans // */
+    WCHAR               *source;       /* private copy of the source, sans // */
     DWORD               source_len;
+    const WCHAR         *prefix;       /* literal every match starts with */
+    DWORD               prefix_len;
+    WCHAR               prefix_char;
     jsbytecode          program[1];    /* regular expression bytecode */
 } regexp_t;
 
-regexp_t* regexp_new(void*, heap_pool_t*, const WCHAR*, DWORD, WORD, BOOL);
-void regexp_destroy(regexp_t*);
-HRESULT regexp_execute(regexp_t*, void*, heap_pool_t*, const WCHAR*,
+regexp_t* regexp_new(void*, struct heap_pool_t*, const WCHAR*, DWORD, WORD, BOOL);
+void regexp_release(regexp_t*);
+HRESULT regexp_execute(regexp_t*, void*, struct heap_pool_t*, const WCHAR*,
         DWORD, match_state_t*);
 
+static inline regexp_t *regexp_addref(regexp_t *regexp)
+{
+    InterlockedIncrement(&regexp->ref);
+    return regexp;
+}
+
+/*
+ * A small cache of compiled patterns, keyed by source and flags. Scripts
+ * tend to evaluate the same regular expression literal or pattern string
+ * over and over, so this saves recompiling them every time.
+ */
+struct regexp_cache;
+
+regexp_t *regexp_new_cached(struct regexp_cache**, void*, struct heap_pool_t*, const WCHAR*, DWORD, WORD);
+void regexp_cache_free(struct regexp_cache*);
+
 static inline match_state_t* alloc_match_state(regexp_t *regexp,
-        heap_pool_t *pool, const WCHAR *pos)
+        struct heap_pool_t *pool, const WCHAR *pos)
 {
     size_t size = offsetof(match_state_t, parens) + regexp->parenCount*sizeof(RECapture);
     match_state_t *ret;
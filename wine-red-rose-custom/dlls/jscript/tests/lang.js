@@ -2093,6 +2093,40 @@ ok(Object === 1, "Object = " + Object);
 Array = 1;
 ok(Array === 1, "Array = " + Array);
 
+/* property lookups are cached per instruction, make sure the caches notice changes */
+(function() {
+    function C(v) { this.a = v; this.b = v + 1; }
+    C.prototype.get = function() { return this.b; };
+
+    var objs = [new C(1), new C(2), {a: 3, b: 4}, {b: 5, a: 6}, new C(7)], i, r = "";
+    for(i = 0; i < objs.length; i++)
+        r += objs[i].b + ",";
+    ok(r === "2,3,4,5,8,", "r = " + r);
+
+    var o = new C(10);
+    for(i = 0, r = ""; i < 4; i++) {
+        r += o.get() + ",";
+        if(i == 0) o.get = function() { return "own"; };
+        if(i == 1) delete o.get;
+        if(i == 2) C.prototype.get = function() { return "proto"; };
+    }
+    ok(r === "11,own,11,proto,", "r = " + r);
+
+    for(i = 0, r = ""; i < 3; i++) {
+        r += o.b + ",";
+        if(i == 0) delete o.b;
+        if(i == 1) o.b = "new";
+    }
+    ok(r === "11,undefined,new,", "r = " + r);
+
+    var names = ["a", "b", "a"];
+    for(i = 0, r = ""; i < names.length; i++) {
+        o[names[i]] = i;
+        r += o[names[i]] + ",";
+    }
+    ok(r === "0,1,2,", "r = " + r);
+})();
+
 Date = 1;
 ok(Date === 1, "Date = " + Date);
 
@@ -732,4 +732,32 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+/* Regular expressions compiled from the same source don't share state. */
+for(i = 0; i < 2; i++) {
+    re = /ab/g;
+    ok(re.lastIndex === 0, "[" + i + "] re.lastIndex = " + re.lastIndex);
+    m = re.exec("xxabab");
+    ok(m.index === 2, "[" + i + "] m.index = " + m.index);
+    ok(re.lastIndex === 4, "[" + i + "] re.lastIndex = " + re.lastIndex);
+}
+re = new RegExp("ab", "gi");
+m = "xxABab".match(re);
+ok(m.length === 2, "m.length = " + m.length);
+ok(re.ignoreCase === true, "re.ignoreCase = " + re.ignoreCase);
+m = "xxABab".match(/ab/g);
+ok(m.length === 1, "m.length = " + m.length);
+
+m = "aaaa_ab_".match(/a+b/);
+ok(m[0] === "ab", "m[0] = " + m[0]);
+m = "aaaab".match(/aab/);
+ok(m.index === 2, "m.index = " + m.index);
+m = "abcabc\nabc".match(/^abc/g);
+ok(m.length === 1, "m.length = " + m.length);
+m = "abcabc\nabc".match(/^abc/gm);
+ok(m.length === 2, "m.length = " + m.length);
+m = "x\u0100\u0101y\u0100".match(/\u0100/g);
+ok(m.length === 2, "m.length = " + m.length);
+ok("abc".search(/c/) === 2, "search returned " + "abc".search(/c/));
+ok("abc".search(/d/) === -1, "search returned " + "abc".search(/d/));
+
 reportSuccess();
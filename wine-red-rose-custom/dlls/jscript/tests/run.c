@@ -3716,6 +3716,18 @@ static void test_destructors(void)
 
     IActiveScript_Release(script2);
     IActiveScript_Release(script);
+
+    /* Short-lived cyclic garbage gets collected by allocating enough objects */
+    SET_EXPECT(testdestrobj);
+    V_VT(&v) = VT_EMPTY;
+    hres = parse_script_expr(L"CollectGarbage(),"
+                             L"(function() { var a = { 'obj': testDestrObj }; a.self = a; })(),"
+                             L"(function() { for(var i = 0; i < 100000; i++) new Object(); })(), true", &v, &script);
+    ok(hres == S_OK, "parse_script_expr failed: %08lx\n", hres);
+    ok(V_VT(&v) == VT_BOOL, "V_VT(v) = %d\n", V_VT(&v));
+    CHECK_CALLED(testdestrobj);
+
+    IActiveScript_Release(script);
 }
 
 static void test_eval(void)
@@ -4344,12 +4356,11 @@ static void run_encoded_tests(void)
     ok(hres == JS_E_INVALID_CHAR, "parse_script failed %08lx\n", hres);
 }
 
-static void run_benchmark(const char *script_name)
+static void run_benchmark_source(const char *name, const WCHAR *src)
 {
     IActiveScriptParse *parser;
     IActiveScript *engine;
     ULONG start, end;
-    BSTR src;
     HRESULT hres;
 
     engine = create_script();
@@ -4376,27 +4387,155 @@ static void run_benchmark(const char *script_name)
     hres = IActiveScript_SetScriptState(engine, SCRIPTSTATE_STARTED);
     ok(hres == S_OK, "SetScriptState(SCRIPTSTATE_STARTED) failed: %08lx\n", hres);
 
-    src = load_res(script_name);
-
     start = GetTickCount();
     hres = IActiveScriptParse_ParseScriptText(parser, src, NULL, NULL, NULL, 0, 0, 0, NULL, NULL);
     end = GetTickCount();
-    ok(hres == S_OK, "%s: ParseScriptText failed: %08lx\n", script_name, hres);
+    ok(hres == S_OK, "%s: ParseScriptText failed: %08lx\n", name, hres);
 
-    trace("%s ran in %lu ms\n", script_name, end-start);
+    trace("%s ran in %lu ms\n", name, end-start);
 
     IActiveScript_Release(engine);
     IActiveScriptParse_Release(parser);
+}
+
+static void run_benchmark(const char *script_name)
+{
+    BSTR src;
+
+    src = load_res(script_name);
+    run_benchmark_source(script_name, src);
     SysFreeString(src);
 }
 
+static const struct {
+    const char *name;
+    const WCHAR *src;
+} micro_benchmarks[] = {
+    {
+        "property get",
+        L"(function() {"
+        L"    var o = {x: 1, y: 2, z: 3}, s = 0;"
+        L"    for(var i = 0; i < 500000; i++) s += o.x + o.y + o.z;"
+        L"})();"
+    },
+    {
+        "property set",
+        L"(function() {"
+        L"    var o = {x: 1, y: 2, z: 3};"
+        L"    for(var i = 0; i < 500000; i++) { o.x = i; o.y = i; o.z = i; }"
+        L"})();"
+    },
+    {
+        "method call",
+        L"function Point(x, y) { this.x = x; this.y = y; }"
+        L"Point.prototype.sum = function() { return this.x + this.y; };"
+        L"(function() {"
+        L"    var p = new Point(1, 2), s = 0;"
+        L"    for(var i = 0; i < 500000; i++) s += p.sum();"
+        L"})();"
+    },
+    {
+        "same shape objects",
+        L"(function() {"
+        L"    var a = [], s = 0, i;"
+        L"    for(i = 0; i < 16; i++) a.push({x: i, y: i, z: i});"
+        L"    for(i = 0; i < 500000; i++) s += a[i & 15].y;"
+        L"})();"
+    },
+    {
+        "array loop",
+        L"(function() {"
+        L"    var a = [], s = 0, i, j;"
+        L"    for(i = 0; i < 1000; i++) a.push(i);"
+        L"    for(j = 0; j < 200; j++)"
+        L"        for(i = 0; i < a.length; i++) s += a[i];"
+        L"})();"
+    },
+    {
+        "global variables",
+        L"var g = 0;"
+        L"function inc() { g++; }"
+        L"for(var i = 0; i < 500000; i++) inc();"
+    },
+    {
+        "temporaries with a large heap",
+        L"(function() {"
+        L"    var heap = [], i, t;"
+        L"    for(i = 0; i < 100000; i++) heap.push({ next: heap[i - 1] });"
+        L"    for(i = 0; i < 500000; i++) { t = { x: i }; t.self = t; }"
+        L"    CollectGarbage();"
+        L"})();"
+    },
+    {
+        "regexp literal search",
+        L"(function() {"
+        L"    var s = new Array(4096).join('lorem ipsum dolor ') + 'needle', n = 0;"
+        L"    for(var i = 0; i < 200; i++) n += s.match(/needle/g).length;"
+        L"})();"
+    },
+    {
+        "regexp prefix scan",
+        L"(function() {"
+        L"    var s = new Array(2048).join('some text foo12 more text '), n = 0;"
+        L"    for(var i = 0; i < 20; i++) n += s.match(/foo[0-9]+/g).length;"
+        L"})();"
+    },
+    {
+        "regexp case-insensitive",
+        L"(function() {"
+        L"    var s = new Array(2048).join('Some Text NEEDLE more text '), n = 0;"
+        L"    for(var i = 0; i < 20; i++) n += s.match(/needle/gi).length;"
+        L"})();"
+    },
+    {
+        "regexp anchored",
+        L"(function() {"
+        L"    var s = new Array(4096).join('x'), n = 0;"
+        L"    for(var i = 0; i < 5000; i++) if(/^abc/.test(s)) n++;"
+        L"})();"
+    },
+    {
+        "regexp alternation",
+        L"(function() {"
+        L"    var s = new Array(2048).join('the cat and the dog saw a bird '), n = 0;"
+        L"    for(var i = 0; i < 10; i++) n += s.match(/cat|dog|bird/g).length;"
+        L"})();"
+    },
+    {
+        "regexp captures",
+        L"(function() {"
+        L"    var s = new Array(2048).join('key=value; '), n = 0;"
+        L"    for(var i = 0; i < 10; i++) n += s.replace(/(\\w+)=(\\w+)/g, '$2=$1').length;"
+        L"})();"
+    },
+    {
+        "regexp literal in loop",
+        L"(function() {"
+        L"    var n = 0;"
+        L"    for(var i = 0; i < 100000; i++) if(/(\\d+)-(\\d+)/.exec('range 123-456')) n++;"
+        L"})();"
+    },
+    {
+        "string replace and split",
+        L"(function() {"
+        L"    var s = new Array(4096).join('a,b,c;'), n = 0;"
+        L"    for(var i = 0; i < 50; i++) n += s.replace(';', ',').split(',').length;"
+        L"})();"
+    },
+};
+
 static void run_benchmarks(void)
 {
+    unsigned i;
+
     trace("Running benchmarks...\n");
 
     run_benchmark("dna.js");
     run_benchmark("base64.js");
     run_benchmark("validateinput.js");
+
+    for(i = 0; i < ARRAY_SIZE(micro_benchmarks); i++)
+        run_benchmark_source(micro_benchmarks[i].name, micro_benchmarks[i].src);
 }
 
 static BOOL check_jscript(void)
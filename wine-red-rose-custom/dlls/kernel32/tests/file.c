@@ -4989,6 +4989,106 @@ static void test_WriteFileGather(void)
     DeleteFileA( filename );
 }
 
+static double scatter_gather_pass( HANDLE file, HANDLE evt, FILE_SEGMENT_ELEMENT *fse, DWORD page_size,
+                                   unsigned int page_count, unsigned int batch, BOOL write )
+{
+    LARGE_INTEGER freq, start, end;
+    unsigned int i, j;
+    OVERLAPPED ovl;
+    DWORD size;
+    BOOL ret;
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < page_count; i += batch)
+    {
+        memset( &ovl, 0, sizeof(ovl) );
+        ovl.hEvent = evt;
+        ovl.Offset = i * page_size;
+        ResetEvent( evt );
+        if (batch == 1 && write)
+            ret = WriteFile( file, fse[i].Buffer, page_size, NULL, &ovl );
+        else if (batch == 1)
+            ret = ReadFile( file, fse[i].Buffer, page_size, NULL, &ovl );
+        else if (write)
+            ret = WriteFileGather( file, fse + i, batch * page_size, NULL, &ovl );
+        else
+            ret = ReadFileScatter( file, fse + i, batch * page_size, NULL, &ovl );
+        ok( ret || GetLastError() == ERROR_IO_PENDING, "I/O failed, error %lu\n", GetLastError() );
+        ret = GetOverlappedResult( file, &ovl, &size, TRUE );
+        ok( ret && size == batch * page_size, "got ret %d, size %lu, error %lu\n", ret, size, GetLastError() );
+    }
+    QueryPerformanceCounter( &end );
+
+    if (!write)
+    {
+        for (i = 0; i < page_count; ++i)
+        {
+            j = *(DWORD *)fse[i].Buffer;
+            ok( j == i, "got page %u at %u\n", j, i );
+            if (j != i) break;
+        }
+    }
+    return (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+}
+
+static void test_scatter_gather_performance(void)
+{
+    static const unsigned int page_count = 16384, batch = 256;
+    char temp_path[MAX_PATH], filename[MAX_PATH];
+    FILE_SEGMENT_ELEMENT *fse;
+    unsigned int i, stride;
+    double mb, secs[4];
+    SYSTEM_INFO si;
+    HANDLE file, evt;
+    char *buffer;
+
+    if (!winetest_interactive)
+    {
+        skip( "Skipping scatter/gather benchmark, set WINETEST_INTERACTIVE to run it.\n" );
+        return;
+    }
+
+    GetSystemInfo( &si );
+    GetTempPathA( MAX_PATH, temp_path );
+    GetTempFileNameA( temp_path, "sgb", 0, filename );
+    file = CreateFileA( filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                        FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "CreateFile failed, error %lu\n", GetLastError() );
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    evt = CreateEventA( NULL, TRUE, FALSE, NULL );
+    buffer = VirtualAlloc( NULL, (SIZE_T)page_count * 2 * si.dwPageSize, MEM_COMMIT, PAGE_READWRITE );
+    ok( buffer != NULL, "VirtualAlloc failed, error %lu\n", GetLastError() );
+    fse = calloc( page_count + 1, sizeof(*fse) );
+    mb = (double)page_count * si.dwPageSize / (1024 * 1024);
+
+    /* contiguous pages can be merged into a single vector, every other page can't */
+    for (stride = 1; stride <= 2; ++stride)
+    {
+        for (i = 0; i < page_count; ++i)
+        {
+            fse[i].Buffer = buffer + (SIZE_T)i * stride * si.dwPageSize;
+            *(DWORD *)fse[i].Buffer = i;
+        }
+
+        secs[0] = scatter_gather_pass( file, evt, fse, si.dwPageSize, page_count, 1, TRUE );
+        secs[1] = scatter_gather_pass( file, evt, fse, si.dwPageSize, page_count, batch, TRUE );
+        for (i = 0; i < page_count; ++i) *(DWORD *)fse[i].Buffer = ~0u;
+        secs[2] = scatter_gather_pass( file, evt, fse, si.dwPageSize, page_count, 1, FALSE );
+        for (i = 0; i < page_count; ++i) *(DWORD *)fse[i].Buffer = ~0u;
+        secs[3] = scatter_gather_pass( file, evt, fse, si.dwPageSize, page_count, batch, FALSE );
+
+        trace( "stride %u: per page write %.0f MB/s, gather %.0f MB/s, per page read %.0f MB/s, scatter %.0f MB/s\n",
+               stride, mb / secs[0], mb / secs[1], mb / secs[2], mb / secs[3] );
+    }
+
+    free( fse );
+    VirtualFree( buffer, 0, MEM_RELEASE );
+    CloseHandle( evt );
+    CloseHandle( file );
+}
+
 static unsigned file_map_access(unsigned access)
 {
     if (access & GENERIC_READ)    access |= FILE_GENERIC_READ;
@@ -6280,6 +6380,7 @@ START_TEST(file)
     test_OpenFileById();
     test_SetFileValidData();
     test_WriteFileGather();
+    test_scatter_gather_performance();
     test_file_access();
     test_GetFinalPathNameByHandleA();
     test_GetFinalPathNameByHandleW();
@@ -4308,6 +4308,103 @@ static void test_CancelSynchronousIo(void)
     CloseHandle(pipe);
 }
 
+static DWORD CALLBACK pipe_throughput_reader(void *arg)
+{
+    static char buf[65536];
+    HANDLE pipe = arg;
+    ULONGLONG total = 0;
+    DWORD read;
+
+    while (ReadFile(pipe, buf, sizeof(buf), &read, NULL) && read) total += read;
+    return total >> 20;
+}
+
+static DWORD CALLBACK pipe_latency_echo(void *arg)
+{
+    HANDLE pipe = arg;
+    DWORD count;
+    char c;
+
+    while (ReadFile(pipe, &c, 1, &count, NULL) && count)
+        if (!WriteFile(pipe, &c, 1, &count, NULL)) break;
+    return 0;
+}
+
+static void test_pipe_throughput(void)
+{
+    static const DWORD sizes[] = {64, 4096, 65536};
+    static char buf[65536];
+    LARGE_INTEGER freq, start, end;
+    HANDLE server, client, thread;
+    DWORD i, j, count, iterations;
+    double secs;
+    char c;
+    BOOL res;
+
+    if (!winetest_interactive)
+    {
+        skip("Skipping pipe benchmark\n");
+        return;
+    }
+
+    QueryPerformanceFrequency(&freq);
+    memset(buf, 0x55, sizeof(buf));
+
+    for (i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        server = CreateNamedPipeA(PIPENAME, PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_WAIT,
+                                  1, 65536, 65536, NMPWAIT_USE_DEFAULT_WAIT, NULL);
+        ok(server != INVALID_HANDLE_VALUE, "CreateNamedPipe failed with %lu\n", GetLastError());
+        client = CreateFileA(PIPENAME, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, 0);
+        ok(client != INVALID_HANDLE_VALUE, "CreateFile failed with %lu\n", GetLastError());
+        thread = CreateThread(NULL, 0, pipe_throughput_reader, server, 0, NULL);
+
+        iterations = (256 << 20) / sizes[i];
+        QueryPerformanceCounter(&start);
+        for (j = 0; j < iterations; j++)
+        {
+            res = WriteFile(client, buf, sizes[i], &count, NULL);
+            ok(res && count == sizes[i], "WriteFile failed with %lu\n", GetLastError());
+            if (!res) break;
+        }
+        CloseHandle(client);
+        WaitForSingleObject(thread, INFINITE);
+        QueryPerformanceCounter(&end);
+        GetExitCodeThread(thread, &count);
+        ok(count == 256, "reader got %lu MB\n", count);
+        CloseHandle(thread);
+        CloseHandle(server);
+
+        secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+        trace("%lu byte writes: %.1f MB/s\n", sizes[i], 256 / secs);
+    }
+
+    server = CreateNamedPipeA(PIPENAME, PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_WAIT,
+                              1, 4096, 4096, NMPWAIT_USE_DEFAULT_WAIT, NULL);
+    ok(server != INVALID_HANDLE_VALUE, "CreateNamedPipe failed with %lu\n", GetLastError());
+    client = CreateFileA(PIPENAME, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, 0);
+    ok(client != INVALID_HANDLE_VALUE, "CreateFile failed with %lu\n", GetLastError());
+    thread = CreateThread(NULL, 0, pipe_latency_echo, server, 0, NULL);
+
+    iterations = 20000;
+    QueryPerformanceCounter(&start);
+    for (j = 0; j < iterations; j++)
+    {
+        c = j;
+        if (!WriteFile(client, &c, 1, &count, NULL) || !ReadFile(client, &c, 1, &count, NULL)) break;
+        if (c != (char)j) break;
+    }
+    QueryPerformanceCounter(&end);
+    ok(j == iterations, "ping-pong failed at iteration %lu, error %lu\n", j, GetLastError());
+    CloseHandle(client);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    CloseHandle(server);
+
+    secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    trace("1 byte round trip: %.2f us\n", secs * 1000000 / iterations);
+}
+
 START_TEST(pipe)
 {
     char **argv;
@@ -4390,4 +4487,5 @@ START_TEST(pipe)
     test_GetOverlappedResultEx();
     test_exit_process_async();
     test_CancelSynchronousIo();
+    test_pipe_throughput();
 }
@@ -368,31 +368,91 @@ static msi_file_state calculate_install_state( MSIPACKAGE *package, MSIFILE *fil
     }
     if (file->hash.dwFileHashInfoSize)
     {
-        if (file_hash_matches( package, file ))
-        {
-            TRACE("keeping %s (hash match)\n", debugstr_w(file->File));
-            return msifs_hashmatch;
-        }
-        else
-        {
-            TRACE("overwriting %s (hash mismatch)\n", debugstr_w(file->File));
-            return msifs_overwrite;
-        }
+        /* hashes are computed later, all at once */
+        TRACE("checking hash of %s\n", debugstr_w(file->File));
+        return msifs_invalid;
     }
     /* assume present */
     TRACE("keeping %s\n", debugstr_w(file->File));
     return msifs_present;
 }
 
+struct hash_check
+{
+    MSIPACKAGE *package;
+    MSIFILE **files;
+    BOOL *matches;
+};
+
+static void hash_check_cb( void *ctx, UINT index )
+{
+    struct hash_check *check = ctx;
+
+    check->matches[index] = file_hash_matches( check->package, check->files[index] );
+}
+
+/* reads and hashes the files that are already present in parallel */
+static void check_file_hashes( MSIPACKAGE *package )
+{
+    struct hash_check check;
+    UINT count = 0, i = 0;
+    MSIFILE *file;
+
+    LIST_FOR_EACH_ENTRY( file, &package->files, MSIFILE, entry )
+        if (file->state == msifs_invalid) count++;
+    if (!count) return;
+
+    check.package = package;
+    check.files = malloc( count * sizeof(*check.files) );
+    check.matches = calloc( count, sizeof(*check.matches) );
+    if (check.files && check.matches)
+    {
+        LIST_FOR_EACH_ENTRY( file, &package->files, MSIFILE, entry )
+            if (file->state == msifs_invalid) check.files[i++] = file;
+
+        if (msi_can_use_workers( package ))
+            msi_run_parallel( count, hash_check_cb, &check );
+        else
+            for (i = 0; i < count; i++) hash_check_cb( &check, i );
+
+        for (i = 0; i < count; i++)
+        {
+            file = check.files[i];
+            if (check.matches[i])
+            {
+                TRACE("keeping %s (hash match)\n", debugstr_w(file->File));
+                file->state = msifs_hashmatch;
+            }
+            else
+            {
+                TRACE("overwriting %s (hash mismatch)\n", debugstr_w(file->File));
+                file->state = msifs_overwrite;
+            }
+        }
+    }
+    else
+    {
+        LIST_FOR_EACH_ENTRY( file, &package->files, MSIFILE, entry )
+            if (file->state == msifs_invalid)
+                file->state = file_hash_matches( package, file ) ? msifs_hashmatch : msifs_overwrite;
+    }
+    free( check.files );
+    free( check.matches );
+}
+
 static void schedule_install_files(MSIPACKAGE *package)
 {
     MSIFILE *file;
 
+    LIST_FOR_EACH_ENTRY(file, &package->files, MSIFILE, entry)
+        file->state = calculate_install_state( package, file );
+
+    check_file_hashes( package );
+
     LIST_FOR_EACH_ENTRY(file, &package->files, MSIFILE, entry)
     {
         MSICOMPONENT *comp = file->Component;
 
-        file->state = calculate_install_state( package, file );
         if (file->state == msifs_overwrite && (comp->Attributes & msidbComponentAttributesNeverOverwrite))
         {
             TRACE("not overwriting %s\n", debugstr_w(file->TargetPath));
@@ -413,6 +473,7 @@ static UINT copy_file_attributes( MSIPACKAGE *package, MSIFILE *file, WCHAR *sou
     return ERROR_SUCCESS;
 }
 
+/* returns ERROR_SUCCESS_REBOOT_REQUIRED if the file is replaced on reboot */
 static UINT copy_install_file(MSIPACKAGE *package, MSIFILE *file, LPWSTR source)
 {
     UINT gle;
@@ -457,8 +518,7 @@ static UINT copy_install_file(MSIPACKAGE *package, MSIFILE *file, LPWSTR source)
             msi_move_file( package, file->TargetPath, NULL, MOVEFILE_DELAY_UNTIL_REBOOT ) &&
             msi_move_file( package, tmpfileW, file->TargetPath, MOVEFILE_DELAY_UNTIL_REBOOT ))
         {
-            package->need_reboot_at_end = 1;
-            gle = ERROR_SUCCESS;
+            gle = ERROR_SUCCESS_REBOOT_REQUIRED;
         }
         else
         {
@@ -533,6 +593,111 @@ static BOOL installfiles_cb(MSIPACKAGE *package, LPCWSTR filename, DWORD action,
     return TRUE;
 }
 
+#define MSI_COPY_BATCH_SIZE 64
+
+/* uncompressed files waiting to be copied */
+struct copy_batch
+{
+    MSIPACKAGE *package;
+    UINT disk_id;
+    UINT count;
+    LONG failed;  /* index of the first job that failed */
+    struct copy_job
+    {
+        MSIFILE *file;
+        WCHAR *source;
+        UINT rc;
+        BOOL copied;
+    } jobs[MSI_COPY_BATCH_SIZE];
+};
+
+static void copy_batch_cb( void *ctx, UINT index )
+{
+    struct copy_batch *batch = ctx;
+    struct copy_job *job = &batch->jobs[index];
+    LONG failed;
+
+    /* a file after a failed one wouldn't have been copied one after another */
+    if ((LONG)index > ReadAcquire( &batch->failed )) return;
+
+    TRACE("copying %s to %s\n", debugstr_w(job->source), debugstr_w(job->file->TargetPath));
+    job->rc = copy_install_file( batch->package, job->file, job->source );
+    job->copied = TRUE;
+    if (job->rc == ERROR_SUCCESS || job->rc == ERROR_SUCCESS_REBOOT_REQUIRED) return;
+
+    while ((failed = ReadAcquire( &batch->failed )) > (LONG)index &&
+           InterlockedCompareExchange( &batch->failed, index, failed ) != failed);
+}
+
+/* copies the queued files, errors are handled in file order as if the files
+ * had been copied one after another */
+static UINT flush_copy_batch( struct copy_batch *batch )
+{
+    UINT i, rc = ERROR_SUCCESS;
+
+    if (!batch->count) return ERROR_SUCCESS;
+
+    batch->failed = MAXLONG;
+    if (msi_can_use_workers( batch->package ))
+        msi_run_parallel( batch->count, copy_batch_cb, batch );
+    else
+        for (i = 0; i < batch->count; i++) copy_batch_cb( batch, i );
+
+    for (i = 0; i < batch->count; i++)
+    {
+        struct copy_job *job = &batch->jobs[i];
+
+        if (rc == ERROR_SUCCESS)
+        {
+            if (job->rc == ERROR_SUCCESS_REBOOT_REQUIRED)
+            {
+                batch->package->need_reboot_at_end = 1;
+                job->rc = ERROR_SUCCESS;
+            }
+            if (job->rc != ERROR_SUCCESS)
+            {
+                ERR("Failed to copy %s to %s (%u)\n", debugstr_w(job->source), debugstr_w(job->file->TargetPath), job->rc);
+                rc = ERROR_INSTALL_FAILURE;
+            }
+            else if (!msi_is_global_assembly( job->file->Component )) job->file->state = msifs_installed;
+        }
+        else if (job->copied && job->rc == ERROR_SUCCESS)
+        {
+            /* copied by another thread before the failure was seen, remove new files again */
+            if (job->file->state == msifs_missing) DeleteFileW( job->file->TargetPath );
+            else if (!msi_is_global_assembly( job->file->Component )) job->file->state = msifs_installed;
+        }
+        else if (job->copied && job->rc == ERROR_SUCCESS_REBOOT_REQUIRED)
+            batch->package->need_reboot_at_end = 1;
+        free( job->source );
+    }
+    batch->count = 0;
+    return rc;
+}
+
+static UINT queue_copy( struct copy_batch *batch, MSIFILE *file, WCHAR *source, UINT disk_id )
+{
+    UINT i, rc;
+
+    /* copies to the same file have to stay in order */
+    for (i = 0; i < batch->count; i++)
+        if (!wcsicmp( batch->jobs[i].file->TargetPath, file->TargetPath )) break;
+
+    if ((i < batch->count || batch->count == MSI_COPY_BATCH_SIZE) && (rc = flush_copy_batch( batch )))
+    {
+        free( source );
+        return rc;
+    }
+
+    batch->jobs[batch->count].file = file;
+    batch->jobs[batch->count].source = source;
+    batch->jobs[batch->count].rc = ERROR_SUCCESS;
+    batch->jobs[batch->count].copied = FALSE;
+    batch->disk_id = disk_id;
+    batch->count++;
+    return ERROR_SUCCESS;
+}
+
 WCHAR *msi_resolve_file_source( MSIPACKAGE *package, MSIFILE *file )
 {
     WCHAR *p, *path;
@@ -560,11 +725,15 @@ WCHAR *msi_resolve_file_source( MSIPACKAGE *package, MSIFILE *file )
  * For efficiency, this is done in two passes:
  * 1) Correct all the TargetPaths and determine what files are to be installed.
  * 2) Extract Cabinets and copy files.
+ *
+ * Uncompressed files are copied in batches on worker threads, a batch is
+ * completed before the media changes and before a cabinet is extracted.
  */
 UINT ACTION_InstallFiles(MSIPACKAGE *package)
 {
     MSIMEDIAINFO *mi;
-    UINT rc = ERROR_SUCCESS;
+    struct copy_batch *batch;
+    UINT rc = ERROR_SUCCESS, r;
     MSIFILE *file;
 
     msi_set_sourcedir_props(package, FALSE);
@@ -574,6 +743,12 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
 
     schedule_install_files(package);
     mi = calloc(1, sizeof(MSIMEDIAINFO));
+    if (!(batch = calloc(1, sizeof(*batch))))
+    {
+        free(mi);
+        return ERROR_OUTOFMEMORY;
+    }
+    batch->package = package;
 
     LIST_FOR_EACH_ENTRY( file, &package->files, MSIFILE, entry )
     {
@@ -589,6 +764,9 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             goto done;
         }
 
+        if (batch->count && batch->disk_id != mi->disk_id && (rc = flush_copy_batch( batch )))
+            goto done;
+
         if (file->state != msifs_hashmatch &&
             file->state != msifs_skipped &&
             (file->state != msifs_present || !msi_get_property_int( package->db, L"Installed", 0 )) &&
@@ -612,6 +790,8 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             data.cb = installfiles_cb;
             data.user = &cursor;
 
+            if (file->IsCompressed && (rc = flush_copy_batch( batch )))
+                goto done;
             if (file->IsCompressed && !msi_cabextract(package, mi, &data))
             {
                 ERR("Failed to extract cabinet: %s\n", debugstr_w(mi->cabinet));
@@ -624,22 +804,12 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
         {
             WCHAR *source = msi_resolve_file_source(package, file);
 
-            TRACE("copying %s to %s\n", debugstr_w(source), debugstr_w(file->TargetPath));
-
             if (!is_global_assembly)
             {
                 create_folder(package, file->Component->Directory);
             }
-            rc = copy_install_file(package, file, source);
-            if (rc != ERROR_SUCCESS)
-            {
-                ERR("Failed to copy %s to %s (%u)\n", debugstr_w(source), debugstr_w(file->TargetPath), rc);
-                rc = ERROR_INSTALL_FAILURE;
-                free(source);
+            if ((rc = queue_copy(batch, file, source, mi->disk_id)))
                 goto done;
-            }
-            if (!is_global_assembly) file->state = msifs_installed;
-            free(source);
         }
         else if (!is_global_assembly && file->state != msifs_installed &&
                  !(file->Attributes & msidbFileAttributesPatchAdded))
@@ -651,6 +821,9 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
     }
 
 done:
+    r = flush_copy_batch(batch);
+    if (rc == ERROR_SUCCESS) rc = r;
+    free(batch);
     msi_free_media_info(mi);
     return rc;
 }
@@ -94,6 +94,266 @@ static MSICABINETSTREAM *get_cabinet_stream( MSIPACKAGE *package, UINT disk_id )
     return NULL;
 }
 
+/*
+ * Extracted files are written by a separate thread fed through a bounded
+ * queue, so that decompression overlaps with the writes. FDI gets a
+ * struct cabinet_output in place of the handle of each extracted file.
+ */
+#define CABINET_WRITE_QUEUE_SIZE (16 * 1024 * 1024)
+
+struct cabinet_writer
+{
+    CRITICAL_SECTION   cs;
+    CONDITION_VARIABLE queued_cv;
+    CONDITION_VARIABLE written_cv;
+    struct list        queue;
+    SIZE_T             queued;     /* bytes waiting to be written */
+    BOOL               shutdown;
+    DWORD              error;      /* first failure */
+    HANDLE             thread;
+};
+
+struct write_request
+{
+    struct list            entry;
+    struct cabinet_output *output;
+    BOOL                   close;
+    BOOL                   set_time;
+    FILETIME               time;
+    UINT                   size;
+    BYTE                   data[1];
+};
+
+struct cabinet_output
+{
+    struct list            entry;   /* in output_list */
+    struct cabinet_writer *writer;
+    HANDLE                 handle;
+    struct write_request  *close;   /* allocated up front so that closing can't fail */
+};
+
+/* outputs that FDI may still close on failure */
+static struct list output_list = LIST_INIT( output_list );
+static CRITICAL_SECTION output_cs;
+static CRITICAL_SECTION_DEBUG output_cs_debug =
+{
+    0, 0, &output_cs,
+    { &output_cs_debug.ProcessLocksList, &output_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": output_cs") }
+};
+static CRITICAL_SECTION output_cs = { &output_cs_debug, -1, 0, 0, 0, 0 };
+
+static void set_writer_error( struct cabinet_writer *writer, DWORD error )
+{
+    EnterCriticalSection( &writer->cs );
+    if (!writer->error) writer->error = error;
+    LeaveCriticalSection( &writer->cs );
+}
+
+static DWORD process_write_request( struct write_request *req )
+{
+    struct cabinet_output *output = req->output;
+    DWORD written, err = ERROR_SUCCESS;
+
+    if (!req->close)
+    {
+        if (!WriteFile( output->handle, req->data, req->size, &written, NULL ))
+            err = GetLastError();
+        else if (written != req->size)
+            err = ERROR_WRITE_FAULT;
+        if (err) WARN( "failed to write to %p (error %lu)\n", output->handle, err );
+        return err;
+    }
+
+    if (req->set_time && !SetFileTime( output->handle, &req->time, 0, &req->time ))
+    {
+        err = GetLastError();
+        WARN( "failed to set time of %p (error %lu)\n", output->handle, err );
+    }
+    CloseHandle( output->handle );
+    free( output );
+    return err;
+}
+
+static DWORD WINAPI cabinet_writer_thread( void *arg )
+{
+    struct cabinet_writer *writer = arg;
+    struct write_request *req;
+    DWORD err;
+
+    EnterCriticalSection( &writer->cs );
+    for (;;)
+    {
+        while (list_empty( &writer->queue ) && !writer->shutdown)
+            SleepConditionVariableCS( &writer->queued_cv, &writer->cs, INFINITE );
+        if (list_empty( &writer->queue )) break;
+
+        req = LIST_ENTRY( list_head( &writer->queue ), struct write_request, entry );
+        LeaveCriticalSection( &writer->cs );
+
+        err = process_write_request( req );
+
+        EnterCriticalSection( &writer->cs );
+        if (err && !writer->error) writer->error = err;
+        list_remove( &req->entry );
+        writer->queued -= req->size;
+        free( req );
+        WakeAllConditionVariable( &writer->written_cv );
+    }
+    LeaveCriticalSection( &writer->cs );
+    return 0;
+}
+
+static void submit_write_request( struct cabinet_writer *writer, struct write_request *req )
+{
+    DWORD err;
+
+    if (!writer->thread)
+    {
+        if ((err = process_write_request( req ))) set_writer_error( writer, err );
+        free( req );
+        return;
+    }
+
+    EnterCriticalSection( &writer->cs );
+    while (writer->queued && writer->queued + req->size > CABINET_WRITE_QUEUE_SIZE)
+        SleepConditionVariableCS( &writer->written_cv, &writer->cs, INFINITE );
+    list_add_tail( &writer->queue, &req->entry );
+    writer->queued += req->size;
+    WakeConditionVariable( &writer->queued_cv );
+    LeaveCriticalSection( &writer->cs );
+}
+
+static void init_cabinet_writer( struct cabinet_writer *writer )
+{
+    InitializeCriticalSection( &writer->cs );
+    writer->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": cabinet_writer.cs");
+    InitializeConditionVariable( &writer->queued_cv );
+    InitializeConditionVariable( &writer->written_cv );
+    list_init( &writer->queue );
+    writer->queued = 0;
+    writer->shutdown = FALSE;
+    writer->error = ERROR_SUCCESS;
+    if (!(writer->thread = CreateThread( NULL, 0, cabinet_writer_thread, writer, 0, NULL )))
+        WARN( "failed to create writer thread, writing synchronously\n" );
+}
+
+/* waits for all the queued writes, returns the first error */
+static DWORD finish_cabinet_writer( struct cabinet_writer *writer )
+{
+    if (writer->thread)
+    {
+        EnterCriticalSection( &writer->cs );
+        writer->shutdown = TRUE;
+        WakeConditionVariable( &writer->queued_cv );
+        LeaveCriticalSection( &writer->cs );
+        WaitForSingleObject( writer->thread, INFINITE );
+        CloseHandle( writer->thread );
+    }
+    writer->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &writer->cs );
+    return writer->error;
+}
+
+static INT_PTR create_output( struct cabinet_writer *writer, HANDLE handle )
+{
+    struct cabinet_output *output;
+
+    if (!(output = malloc( sizeof(*output) )) ||
+        !(output->close = calloc( 1, sizeof(*output->close) )))
+    {
+        free( output );
+        CloseHandle( handle );
+        return -1;
+    }
+    output->writer = writer;
+    output->handle = handle;
+    output->close->output = output;
+    output->close->close = TRUE;
+
+    EnterCriticalSection( &output_cs );
+    list_add_tail( &output_list, &output->entry );
+    LeaveCriticalSection( &output_cs );
+    return (INT_PTR)output;
+}
+
+/* queues the closing of the file, after the data written so far */
+static void close_output( struct cabinet_output *output, const FILETIME *time )
+{
+    struct write_request *req = output->close;
+
+    EnterCriticalSection( &output_cs );
+    list_remove( &output->entry );
+    LeaveCriticalSection( &output_cs );
+
+    if ((req->set_time = (time != NULL))) req->time = *time;
+    submit_write_request( output->writer, req );
+}
+
+/* FDI closes the files it was extracting when it fails */
+static BOOL abort_output( INT_PTR hf )
+{
+    struct cabinet_output *output;
+    BOOL found = FALSE;
+
+    EnterCriticalSection( &output_cs );
+    LIST_FOR_EACH_ENTRY( output, &output_list, struct cabinet_output, entry )
+    {
+        if ((INT_PTR)output == hf)
+        {
+            found = TRUE;
+            break;
+        }
+    }
+    LeaveCriticalSection( &output_cs );
+
+    if (found) close_output( output, NULL );
+    return found;
+}
+
+/* state of an extraction thread, passed to FDI as user data */
+struct cabinet_extract
+{
+    MSICABDATA              data;     /* must be first */
+    MSIMEDIAINFO            mi;       /* copy for worker threads */
+    struct cabinet_writer  *writer;
+    struct cabinet_folders *folders;  /* NULL unless folders are extracted in parallel */
+    LONG                    worker;
+    void                   *cursor;   /* copy of *data.user for worker threads */
+};
+
+/* independent cabinet folders extracted in parallel, each thread runs its
+ * own FDICopy and extracts the files of the folders it is the first to see */
+struct cabinet_folders
+{
+    CRITICAL_SECTION        cs;       /* serializes the extraction callbacks */
+    LONG                   *owner;
+    UINT                    count;
+    char                   *cabinet;
+    char                   *cab_path;
+    struct cabinet_extract *workers;
+    LONG                    failed;
+};
+
+static inline void lock_extract( struct cabinet_extract *ctx )
+{
+    if (ctx->folders) EnterCriticalSection( &ctx->folders->cs );
+}
+
+static inline void unlock_extract( struct cabinet_extract *ctx )
+{
+    if (ctx->folders) LeaveCriticalSection( &ctx->folders->cs );
+}
+
+static BOOL claim_folder( struct cabinet_extract *ctx, USHORT folder )
+{
+    LONG owner;
+
+    if (folder >= ctx->folders->count) return !ctx->worker;
+    owner = InterlockedCompareExchange( &ctx->folders->owner[folder], ctx->worker, -1 );
+    return owner == -1 || owner == ctx->worker;
+}
+
 static void * CDECL cabinet_alloc(ULONG cb)
 {
     return malloc(cb);
@@ -152,18 +412,27 @@ static UINT CDECL cabinet_read(INT_PTR hf, void *pv, UINT cb)
 
 static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 {
-    HANDLE handle = (HANDLE)hf;
-    DWORD written;
+    struct cabinet_output *output = (struct cabinet_output *)hf;
+    struct write_request *req;
 
-    if (WriteFile(handle, pv, cb, &written, NULL))
-        return written;
-
-    return 0;
+    if (!(req = malloc( offsetof( struct write_request, data[cb] ) )))
+    {
+        set_writer_error( output->writer, ERROR_OUTOFMEMORY );
+        return 0;
+    }
+    req->output = output;
+    req->close = FALSE;
+    req->size = cb;
+    memcpy( req->data, pv, cb );
+    submit_write_request( output->writer, req );
+    return cb;
 }
 
 static int CDECL cabinet_close(INT_PTR hf)
 {
     HANDLE handle = (HANDLE)hf;
+
+    if (abort_output( hf )) return 0;
     return CloseHandle(handle) ? 0 : -1;
 }
 
@@ -238,6 +507,8 @@ static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
 static int CDECL cabinet_close_stream( INT_PTR hf )
 {
     IStream *stm = (IStream *)hf;
+
+    if (abort_output( hf )) return 0;
     IStream_Release( stm );
     return 0;
 }
@@ -398,10 +669,8 @@ static INT_PTR cabinet_next_cabinet_stream( FDINOTIFICATIONTYPE fdint,
     return 0;
 }
 
-static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
-                                 PFDINOTIFICATION pfdin)
+static HANDLE open_output_file( MSICABDATA *data, PFDINOTIFICATION pfdin )
 {
-    MSICABDATA *data = pfdin->pv;
     HANDLE handle = 0;
     LPWSTR path = NULL;
     DWORD attrs;
@@ -448,13 +717,18 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 
             TRACE("file in use, scheduling rename operation\n");
 
-            if (!(tmppathW = wcsdup(path))) return ERROR_OUTOFMEMORY;
+            if (!(tmppathW = wcsdup(path)))
+            {
+                handle = INVALID_HANDLE_VALUE;
+                goto done;
+            }
             if ((p = wcsrchr(tmppathW, '\\'))) *p = 0;
             len = lstrlenW( tmppathW ) + 16;
             if (!(tmpfileW = malloc(len * sizeof(WCHAR))))
             {
                 free( tmppathW );
-                return ERROR_OUTOFMEMORY;
+                handle = INVALID_HANDLE_VALUE;
+                goto done;
             }
             if (!msi_get_temp_file_name( data->package, tmppathW, L"msi", tmpfileW )) tmpfileW[0] = 0;
             free( tmppathW );
@@ -480,37 +754,49 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 done:
     free(path);
 
-    return (INT_PTR)handle;
+    return handle;
+}
+
+static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
+                                 PFDINOTIFICATION pfdin)
+{
+    struct cabinet_extract *ctx = pfdin->pv;
+    HANDLE handle;
+
+    if (ctx->folders && !claim_folder( ctx, pfdin->iFolder )) return 0;
+
+    lock_extract( ctx );
+    handle = open_output_file( &ctx->data, pfdin );
+    unlock_extract( ctx );
+
+    if (!handle || handle == INVALID_HANDLE_VALUE) return (INT_PTR)handle;
+    return create_output( ctx->writer, handle );
 }
 
 static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
                                        PFDINOTIFICATION pfdin)
 {
-    MSICABDATA *data = pfdin->pv;
+    struct cabinet_extract *ctx = pfdin->pv;
+    MSICABDATA *data = &ctx->data;
+    struct cabinet_output *output = (struct cabinet_output *)pfdin->hf;
     FILETIME ft;
     FILETIME ftLocal;
-    HANDLE handle = (HANDLE)pfdin->hf;
 
     data->mi->is_continuous = FALSE;
 
-    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
+    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft) ||
+        !LocalFileTimeToFileTime(&ft, &ftLocal))
     {
-        CloseHandle(handle);
-        return -1;
-    }
-    if (!LocalFileTimeToFileTime(&ft, &ftLocal))
-    {
-        CloseHandle(handle);
-        return -1;
-    }
-    if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
-    {
-        CloseHandle(handle);
+        close_output( output, NULL );
         return -1;
     }
 
-    CloseHandle(handle);
+    /* a failure to write the file fails the whole extraction */
+    close_output( output, &ftLocal );
+
+    lock_extract( ctx );
     data->cb(data->package, data->curfile, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL, data->user);
+    unlock_extract( ctx );
 
     free(data->curfile);
     data->curfile = NULL;
@@ -564,14 +850,11 @@ static INT_PTR CDECL cabinet_notify_stream( FDINOTIFICATIONTYPE fdint, PFDINOTIF
     }
 }
 
-static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data )
+static BOOL copy_cabinet( struct cabinet_extract *ctx, char *cabinet, char *cab_path )
 {
-    LPSTR cabinet, cab_path = NULL;
     HFDI hfdi;
     ERF erf;
-    BOOL ret = FALSE;
-
-    TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
+    BOOL ret;
 
     hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open, cabinet_read,
                       cabinet_write, cabinet_close, cabinet_seek, 0, &erf );
@@ -581,6 +864,115 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
         return FALSE;
     }
 
+    ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, ctx );
+    if (!ret)
+        ERR("FDICopy failed\n");
+
+    FDIDestroy( hfdi );
+    return ret;
+}
+
+/* returns the number of folders of a cabinet that doesn't span several files */
+static UINT get_cabinet_folder_count( const char *cabinet, const char *cab_path )
+{
+    FDICABINETINFO info;
+    UINT count = 0;
+    INT_PTR hf;
+    HFDI hfdi;
+    char *path;
+    ERF erf;
+
+    if (!(path = malloc( strlen( cab_path ) + strlen( cabinet ) + 1 ))) return 0;
+    strcpy( path, cab_path );
+    strcat( path, cabinet );
+
+    hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open, cabinet_read,
+                      cabinet_write, cabinet_close, cabinet_seek, 0, &erf );
+    if (hfdi)
+    {
+        if ((hf = cabinet_open( path, _O_RDONLY, 0 )) != -1)
+        {
+            if (FDIIsCabinet( hfdi, hf, &info ) && !info.hasprev && !info.hasnext)
+                count = info.cFolders;
+            cabinet_close( hf );
+        }
+        FDIDestroy( hfdi );
+    }
+    free( path );
+    return count;
+}
+
+static void extract_folders_cb( void *arg, UINT index )
+{
+    struct cabinet_folders *folders = arg;
+
+    if (!copy_cabinet( &folders->workers[index], folders->cabinet, folders->cab_path ))
+        InterlockedExchange( &folders->failed, TRUE );
+}
+
+static BOOL extract_folders( MSICABDATA *data, struct cabinet_writer *writer, UINT folder_count,
+                             char *cabinet, char *cab_path )
+{
+    UINT i, count = min( folder_count, msi_get_worker_count() );
+    struct cabinet_folders folders;
+    BOOL ret = FALSE;
+
+    folders.owner = malloc( folder_count * sizeof(*folders.owner) );
+    folders.workers = calloc( count, sizeof(*folders.workers) );
+    if (folders.owner && folders.workers)
+    {
+        TRACE("extracting %u folders on %u threads\n", folder_count, count);
+
+        InitializeCriticalSection( &folders.cs );
+        folders.cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": cabinet_folders.cs");
+        for (i = 0; i < folder_count; i++) folders.owner[i] = -1;
+        folders.count = folder_count;
+        folders.cabinet = cabinet;
+        folders.cab_path = cab_path;
+        folders.failed = FALSE;
+
+        for (i = 0; i < count; i++)
+        {
+            struct cabinet_extract *ctx = &folders.workers[i];
+
+            ctx->data = *data;
+            ctx->mi = *data->mi;
+            ctx->data.mi = &ctx->mi;
+            ctx->cursor = *(void **)data->user;
+            ctx->data.user = &ctx->cursor;
+            ctx->writer = writer;
+            ctx->folders = &folders;
+            ctx->worker = i;
+        }
+
+        msi_run_parallel( count, extract_folders_cb, &folders );
+
+        for (i = 0; i < count; i++)
+            if (!folders.workers[i].mi.is_continuous) data->mi->is_continuous = FALSE;
+        ret = !folders.failed;
+
+        folders.cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection( &folders.cs );
+    }
+    free( folders.owner );
+    free( folders.workers );
+    return ret;
+}
+
+static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, MSICABDATA *data,
+                             struct cabinet_writer *writer )
+{
+    struct cabinet_extract ctx;
+    LPSTR cabinet, cab_path = NULL;
+    BOOL ret = FALSE;
+    UINT count;
+
+    TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
+
+    memset( &ctx, 0, sizeof(ctx) );
+    ctx.data = *data;
+    ctx.writer = writer;
+
     cabinet = strdupWtoU( mi->cabinet );
     if (!cabinet)
         goto done;
@@ -589,30 +981,33 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
     if (!cab_path)
         goto done;
 
-    ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, data );
-    if (!ret)
-        ERR("FDICopy failed\n");
+    if (msi_can_use_workers( package ) && msi_get_worker_count() > 1 &&
+        (count = get_cabinet_folder_count( cabinet, cab_path )) > 1)
+        ret = extract_folders( data, writer, count, cabinet, cab_path );
+    else
+        ret = copy_cabinet( &ctx, cabinet, cab_path );
 
 done:
-    FDIDestroy( hfdi );
     free( cabinet );
     free( cab_path );
-
-    if (ret)
-        mi->is_extracted = TRUE;
-
     return ret;
 }
 
-static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOID data )
+static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, MSICABDATA *data,
+                                    struct cabinet_writer *writer )
 {
     static char filename[] = {'<','S','T','R','E','A','M','>',0};
+    struct cabinet_extract ctx;
     HFDI hfdi;
     ERF erf;
     BOOL ret = FALSE;
 
     TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
 
+    memset( &ctx, 0, sizeof(ctx) );
+    ctx.data = *data;
+    ctx.writer = writer;
+
     hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open_stream, cabinet_read_stream,
                       cabinet_write, cabinet_close_stream, cabinet_seek_stream, 0, &erf );
     if (!hfdi)
@@ -624,11 +1019,10 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     package_disk.package = package;
     package_disk.id      = mi->disk_id;
 
-    ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, data );
+    ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, &ctx );
     if (!ret) ERR("FDICopy failed\n");
 
     FDIDestroy( hfdi );
-    if (ret) mi->is_extracted = TRUE;
     return ret;
 }
 
@@ -639,11 +1033,24 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
  */
 BOOL msi_cabextract(MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data)
 {
+    struct cabinet_writer writer;
+    DWORD err;
+    BOOL ret;
+
+    init_cabinet_writer( &writer );
+
     if (mi->cabinet[0] == '#')
+        ret = extract_cabinet_stream( package, mi, data, &writer );
+    else
+        ret = extract_cabinet( package, mi, data, &writer );
+
+    if ((err = finish_cabinet_writer( &writer )))
     {
-        return extract_cabinet_stream( package, mi, data );
+        ERR("failed to write extracted files (%lu)\n", err);
+        ret = FALSE;
     }
-    return extract_cabinet( package, mi, data );
+    if (ret) mi->is_extracted = TRUE;
+    return ret;
 }
 
 void msi_free_media_info(MSIMEDIAINFO *mi)
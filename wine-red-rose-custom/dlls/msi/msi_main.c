@@ -87,6 +87,86 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
     return TRUE;
 }
 
+#define MSI_MAX_WORKERS 8
+
+struct parallel_job
+{
+    void (*func)( void *, UINT );
+    void *ctx;
+    UINT count;
+    LONG next;
+    LONG pending;
+    HANDLE done_event;
+};
+
+UINT msi_get_worker_count(void)
+{
+    static LONG worker_count;
+    SYSTEM_INFO info;
+    LONG count;
+
+    if ((count = ReadNoFence( &worker_count ))) return count;
+
+    GetSystemInfo( &info );
+    count = min( max( info.dwNumberOfProcessors, 1 ), MSI_MAX_WORKERS );
+    InterlockedExchange( &worker_count, count );
+    return count;
+}
+
+static void parallel_job_process( struct parallel_job *job )
+{
+    UINT index;
+
+    while ((index = InterlockedIncrement( &job->next ) - 1) < job->count)
+        job->func( job->ctx, index );
+}
+
+static void CALLBACK parallel_job_callback( TP_CALLBACK_INSTANCE *instance, void *ctx )
+{
+    struct parallel_job *job = ctx;
+
+    parallel_job_process( job );
+    if (!InterlockedDecrement( &job->pending ))
+        SetEventWhenCallbackReturns( instance, job->done_event );
+}
+
+/* calls func once for each index below count, possibly from several threads
+ * including the calling one, and returns when all calls are done */
+void msi_run_parallel( UINT count, void (*func)( void *, UINT ), void *ctx )
+{
+    struct parallel_job job;
+    UINT i, workers = min( msi_get_worker_count(), count );
+
+    if (workers <= 1 || !(job.done_event = CreateEventW( NULL, TRUE, FALSE, NULL )))
+    {
+        for (i = 0; i < count; i++) func( ctx, i );
+        return;
+    }
+
+    TRACE( "running %u jobs on %u threads\n", count, workers );
+
+    job.func = func;
+    job.ctx = ctx;
+    job.count = count;
+    job.next = 0;
+    job.pending = workers;
+
+    for (i = 1; i < workers; i++)
+    {
+        if (!TrySubmitThreadpoolCallback( parallel_job_callback, &job, NULL ))
+        {
+            WARN( "failed to submit thread pool callback, error %lu\n", GetLastError() );
+            InterlockedAdd( &job.pending, -(LONG)(workers - i) );
+            break;
+        }
+    }
+
+    parallel_job_process( &job );
+    if (InterlockedDecrement( &job.pending ))
+        WaitForSingleObject( job.done_event, INFINITE );
+    CloseHandle( job.done_event );
+}
+
 struct class_factory
 {
     IClassFactory IClassFactory_iface;
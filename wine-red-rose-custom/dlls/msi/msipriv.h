@@ -226,7 +226,7 @@ typedef struct _column_info
     struct _column_info *next;
 } column_info;
 
-typedef const struct tagMSICOLUMNHASHENTRY *MSIITERHANDLE;
+typedef const struct column_hash_entry *MSIITERHANDLE;
 
 typedef struct tagMSIVIEWOPS
 {
@@ -323,6 +323,17 @@ typedef struct tagMSIVIEWOPS
      */
     UINT (*delete)( struct tagMSIVIEW * );
 
+    /*
+     * find_matching_rows - iterates through rows that match a value
+     *
+     * The value is compared with what fetch_int returns for the column, so
+     *  a string ID should be passed in for string columns.
+     *
+     * The handle must be initialized to NULL before the first call, the
+     *  function returns ERROR_NO_MORE_ITEMS when there are no more rows.
+     */
+    UINT (*find_matching_rows)( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row, MSIITERHANDLE *handle );
+
     /*
      * add_ref - increases the reference count of the table
      */
@@ -1077,6 +1088,14 @@ static inline void msi_revert_fs_redirection( MSIPACKAGE *package )
 {
     if (is_wow64 && package->platform == PLATFORM_X64) Wow64RevertWow64FsRedirection( package->cookie );
 }
+/* the redirection cookie lives in the package, so file system work can only
+ * be spread over worker threads when there is nothing to redirect */
+static inline BOOL msi_can_use_workers( MSIPACKAGE *package )
+{
+    return !(is_wow64 && package->platform == PLATFORM_X64);
+}
+extern UINT msi_get_worker_count(void);
+extern void msi_run_parallel( UINT count, void (*func)( void *, UINT ), void * );
 extern BOOL msi_get_temp_file_name( MSIPACKAGE *, const WCHAR *, const WCHAR *, WCHAR * );
 extern HANDLE msi_create_file( MSIPACKAGE *, const WCHAR *, DWORD, DWORD, DWORD, DWORD );
 extern BOOL msi_delete_file( MSIPACKAGE *, const WCHAR * );
@@ -1101,6 +1120,8 @@ typedef BOOL (*PMSICABEXTRACTCB)(MSIPACKAGE *, LPCWSTR, DWORD, LPWSTR *, DWORD *
 #define MSICABEXTRACT_BEGINEXTRACT  0x01
 #define MSICABEXTRACT_FILEEXTRACTED 0x02
 
+/* The callback may be called from several threads, one call at a time.
+ * user points to a pointer that is copied for each extraction thread. */
 typedef struct
 {
     MSIPACKAGE* package;
@@ -370,6 +370,7 @@ static const MSIVIEWOPS select_ops =
     NULL,
     NULL,
     NULL,
+    NULL,
 };
 
 static UINT SELECT_AddColumn( struct select_view *sv, const WCHAR *name, const WCHAR *table_name )
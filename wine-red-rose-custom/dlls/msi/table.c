@@ -38,7 +38,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(msidb);
 
-#define MSITABLE_HASH_TABLE_SIZE 37
+#define MSITABLE_HASH_MIN_BITS 4
 
 struct column_hash_entry
 {
@@ -47,6 +47,15 @@ struct column_hash_entry
     UINT row;
 };
 
+/* index of the values of a column, built on the first lookup and freed
+ * whenever the column or the row order changes */
+struct column_hash
+{
+    UINT bits;
+    struct column_hash_entry **buckets;
+    struct column_hash_entry entries[1];
+};
+
 struct column_info
 {
     LPCWSTR tablename;
@@ -54,7 +63,7 @@ struct column_info
     LPCWSTR colname;
     UINT    type;
     UINT    offset;
-    struct column_hash_entry **hash_table;
+    struct column_hash *hash_table;
 };
 
 struct tagMSITABLE
@@ -1155,6 +1164,87 @@ static UINT TABLE_fetch_stream( struct tagMSIVIEW *view, UINT row, UINT col, ISt
     return r;
 }
 
+static inline UINT column_hash_bucket( const struct column_hash *hash, UINT value )
+{
+    return (value * 0x9e3779b1) >> (32 - hash->bits);
+}
+
+static void table_free_hash( struct table_view *tv )
+{
+    UINT i;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        free( tv->columns[i].hash_table );
+        tv->columns[i].hash_table = NULL;
+    }
+}
+
+static struct column_hash *table_build_hash( struct table_view *tv, UINT col )
+{
+    UINT i, bits = MSITABLE_HASH_MIN_BITS, count = tv->table->row_count;
+    struct column_hash *hash;
+
+    while (bits < 31 && (1u << bits) < count) bits++;
+
+    if (!(hash = malloc( offsetof( struct column_hash, entries[count] ) + (sizeof(*hash->buckets) << bits) )))
+        return NULL;
+    hash->bits = bits;
+    hash->buckets = (struct column_hash_entry **)&hash->entries[count];
+    memset( hash->buckets, 0, sizeof(*hash->buckets) << bits );
+
+    /* insert backwards to keep the rows of each value in ascending order */
+    for (i = count; i-- > 0;)
+    {
+        struct column_hash_entry *entry = &hash->entries[i];
+        UINT bucket;
+
+        if (TABLE_fetch_int( &tv->view, i, col, &entry->value ) != ERROR_SUCCESS)
+        {
+            free( hash );
+            return NULL;
+        }
+        entry->row = i;
+        bucket = column_hash_bucket( hash, entry->value );
+        entry->next = hash->buckets[bucket];
+        hash->buckets[bucket] = entry;
+    }
+
+    TRACE("built index on %s.%s, %u rows\n", debugstr_w(tv->name),
+          debugstr_w(tv->columns[col - 1].colname), count);
+    tv->columns[col - 1].hash_table = hash;
+    return hash;
+}
+
+static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row,
+                                      MSIITERHANDLE *handle )
+{
+    struct table_view *tv = (struct table_view *)view;
+    const struct column_hash_entry *entry;
+    struct column_hash *hash;
+
+    TRACE("%p, %u, %04x, %p\n", tv, col, val, *handle);
+
+    if (!tv->table || col == 0 || col > tv->num_cols)
+        return ERROR_INVALID_PARAMETER;
+
+    if (!(hash = tv->columns[col - 1].hash_table) && !(hash = table_build_hash( tv, col )))
+        return ERROR_OUTOFMEMORY;
+
+    if (*handle) entry = (*handle)->next;
+    else entry = hash->buckets[column_hash_bucket( hash, val )];
+
+    while (entry && entry->value != val)
+        entry = entry->next;
+
+    *handle = entry;
+    if (!entry)
+        return ERROR_NO_MORE_ITEMS;
+
+    *row = entry->row;
+    return ERROR_SUCCESS;
+}
+
 /* Set a table value, i.e. preadjusted integer or string ID. */
 static UINT table_set_bytes( struct table_view *tv, UINT row, UINT col, UINT val )
 {
@@ -1520,6 +1610,8 @@ static UINT table_create_new_row( struct tagMSIVIEW *view, UINT *num, BOOL tempo
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    table_free_hash( tv );
+
     *data_ptr = p;
     (*data_ptr)[*row_count] = row;
 
@@ -1758,12 +1850,7 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
     num_rows = tv->table->row_count;
     tv->table->row_count--;
 
-    /* reset the hash tables */
-    for (i = 0; i < tv->num_cols; i++)
-    {
-        free(tv->columns[i].hash_table);
-        tv->columns[i].hash_table = NULL;
-    }
+    table_free_hash( tv );
 
     for (i = row + 1; i < num_rows; i++)
     {
@@ -1947,6 +2034,7 @@ static UINT TABLE_remove_column(struct tagMSIVIEW *view, UINT number)
     if (tv->table->colinfo[number-1].type & MSITYPE_TEMPORARY)
     {
         UINT size = tv->table->colinfo[number-1].offset;
+        free(tv->table->colinfo[number-1].hash_table);
         tv->table->col_count--;
         tv->table->colinfo = realloc(tv->table->colinfo, sizeof(*tv->table->colinfo) * tv->table->col_count);
 
@@ -2181,6 +2269,7 @@ static const MSIVIEWOPS table_ops =
     TABLE_get_column_info,
     TABLE_modify,
     TABLE_delete,
+    TABLE_find_matching_rows,
     TABLE_add_ref,
     TABLE_release,
     TABLE_add_column,
@@ -2762,6 +2851,7 @@ static const MSIVIEWOPS transform_view_ops =
     NULL,
     NULL,
     NULL,
+    NULL,
     NULL
 };
 
@@ -3153,6 +3243,29 @@ static UINT table_find_row( struct table_view *tv, MSIRECORD *rec, UINT *row, UI
     data = record_to_row( tv, rec );
     if( !data )
         return r;
+
+    /* use the index of the first key column if there is one, it's not worth
+     * building it here since rows are usually looked up before being inserted */
+    for( i = 0; i < tv->num_cols; i++ )
+        if ( tv->columns[i].type & MSITYPE_KEY ) break;
+    if ( i < tv->num_cols && tv->columns[i].hash_table )
+    {
+        MSIITERHANDLE handle = NULL;
+        UINT col = i + 1, n;
+
+        while ( TABLE_find_matching_rows( &tv->view, col, data[col - 1], &n, &handle ) == ERROR_SUCCESS )
+        {
+            r = row_matches( tv, n, data, column );
+            if( r == ERROR_SUCCESS )
+            {
+                *row = n;
+                break;
+            }
+        }
+        free( data );
+        return r;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = row_matches( tv, i, data, column );
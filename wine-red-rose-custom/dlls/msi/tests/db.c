@@ -9406,6 +9406,215 @@ static void test_viewfetch_wraparound(void)
     DeleteFileA(msifile);
 }
 
+static int count_rows( MSIHANDLE hdb, MSIHANDLE hrec, const char *query )
+{
+    MSIHANDLE hview, rec;
+    int count = 0;
+    UINT r;
+
+    r = MsiDatabaseOpenViewA( hdb, query, &hview );
+    if (r != ERROR_SUCCESS) return -1;
+    r = MsiViewExecute( hview, hrec );
+    if (r == ERROR_SUCCESS)
+    {
+        while (MsiViewFetch( hview, &rec ) == ERROR_SUCCESS)
+        {
+            MsiCloseHandle( rec );
+            count++;
+        }
+    }
+    else count = -1;
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+    return count;
+}
+
+static void test_indexed_query(void)
+{
+    MSIHANDLE hdb, hrec;
+    char query[256];
+    int count;
+    UINT r, i;
+
+    hdb = create_db();
+    ok( hdb, "failed to create db\n" );
+
+    r = run_query( hdb, 0, "CREATE TABLE `Item` (`Key` CHAR(72) NOT NULL, `Num` SHORT, `Big` LONG, "
+                           "`Owner` CHAR(72) PRIMARY KEY `Key`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, 0, "CREATE TABLE `Owner` (`Name` CHAR(72) NOT NULL, `Id` SHORT PRIMARY KEY `Name`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    for (i = 0; i < 100; i++)
+    {
+        sprintf( query, "INSERT INTO `Item` (`Key`, `Num`, `Big`, `Owner`) VALUES ('item%u', %u, %u, 'owner%u')",
+                 i, i % 10, i * 100000, i % 4 );
+        r = run_query( hdb, 0, query );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+    }
+    for (i = 0; i < 4; i++)
+    {
+        sprintf( query, "INSERT INTO `Owner` (`Name`, `Id`) VALUES ('owner%u', %u)", i, i );
+        r = run_query( hdb, 0, query );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+    }
+
+    r = do_query( hdb, "SELECT * FROM `Item` WHERE `Key` = 'item42'", &hrec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( hrec, 4, "item42", "2", "4200000", "owner2" );
+    MsiCloseHandle( hrec );
+
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Key` = 'nothere'" );
+    ok( count == 0, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 3" );
+    ok( count == 10, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 3 AND `Big` = 1300000" );
+    ok( count == 1, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 70000" );
+    ok( count == 0, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Big` = -5" );
+    ok( count == 0, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 3 OR `Num` = 4" );
+    ok( count == 20, "got %d\n", count );
+
+    hrec = MsiCreateRecord( 2 );
+    MsiRecordSetInteger( hrec, 1, 3 );
+    MsiRecordSetStringA( hrec, 2, "item13" );
+    count = count_rows( hdb, hrec, "SELECT * FROM `Item` WHERE `Num` = ? AND `Key` = ?" );
+    ok( count == 1, "got %d\n", count );
+    MsiRecordSetInteger( hrec, 1, 4 );
+    count = count_rows( hdb, hrec, "SELECT * FROM `Item` WHERE `Num` = ? AND `Key` = ?" );
+    ok( count == 0, "got %d\n", count );
+    MsiCloseHandle( hrec );
+
+    count = count_rows( hdb, 0, "SELECT `Item`.`Key`, `Owner`.`Id` FROM `Item`, `Owner` "
+                                "WHERE `Item`.`Owner` = `Owner`.`Name`" );
+    ok( count == 100, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT `Item`.`Key` FROM `Item`, `Owner` WHERE `Item`.`Num` = `Owner`.`Id`" );
+    ok( count == 40, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT `Item`.`Key` FROM `Item`, `Owner` "
+                                "WHERE `Owner`.`Name` = 'owner1' AND `Item`.`Owner` = `Owner`.`Name`" );
+    ok( count == 25, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT `Item`.`Key` FROM `Item`, `Owner` "
+                                "WHERE `Item`.`Owner` = `Owner`.`Name` AND `Item`.`Num` = `Owner`.`Id`" );
+    ok( count == 20, "got %d\n", count );
+
+    /* the indexes must follow modifications of the table */
+    r = run_query( hdb, 0, "UPDATE `Item` SET `Num` = 3 WHERE `Key` = 'item0'" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 3" );
+    ok( count == 11, "got %d\n", count );
+
+    r = run_query( hdb, 0, "INSERT INTO `Item` (`Key`, `Num`) VALUES ('item100', 3)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 3" );
+    ok( count == 12, "got %d\n", count );
+    r = run_query( hdb, 0, "INSERT INTO `Item` (`Key`, `Num`) VALUES ('item100', 5)" );
+    ok( r != ERROR_SUCCESS, "duplicate key inserted\n" );
+
+    r = run_query( hdb, 0, "DELETE FROM `Item` WHERE `Key` = 'item13'" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Num` = 3" );
+    ok( count == 11, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Key` = 'item13'" );
+    ok( count == 0, "got %d\n", count );
+    count = count_rows( hdb, 0, "SELECT * FROM `Item` WHERE `Key` = 'item100'" );
+    ok( count == 1, "got %d\n", count );
+
+    /* null and empty strings compare equal */
+    hrec = MsiCreateRecord( 1 );
+    MsiRecordSetStringA( hrec, 1, "" );
+    count = count_rows( hdb, hrec, "SELECT * FROM `Item` WHERE `Owner` = ?" );
+    ok( count == 1, "got %d\n", count );
+    MsiCloseHandle( hrec );
+
+    MsiCloseHandle( hdb );
+    DeleteFileA( msifile );
+}
+
+static double elapsed_ms( LARGE_INTEGER start, LARGE_INTEGER freq )
+{
+    LARGE_INTEGER end;
+
+    QueryPerformanceCounter( &end );
+    return (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+static void benchmark_indexed_query(void)
+{
+    static const UINT files = 20000, components = 2000, lookups = 2000;
+    MSIHANDLE hdb, hview, hrec;
+    LARGE_INTEGER freq, start;
+    char buffer[32];
+    int count;
+    UINT r, i;
+
+    hdb = create_db();
+    ok( hdb, "failed to create db\n" );
+
+    r = run_query( hdb, 0, "CREATE TABLE `File` (`File` CHAR(72) NOT NULL, `Component_` CHAR(72) NOT NULL, "
+                           "`Sequence` LONG PRIMARY KEY `File`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, 0, "CREATE TABLE `Component` (`Component` CHAR(72) NOT NULL, `Attributes` SHORT "
+                           "PRIMARY KEY `Component`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+
+    hrec = MsiCreateRecord( 3 );
+    r = MsiDatabaseOpenViewA( hdb, "INSERT INTO `File` (`File`, `Component_`, `Sequence`) VALUES (?, ?, ?)", &hview );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    for (i = 0; i < files; i++)
+    {
+        sprintf( buffer, "file%u", i );
+        MsiRecordSetStringA( hrec, 1, buffer );
+        sprintf( buffer, "comp%u", i % components );
+        MsiRecordSetStringA( hrec, 2, buffer );
+        MsiRecordSetInteger( hrec, 3, i + 1 );
+        r = MsiViewExecute( hview, hrec );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+    }
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+
+    r = MsiDatabaseOpenViewA( hdb, "INSERT INTO `Component` (`Component`, `Attributes`) VALUES (?, ?)", &hview );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    for (i = 0; i < components; i++)
+    {
+        sprintf( buffer, "comp%u", i );
+        MsiRecordSetStringA( hrec, 1, buffer );
+        MsiRecordSetInteger( hrec, 2, i & 0xff );
+        r = MsiViewExecute( hview, hrec );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+    }
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+    MsiCloseHandle( hrec );
+    trace( "inserted %u files and %u components in %.1f ms\n", files, components, elapsed_ms( start, freq ) );
+
+    hrec = MsiCreateRecord( 1 );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < lookups; i++)
+    {
+        sprintf( buffer, "file%u", (i * 7919) % files );
+        MsiRecordSetStringA( hrec, 1, buffer );
+        count = count_rows( hdb, hrec, "SELECT `Sequence` FROM `File` WHERE `File` = ?" );
+        ok( count == 1, "got %d\n", count );
+    }
+    trace( "%u key lookups in %.1f ms\n", lookups, elapsed_ms( start, freq ) );
+    MsiCloseHandle( hrec );
+
+    QueryPerformanceCounter( &start );
+    count = count_rows( hdb, 0, "SELECT `File`.`File`, `Component`.`Attributes` FROM `File`, `Component` "
+                                "WHERE `File`.`Component_` = `Component`.`Component`" );
+    ok( count == files, "got %d\n", count );
+    trace( "join of %u rows in %.1f ms\n", count, elapsed_ms( start, freq ) );
+
+    MsiCloseHandle( hdb );
+    DeleteFileA( msifile );
+}
+
 START_TEST(db)
 {
     test_msidatabase();
@@ -9466,4 +9675,6 @@ START_TEST(db)
     test_viewmodify_insert();
     test_view_get_error();
     test_viewfetch_wraparound();
+    test_indexed_query();
+    if (winetest_interactive) benchmark_indexed_query();
 }
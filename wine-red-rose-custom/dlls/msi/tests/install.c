@@ -384,6 +384,18 @@ static const CHAR co_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion
                                   "augustus\taugustus\taugustus\t50000\t\t\t16384\t2\n"
                                   "caesar\tcaesar\tcaesar\t500\t\t\t16384\t3";
 
+static const CHAR bf_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion\tLanguage\tAttributes\tSequence\n"
+                                  "s72\ts72\tl255\ti4\tS72\tS20\tI2\ti2\n"
+                                  "File\tFile\n"
+                                  "maximus\tmaximus\tmaximus\t500\t\t\t8192\t1\n"
+                                  "augustus\taugustus\taugustus\t500\t\t\t8192\t2\n"
+                                  "caesar\tcaesar\tcaesar\t500\t\t\t8192\t3";
+
+static const CHAR bf_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
+                                   "i2\ti4\tL64\tS255\tS32\tS72\n"
+                                   "Media\tDiskId\n"
+                                   "1\t3\t\t\tDISK1\t\n";
+
 static const CHAR co_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
                                    "i2\ti4\tL64\tS255\tS32\tS72\n"
                                    "Media\tDiskId\n"
@@ -391,6 +403,11 @@ static const CHAR co_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tV
                                    "2\t2\t\ttest2.cab\tDISK2\t\n"
                                    "3\t3\t\ttest3.cab\tDISK3\t\n";
 
+static const CHAR mf_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
+                                   "i2\ti4\tL64\tS255\tS32\tS72\n"
+                                   "Media\tDiskId\n"
+                                   "1\t3\t\ttest1.cab\tDISK1\t\n";
+
 static const CHAR co2_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
                                     "i2\ti4\tL64\tS255\tS32\tS72\n"
                                     "Media\tDiskId\n"
@@ -1598,6 +1615,30 @@ static const msi_table co_tables[] =
     ADD_TABLE(property),
 };
 
+static const msi_table mf_tables[] =
+{
+    ADD_TABLE(cc_component),
+    ADD_TABLE(directory),
+    ADD_TABLE(cc_feature),
+    ADD_TABLE(cc_feature_comp),
+    ADD_TABLE(co_file),
+    ADD_TABLE(install_exec_seq),
+    ADD_TABLE(mf_media),
+    ADD_TABLE(property),
+};
+
+static const msi_table bf_tables[] =
+{
+    ADD_TABLE(cc_component),
+    ADD_TABLE(directory),
+    ADD_TABLE(cc_feature),
+    ADD_TABLE(cc_feature_comp),
+    ADD_TABLE(bf_file),
+    ADD_TABLE(install_exec_seq),
+    ADD_TABLE(bf_media),
+    ADD_TABLE(property),
+};
+
 static const msi_table co2_tables[] =
 {
     ADD_TABLE(cc_component),
@@ -3612,6 +3653,121 @@ error:
     RemoveDirectoryA("msitest");
 }
 
+static void test_multifolder_cab(void)
+{
+    CCAB cabParams;
+    HFCI hfci;
+    ERF erf;
+    BOOL res;
+    UINT r;
+
+    if (is_process_limited())
+    {
+        skip("process is limited\n");
+        return;
+    }
+
+    create_file("maximus", 500);
+    create_file("augustus", 50000);
+    create_file("caesar", 500);
+
+    /* one folder per file, so that the folders may be extracted in parallel */
+    set_cab_parameters(&cabParams, "test1.cab", MEDIA_SIZE);
+
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                      fci_read, fci_write, fci_close, fci_seek, fci_delete,
+                      get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    res = add_file(hfci, "maximus", tcompTYPE_MSZIP);
+    ok(res, "Failed to add file maximus\n");
+    res = FCIFlushFolder(hfci, get_next_cabinet, progress);
+    ok(res, "Failed to flush the folder\n");
+
+    res = add_file(hfci, "augustus", tcompTYPE_MSZIP);
+    ok(res, "Failed to add file augustus\n");
+    res = FCIFlushFolder(hfci, get_next_cabinet, progress);
+    ok(res, "Failed to flush the folder\n");
+
+    res = add_file(hfci, "caesar", tcompTYPE_NONE);
+    ok(res, "Failed to add file caesar\n");
+
+    res = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(res, "Failed to flush the cabinet\n");
+
+    res = FCIDestroy(hfci);
+    ok(res, "Failed to destroy the cabinet\n");
+
+    create_database(msifile, mf_tables, ARRAY_SIZE(mf_tables));
+
+    MsiSetInternalUI(INSTALLUILEVEL_NONE, NULL);
+
+    r = MsiInstallProductA(msifile, NULL);
+    if (r == ERROR_INSTALL_PACKAGE_REJECTED)
+    {
+        skip("Not enough rights to perform tests\n");
+        goto error;
+    }
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    ok(delete_pf("msitest\\maximus", TRUE), "File not installed\n");
+    ok(delete_pf("msitest\\augustus", TRUE), "File not installed\n");
+    ok(delete_pf("msitest\\caesar", TRUE), "File not installed\n");
+    ok(delete_pf("msitest", FALSE), "Directory not created\n");
+
+error:
+    delete_cab_files();
+    DeleteFileA(msifile);
+    DeleteFileA("maximus");
+    DeleteFileA("augustus");
+    DeleteFileA("caesar");
+}
+
+static void test_copy_failure(void)
+{
+    CHAR path[MAX_PATH];
+    UINT r;
+
+    if (is_process_limited())
+    {
+        skip("process is limited\n");
+        return;
+    }
+
+    CreateDirectoryA("msitest", NULL);
+    create_file("msitest\\maximus", 500);
+    create_file("msitest\\augustus", 500);
+    create_file("msitest\\caesar", 500);
+    create_database(msifile, bf_tables, ARRAY_SIZE(bf_tables));
+
+    MsiSetInternalUI(INSTALLUILEVEL_NONE, NULL);
+
+    /* a directory in place of the second file makes its copy fail */
+    lstrcpyA(path, PROG_FILES_DIR);
+    lstrcatA(path, "\\msitest");
+    CreateDirectoryA(path, NULL);
+    lstrcatA(path, "\\augustus");
+    CreateDirectoryA(path, NULL);
+
+    r = MsiInstallProductA(msifile, NULL);
+    if (r == ERROR_INSTALL_PACKAGE_REJECTED)
+    {
+        skip("Not enough rights to perform tests\n");
+        goto error;
+    }
+    ok(r == ERROR_INSTALL_FAILURE, "Expected ERROR_INSTALL_FAILURE, got %u\n", r);
+    ok(!delete_pf("msitest\\caesar", TRUE), "File after the failed one installed\n");
+
+error:
+    delete_pf("msitest\\maximus", TRUE);
+    delete_pf("msitest\\augustus", FALSE);
+    delete_pf("msitest", FALSE);
+    DeleteFileA("msitest\\maximus");
+    DeleteFileA("msitest\\augustus");
+    DeleteFileA("msitest\\caesar");
+    RemoveDirectoryA("msitest");
+    DeleteFileA(msifile);
+}
+
 BOOL file_exists(const char *file)
 {
     return GetFileAttributesA(file) != INVALID_FILE_ATTRIBUTES;
@@ -6335,6 +6491,8 @@ START_TEST(install)
     test_readonlyfile_cab();
     test_setdirproperty();
     test_cabisextracted();
+    test_multifolder_cab();
+    test_copy_failure();
     test_transformprop();
     test_currentworkingdir();
     test_admin();
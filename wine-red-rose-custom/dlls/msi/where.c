@@ -53,6 +53,14 @@ struct join_table
     UINT table_index;
 };
 
+/* equality used to look up the rows of a table instead of scanning it */
+struct join_lookup
+{
+    const struct expr *column; /* indexed column of the table */
+    const struct expr *value;  /* constant, wildcard or column of an outer table */
+    UINT wildcard;             /* record field of a wildcard value */
+};
+
 typedef struct tagMSIORDERINFO
 {
     UINT col_count;
@@ -647,16 +655,108 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+/* returns ERROR_NO_MORE_ITEMS if no row can match and ERROR_CONTINUE if the
+ * table has to be scanned */
+static UINT lookup_key( MSIWHEREVIEW *wv, const struct join_lookup *lookup, const UINT rows[],
+                        MSIRECORD *record, UINT *key )
+{
+    const struct expr *value = lookup->value;
+    const WCHAR *str = NULL;
+    UINT r, tval;
+    INT val = 0;
+
+    if (lookup->column->type == EXPR_COL_NUMBER_STRING)
+    {
+        switch (value->type)
+        {
+        case EXPR_SVAL:
+            str = value->u.sval;
+            break;
+        case EXPR_WILDCARD:
+            str = MSI_RecordGetString( record, lookup->wildcard );
+            break;
+        case EXPR_COL_NUMBER_STRING:
+            r = expr_fetch_value( &value->u.column, rows, key );
+            if (r != ERROR_SUCCESS)
+                return r;
+            /* null and empty strings compare equal, scan for both */
+            if (!*key || !(str = msi_string_lookup( wv->db->strings, *key, NULL )) || !*str)
+                return ERROR_CONTINUE;
+            return ERROR_SUCCESS;
+        }
+
+        if (!str || !*str)
+            return ERROR_CONTINUE;
+        if (msi_string2id( wv->db->strings, str, -1, key ) != ERROR_SUCCESS)
+            return ERROR_NO_MORE_ITEMS;
+        return ERROR_SUCCESS;
+    }
+
+    switch (value->type)
+    {
+    case EXPR_UVAL:
+        val = value->u.uval;
+        break;
+    case EXPR_WILDCARD:
+        val = MSI_RecordGetInteger( record, lookup->wildcard );
+        break;
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+        r = expr_fetch_value( &value->u.column, rows, &tval );
+        if (r != ERROR_SUCCESS)
+            return r;
+        val = tval - (value->type == EXPR_COL_NUMBER32 ? 0x80000000 : 0x8000);
+        break;
+    }
+
+    if (lookup->column->type == EXPR_COL_NUMBER32)
+        *key = val + 0x80000000;
+    else if ((*key = val + 0x8000) & 0xffff0000)
+        return ERROR_NO_MORE_ITEMS;
+    return ERROR_SUCCESS;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_table **tables,
-                             UINT table_rows[] )
+                             const struct join_lookup *lookups, UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    UINT *row = &table_rows[(*tables)->table_index];
+    UINT r = ERROR_SUCCESS, key = 0, i = 0;
+    MSIITERHANDLE handle = NULL;
+    BOOL scan = TRUE;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (lookups->column)
     {
+        r = lookup_key( wv, lookups, table_rows, record, &key );
+        if (r == ERROR_NO_MORE_ITEMS)
+            return ERROR_SUCCESS;
+        if (r != ERROR_SUCCESS && r != ERROR_CONTINUE)
+            return r;
+        scan = (r == ERROR_CONTINUE);
+        r = ERROR_SUCCESS;
+    }
+
+    for (;;)
+    {
+        if (scan)
+        {
+            if (i >= (*tables)->row_count)
+                break;
+            *row = i++;
+        }
+        else
+        {
+            UINT res = (*tables)->view->ops->find_matching_rows( (*tables)->view,
+                    lookups->column->u.column.parsed.column, key, row, &handle );
+            if (res == ERROR_NO_MORE_ITEMS)
+                break;
+            if (res != ERROR_SUCCESS)
+            {
+                r = res;
+                break;
+            }
+        }
+
         val = 0;
         wv->rec_index = 0;
         r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
@@ -666,7 +766,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_ta
         {
             if (*(tables + 1))
             {
-                r = check_condition(wv, record, tables + 1, table_rows);
+                r = check_condition(wv, record, tables + 1, lookups + 1, table_rows);
                 if (r != ERROR_SUCCESS)
                     break;
             }
@@ -678,7 +778,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_ta
             }
         }
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    *row = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -810,6 +910,115 @@ static struct join_table **ordertables( MSIWHEREVIEW *wv )
     return tables;
 }
 
+static inline BOOL is_column_expr( const struct expr *expr )
+{
+    return expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+           expr->type == EXPR_COL_NUMBER_STRING;
+}
+
+static UINT table_position( struct join_table **tables, const struct join_table *table )
+{
+    UINT i;
+
+    for (i = 0; tables[i] != table; i++)
+        ;
+    return i;
+}
+
+static void add_lookup( MSIWHEREVIEW *wv, struct join_table **tables, struct join_lookup *lookups,
+                        const struct expr *column, const struct expr *value, UINT wildcard,
+                        BOOL string )
+{
+    struct join_table *table;
+    UINT pos, type;
+
+    if (!is_column_expr( column ) || (column->type == EXPR_COL_NUMBER_STRING) != string)
+        return;
+
+    table = column->u.column.parsed.table;
+    if (!table->view->ops->find_matching_rows)
+        return;
+    pos = table_position( tables, table );
+
+    switch (value->type)
+    {
+    case EXPR_UVAL:
+        if (string) return;
+        break;
+    case EXPR_SVAL:
+        if (!string) return;
+        break;
+    case EXPR_WILDCARD:
+        break;
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        if ((value->type == EXPR_COL_NUMBER_STRING) != string)
+            return;
+        /* the value has to be known before the table is visited */
+        if (table_position( tables, value->u.column.parsed.table ) >= pos)
+            return;
+        if (string)
+        {
+            if (value->u.column.parsed.table->view->ops->get_column_info( value->u.column.parsed.table->view,
+                    value->u.column.parsed.column, NULL, &type, NULL, NULL ) != ERROR_SUCCESS)
+                return;
+            if (MSITYPE_IS_BINARY(type)) return;
+        }
+        break;
+    default:
+        return;
+    }
+
+    if (table->view->ops->get_column_info( table->view, column->u.column.parsed.column,
+                                           NULL, &type, NULL, NULL ) != ERROR_SUCCESS)
+        return;
+    if (MSITYPE_IS_BINARY(type))
+        return;
+
+    /* prefer comparisons to constants over joins */
+    if (lookups[pos].column && (is_column_expr( value ) || !is_column_expr( lookups[pos].value )))
+        return;
+
+    lookups[pos].column = column;
+    lookups[pos].value = value;
+    lookups[pos].wildcard = wildcard;
+}
+
+/* finds the equalities that have to hold for the whole condition to be true,
+ * wildcards are numbered in the order WHERE_evaluate consumes them */
+static void find_lookups( MSIWHEREVIEW *wv, const struct expr *expr, BOOL required,
+                          struct join_table **tables, struct join_lookup *lookups, UINT *wildcard )
+{
+    const struct expr *left, *right;
+
+    switch (expr->type)
+    {
+    case EXPR_WILDCARD:
+        (*wildcard)++;
+        return;
+    case EXPR_COMPLEX:
+    case EXPR_STRCMP:
+        left = expr->u.expr.left;
+        right = expr->u.expr.right;
+        if (required && expr->u.expr.op == OP_EQ)
+        {
+            BOOL string = (expr->type == EXPR_STRCMP);
+            UINT next = *wildcard + 1;
+
+            add_lookup( wv, tables, lookups, left, right,
+                        next + (left->type == EXPR_WILDCARD), string );
+            add_lookup( wv, tables, lookups, right, left, next, string );
+        }
+        required = required && expr->type == EXPR_COMPLEX && expr->u.expr.op == OP_AND;
+        find_lookups( wv, left, required, tables, lookups, wildcard );
+        find_lookups( wv, right, required, tables, lookups, wildcard );
+        return;
+    default:
+        return;
+    }
+}
+
 static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
 {
     MSIWHEREVIEW *wv = (MSIWHEREVIEW*)view;
@@ -817,6 +1026,7 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     struct join_table *table = wv->tables;
     UINT *rows;
     struct join_table **ordered_tables;
+    struct join_lookup *lookups;
     UINT i = 0;
 
     TRACE("%p %p\n", wv, record);
@@ -847,11 +1057,23 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
 
     ordered_tables = ordertables( wv );
 
+    lookups = calloc(wv->table_count, sizeof(*lookups));
+    if (!lookups)
+    {
+        free(ordered_tables);
+        return ERROR_OUTOFMEMORY;
+    }
+    if (wv->cond)
+    {
+        i = 0;
+        find_lookups( wv, wv->cond, TRUE, ordered_tables, lookups, &i );
+    }
+
     rows = malloc(wv->table_count * sizeof(*rows));
     for (i = 0; i < wv->table_count; i++)
         rows[i] = INVALID_ROW_INDEX;
 
-    r =  check_condition(wv, record, ordered_tables, rows);
+    r =  check_condition(wv, record, ordered_tables, lookups, rows);
 
     if (wv->order_info)
         wv->order_info->error = ERROR_SUCCESS;
@@ -862,6 +1084,7 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
         r = wv->order_info->error;
 
     free(rows);
+    free(lookups);
     free(ordered_tables);
     return r;
 }
@@ -1130,6 +1353,7 @@ static const MSIVIEWOPS where_ops =
     NULL,
     NULL,
     NULL,
+    NULL,
     WHERE_sort,
     NULL,
 };
@@ -4161,6 +4161,7 @@ void WINAPI LdrShutdownProcess(void)
         RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
     process_detach();
+    dump_lock_profile();
 }
 
 extern const char * CDECL wine_get_version(void);
@@ -4698,6 +4699,7 @@ void loader_init( CONTEXT *context, void **entry )
         }
 
         peb->ProcessHeap        = RtlCreateHeap( heap_flags, NULL, 0, 0, NULL, NULL );
+        init_lock_profile();
 
         RtlInitializeBitMap( &tls_bitmap, peb->TlsBitmapBits, sizeof(peb->TlsBitmapBits) * 8 );
         RtlInitializeBitMap( &tls_expansion_bitmap, peb->TlsExpansionBitmapBits,
@@ -138,6 +138,10 @@ static inline void ascii_to_unicode( WCHAR *dst, const char *src, size_t len )
     while (len--) *dst++ = (unsigned char)*src++;
 }
 
+/* lock contention profiling */
+extern void init_lock_profile(void);
+extern void dump_lock_profile(void);
+
 /* FLS data */
 extern TEB_FLS_DATA *fls_alloc_data(void);
 extern void heap_thread_detach(void);
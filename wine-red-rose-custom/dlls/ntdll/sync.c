@@ -34,6 +34,7 @@
 #include "winternl.h"
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/lock_profile.h"
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(sync);
@@ -142,6 +143,191 @@ DWORD WINAPI RtlRunOnceComplete( RTL_RUN_ONCE *once, ULONG flags, void *context
 }
 
 
+/***********************************************************************
+ * Lock contention profiling
+ ***********************************************************************/
+
+static struct lock_profile *lock_profile;  /* NULL unless WINELOCKPROFILE is set */
+
+#ifdef __GNUC__
+#define lock_caller() __builtin_return_address(0)
+#else
+#define lock_caller() NULL
+#endif
+
+static inline LONGLONG lock_profile_time(void)
+{
+    LARGE_INTEGER counter;
+    RtlQueryPerformanceCounter( &counter );
+    return counter.QuadPart;
+}
+
+/***********************************************************************
+ *           init_lock_profile
+ *
+ * Create the shared lock profile if requested.
+ */
+void init_lock_profile(void)
+{
+    UNICODE_STRING name, value;
+    OBJECT_ATTRIBUTES attr;
+    LARGE_INTEGER size, freq;
+    WCHAR buffer[64];
+    SIZE_T view_size = 0;
+    void *ptr = NULL;
+    HANDLE section;
+
+    RtlInitUnicodeString( &name, L"WINELOCKPROFILE" );
+    value.Length = 0;
+    value.MaximumLength = sizeof(buffer);
+    value.Buffer = buffer;
+    if (RtlQueryEnvironmentVariable_U( NULL, &name, &value ) || !value.Length || buffer[0] == '0') return;
+
+    swprintf( buffer, ARRAY_SIZE(buffer), L"\\__wine_lock_profile_%04lx", GetCurrentProcessId() );
+    RtlInitUnicodeString( &name, buffer );
+    InitializeObjectAttributes( &attr, &name, OBJ_OPENIF, NULL, NULL );
+    size.QuadPart = sizeof(*lock_profile);
+    if (NtCreateSection( &section, SECTION_ALL_ACCESS, &attr, &size, PAGE_READWRITE, SEC_COMMIT, NULL ))
+    {
+        ERR( "failed to create lock profile section\n" );
+        return;
+    }
+    /* the section is kept open so that readers can find it */
+    if (NtMapViewOfSection( section, GetCurrentProcess(), &ptr, 0, 0, NULL, &view_size,
+                            ViewShare, 0, PAGE_READWRITE ))
+    {
+        NtClose( section );
+        return;
+    }
+
+    RtlQueryPerformanceFrequency( &freq );
+    lock_profile = ptr;
+    lock_profile->version     = LOCK_PROFILE_VERSION;
+    lock_profile->entry_count = LOCK_PROFILE_ENTRIES;
+    lock_profile->frequency   = freq.QuadPart;
+    MESSAGE( "wine: lock profiling enabled in %s\n", debugstr_w( buffer ));
+}
+
+static struct lock_profile_entry *get_lock_profile_entry( const void *lock, LONG type )
+{
+    ULONG64 key = (ULONG_PTR)lock;
+    unsigned int i, hash = (ULONG)((key >> 3) * 0x9e3779b1);
+    struct lock_profile_entry *entry;
+
+    for (i = 0; i < 64; i++)
+    {
+        entry = &lock_profile->entries[(hash + i) & (LOCK_PROFILE_ENTRIES - 1)];
+        if (entry->lock == key) return entry;
+        if (entry->lock) continue;
+        if (!InterlockedCompareExchange64( (LONG64 *)&entry->lock, key, 0 ))
+        {
+            entry->type = type;
+            InterlockedIncrement( &lock_profile->used );
+            return entry;
+        }
+        if (entry->lock == key) return entry;
+    }
+    InterlockedIncrement( &lock_profile->dropped );
+    return NULL;
+}
+
+static void lock_profile_acquire( const void *lock, LONG type )
+{
+    struct lock_profile_entry *entry;
+
+    if ((entry = get_lock_profile_entry( lock, type ))) InterlockedIncrement64( &entry->acquire_count );
+}
+
+static void lock_profile_contended( const void *lock, LONG type, const void *caller, LONGLONG start )
+{
+    LONGLONG max, time = lock_profile_time() - start;
+    ULONG64 address = (ULONG_PTR)caller;
+    struct lock_profile_entry *entry;
+    struct lock_profile_site *site;
+    unsigned int i;
+
+    if (!(entry = get_lock_profile_entry( lock, type ))) return;
+
+    InterlockedIncrement64( &entry->contended_count );
+    InterlockedExchangeAdd64( &entry->wait_time, time );
+    while ((max = entry->max_wait_time) < time &&
+           InterlockedCompareExchange64( &entry->max_wait_time, time, max ) != max)
+        ;
+
+    /* keep the sites which wait the most, replacing the least frequent one
+     * and inheriting its count, as in the space saving algorithm; this is
+     * racy and thus only approximate, which is good enough for profiling */
+    for (i = 0; i < LOCK_PROFILE_SITES; i++) if (entry->sites[i].address == address) break;
+    if (i == LOCK_PROFILE_SITES)
+    {
+        unsigned int j;
+
+        for (i = 0, j = 1; j < LOCK_PROFILE_SITES; j++)
+            if (entry->sites[j].count < entry->sites[i].count) i = j;
+        entry->sites[i].address = address;
+    }
+    site = &entry->sites[i];
+    InterlockedIncrement64( &site->count );
+    InterlockedExchangeAdd64( &site->wait_time, time );
+}
+
+static LONGLONG lock_profile_usec( LONGLONG time )
+{
+    return time * 1000000 / lock_profile->frequency;
+}
+
+static void print_lock_profile_address( const char *prefix, ULONG64 address )
+{
+    LDR_DATA_TABLE_ENTRY *mod;
+
+    if (!LdrFindEntryForAddress( (void *)(ULONG_PTR)address, &mod ))
+        MESSAGE( "%s%s+0x%lx", prefix, debugstr_w( mod->BaseDllName.Buffer ),
+                 (ULONG)((ULONG_PTR)address - (ULONG_PTR)mod->DllBase) );
+    else
+        MESSAGE( "%s%I64x", prefix, address );
+}
+
+/***********************************************************************
+ *           dump_lock_profile
+ *
+ * Print the locks which waited the longest.
+ */
+void dump_lock_profile(void)
+{
+    const struct lock_profile_entry *entry, *top[32];
+    unsigned int i, j, count = 0;
+
+    if (!lock_profile) return;
+
+    for (i = 0; i < LOCK_PROFILE_ENTRIES; i++)
+    {
+        entry = &lock_profile->entries[i];
+        if (!entry->lock || !entry->contended_count) continue;
+        if (count == ARRAY_SIZE(top) && entry->wait_time <= top[count - 1]->wait_time) continue;
+        for (j = (count < ARRAY_SIZE(top)) ? count++ : count - 1; j && top[j - 1]->wait_time < entry->wait_time; j--)
+            top[j] = top[j - 1];
+        top[j] = entry;
+    }
+
+    MESSAGE( "wine: lock profile for process %04lx: %ld locks, %ld dropped\n",
+             GetCurrentProcessId(), lock_profile->used, lock_profile->dropped );
+    for (i = 0; i < count; i++)
+    {
+        entry = top[i];
+        print_lock_profile_address( entry->type == LOCK_PROFILE_SRWLOCK ? "  srwlock " : "  critsec ", entry->lock );
+        MESSAGE( ": %I64d acquired, %I64d contended, wait %I64d us total, %I64d us max\n",
+                 entry->acquire_count, entry->contended_count,
+                 lock_profile_usec( entry->wait_time ), lock_profile_usec( entry->max_wait_time ));
+        for (j = 0; j < LOCK_PROFILE_SITES; j++)
+        {
+            if (!entry->sites[j].address) continue;
+            print_lock_profile_address( "    from ", entry->sites[j].address );
+            MESSAGE( ": %I64d waits, %I64d us\n", entry->sites[j].count,
+                     lock_profile_usec( entry->sites[j].wait_time ));
+        }
+    }
+}
+
 /***********************************************************************
  * Critical sections
  ***********************************************************************/
@@ -359,6 +545,8 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
  */
 NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
+    if (lock_profile) lock_profile_acquire( crit, LOCK_PROFILE_CRITICAL_SECTION );
+
     if (crit->SpinCount)
     {
         ULONG count;
@@ -384,7 +572,13 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
         }
 
         /* Now wait for it */
-        RtlpWaitForCriticalSection( crit );
+        if (lock_profile)
+        {
+            LONGLONG start = lock_profile_time();
+            RtlpWaitForCriticalSection( crit );
+            lock_profile_contended( crit, LOCK_PROFILE_CRITICAL_SECTION, lock_caller(), start );
+        }
+        else RtlpWaitForCriticalSection( crit );
     }
 done:
     crit->OwningThread   = ULongToHandle(GetCurrentThreadId());
@@ -521,6 +715,9 @@ void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
     union { RTL_SRWLOCK *rtl; struct srw_lock *s; LONG *l; } u = { lock };
+    LONGLONG start = 0;
+
+    if (lock_profile) lock_profile_acquire( lock, LOCK_PROFILE_SRWLOCK );
 
     InterlockedExchangeAdd16( &u.s->exclusive_waiters, 2 );
 
@@ -548,9 +745,12 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
             }
         } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
-        if (!wait) return;
+        if (!wait) break;
+        if (lock_profile && !start) start = lock_profile_time();
         RtlWaitOnAddress( &u.s->owners, &new.s.owners, sizeof(short), NULL );
     }
+
+    if (start) lock_profile_contended( lock, LOCK_PROFILE_SRWLOCK, lock_caller(), start );
 }
 
 /***********************************************************************
@@ -563,6 +763,9 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     union { RTL_SRWLOCK *rtl; struct srw_lock *s; LONG *l; } u = { lock };
+    LONGLONG start = 0;
+
+    if (lock_profile) lock_profile_acquire( lock, LOCK_PROFILE_SRWLOCK );
 
     for (;;)
     {
@@ -587,9 +790,12 @@ void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
             }
         } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
-        if (!wait) return;
+        if (!wait) break;
+        if (lock_profile && !start) start = lock_profile_time();
         RtlWaitOnAddress( u.s, &new.s, sizeof(struct srw_lock), NULL );
     }
+
+    if (start) lock_profile_contended( lock, LOCK_PROFILE_SRWLOCK, lock_caller(), start );
 }
 
 /***********************************************************************
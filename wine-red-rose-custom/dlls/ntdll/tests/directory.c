@@ -1042,6 +1042,88 @@ static void test_redirection(void)
     pRtlWow64EnableFsRedirectionEx( old, &cur );
 }
 
+static unsigned int enum_directory( HANDLE handle, BOOLEAN restart )
+{
+    static BYTE data[65536];
+    FILE_BOTH_DIRECTORY_INFORMATION *info;
+    unsigned int count = 0;
+    IO_STATUS_BLOCK io;
+    NTSTATUS status;
+
+    for (;;)
+    {
+        status = pNtQueryDirectoryFile( handle, 0, NULL, NULL, &io, data, sizeof(data),
+                                        FileBothDirectoryInformation, FALSE, NULL, restart );
+        if (status) break;
+        restart = FALSE;
+        info = (FILE_BOTH_DIRECTORY_INFORMATION *)data;
+        for (;;)
+        {
+            count++;
+            if (!info->NextEntryOffset) break;
+            info = (FILE_BOTH_DIRECTORY_INFORMATION *)((BYTE *)info + info->NextEntryOffset);
+        }
+    }
+    ok( status == STATUS_NO_MORE_FILES, "got %#lx\n", status );
+    return count;
+}
+
+static void test_directory_enum_benchmark(void)
+{
+    static const unsigned int file_count = 20000, restarts = 10;
+    WCHAR path[MAX_PATH], dir[MAX_PATH];
+    LARGE_INTEGER freq, start, end;
+    unsigned int i, count;
+    HANDLE handle;
+
+    if (!winetest_interactive)
+    {
+        skip( "Skipping directory enumeration benchmark\n" );
+        return;
+    }
+
+    GetTempPathW( MAX_PATH, path );
+    GetTempFileNameW( path, L"dir", 0, dir );
+    DeleteFileW( dir );
+    ok( CreateDirectoryW( dir, NULL ), "CreateDirectory failed %lu\n", GetLastError() );
+    for (i = 0; i < file_count; i++)
+    {
+        swprintf( path, ARRAY_SIZE(path), L"%s\\file%05u.txt", dir, i );
+        handle = CreateFileW( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, 0 );
+        ok( handle != INVALID_HANDLE_VALUE, "CreateFile failed %lu\n", GetLastError() );
+        CloseHandle( handle );
+    }
+
+    QueryPerformanceFrequency( &freq );
+
+    QueryPerformanceCounter( &start );
+    handle = CreateFileW( dir, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                          NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0 );
+    ok( handle != INVALID_HANDLE_VALUE, "CreateFile failed %lu\n", GetLastError() );
+    count = enum_directory( handle, TRUE );
+    QueryPerformanceCounter( &end );
+    ok( count == file_count + 2, "got %u entries\n", count );
+    trace( "first scan of %u entries: %.2f ms\n", count,
+           (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < restarts; i++)
+    {
+        count = enum_directory( handle, TRUE );
+        ok( count == file_count + 2, "got %u entries\n", count );
+    }
+    QueryPerformanceCounter( &end );
+    trace( "restarted scan: %.2f ms\n", (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart / restarts );
+    CloseHandle( handle );
+
+    for (i = 0; i < file_count; i++)
+    {
+        swprintf( path, ARRAY_SIZE(path), L"%s\\file%05u.txt", dir, i );
+        DeleteFileW( path );
+    }
+    RemoveDirectoryW( dir );
+}
+
 START_TEST(directory)
 {
     WCHAR sysdir[MAX_PATH];
@@ -1066,4 +1148,5 @@ START_TEST(directory)
     test_NtQueryDirectoryFile();
     test_NtQueryDirectoryFile_case();
     test_redirection();
+    test_directory_enum_benchmark();
 }
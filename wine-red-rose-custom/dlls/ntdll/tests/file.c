@@ -5991,6 +5991,96 @@ static void test_reparse_points(void)
     CloseHandle( handle );
 }
 
+static void test_overlapped_read_performance(void)
+{
+    static const unsigned int block_size = 4096, block_count = 16384, depth = 32, count = 100000;
+    HANDLE file, events[32];
+    OVERLAPPED ovl[32];
+    char path[MAX_PATH], name[MAX_PATH];
+    LARGE_INTEGER freq, start, end;
+    unsigned int i, issued = 0, done = 0, seed = 0x1234;
+    DWORD *buffers, size;
+    double secs;
+    BOOL ret;
+
+    if (!winetest_interactive)
+    {
+        skip("Skipping overlapped read benchmark, set WINETEST_INTERACTIVE to run it.\n");
+        return;
+    }
+
+    GetTempPathA( MAX_PATH, path );
+    GetTempFileNameA( path, "iop", 0, name );
+    file = CreateFileA( name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                        FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "CreateFile failed, error %lu\n", GetLastError() );
+
+    /* tag every block with its index, so that reads can be checked */
+    buffers = malloc( depth * block_size );
+    for (i = 0; i < block_count; ++i)
+    {
+        memset( &ovl[0], 0, sizeof(ovl[0]) );
+        ovl[0].Offset = i * block_size;
+        memset( buffers, 0, block_size );
+        buffers[0] = i;
+        ret = WriteFile( file, buffers, block_size, NULL, &ovl[0] );
+        if (!ret && GetLastError() == ERROR_IO_PENDING) ret = GetOverlappedResult( file, &ovl[0], &size, TRUE );
+        ok( ret, "WriteFile failed, error %lu\n", GetLastError() );
+    }
+
+    for (i = 0; i < depth; ++i) events[i] = CreateEventA( NULL, TRUE, FALSE, NULL );
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < depth; ++i)
+    {
+        memset( &ovl[i], 0, sizeof(ovl[i]) );
+        ovl[i].hEvent = events[i];
+        seed = seed * 1103515245 + 12345;
+        ovl[i].Offset = ((seed >> 8) % block_count) * block_size;
+        ret = ReadFile( file, (char *)buffers + i * block_size, block_size, NULL, &ovl[i] );
+        ok( ret || GetLastError() == ERROR_IO_PENDING, "ReadFile failed, error %lu\n", GetLastError() );
+        ++issued;
+    }
+    while (done < count)
+    {
+        DWORD idx = WaitForMultipleObjects( depth, events, FALSE, INFINITE ) - WAIT_OBJECT_0;
+
+        ok( idx < depth, "wait failed, ret %lu\n", idx );
+        if (idx >= depth) break;
+        ret = GetOverlappedResult( file, &ovl[idx], &size, FALSE );
+        ok( ret && size == block_size, "got ret %d, size %lu, error %lu\n", ret, size, GetLastError() );
+        ok( buffers[idx * block_size / sizeof(DWORD)] == ovl[idx].Offset / block_size,
+            "got block %lu at offset %#lx\n", buffers[idx * block_size / sizeof(DWORD)], ovl[idx].Offset );
+        ++done;
+
+        if (issued < count)
+        {
+            ResetEvent( events[idx] );
+            seed = seed * 1103515245 + 12345;
+            ovl[idx].Offset = ((seed >> 8) % block_count) * block_size;
+            ret = ReadFile( file, (char *)buffers + idx * block_size, block_size, NULL, &ovl[idx] );
+            ok( ret || GetLastError() == ERROR_IO_PENDING, "ReadFile failed, error %lu\n", GetLastError() );
+            ++issued;
+        }
+        else
+        {
+            /* keep the finished slot from being reported again */
+            CloseHandle( events[idx] );
+            events[idx] = CreateEventA( NULL, TRUE, FALSE, NULL );
+        }
+    }
+    QueryPerformanceCounter( &end );
+
+    secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    trace( "%u random %u byte reads with queue depth %u in %.3f s, %.0f IOPS\n",
+           done, block_size, depth, secs, done / secs );
+
+    for (i = 0; i < depth; ++i) CloseHandle( events[i] );
+    free( buffers );
+    CloseHandle( file );
+}
+
 START_TEST(file)
 {
     HMODULE hkernel32 = GetModuleHandleA("kernel32.dll");
@@ -6071,4 +6161,5 @@ START_TEST(file)
     test_flush_buffers_file();
     test_mailslot_name();
     test_reparse_points();
+    test_overlapped_read_performance();
 }
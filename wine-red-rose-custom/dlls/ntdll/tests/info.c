@@ -3892,6 +3892,63 @@ static void test_ThreadIsTerminated(void)
     ok( status == STATUS_INVALID_HANDLE, "got %#lx.\n", status );
 }
 
+static DWORD WINAPI test_thread_info_updates_thread( void *stop_event )
+{
+    WaitForSingleObject( stop_event, INFINITE );
+    return 0x1234;
+}
+
+static void test_thread_info_updates(void)
+{
+    THREAD_BASIC_INFORMATION info;
+    HANDLE thread, limited, stop_event;
+    ULONG count;
+    NTSTATUS status;
+    DWORD tid;
+
+    stop_event = CreateEventW( NULL, FALSE, FALSE, NULL );
+    thread = CreateThread( NULL, 0, test_thread_info_updates_thread, stop_event, CREATE_SUSPENDED, &tid );
+    ok( thread != NULL, "failed, error %lu\n", GetLastError() );
+
+    status = pNtQueryInformationThread( thread, ThreadSuspendCount, &count, sizeof(count), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( count == 1, "got %lu.\n", count );
+    SuspendThread( thread );
+    status = pNtQueryInformationThread( thread, ThreadSuspendCount, &count, sizeof(count), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( count == 2, "got %lu.\n", count );
+    ResumeThread( thread );
+    ResumeThread( thread );
+    status = pNtQueryInformationThread( thread, ThreadSuspendCount, &count, sizeof(count), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( !count, "got %lu.\n", count );
+
+    SetThreadPriority( thread, THREAD_PRIORITY_ABOVE_NORMAL );
+    status = pNtQueryInformationThread( thread, ThreadBasicInformation, &info, sizeof(info), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( info.ExitStatus == STATUS_PENDING, "got %#lx.\n", info.ExitStatus );
+    ok( info.Priority == THREAD_PRIORITY_ABOVE_NORMAL, "got %ld.\n", info.Priority );
+    ok( HandleToULong( info.ClientId.UniqueThread ) == tid, "got %p, expected %#lx.\n",
+        info.ClientId.UniqueThread, tid );
+
+    limited = OpenThread( THREAD_QUERY_LIMITED_INFORMATION, FALSE, tid );
+    ok( limited != NULL, "failed, error %lu\n", GetLastError() );
+    status = pNtQueryInformationThread( limited, ThreadBasicInformation, &info, sizeof(info), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( info.ExitStatus == STATUS_PENDING, "got %#lx.\n", info.ExitStatus );
+
+    SetEvent( stop_event );
+    WaitForSingleObject( thread, INFINITE );
+
+    status = pNtQueryInformationThread( limited, ThreadBasicInformation, &info, sizeof(info), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( info.ExitStatus == 0x1234, "got %#lx.\n", info.ExitStatus );
+
+    CloseHandle( limited );
+    CloseHandle( stop_event );
+    CloseHandle( thread );
+}
+
 static void test_system_debug_control(void)
 {
     NTSTATUS status;
@@ -4414,6 +4471,7 @@ START_TEST(info)
     test_thread_lookup();
     test_thread_ideal_processor();
     test_ThreadIsTerminated();
+    test_thread_info_updates();
 
     test_affinity();
     test_debug_object();
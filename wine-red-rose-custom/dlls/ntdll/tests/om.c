@@ -3233,6 +3233,86 @@ static void test_zero_access(void)
     ok( status == STATUS_ACCESS_DENIED, "got %#lx.\n", status );
 }
 
+struct request_latency_params
+{
+    HANDLE event;
+    HWND hwnd;
+    LONG iterations;
+    LONGLONG total;  /* total time in performance counter ticks */
+};
+
+static DWORD WINAPI request_latency_thread( void *arg )
+{
+    struct request_latency_params *params = arg;
+    OBJECT_BASIC_INFORMATION info;
+    LARGE_INTEGER start, end;
+    FILETIME times[4];
+    DWORD pid;
+    LONG i;
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < params->iterations; i++)
+    {
+        switch (i % 4)
+        {
+        case 0: pNtQueryObject( params->event, ObjectBasicInformation, &info, sizeof(info), NULL ); break;
+        case 1: GetThreadTimes( GetCurrentThread(), &times[0], &times[1], &times[2], &times[3] ); break;
+        case 2: GetWindowThreadProcessId( params->hwnd, &pid ); break;
+        case 3: SetEvent( params->event ); break;
+        }
+    }
+    QueryPerformanceCounter( &end );
+    params->total = end.QuadPart - start.QuadPart;
+    return 0;
+}
+
+static void test_request_latency(void)
+{
+    static const unsigned int thread_counts[] = { 1, 2, 4, 8 };
+    struct request_latency_params params[8];
+    HANDLE threads[8];
+    LARGE_INTEGER freq;
+    unsigned int i, j;
+    LONGLONG total;
+    HWND hwnd;
+
+    if (!winetest_interactive)
+    {
+        skip( "Skipping server request latency benchmark\n" );
+        return;
+    }
+
+    QueryPerformanceFrequency( &freq );
+    hwnd = CreateWindowA( "static", NULL, WS_POPUP, 0, 0, 10, 10, NULL, NULL, NULL, NULL );
+    ok( hwnd != NULL, "CreateWindow failed %lu\n", GetLastError() );
+
+    for (i = 0; i < ARRAY_SIZE(thread_counts); i++)
+    {
+        for (j = 0; j < thread_counts[i]; j++)
+        {
+            params[j].event = CreateEventA( NULL, TRUE, FALSE, NULL );
+            params[j].hwnd = hwnd;
+            params[j].iterations = 100000;
+            threads[j] = CreateThread( NULL, 0, request_latency_thread, &params[j], CREATE_SUSPENDED, NULL );
+            ok( threads[j] != NULL, "CreateThread failed %lu\n", GetLastError() );
+        }
+        for (j = 0; j < thread_counts[i]; j++) ResumeThread( threads[j] );
+        WaitForMultipleObjects( thread_counts[i], threads, TRUE, INFINITE );
+
+        total = 0;
+        for (j = 0; j < thread_counts[i]; j++)
+        {
+            total += params[j].total;
+            CloseHandle( threads[j] );
+            CloseHandle( params[j].event );
+        }
+        trace( "%u threads: %.2f us per request\n", thread_counts[i],
+               total * 1000000.0 / freq.QuadPart / (thread_counts[i] * 100000.0) );
+    }
+
+    DestroyWindow( hwnd );
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
@@ -3298,4 +3378,5 @@ START_TEST(om)
     test_object_identity();
     test_query_directory();
     test_zero_access();
+    test_request_latency();
 }
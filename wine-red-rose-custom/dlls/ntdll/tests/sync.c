@@ -25,6 +25,7 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/test.h"
+#include "wine/lock_profile.h"
 
 static NTSTATUS (WINAPI *pNtAlertThreadByThreadId)( HANDLE );
 static NTSTATUS (WINAPI *pNtClose)( HANDLE );
@@ -1030,6 +1031,345 @@ static void test_completion_port_scheduling(void)
     }
 }
 
+static DWORD WINAPI completion_port_wait_thread( void *arg )
+{
+    return WaitForSingleObject( arg, 5000 );
+}
+
+static void test_completion_port_queue(void)
+{
+    /* more than the completions that fit in the shared ring */
+    static const unsigned int queued_count = 1000;
+    FILE_IO_COMPLETION_INFORMATION info[64];
+    LARGE_INTEGER timeout = {{ 0 }};
+    HANDLE port, port2, thread;
+    ULONG_PTR key, value;
+    IO_STATUS_BLOCK iosb;
+    unsigned int i, next;
+    NTSTATUS status;
+    ULONG count;
+    DWORD ret;
+
+    status = NtCreateIoCompletion( &port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( !status, "got %#lx.\n", status );
+
+    /* overflowing completions are still returned in order */
+    for (i = 0; i < queued_count; ++i)
+    {
+        status = NtSetIoCompletion( port, i, i * 2, STATUS_SUCCESS, i );
+        ok( !status, "got %#lx.\n", status );
+    }
+    status = NtQueryIoCompletion( port, IoCompletionBasicInformation, &count, sizeof(count), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( count == queued_count, "got %lu.\n", count );
+    for (i = 0; i < queued_count; ++i)
+    {
+        status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+        ok( !status, "got %#lx.\n", status );
+        if (status) break;
+        ok( key == i, "got key %Iu, expected %u.\n", key, i );
+        ok( value == i * 2, "got value %Iu, expected %u.\n", value, i * 2 );
+        ok( iosb.Information == i, "got information %Iu, expected %u.\n", iosb.Information, i );
+    }
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+
+    /* several completions at once, with the queue positions wrapping around */
+    for (next = i = 0; i < queued_count; ++i)
+    {
+        status = NtSetIoCompletion( port, i, 0, STATUS_SUCCESS, 0 );
+        ok( !status, "got %#lx.\n", status );
+        if (i % 100 != 99) continue;
+
+        count = 0;
+        status = NtRemoveIoCompletionEx( port, info, ARRAY_SIZE(info), &count, &timeout, FALSE );
+        ok( !status, "got %#lx.\n", status );
+        ok( count == ARRAY_SIZE(info), "got count %lu.\n", count );
+        for (count = 0; count < ARRAY_SIZE(info); ++count, ++next)
+            ok( info[count].CompletionKey == next, "got key %Iu, expected %u.\n", info[count].CompletionKey, next );
+    }
+    while (next < queued_count)
+    {
+        count = 0;
+        status = NtRemoveIoCompletionEx( port, info, ARRAY_SIZE(info), &count, &timeout, FALSE );
+        ok( !status, "got %#lx.\n", status );
+        if (status) break;
+        ok( count == min( ARRAY_SIZE(info), queued_count - next ), "got count %lu.\n", count );
+        for (i = 0; i < count; ++i, ++next)
+            ok( info[i].CompletionKey == next, "got key %Iu, expected %u.\n", info[i].CompletionKey, next );
+    }
+    ok( next == queued_count, "got %u completions.\n", next );
+
+    /* the port handle is signaled while completions are queued */
+    ret = WaitForSingleObject( port, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %#lx.\n", ret );
+    thread = CreateThread( NULL, 0, completion_port_wait_thread, port, 0, NULL );
+    Sleep( 50 );
+    status = NtSetIoCompletion( port, 1, 0, STATUS_SUCCESS, 0 );
+    ok( !status, "got %#lx.\n", status );
+    ret = WaitForSingleObject( thread, 5000 );
+    ok( !ret, "got %#lx.\n", ret );
+    GetExitCodeThread( thread, &ret );
+    ok( ret == WAIT_OBJECT_0, "got %#lx.\n", ret );
+    CloseHandle( thread );
+    ret = WaitForSingleObject( port, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %#lx.\n", ret );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( !status, "got %#lx.\n", status );
+    ok( key == 1, "got key %Iu.\n", key );
+    ret = WaitForSingleObject( port, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %#lx.\n", ret );
+
+    /* the queued completions stay with the port until its last handle is closed */
+    ret = DuplicateHandle( GetCurrentProcess(), port, GetCurrentProcess(), &port2, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "got error %lu.\n", GetLastError() );
+    for (i = 0; i < queued_count; ++i) NtSetIoCompletion( port, i, 0, STATUS_SUCCESS, 0 );
+    status = NtClose( port );
+    ok( !status, "got %#lx.\n", status );
+    for (i = 0; i < queued_count; ++i)
+    {
+        status = NtRemoveIoCompletion( port2, &key, &value, &iosb, &timeout );
+        ok( !status, "got %#lx.\n", status );
+        if (status) break;
+        ok( key == i, "got key %Iu, expected %u.\n", key, i );
+        if (i == queued_count / 2) break;
+    }
+    status = NtClose( port2 );
+    ok( !status, "got %#lx.\n", status );
+
+    /* a new port doesn't get the completions of a closed one */
+    status = NtCreateIoCompletion( &port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( !status, "got %#lx.\n", status );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+    status = NtQueryIoCompletion( port, IoCompletionBasicInformation, &count, sizeof(count), NULL );
+    ok( !status, "got %#lx.\n", status );
+    ok( !count, "got %lu.\n", count );
+    NtClose( port );
+}
+
+struct completion_port_perf_param
+{
+    HANDLE port, reply_port;
+    unsigned int count;
+};
+
+static DWORD WINAPI completion_port_pong_thread( void *arg )
+{
+    struct completion_port_perf_param *p = arg;
+    ULONG_PTR key, value;
+    IO_STATUS_BLOCK iosb;
+    unsigned int i;
+
+    for (i = 0; i < p->count; ++i)
+    {
+        NtRemoveIoCompletion( p->port, &key, &value, &iosb, NULL );
+        NtSetIoCompletion( p->reply_port, key, value, STATUS_SUCCESS, 0 );
+    }
+    return 0;
+}
+
+static DWORD WINAPI completion_port_producer_thread( void *arg )
+{
+    struct completion_port_perf_param *p = arg;
+    unsigned int i;
+
+    for (i = 0; i < p->count; ++i)
+        NtSetIoCompletion( p->port, i, 0, STATUS_SUCCESS, 0 );
+    return 0;
+}
+
+static void test_completion_port_performance(void)
+{
+    static const unsigned int pingpong_count = 100000, producer_count = 250000, producers = 4;
+    struct completion_port_perf_param p;
+    LARGE_INTEGER frequency, start, end;
+    FILE_IO_COMPLETION_INFORMATION info[64];
+    HANDLE port, reply_port, threads[4];
+    ULONG_PTR key, value;
+    IO_STATUS_BLOCK iosb;
+    unsigned int i, total;
+    NTSTATUS status;
+    ULONG count;
+
+    if (!winetest_interactive)
+    {
+        skip( "Skipping completion port performance tests.\n" );
+        return;
+    }
+
+    QueryPerformanceFrequency( &frequency );
+
+    status = NtCreateIoCompletion( &port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( !status, "got %#lx.\n", status );
+    status = NtCreateIoCompletion( &reply_port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( !status, "got %#lx.\n", status );
+
+    /* ping-pong between two threads */
+    p.port = port;
+    p.reply_port = reply_port;
+    p.count = pingpong_count;
+    threads[0] = CreateThread( NULL, 0, completion_port_pong_thread, &p, 0, NULL );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < pingpong_count; ++i)
+    {
+        NtSetIoCompletion( port, i, 0, STATUS_SUCCESS, 0 );
+        status = NtRemoveIoCompletion( reply_port, &key, &value, &iosb, NULL );
+        ok( !status && key == i, "got %#lx, key %Iu.\n", status, key );
+        if (status) break;
+    }
+    QueryPerformanceCounter( &end );
+    WaitForSingleObject( threads[0], INFINITE );
+    CloseHandle( threads[0] );
+    trace( "completion port ping-pong: %.2f us per round trip.\n",
+           (end.QuadPart - start.QuadPart) * 1e6 / frequency.QuadPart / pingpong_count );
+
+    /* fan-in from several producers to one consumer */
+    p.port = port;
+    p.count = producer_count;
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < producers; ++i)
+        threads[i] = CreateThread( NULL, 0, completion_port_producer_thread, &p, 0, NULL );
+    for (total = 0; total < producer_count * producers; total += count)
+    {
+        status = NtRemoveIoCompletionEx( port, info, ARRAY_SIZE(info), &count, NULL, FALSE );
+        ok( !status, "got %#lx.\n", status );
+        if (status) break;
+    }
+    QueryPerformanceCounter( &end );
+    WaitForMultipleObjects( producers, threads, TRUE, INFINITE );
+    for (i = 0; i < producers; ++i) CloseHandle( threads[i] );
+    trace( "completion port fan-in, %u producers: %.2f Mcompletions/s.\n", producers,
+           (double)total * frequency.QuadPart / (end.QuadPart - start.QuadPart) / 1e6 );
+
+    NtClose( reply_port );
+    NtClose( port );
+}
+
+static CRITICAL_SECTION lock_profile_cs;
+static SRWLOCK lock_profile_srwlock = SRWLOCK_INIT;
+
+static DWORD WINAPI lock_profile_thread( void *arg )
+{
+    HANDLE ready = arg;
+
+    SetEvent( ready );
+    EnterCriticalSection( &lock_profile_cs );
+    LeaveCriticalSection( &lock_profile_cs );
+    SetEvent( ready );
+    AcquireSRWLockShared( &lock_profile_srwlock );
+    ReleaseSRWLockShared( &lock_profile_srwlock );
+    return 0;
+}
+
+static void lock_profile_child(void)
+{
+    HANDLE thread, ready, parent_ready, parent_done;
+
+    InitializeCriticalSection( &lock_profile_cs );
+    ready = CreateEventA( NULL, FALSE, FALSE, NULL );
+
+    EnterCriticalSection( &lock_profile_cs );
+    AcquireSRWLockExclusive( &lock_profile_srwlock );
+    thread = CreateThread( NULL, 0, lock_profile_thread, ready, 0, NULL );
+    WaitForSingleObject( ready, INFINITE );
+    Sleep( 100 );
+    LeaveCriticalSection( &lock_profile_cs );
+    WaitForSingleObject( ready, INFINITE );
+    Sleep( 100 );
+    ReleaseSRWLockExclusive( &lock_profile_srwlock );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    CloseHandle( ready );
+
+    parent_ready = OpenEventA( EVENT_ALL_ACCESS, FALSE, "test_lock_profile_ready" );
+    parent_done = OpenEventA( EVENT_ALL_ACCESS, FALSE, "test_lock_profile_done" );
+    SetEvent( parent_ready );
+    WaitForSingleObject( parent_done, INFINITE );
+    CloseHandle( parent_ready );
+    CloseHandle( parent_done );
+    DeleteCriticalSection( &lock_profile_cs );
+}
+
+static void test_lock_profile( char **argv )
+{
+    const struct lock_profile_entry *entry, *crit_entry = NULL, *srw_entry = NULL;
+    const struct lock_profile *profile;
+    HANDLE ready, done, section;
+    STARTUPINFOA si = {0};
+    PROCESS_INFORMATION pi;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    char cmdline[MAX_PATH];
+    WCHAR buffer[64];
+    NTSTATUS status;
+    unsigned int i;
+    BOOL ret;
+
+    ready = CreateEventA( NULL, FALSE, FALSE, "test_lock_profile_ready" );
+    done = CreateEventA( NULL, FALSE, FALSE, "test_lock_profile_done" );
+
+    SetEnvironmentVariableA( "WINELOCKPROFILE", "1" );
+    sprintf( cmdline, "%s %s lock_profile", argv[0], argv[1] );
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    ok( ret, "failed to create process, error %lu\n", GetLastError() );
+    SetEnvironmentVariableA( "WINELOCKPROFILE", NULL );
+    ok( !WaitForSingleObject( ready, 10000 ), "wait failed\n" );
+
+    swprintf( buffer, ARRAY_SIZE(buffer), L"\\__wine_lock_profile_%04lx", pi.dwProcessId );
+    pRtlInitUnicodeString( &name, buffer );
+    InitializeObjectAttributes( &attr, &name, 0, NULL, NULL );
+    status = NtOpenSection( &section, SECTION_MAP_READ, &attr );
+    if (status)
+    {
+        ok( status == STATUS_OBJECT_NAME_NOT_FOUND, "got %#lx\n", status );
+        win_skip( "lock profiling not supported\n" );
+        goto done;
+    }
+
+    profile = MapViewOfFile( section, FILE_MAP_READ, 0, 0, 0 );
+    ok( profile != NULL, "failed to map profile, error %lu\n", GetLastError() );
+    ok( profile->version == LOCK_PROFILE_VERSION, "got version %lu\n", profile->version );
+    ok( profile->entry_count == LOCK_PROFILE_ENTRIES, "got %lu entries\n", profile->entry_count );
+    ok( profile->frequency > 0, "got frequency %I64d\n", profile->frequency );
+    ok( profile->used > 0, "got %ld used entries\n", profile->used );
+
+    /* the loader lock and others are contended too; look for entries with our exact counts */
+    for (i = 0; i < profile->entry_count; i++)
+    {
+        entry = &profile->entries[i];
+        if (entry->acquire_count != 2 || entry->contended_count != 1) continue;
+        if (entry->type == LOCK_PROFILE_CRITICAL_SECTION && !crit_entry) crit_entry = entry;
+        if (entry->type == LOCK_PROFILE_SRWLOCK && !srw_entry) srw_entry = entry;
+    }
+    ok( crit_entry != NULL, "critical section not found\n" );
+    if (crit_entry)
+    {
+        ok( crit_entry->wait_time > 0, "got wait time %I64d\n", crit_entry->wait_time );
+        ok( crit_entry->max_wait_time == crit_entry->wait_time, "got max wait time %I64d\n",
+            crit_entry->max_wait_time );
+        ok( crit_entry->sites[0].address != 0, "got no call site\n" );
+        ok( crit_entry->sites[0].count == 1, "got %I64d waits\n", crit_entry->sites[0].count );
+    }
+    ok( srw_entry != NULL, "SRW lock not found\n" );
+    if (srw_entry)
+    {
+        ok( srw_entry->wait_time > 0, "got wait time %I64d\n", srw_entry->wait_time );
+        ok( srw_entry->sites[0].address != 0, "got no call site\n" );
+    }
+
+    UnmapViewOfFile( profile );
+    NtClose( section );
+
+done:
+    SetEvent( done );
+    ok( !WaitForSingleObject( pi.hProcess, 10000 ), "wait failed\n" );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+    CloseHandle( ready );
+    CloseHandle( done );
+}
+
 START_TEST(sync)
 {
     HMODULE module = GetModuleHandleA("ntdll.dll");
@@ -1038,7 +1378,11 @@ START_TEST(sync)
 
     argc = winetest_get_mainargs( &argv );
 
-    if (argc > 2) return;
+    if (argc > 2)
+    {
+        if (!strcmp( argv[2], "lock_profile" )) lock_profile_child();
+        return;
+    }
 
     pNtAlertThreadByThreadId        = (void *)GetProcAddress(module, "NtAlertThreadByThreadId");
     pNtClose                        = (void *)GetProcAddress(module, "NtClose");
@@ -1078,4 +1422,7 @@ START_TEST(sync)
     test_resource();
     test_tid_alert( argv );
     test_completion_port_scheduling();
+    test_completion_port_queue();
+    test_completion_port_performance();
+    test_lock_profile( argv );
 }
@@ -87,6 +87,11 @@
 #ifdef HAVE_LINUX_MAJOR_H
 # include <linux/major.h>
 #endif
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/uio.h>
+#endif
 #ifdef HAVE_SYS_PARAM_H
 #include <sys/param.h>
 #endif
@@ -146,6 +151,16 @@ typedef struct
     char d_name[256];
 } KERNEL_DIRENT;
 
+/* dirent structure returned by the getdents64 syscall */
+typedef struct
+{
+    ULONG64 d_ino;
+    LONG64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[256];
+} KERNEL_DIRENT64;
+
 /* Define the VFAT ioctl to get both short and long file names */
 #define VFAT_IOCTL_READDIR_BOTH  _IOR('r', 1, KERNEL_DIRENT [2] )
 
@@ -220,19 +235,29 @@ struct dir_data_names
     const char  *unix_name;          /* Unix file name in host encoding */
 };
 
+struct dir_data_info
+{
+    int                     ret;         /* result of the stat call */
+    ULONG                   attributes;  /* file attributes */
+    struct stat             st;          /* file stat information */
+};
+
 struct dir_data
 {
     unsigned int            size;    /* size of the names array */
     unsigned int            count;   /* count of used entries in the names array */
     unsigned int            pos;     /* current reading position in the names array */
+    unsigned int            filled;  /* count of entries with cached file information */
     struct file_identity    id;      /* directory file identity */
     struct dir_data_names  *names;   /* directory file names */
+    struct dir_data_info   *info;    /* cached file information, parallel to the names array */
     struct dir_data_buffer *buffer;  /* head of data buffers list */
 };
 
 static const unsigned int dir_data_buffer_initial_size = 4096;
 static const unsigned int dir_data_cache_initial_size  = 256;
 static const unsigned int dir_data_names_initial_size  = 64;
+static const unsigned int dir_data_info_batch_size     = 128;
 
 static struct dir_data **dir_data_cache;
 static unsigned int dir_data_cache_size;
@@ -523,6 +548,7 @@ static void free_dir_data( struct dir_data *data )
         free( buffer );
     }
     free( data->names );
+    free( data->info );
     free( data );
 }
 
@@ -1704,11 +1730,33 @@ static NTSTATUS fd_set_file_info( int fd, HANDLE handle, UINT attr, BOOL force_s
 
 
 /* get the stat info and file attributes for a file (by name) */
+/* add the DOS attributes stored in extended attributes, or the hidden attribute for dot files */
+static void get_file_dos_attributes( const char *path, ULONG *attr )
+{
+    char attr_data[65];
+    int attr_len;
+
+    attr_len = xattr_get( path, SAMBA_XATTR_DOS_ATTRIB, attr_data, sizeof(attr_data)-1 );
+    if (attr_len != -1)
+        *attr |= parse_samba_dos_attrib_data( attr_data, attr_len );
+    else
+    {
+        if (is_hidden_file( path ))
+            *attr |= FILE_ATTRIBUTE_HIDDEN;
+        if (errno == ENOTSUP) return;
+#ifdef ENODATA
+        if (errno == ENODATA) return;
+#endif
+        WARN( "Failed to get extended attribute " SAMBA_XATTR_DOS_ATTRIB " from \"%s\". errno %d (%s)\n",
+              path, errno, strerror( errno ) );
+    }
+}
+
+
 static int get_file_info( const char *path, struct stat *st, ULONG *attr )
 {
     char *parent_path;
-    char attr_data[65];
-    int attr_len, ret;
+    int ret;
 
     *attr = 0;
     ret = lstat( path, st );
@@ -1734,22 +1782,79 @@ static int get_file_info( const char *path, struct stat *st, ULONG *attr )
         free( parent_path );
     }
     *attr |= get_file_attributes( st );
+    get_file_dos_attributes( path, attr );
+    return ret;
+}
 
-    attr_len = xattr_get( path, SAMBA_XATTR_DOS_ATTRIB, attr_data, sizeof(attr_data)-1 );
-    if (attr_len != -1)
-        *attr |= parse_samba_dos_attrib_data( attr_data, attr_len );
-    else
+
+/* lstat() a directory entry, without waiting for remote file systems to synchronize */
+static int lstat_dir_entry( const char *name, struct stat *st )
+{
+#if defined(linux) && defined(STATX_BASIC_STATS)
+    static BOOL no_statx;
+    struct statx stx;
+
+    if (!no_statx)
     {
-        if (is_hidden_file( path ))
-            *attr |= FILE_ATTRIBUTE_HIDDEN;
-        if (errno == ENOTSUP) return ret;
-#ifdef ENODATA
-        if (errno == ENODATA) return ret;
+        if (statx( AT_FDCWD, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | AT_STATX_DONT_SYNC,
+                   STATX_BASIC_STATS, &stx ) == -1)
+        {
+            if (errno != ENOSYS) return -1;
+            no_statx = TRUE;
+        }
+        else if ((stx.stx_mask & STATX_BASIC_STATS) == STATX_BASIC_STATS)
+        {
+            memset( st, 0, sizeof(*st) );
+            st->st_dev = makedev( stx.stx_dev_major, stx.stx_dev_minor );
+            st->st_ino = stx.stx_ino;
+            st->st_mode = stx.stx_mode;
+            st->st_nlink = stx.stx_nlink;
+            st->st_uid = stx.stx_uid;
+            st->st_gid = stx.stx_gid;
+            st->st_rdev = makedev( stx.stx_rdev_major, stx.stx_rdev_minor );
+            st->st_size = stx.stx_size;
+            st->st_blksize = stx.stx_blksize;
+            st->st_blocks = stx.stx_blocks;
+            st->st_atim.tv_sec = stx.stx_atime.tv_sec;
+            st->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+            st->st_mtim.tv_sec = stx.stx_mtime.tv_sec;
+            st->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+            st->st_ctim.tv_sec = stx.stx_ctime.tv_sec;
+            st->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+            return 0;
+        }
+    }
 #endif
-        WARN( "Failed to get extended attribute " SAMBA_XATTR_DOS_ATTRIB " from \"%s\". errno %d (%s)\n",
-              path, errno, strerror( errno ) );
+    return lstat( name, st );
+}
+
+
+/***********************************************************************
+ *           get_dir_entry_info
+ *
+ * Same as get_file_info() for an entry of the current directory, which is
+ * also the directory described by the specified identity.
+ */
+static int get_dir_entry_info( const struct file_identity *dir, const char *name,
+                               struct stat *st, ULONG *attr )
+{
+    if (!strcmp( name, "." ) || !strcmp( name, ".." )) return get_file_info( name, st, attr );
+
+    *attr = 0;
+    if (lstat_dir_entry( name, st ) == -1) return -1;
+    if (S_ISLNK( st->st_mode ))
+    {
+        if (stat( name, st ) == -1) return -1;
+        /* is a symbolic link and a directory, consider these "reparse points" */
+        if (S_ISDIR( st->st_mode )) *attr |= FILE_ATTRIBUTE_REPARSE_POINT;
     }
-    return ret;
+    /* the parent of a subdirectory is the current directory, no need to stat it again */
+    else if (S_ISDIR( st->st_mode ) && (st->st_dev != dir->dev || st->st_ino == dir->ino))
+        *attr |= FILE_ATTRIBUTE_REPARSE_POINT;
+
+    *attr |= get_file_attributes( st );
+    get_file_dos_attributes( name, attr );
+    return 0;
 }
 
 
@@ -2269,6 +2374,29 @@ static NTSTATUS get_mountmgr_fs_info( HANDLE handle, int fd, struct mountmgr_uni
 }
 
 
+/***********************************************************************
+ *           fill_dir_data_info
+ *
+ * Fetch the file information for the next batch of directory entries.
+ * The results are kept until the directory data is freed, so that
+ * restarting the scan doesn't need to query the files again.
+ */
+static void fill_dir_data_info( struct dir_data *data )
+{
+    unsigned int end = min( data->filled + dir_data_info_batch_size, data->count );
+    struct dir_data_info *info;
+
+    if (!data->info && !(data->info = malloc( data->count * sizeof(*data->info) ))) return;
+
+    for (; data->filled < end; data->filled++)
+    {
+        info = &data->info[data->filled];
+        info->ret = get_dir_entry_info( &data->id, data->names[data->filled].unix_name,
+                                        &info->st, &info->attributes );
+    }
+}
+
+
 /***********************************************************************
  *           get_dir_data_entry
  *
@@ -2282,8 +2410,18 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
     union file_directory_info *info;
     struct stat st;
     ULONG name_len, start, dir_size, attributes;
+    int ret;
 
-    if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+    if (dir_data->pos >= dir_data->filled) fill_dir_data_info( dir_data );
+    if (dir_data->pos < dir_data->filled)
+    {
+        st = dir_data->info[dir_data->pos].st;
+        attributes = dir_data->info[dir_data->pos].attributes;
+        ret = dir_data->info[dir_data->pos].ret;
+    }
+    else ret = get_file_info( names->unix_name, &st, &attributes );
+
+    if (ret == -1)
     {
         TRACE( "file no longer exists %s\n", names->unix_name );
         return STATUS_SUCCESS;
@@ -2513,6 +2651,55 @@ done:
 }
 
 
+#if defined(linux) && defined(__NR_getdents64)
+
+/***********************************************************************
+ *           read_directory_data_getdents
+ *
+ * Read a directory using the getdents64 syscall with a large buffer; helper for NtQueryDirectoryFile.
+ */
+static NTSTATUS read_directory_data_getdents( struct dir_data *data, const UNICODE_STRING *mask )
+{
+    static const unsigned int buffer_size = 65536;
+    NTSTATUS status = STATUS_NO_MEMORY;
+    KERNEL_DIRENT64 *de;
+    char *buffer;
+    int fd, size, pos;
+
+    if ((fd = open( ".", O_RDONLY | O_DIRECTORY )) == -1) return STATUS_NO_SUCH_FILE;
+    if (!(buffer = malloc( buffer_size ))) goto done;
+
+    if ((size = syscall( __NR_getdents64, fd, buffer, buffer_size )) == -1)
+    {
+        status = STATUS_NOT_SUPPORTED;
+        goto done;
+    }
+
+    if (!append_entry( data, ".", NULL, mask )) goto done;
+    if (!append_entry( data, "..", NULL, mask )) goto done;
+    while (size > 0)
+    {
+        for (pos = 0; pos < size; pos += de->d_reclen)
+        {
+            de = (KERNEL_DIRENT64 *)(buffer + pos);
+            if (!strcmp( de->d_name, "." ) || !strcmp( de->d_name, ".." )) continue;
+            if (!append_entry( data, de->d_name, NULL, mask )) goto done;
+        }
+        while ((size = syscall( __NR_getdents64, fd, buffer, buffer_size )) == -1 && errno == EINTR);
+    }
+    /* don't return a truncated listing; the entries read so far can't be
+     * handed over to the readdir fallback either */
+    status = size ? errno_to_status( errno ) : STATUS_SUCCESS;
+
+done:
+    free( buffer );
+    close( fd );
+    return status;
+}
+
+#endif  /* linux && __NR_getdents64 */
+
+
 /***********************************************************************
  *           read_directory_data
  *
@@ -2542,6 +2729,9 @@ static NTSTATUS read_directory_data( struct dir_data *data, int fd, const UNICOD
         }
     }
 
+#if defined(linux) && defined(__NR_getdents64)
+    if ((status = read_directory_data_getdents( data, mask )) != STATUS_NOT_SUPPORTED) return status;
+#endif
     return read_directory_data_readdir( data, mask );
 }
 
@@ -4675,6 +4865,7 @@ NTSTATUS WINAPI NtQueryInformationFile( HANDLE handle, IO_STATUS_BLOCK *io,
     ULONG attr;
     unsigned int options;
     unsigned int status;
+    enum server_fd_type type;
 
     TRACE( "(%p,%p,%p,0x%08x,0x%08x)\n", handle, io, ptr, (int)len, class);
 
@@ -4687,11 +4878,16 @@ NTSTATUS WINAPI NtQueryInformationFile( HANDLE handle, IO_STATUS_BLOCK *io,
     if (len < info_sizes[class])
         return io->Status = STATUS_INFO_LENGTH_MISMATCH;
 
-    if ((status = server_get_unix_fd( handle, 0, &fd, &needs_close, NULL, &options )))
+    if ((status = server_get_unix_fd( handle, 0, &fd, &needs_close, &type, &options )))
     {
         if (status != STATUS_BAD_DEVICE_TYPE) return io->Status = status;
         return server_get_file_info( handle, io, ptr, len, class );
     }
+    if (type == FD_TYPE_PIPE)  /* the unix fd only carries the pipe data */
+    {
+        if (needs_close) close( fd );
+        return server_get_file_info( handle, io, ptr, len, class );
+    }
 
     switch (class)
     {
@@ -5338,6 +5534,17 @@ static BOOL async_read_proc( void *user, ULONG_PTR *info, unsigned int *status )
                                           &needs_close, NULL, NULL )))
             break;
 
+        if (!fileio->count)  /* zero-length pipe read, only wait for data to be available */
+        {
+            char c;
+
+            result = recv( fd, &c, 1, MSG_PEEK | MSG_DONTWAIT );
+            if (needs_close) close( fd );
+            if (result < 0 && (errno == EAGAIN || errno == EINTR)) return FALSE;
+            *status = result > 0 ? STATUS_SUCCESS : result ? errno_to_status( errno ) : STATUS_PIPE_BROKEN;
+            break;
+        }
+
         result = virtual_locked_read(fd, &fileio->buffer[fileio->already], fileio->count-fileio->already);
         if (needs_close) close( fd );
 
@@ -5702,6 +5909,107 @@ static unsigned int register_async_file_read( HANDLE handle, HANDLE event,
     return status;
 }
 
+static unsigned int register_async_file_write( HANDLE handle, HANDLE event,
+                                               PIO_APC_ROUTINE apc, void *apc_user,
+                                               client_ptr_t iosb, const void *buffer,
+                                               ULONG already, ULONG length )
+{
+    struct async_fileio_write *fileio;
+    unsigned int status;
+
+    if (!(fileio = (struct async_fileio_write *)alloc_fileio( sizeof(*fileio), async_write_proc, handle )))
+        return STATUS_NO_MEMORY;
+
+    fileio->already = already;
+    fileio->count = length;
+    fileio->buffer = buffer;
+
+    SERVER_START_REQ( register_async )
+    {
+        req->type   = ASYNC_TYPE_WRITE;
+        req->count  = length;
+        req->async  = server_async( handle, &fileio->io, event, apc, apc_user, iosb );
+        status = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+
+    if (status != STATUS_PENDING) free( fileio );
+    return status;
+}
+
+/* read from a byte mode pipe whose data is transferred over a socket; returns
+ * STATUS_BAD_DEVICE_TYPE when the data needs to go through the server again,
+ * which is also where synchronous reads wait so that they can be canceled */
+static unsigned int pipe_read( HANDLE handle, int *fd, int *needs_close, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
+                               client_ptr_t iosb, void *buffer, ULONG length, BOOL async, UINT *total )
+{
+    unsigned int status;
+    BOOL reopened;
+    int result;
+    char c;
+
+    for (;;)
+    {
+        /* zero-length reads only wait for data to be available */
+        if (length) result = virtual_locked_read( *fd, buffer, length );
+        else result = recv( *fd, &c, 1, MSG_PEEK | MSG_DONTWAIT );
+
+        if (result > 0)
+        {
+            *total = length ? result : 0;
+            return STATUS_SUCCESS;
+        }
+        if (!result)
+        {
+            /* the other end was closed, or our end got disconnected and maybe reconnected */
+            if ((status = server_reopen_unix_fd( handle, fd, needs_close, &reopened ))) return status;
+            if (reopened) continue;
+            return STATUS_PIPE_BROKEN;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) return errno_to_status( errno );
+
+        if (async)
+            return register_async_file_read( handle, event, apc, apc_user, iosb, buffer, 0, length, TRUE );
+        return STATUS_BAD_DEVICE_TYPE;
+    }
+}
+
+/* write to a byte mode pipe whose data is transferred over a socket; returns
+ * STATUS_BAD_DEVICE_TYPE when the rest of the data needs to go through the
+ * server, which is also where synchronous writes wait for buffer space */
+static unsigned int pipe_write( HANDLE handle, int *fd, int *needs_close, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
+                                client_ptr_t iosb, const void *buffer, ULONG length, BOOL async, UINT *total )
+{
+    unsigned int status;
+    BOOL reopened;
+    int result;
+
+    while (*total < length)
+    {
+        if ((result = send( *fd, (const char *)buffer + *total, length - *total,
+                            MSG_DONTWAIT | MSG_NOSIGNAL )) >= 0)
+        {
+            *total += result;
+            continue;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EPIPE)
+        {
+            if (*total) return STATUS_PIPE_CLOSING;
+            if ((status = server_reopen_unix_fd( handle, fd, needs_close, &reopened ))) return status;
+            if (reopened) continue;
+            return STATUS_PIPE_CLOSING;
+        }
+        if (errno != EAGAIN) return errno == EFAULT ? STATUS_INVALID_USER_BUFFER : errno_to_status( errno );
+
+        if (async)
+            return register_async_file_write( handle, event, apc, apc_user, iosb, buffer, *total, length );
+        return STATUS_BAD_DEVICE_TYPE;
+    }
+    return STATUS_SUCCESS;
+}
+
 void add_completion( HANDLE handle, ULONG_PTR value, NTSTATUS status, ULONG info, BOOL async )
 {
     SERVER_START_REQ( add_fd_completion )
@@ -5968,6 +6276,340 @@ static NTSTATUS cancel_async_file_read( HANDLE handle, IO_STATUS_BLOCK *io )
     return count ? STATUS_SUCCESS : STATUS_NOT_FOUND;
 }
 
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+
+/* Overlapped I/O on regular files is normally done synchronously with
+ * pread()/pwrite(), blocking the issuing thread. When WINEIOURING is set,
+ * requests which complete through an event (and optionally a completion
+ * port) are instead submitted to an io_uring, and completed from a helper
+ * thread. */
+
+#define URING_ENTRIES 256
+
+struct uring_request
+{
+    struct list      entry;       /* entry in uring_pending */
+    HANDLE           handle;
+    int              fd;          /* owned by the request */
+    HANDLE           event;
+    IO_STATUS_BLOCK *io;
+    ULONG_PTR        cvalue;
+    off_t            offset;
+    DWORD            thread_id;
+    BOOL             write;
+    BOOL             cancelled;
+    unsigned int     iov_count;
+    struct iovec     iov[1];
+};
+
+static struct
+{
+    int                  fd;
+    unsigned int         entries;
+    unsigned int         inflight;
+    unsigned int        *sq_head;
+    unsigned int        *sq_tail;
+    unsigned int        *sq_mask;
+    unsigned int        *sq_array;
+    unsigned int        *cq_head;
+    unsigned int        *cq_tail;
+    unsigned int        *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+} uring = { -1 };
+
+static pthread_mutex_t uring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t uring_once = PTHREAD_ONCE_INIT;
+static struct list uring_pending = LIST_INIT( uring_pending );
+
+static void uring_complete( struct uring_request *req, int res )
+{
+    NTSTATUS status;
+    ULONG total = 0;
+
+    if (res == -EFAULT && !req->write)
+    {
+        /* the kernel can't fault in write watched pages, do it ourselves */
+        unsigned int i;
+        ssize_t ret;
+
+        for (i = res = 0; i < req->iov_count; i++)
+        {
+            while ((ret = virtual_locked_pread( req->fd, req->iov[i].iov_base, req->iov[i].iov_len,
+                                                req->offset + res )) == -1 && errno == EINTR);
+            if (ret < 0)
+            {
+                if (!res) res = -errno;
+                break;
+            }
+            res += ret;
+            if (ret < req->iov[i].iov_len) break;
+        }
+    }
+
+    if (res == -ECANCELED) status = STATUS_CANCELLED;
+    else if (res == -EFAULT) status = STATUS_INVALID_USER_BUFFER;
+    else if (res < 0) status = errno_to_status( -res );
+    else
+    {
+        total = res;
+        status = (total || req->write) ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+    }
+    TRACE( "handle %p, io %p, status %#x, total %u\n", req->handle, req->io, (int)status, (int)total );
+
+    close( req->fd );
+    req->io->Status = status;
+    req->io->Information = total;
+    NtSetEvent( req->event, NULL );
+    if (req->cvalue) add_completion( req->handle, req->cvalue, status, total, TRUE );
+    free( req );
+}
+
+static void CALLBACK uring_thread( void *arg )
+{
+    struct uring_request *req;
+    struct io_uring_cqe *cqe;
+    unsigned int head, tail;
+
+    for (;;)
+    {
+        if (syscall( __NR_io_uring_enter, uring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0 ) < 0 && errno != EINTR)
+        {
+            ERR( "io_uring_enter failed: %s\n", strerror( errno ) );
+            break;
+        }
+
+        head = *uring.cq_head;
+        tail = __atomic_load_n( uring.cq_tail, __ATOMIC_ACQUIRE );
+        while (head != tail)
+        {
+            cqe = &uring.cqes[head & *uring.cq_mask];
+            req = (struct uring_request *)(ULONG_PTR)cqe->user_data;
+            __atomic_store_n( uring.cq_head, ++head, __ATOMIC_RELEASE );
+
+            pthread_mutex_lock( &uring_mutex );
+            uring.inflight--;
+            if (req) list_remove( &req->entry );
+            pthread_mutex_unlock( &uring_mutex );
+
+            /* cancel requests have no associated request */
+            if (req) uring_complete( req, cqe->res );
+        }
+    }
+}
+
+static void uring_init(void)
+{
+    struct io_uring_params params;
+    size_t sq_size, cq_size;
+    const char *env;
+    HANDLE thread;
+    void *sq, *cq;
+    int fd;
+
+    if (!(env = getenv( "WINEIOURING" )) || !atoi( env )) return;
+    /* the completion thread is started with a host entry point */
+    if (is_wow64()) return;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = syscall( __NR_io_uring_setup, URING_ENTRIES, &params )) < 0)
+    {
+        WARN( "io_uring_setup failed: %s\n", strerror( errno ) );
+        return;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = max( sq_size, cq_size );
+
+    sq = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if (sq == MAP_FAILED) goto failed;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) cq = sq;
+    else
+    {
+        cq = mmap( NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+        if (cq == MAP_FAILED) goto failed;
+    }
+    uring.sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (uring.sqes == MAP_FAILED) goto failed;
+
+    uring.sq_head  = (unsigned int *)((char *)sq + params.sq_off.head);
+    uring.sq_tail  = (unsigned int *)((char *)sq + params.sq_off.tail);
+    uring.sq_mask  = (unsigned int *)((char *)sq + params.sq_off.ring_mask);
+    uring.sq_array = (unsigned int *)((char *)sq + params.sq_off.array);
+    uring.cq_head  = (unsigned int *)((char *)cq + params.cq_off.head);
+    uring.cq_tail  = (unsigned int *)((char *)cq + params.cq_off.tail);
+    uring.cq_mask  = (unsigned int *)((char *)cq + params.cq_off.ring_mask);
+    uring.cqes     = (struct io_uring_cqe *)((char *)cq + params.cq_off.cqes);
+    uring.entries  = params.sq_entries;
+
+    uring.fd = fd;
+    if (NtCreateThreadEx( &thread, THREAD_ALL_ACCESS, NULL, NtCurrentProcess(), uring_thread,
+                          NULL, 0, 0, 0, 0, NULL ))
+    {
+        /* leave the mappings around, but never submit anything */
+        uring.fd = -1;
+        close( fd );
+        return;
+    }
+    NtClose( thread );
+    TRACE( "using io_uring with %u entries\n", uring.entries );
+    return;
+
+failed:
+    WARN( "failed to map io_uring: %s\n", strerror( errno ) );
+    close( fd );
+}
+
+/* caller must hold uring_mutex */
+static struct io_uring_sqe *uring_get_sqe(void)
+{
+    unsigned int tail = *uring.sq_tail, idx;
+
+    /* keep the completion queue (twice the size of the submission queue) from overflowing */
+    if (uring.inflight >= uring.entries) return NULL;
+    if (tail - __atomic_load_n( uring.sq_head, __ATOMIC_ACQUIRE ) >= uring.entries) return NULL;
+
+    idx = tail & *uring.sq_mask;
+    uring.sq_array[idx] = idx;
+    memset( &uring.sqes[idx], 0, sizeof(uring.sqes[idx]) );
+    return &uring.sqes[idx];
+}
+
+/* caller must hold uring_mutex */
+static BOOL uring_submit_sqe(void)
+{
+    unsigned int tail = *uring.sq_tail;
+
+    __atomic_store_n( uring.sq_tail, tail + 1, __ATOMIC_RELEASE );
+    if (syscall( __NR_io_uring_enter, uring.fd, 1, 0, 0, NULL, 0 ) == 1)
+    {
+        uring.inflight++;
+        return TRUE;
+    }
+    /* the kernel didn't consume the entry, take it back */
+    __atomic_store_n( uring.sq_tail, tail, __ATOMIC_RELEASE );
+    return FALSE;
+}
+
+static NTSTATUS uring_queue_rwv( HANDLE handle, int fd, int needs_close, HANDLE event, IO_STATUS_BLOCK *io,
+                                 ULONG_PTR cvalue, const struct iovec *iov, unsigned int count,
+                                 off_t offset, BOOL write )
+{
+    struct uring_request *req;
+    struct io_uring_sqe *sqe;
+
+    pthread_once( &uring_once, uring_init );
+    if (uring.fd == -1) return STATUS_NOT_SUPPORTED;
+
+    if (!(req = malloc( offsetof( struct uring_request, iov[count] ) ))) return STATUS_NOT_SUPPORTED;
+    /* the handle may be closed before completion, and the fd is needed again
+     * if the kernel can't access the buffer, so don't rely on the fd cache */
+    if (!needs_close && (fd = dup( fd )) == -1)
+    {
+        free( req );
+        return STATUS_NOT_SUPPORTED;
+    }
+    req->handle      = handle;
+    req->fd          = fd;
+    req->event       = event;
+    req->io          = io;
+    req->cvalue      = cvalue;
+    req->offset      = offset;
+    req->thread_id   = GetCurrentThreadId();
+    req->write       = write;
+    req->cancelled   = FALSE;
+    req->iov_count   = count;
+    memcpy( req->iov, iov, count * sizeof(*iov) );
+
+    NtResetEvent( event, NULL );
+
+    pthread_mutex_lock( &uring_mutex );
+    if (!(sqe = uring_get_sqe()))
+    {
+        pthread_mutex_unlock( &uring_mutex );
+        if (!needs_close) close( fd );
+        free( req );
+        return STATUS_NOT_SUPPORTED;
+    }
+    sqe->opcode    = write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = fd;
+    sqe->off       = offset;
+    sqe->addr      = (ULONG_PTR)req->iov;
+    sqe->len       = count;
+    sqe->user_data = (ULONG_PTR)req;
+    if (!uring_submit_sqe())
+    {
+        pthread_mutex_unlock( &uring_mutex );
+        if (!needs_close) close( fd );
+        free( req );
+        return STATUS_NOT_SUPPORTED;
+    }
+    list_add_tail( &uring_pending, &req->entry );
+    pthread_mutex_unlock( &uring_mutex );
+    return STATUS_PENDING;
+}
+
+static NTSTATUS uring_queue_rw( HANDLE handle, int fd, int needs_close, HANDLE event, IO_STATUS_BLOCK *io,
+                                ULONG_PTR cvalue, void *buffer, ULONG length, off_t offset, BOOL write )
+{
+    struct iovec iov;
+
+    iov.iov_base = buffer;
+    iov.iov_len  = length;
+    return uring_queue_rwv( handle, fd, needs_close, event, io, cvalue, &iov, 1, offset, write );
+}
+
+static NTSTATUS uring_cancel( HANDLE handle, IO_STATUS_BLOCK *io )
+{
+    DWORD thread_id = GetCurrentThreadId();
+    struct uring_request *req;
+    struct io_uring_sqe *sqe;
+    unsigned int count = 0;
+
+    if (uring.fd == -1) return STATUS_NOT_FOUND;
+
+    pthread_mutex_lock( &uring_mutex );
+    LIST_FOR_EACH_ENTRY( req, &uring_pending, struct uring_request, entry )
+    {
+        if (req->handle != handle || req->cancelled) continue;
+        if (io ? req->io != io : req->thread_id != thread_id) continue;
+
+        /* requests which are already running complete normally */
+        if (!(sqe = uring_get_sqe())) break;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr   = (ULONG_PTR)req;
+        if (!uring_submit_sqe()) break;
+        req->cancelled = TRUE;
+        ++count;
+    }
+    pthread_mutex_unlock( &uring_mutex );
+    return count ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+}
+
+#else
+
+static NTSTATUS uring_queue_rwv( HANDLE handle, int fd, int needs_close, HANDLE event, IO_STATUS_BLOCK *io,
+                                 ULONG_PTR cvalue, const struct iovec *iov, unsigned int count,
+                                 off_t offset, BOOL write )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+static NTSTATUS uring_queue_rw( HANDLE handle, int fd, int needs_close, HANDLE event, IO_STATUS_BLOCK *io,
+                                ULONG_PTR cvalue, void *buffer, ULONG length, off_t offset, BOOL write )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+static NTSTATUS uring_cancel( HANDLE handle, IO_STATUS_BLOCK *io )
+{
+    return STATUS_NOT_FOUND;
+}
+
+#endif
+
 /******************************************************************************
  *              NtReadFile   (NTDLL.@)
  */
@@ -6015,6 +6657,14 @@ NTSTATUS WINAPI NtReadFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, vo
             goto err;
         }
 
+        if (async_read && length && event && !apc &&
+            (status = uring_queue_rw( handle, unix_handle, needs_close, event, io, cvalue,
+                                      buffer, length, offset->QuadPart, FALSE )) != STATUS_NOT_SUPPORTED)
+        {
+            needs_close = 0;
+            goto err;
+        }
+
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
             /* async I/O doesn't make sense on regular files */
@@ -6048,6 +6698,18 @@ NTSTATUS WINAPI NtReadFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, vo
         if (needs_close) close( unix_handle );
         return status;
     }
+    else if (type == FD_TYPE_PIPE)
+    {
+        status = pipe_read( handle, &unix_handle, &needs_close, event, apc, apc_user, iosb_ptr,
+                            buffer, length, async_read, &total );
+        if (status == STATUS_BAD_DEVICE_TYPE)
+        {
+            if (needs_close) close( unix_handle );
+            return server_read_file( handle, event, apc, apc_user, io, buffer, length, offset, key );
+        }
+        if (status == STATUS_SUCCESS) goto done;
+        goto err;
+    }
 
     if (type == FD_TYPE_SERIAL && async_read && length)
     {
@@ -6178,6 +6840,61 @@ err:
 }
 
 
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+/* fill an iovec array from a list of page segments, starting at offset pos
+ * in the first one and merging pages which are contiguous in memory; returns
+ * the number of entries, and the number of bytes they cover in size */
+static unsigned int get_segments_iov( struct iovec *iov, const FILE_SEGMENT_ELEMENT *segments,
+                                      UINT pos, ULONG length, ULONG *size )
+{
+    unsigned int count = 0;
+    ULONG len;
+    char *ptr;
+
+    *size = 0;
+    while (length)
+    {
+        ptr = (char *)segments->Buffer + pos;
+        len = min( length, page_size - pos );
+        if (count && (char *)iov[count - 1].iov_base + iov[count - 1].iov_len == ptr)
+            iov[count - 1].iov_len += len;
+        else if (count == IOV_MAX)
+            break;
+        else
+        {
+            iov[count].iov_base = ptr;
+            iov[count].iov_len  = len;
+            count++;
+        }
+        *size += len;
+        length -= len;
+        pos = 0;
+        segments++;
+    }
+    return count;
+}
+
+static ssize_t segments_preadv( int fd, const struct iovec *iov, unsigned int count, off_t offset )
+{
+#ifdef HAVE_PREADV
+    return preadv( fd, iov, count, offset );
+#else
+    return pread( fd, iov[0].iov_base, iov[0].iov_len, offset );
+#endif
+}
+
+static ssize_t segments_pwritev( int fd, const struct iovec *iov, unsigned int count, off_t offset )
+{
+#ifdef HAVE_PWRITEV
+    return pwritev( fd, iov, count, offset );
+#else
+    return pwrite( fd, iov[0].iov_base, iov[0].iov_len, offset );
+#endif
+}
+
 /******************************************************************************
  *              NtReadFileScatter   (NTDLL.@)
  */
@@ -6185,13 +6902,16 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
                                    IO_STATUS_BLOCK *io, FILE_SEGMENT_ELEMENT *segments,
                                    ULONG length, LARGE_INTEGER *offset, ULONG *key )
 {
-    int result, unix_handle, needs_close;
-    unsigned int options, status;
+    int unix_handle, needs_close;
+    ssize_t result;
+    unsigned int options, status, count;
     UINT pos = 0, total = 0;
+    ULONG size;
     client_ptr_t iosb_ptr = iosb_client_ptr(io);
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+    struct iovec iov[IOV_MAX];
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io, segments, (int)length, offset, key );
@@ -6209,13 +6929,23 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         goto error;
     }
 
+    /* submit the whole request at once if it fits in a single vector */
+    if (length && event && !apc && offset && offset->QuadPart >= 0 &&
+        (count = get_segments_iov( iov, segments, 0, length, &size )) && size == length &&
+        uring_queue_rwv( file, unix_handle, needs_close, event, io, cvalue,
+                         iov, count, offset->QuadPart, FALSE ) == STATUS_PENDING)
+    {
+        TRACE("= STATUS_PENDING\n");
+        return STATUS_PENDING;
+    }
+
     while (length)
     {
+        count = get_segments_iov( iov, segments, pos, length, &size );
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
-            result = pread( unix_handle, (char *)segments->Buffer + pos,
-                            min( length - pos, page_size - pos ), offset->QuadPart + total );
+            result = segments_preadv( unix_handle, iov, count, offset->QuadPart + total );
         else
-            result = read( unix_handle, (char *)segments->Buffer + pos, min( length - pos, page_size - pos ) );
+            result = readv( unix_handle, iov, count );
 
         if (result == -1)
         {
@@ -6226,11 +6956,9 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         if (!result) break;
         total += result;
         length -= result;
-        if ((pos += result) == page_size)
-        {
-            pos = 0;
-            segments++;
-        }
+        pos += result;
+        segments += pos / page_size;
+        pos %= page_size;
     }
 
     if (total == 0) status = STATUS_END_OF_FILE;
@@ -6313,6 +7041,14 @@ NTSTATUS WINAPI NtWriteFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, v
             offset = &offset_eof;
         }
 
+        if (async_write && length && event && !apc && offset->QuadPart >= 0 &&
+            (status = uring_queue_rw( handle, unix_handle, needs_close, event, io, cvalue,
+                                      (void *)buffer, length, offset->QuadPart, TRUE )) != STATUS_NOT_SUPPORTED)
+        {
+            needs_close = 0;
+            goto err;
+        }
+
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
             off_t off = offset->QuadPart;
@@ -6368,6 +7104,21 @@ NTSTATUS WINAPI NtWriteFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, v
         if (needs_close) close( unix_handle );
         return status;
     }
+    else if (type == FD_TYPE_PIPE)
+    {
+        status = pipe_write( handle, &unix_handle, &needs_close, event, apc, apc_user, iosb_ptr,
+                             buffer, length, async_write, &total );
+        if (status == STATUS_BAD_DEVICE_TYPE)
+        {
+            if (needs_close) close( unix_handle );
+            status = server_write_file( handle, event, apc, apc_user, io, (const char *)buffer + total,
+                                        length - total, offset, key );
+            if (total && status == STATUS_SUCCESS) io->Information += total;
+            return status;
+        }
+        if (status == STATUS_SUCCESS) goto done;
+        goto err;
+    }
 
     for (;;)
     {
@@ -6400,28 +7151,8 @@ NTSTATUS WINAPI NtWriteFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, v
 
         if (async_write)
         {
-            struct async_fileio_write *fileio;
-
-            fileio = (struct async_fileio_write *)alloc_fileio( sizeof(*fileio), async_write_proc, handle );
-            if (!fileio)
-            {
-                status = STATUS_NO_MEMORY;
-                goto err;
-            }
-            fileio->already = total;
-            fileio->count = length;
-            fileio->buffer = buffer;
-
-            SERVER_START_REQ( register_async )
-            {
-                req->type   = ASYNC_TYPE_WRITE;
-                req->count  = length;
-                req->async  = server_async( handle, &fileio->io, event, apc, apc_user, iosb_ptr );
-                status = wine_server_call( req );
-            }
-            SERVER_END_REQ;
-
-            if (status != STATUS_PENDING) free( fileio );
+            status = register_async_file_write( handle, event, apc, apc_user, iosb_ptr,
+                                                buffer, total, length );
             goto err;
         }
         else  /* synchronous write, wait for the fd to become ready */
@@ -6492,13 +7223,16 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
                                    IO_STATUS_BLOCK *io, FILE_SEGMENT_ELEMENT *segments,
                                    ULONG length, LARGE_INTEGER *offset, ULONG *key )
 {
-    int result, unix_handle, needs_close;
-    unsigned int options, status;
+    int unix_handle, needs_close;
+    ssize_t result;
+    unsigned int options, status, count;
     UINT pos = 0, total = 0;
+    ULONG size;
     client_ptr_t iosb_ptr = iosb_client_ptr(io);
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+    struct iovec iov[IOV_MAX];
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io, segments, (int)length, offset, key );
@@ -6517,13 +7251,23 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         goto done;
     }
 
+    /* submit the whole request at once if it fits in a single vector */
+    if (length && event && !apc && offset && offset->QuadPart >= 0 &&
+        (count = get_segments_iov( iov, segments, 0, length, &size )) && size == length &&
+        uring_queue_rwv( file, unix_handle, needs_close, event, io, cvalue,
+                         iov, count, offset->QuadPart, TRUE ) == STATUS_PENDING)
+    {
+        TRACE("= STATUS_PENDING\n");
+        return STATUS_PENDING;
+    }
+
     while (length)
     {
+        count = get_segments_iov( iov, segments, pos, length, &size );
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
-            result = pwrite( unix_handle, (char *)segments->Buffer + pos,
-                             page_size - pos, offset->QuadPart + total );
+            result = segments_pwritev( unix_handle, iov, count, offset->QuadPart + total );
         else
-            result = write( unix_handle, (char *)segments->Buffer + pos, page_size - pos );
+            result = writev( unix_handle, iov, count );
 
         if (result == -1)
         {
@@ -6543,11 +7287,9 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         }
         total += result;
         length -= result;
-        if ((pos += result) == page_size)
-        {
-            pos = 0;
-            segments++;
-        }
+        pos += result;
+        segments += pos / page_size;
+        pos %= page_size;
     }
 
     send_completion = cvalue != 0;
@@ -6820,18 +7562,22 @@ NTSTATUS WINAPI NtFlushBuffersFile( HANDLE handle, IO_STATUS_BLOCK *io )
  */
 NTSTATUS WINAPI NtCancelIoFile( HANDLE handle, IO_STATUS_BLOCK *io_status )
 {
-    unsigned int status;
+    unsigned int status, uring_status;
 
     TRACE( "%p %p\n", handle, io_status );
 
     if (ac_odyssey && !cancel_async_file_read( handle, NULL ))
         return (io_status->Status = STATUS_SUCCESS);
+    /* io_uring requests don't exclude server asyncs on the same handle */
+    uring_status = uring_cancel( handle, NULL );
 
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( handle );
         req->only_thread = TRUE;
-        if (!(status = wine_server_call( req )))
+        status = wine_server_call( req );
+        if (status == STATUS_NOT_FOUND && !uring_status) status = STATUS_SUCCESS;
+        if (!status)
         {
             io_status->Status = status;
             io_status->Information = 0;
@@ -6848,18 +7594,21 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE handle, IO_STATUS_BLOCK *io_status )
  */
 NTSTATUS WINAPI NtCancelIoFileEx( HANDLE handle, IO_STATUS_BLOCK *io, IO_STATUS_BLOCK *io_status )
 {
-    unsigned int status;
+    unsigned int status, uring_status;
 
     TRACE( "%p %p %p\n", handle, io, io_status );
 
     if (ac_odyssey && !cancel_async_file_read( handle, io ))
         return (io_status->Status = STATUS_SUCCESS);
+    uring_status = uring_cancel( handle, io );
 
     SERVER_START_REQ( cancel_async )
     {
         req->handle = wine_server_obj_handle( handle );
         req->iosb   = wine_server_client_ptr( io );
-        if (!(status = wine_server_call( req )))
+        status = wine_server_call( req );
+        if (status == STATUS_NOT_FOUND && !uring_status) status = STATUS_SUCCESS;
+        if (!status)
         {
             io_status->Status = status;
             io_status->Information = 0;
@@ -266,6 +266,19 @@ C_ASSERT(sizeof(struct fsync_cache) == sizeof(uint64_t));
 static struct fsync_cache *fsync_list[FSYNC_LIST_ENTRIES];
 static struct fsync_cache fsync_list_initial_block[FSYNC_LIST_BLOCK_SIZE];
 
+/* Completion port rings; the ring index is cached per handle just like the
+ * fsync objects. */
+
+#define COMPLETION_RINGS_PER_PAGE (FSYNC_SHM_PAGE_SIZE / sizeof(completion_ring_t))
+#define NO_COMPLETION_RING        (~0u)
+
+static char ring_shm_name[40];
+static int ring_shm_fd = -1;
+static volatile void *ring_shm_addrs[4096];
+
+static unsigned int *completion_ring_list[FSYNC_LIST_ENTRIES];
+static unsigned int completion_ring_list_initial_block[FSYNC_LIST_BLOCK_SIZE];
+
 static inline UINT_PTR handle_to_index( HANDLE handle, UINT_PTR *entry )
 {
     UINT_PTR idx = (((UINT_PTR)handle) >> 2) - 1;
@@ -457,12 +470,16 @@ static NTSTATUS get_object_for_wait( HANDLE handle, struct fsync *obj, int *prev
     return STATUS_SUCCESS;
 }
 
+static void close_completion_ring( HANDLE handle );
+
 NTSTATUS fsync_close( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
 
     TRACE("%p.\n", handle);
 
+    close_completion_ring( handle );
+
     if (entry < FSYNC_LIST_ENTRIES && fsync_list[entry])
     {
         struct fsync_cache cache;
@@ -584,6 +601,10 @@ void fsync_init(void)
         exit(1);
     }
 
+    sprintf( ring_shm_name, "%s-iocp", shm_name );
+    if ((ring_shm_fd = shm_open( ring_shm_name, O_RDWR, 0644 )) == -1)
+        WARN("Failed to open completion port shared memory: %s\n", strerror( errno ));
+
     current_pid = GetCurrentProcessId();
     assert(current_pid);
 }
@@ -905,6 +926,337 @@ static NTSTATUS do_single_wait( int *addr, int val, const struct timespec64 *end
         return STATUS_PENDING;
 }
 
+/* Grab the APC futex if we don't already have it. */
+static int *get_apc_futex(void)
+{
+    if (!ntdll_get_thread_data()->fsync_apc_futex)
+    {
+        unsigned int idx = 0;
+        SERVER_START_REQ( get_fsync_apc_idx )
+        {
+            if (!wine_server_call( req ))
+                idx = reply->shm_idx;
+        }
+        SERVER_END_REQ;
+
+        if (idx)
+        {
+            struct event *apc_event = get_shm( idx );
+            ntdll_get_thread_data()->fsync_apc_futex = &apc_event->signaled;
+        }
+    }
+    return ntdll_get_thread_data()->fsync_apc_futex;
+}
+
+/* Completion port queues. The server allocates one ring per port in a
+ * separate shared memory file; posting and removing completions goes through
+ * the ring without server calls, and waiters sleep on its futex. */
+
+static completion_ring_t *get_ring_shm( unsigned int idx )
+{
+    unsigned int entry  = idx / COMPLETION_RINGS_PER_PAGE;
+    unsigned int offset = (idx % COMPLETION_RINGS_PER_PAGE) * sizeof(completion_ring_t);
+
+    if (entry >= ARRAY_SIZE(ring_shm_addrs))
+    {
+        ERR( "ring idx %u exceeds maximum.\n", idx );
+        return NULL;
+    }
+
+    if (!ring_shm_addrs[entry])
+    {
+        void *addr = mmap( NULL, FSYNC_SHM_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, ring_shm_fd,
+                           (off_t)entry * FSYNC_SHM_PAGE_SIZE );
+        if (addr == MAP_FAILED)
+        {
+            ERR( "Failed to map ring page %u.\n", entry );
+            return NULL;
+        }
+
+        TRACE( "Mapping ring page %u at %p.\n", entry, addr );
+
+        if (__sync_val_compare_and_swap( &ring_shm_addrs[entry], 0, addr ))
+            munmap( addr, FSYNC_SHM_PAGE_SIZE ); /* someone beat us to it */
+    }
+
+    return (completion_ring_t *)((char *)ring_shm_addrs[entry] + offset);
+}
+
+static void cache_completion_ring( HANDLE handle, unsigned int ring_idx )
+{
+    UINT_PTR entry, idx = handle_to_index( handle, &entry );
+
+    if (entry >= FSYNC_LIST_ENTRIES) return;
+
+    if (!completion_ring_list[entry])
+    {
+        if (!entry) completion_ring_list[0] = completion_ring_list_initial_block;
+        else
+        {
+            void *ptr = anon_mmap_alloc( FSYNC_LIST_BLOCK_SIZE * sizeof(*completion_ring_list[entry]),
+                                         PROT_READ | PROT_WRITE );
+            if (ptr == MAP_FAILED) return;
+            if (__sync_val_compare_and_swap( &completion_ring_list[entry], NULL, ptr ))
+                munmap( ptr, FSYNC_LIST_BLOCK_SIZE * sizeof(*completion_ring_list[entry]) );
+        }
+    }
+
+    __atomic_store_n( &completion_ring_list[entry][idx], ring_idx, __ATOMIC_SEQ_CST );
+}
+
+static completion_ring_t *get_completion_ring( HANDLE handle )
+{
+    UINT_PTR entry, idx;
+    unsigned int ring_idx = 0;
+    NTSTATUS ret;
+    sigset_t sigset;
+
+    if (ring_shm_fd == -1 || !handle || (INT_PTR)handle < 0) return NULL;
+
+    idx = handle_to_index( handle, &entry );
+    if (entry < FSYNC_LIST_ENTRIES && completion_ring_list[entry])
+        ring_idx = __atomic_load_n( &completion_ring_list[entry][idx], __ATOMIC_SEQ_CST );
+
+    if (!ring_idx)
+    {
+        /* See get_object() for why the uninterrupted section is needed. */
+        server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+        SERVER_START_REQ( get_completion_ring )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!(ret = wine_server_call( req ))) ring_idx = reply->ring_idx;
+        }
+        SERVER_END_REQ;
+        /* remember handles which can't use the ring, unless the handle is bogus */
+        if (ret && ret != STATUS_INVALID_HANDLE) ring_idx = NO_COMPLETION_RING;
+        if (ring_idx) cache_completion_ring( handle, ring_idx );
+        server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+    }
+
+    if (!ring_idx || ring_idx == NO_COMPLETION_RING) return NULL;
+    return get_ring_shm( ring_idx );
+}
+
+static void close_completion_ring( HANDLE handle )
+{
+    UINT_PTR entry, idx = handle_to_index( handle, &entry );
+
+    if (entry < FSYNC_LIST_ENTRIES && completion_ring_list[entry])
+        __atomic_store_n( &completion_ring_list[entry][idx], 0, __ATOMIC_SEQ_CST );
+}
+
+/* Lock-free bounded MPMC queue; must match the server side in completion.c. */
+static BOOL completion_ring_push( completion_ring_t *ring, ULONG_PTR key, ULONG_PTR value,
+                                  NTSTATUS status, SIZE_T count )
+{
+    unsigned int pos = __atomic_load_n( &ring->enqueue_pos, __ATOMIC_RELAXED );
+    completion_ring_entry_t *entry;
+    int diff;
+
+    for (;;)
+    {
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = (int)(__atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - pos);
+        if (!diff)
+        {
+            if (__atomic_compare_exchange_n( &ring->enqueue_pos, &pos, pos + 1, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+                break;
+        }
+        else if (diff < 0) return FALSE;  /* full */
+        else pos = __atomic_load_n( &ring->enqueue_pos, __ATOMIC_RELAXED );
+    }
+
+    entry->ckey = key;
+    entry->cvalue = value;
+    entry->status = status;
+    entry->information = count;
+    __atomic_store_n( &entry->seq, pos + 1, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+static BOOL completion_ring_pop( completion_ring_t *ring, FILE_IO_COMPLETION_INFORMATION *info )
+{
+    unsigned int pos = __atomic_load_n( &ring->dequeue_pos, __ATOMIC_RELAXED );
+    completion_ring_entry_t *entry;
+    int diff;
+
+    for (;;)
+    {
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = (int)(__atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - (pos + 1));
+        if (!diff)
+        {
+            if (__atomic_compare_exchange_n( &ring->dequeue_pos, &pos, pos + 1, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+                break;
+        }
+        else if (diff < 0) return FALSE;  /* empty */
+        else pos = __atomic_load_n( &ring->dequeue_pos, __ATOMIC_RELAXED );
+    }
+
+    info->CompletionKey             = entry->ckey;
+    info->CompletionValue           = entry->cvalue;
+    info->IoStatusBlock.Information = entry->information;
+    info->IoStatusBlock.Status      = entry->status;
+    __atomic_store_n( &entry->seq, pos + COMPLETION_RING_SIZE, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+static BOOL completion_ring_empty( completion_ring_t *ring )
+{
+    return __atomic_load_n( &ring->enqueue_pos, __ATOMIC_SEQ_CST ) ==
+           __atomic_load_n( &ring->dequeue_pos, __ATOMIC_SEQ_CST ) &&
+           !__atomic_load_n( &ring->overflow, __ATOMIC_SEQ_CST );
+}
+
+/* Keep the port's own wait state in sync, for waits on the port handle. */
+static void update_completion_event( completion_ring_t *ring, BOOL posted )
+{
+    struct event *event;
+
+    if (!ring->event_idx || !(event = get_shm( ring->event_idx ))) return;
+
+    if (!posted)
+    {
+        if (!completion_ring_empty( ring )) return;
+        __atomic_store_n( &event->signaled, 0, __ATOMIC_SEQ_CST );
+        /* recheck, someone may have posted in the meantime */
+        if (completion_ring_empty( ring )) return;
+    }
+    if (!__atomic_exchange_n( &event->signaled, 1, __ATOMIC_SEQ_CST ))
+        futex_wake( &event->signaled, INT_MAX );
+}
+
+/* A thread that can't wait on the ring retires it, and the server owns the
+ * queue from then on. */
+static BOOL completion_ring_retired( completion_ring_t *ring )
+{
+    return __atomic_load_n( &ring->retired, __ATOMIC_SEQ_CST );
+}
+
+static void repost_completion( HANDLE handle, const FILE_IO_COMPLETION_INFORMATION *info )
+{
+    SERVER_START_REQ( add_completion )
+    {
+        req->handle      = wine_server_obj_handle( handle );
+        req->ckey        = info->CompletionKey;
+        req->cvalue      = info->CompletionValue;
+        req->status      = info->IoStatusBlock.Status;
+        req->information = info->IoStatusBlock.Information;
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+}
+
+NTSTATUS fsync_set_io_completion( HANDLE handle, ULONG_PTR key, ULONG_PTR value,
+                                  NTSTATUS status, SIZE_T count )
+{
+    FILE_IO_COMPLETION_INFORMATION info;
+    completion_ring_t *ring;
+
+    TRACE("%p, %lx, %lx, %#x, %lu.\n", handle, (unsigned long)key, (unsigned long)value,
+          (unsigned int)status, (unsigned long)count);
+
+    if (!(ring = get_completion_ring( handle ))) return STATUS_NOT_IMPLEMENTED;
+
+    /* once the ring overflowed, keep posting through the server to preserve ordering */
+    if (completion_ring_retired( ring ) || __atomic_load_n( &ring->overflow, __ATOMIC_SEQ_CST ) ||
+        !completion_ring_push( ring, key, value, status, count ))
+        return STATUS_NOT_IMPLEMENTED;
+
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if (completion_ring_retired( ring ))
+    {
+        /* the ring got retired under us; unless the server already drained
+         * it, move the message over ourselves */
+        if (completion_ring_pop( ring, &info )) repost_completion( handle, &info );
+        return STATUS_SUCCESS;
+    }
+
+    __atomic_add_fetch( &ring->signal, 1, __ATOMIC_SEQ_CST );
+    if (__atomic_load_n( &ring->waiters, __ATOMIC_SEQ_CST ))
+        futex_wake( &ring->signal, 1 );
+    update_completion_event( ring, TRUE );
+    return STATUS_SUCCESS;
+}
+
+static BOOL remove_overflow_completion( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info )
+{
+    NTSTATUS ret;
+
+    SERVER_START_REQ( remove_completion )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        req->alertable = 0;
+        req->ring      = 1;
+        if (!(ret = wine_server_call( req )))
+        {
+            info->CompletionKey             = reply->ckey;
+            info->CompletionValue           = reply->cvalue;
+            info->IoStatusBlock.Information = reply->information;
+            info->IoStatusBlock.Status      = reply->status;
+        }
+    }
+    SERVER_END_REQ;
+    return !ret;
+}
+
+NTSTATUS fsync_remove_io_completion( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
+                                     ULONG *written, const LARGE_INTEGER *timeout, BOOLEAN alertable )
+{
+    completion_ring_t *ring;
+    clockid_t clock_id = 0;
+    struct timespec64 end;
+    NTSTATUS ret;
+    ULONG i = 0;
+    int signal;
+
+    TRACE("%p, %p, %u, %p, %p, %u.\n", handle, info, (unsigned int)count, written, timeout, alertable);
+
+    if (!(ring = get_completion_ring( handle )) || completion_ring_retired( ring ))
+        return STATUS_NOT_IMPLEMENTED;
+    if (alertable && !get_apc_futex()) return STATUS_NOT_IMPLEMENTED;
+
+    get_wait_end_time( &timeout, &end, &clock_id );
+
+    for (;;)
+    {
+        signal = __atomic_load_n( &ring->signal, __ATOMIC_SEQ_CST );
+
+        while (i < count && completion_ring_pop( ring, &info[i] )) ++i;
+        while (i < count && __atomic_load_n( &ring->overflow, __ATOMIC_SEQ_CST ) &&
+               remove_overflow_completion( handle, &info[i] )) ++i;
+        if (i)
+        {
+            update_completion_event( ring, FALSE );
+            ret = STATUS_SUCCESS;
+            break;
+        }
+        /* the server queue took over, wait there */
+        if (completion_ring_retired( ring )) return STATUS_NOT_IMPLEMENTED;
+
+        if (__atomic_load_n( &ring->closed, __ATOMIC_SEQ_CST ))
+        {
+            ret = STATUS_ABANDONED_WAIT_0;
+            break;
+        }
+        if (timeout && !update_timeout( &end, clock_id ))
+        {
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+
+        __atomic_add_fetch( &ring->waiters, 1, __ATOMIC_SEQ_CST );
+        ret = do_single_wait( &ring->signal, signal, timeout ? &end : NULL, clock_id, alertable );
+        __atomic_sub_fetch( &ring->waiters, 1, __ATOMIC_SEQ_CST );
+        if (ret == STATUS_TIMEOUT || ret == STATUS_USER_APC) break;
+    }
+
+    *written = i;
+    return ret;
+}
+
 static void put_objects( struct fsync *objs, unsigned int count )
 {
     unsigned int i;
@@ -933,23 +1285,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
     DWORD waitcount;
     int i, ret;
 
-    /* Grab the APC futex if we don't already have it. */
-    if (alertable && !ntdll_get_thread_data()->fsync_apc_futex)
-    {
-        unsigned int idx = 0;
-        SERVER_START_REQ( get_fsync_apc_idx )
-        {
-            if (!(ret = wine_server_call( req )))
-                idx = reply->shm_idx;
-        }
-        SERVER_END_REQ;
-
-        if (idx)
-        {
-            struct event *apc_event = get_shm( idx );
-            ntdll_get_thread_data()->fsync_apc_futex = &apc_event->signaled;
-        }
-    }
+    if (alertable) get_apc_futex();
 
     get_wait_end_time( &timeout, &end, &clock_id );
 
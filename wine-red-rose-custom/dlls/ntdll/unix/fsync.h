@@ -47,6 +47,10 @@ extern NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN
                                     BOOLEAN alertable, const LARGE_INTEGER *timeout );
 extern NTSTATUS fsync_signal_and_wait( HANDLE signal, HANDLE wait,
     BOOLEAN alertable, const LARGE_INTEGER *timeout );
+extern NTSTATUS fsync_set_io_completion( HANDLE handle, ULONG_PTR key, ULONG_PTR value,
+    NTSTATUS status, SIZE_T count );
+extern NTSTATUS fsync_remove_io_completion( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info,
+    ULONG count, ULONG *written, const LARGE_INTEGER *timeout, BOOLEAN alertable );
 
 /* We have to synchronize on the fd cache mutex so that fsync_close(), close_handle() sequence 
  * called from NtClose() doesn't race with get_fsync_idx(), add_to_list() sequence called
@@ -1120,6 +1120,37 @@ void fill_vm_counters( VM_COUNTERS_EX *pvmi, int unix_pid )
 
 #endif
 
+/* retrieve the information returned by get_process_info, from shared memory if possible */
+static unsigned int query_process_info( HANDLE handle, struct ptid_shared_memory *info )
+{
+    unsigned int status, seq;
+
+    if (get_shared_ptid_info( handle, PTID_CACHE_PROCESS, info )) return STATUS_SUCCESS;
+
+    seq = get_ptid_cache_seq( handle );
+    memset( info, 0, sizeof(*info) );
+    SERVER_START_REQ( get_process_info )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        if (!(status = wine_server_call( req )))
+        {
+            info->id         = reply->pid;
+            info->start_time = reply->start_time;
+            info->end_time   = reply->end_time;
+            info->base       = reply->peb;
+            info->affinity   = reply->affinity;
+            info->pid        = reply->ppid;
+            info->exit_code  = reply->exit_code;
+            info->priority   = reply->priority;
+            info->session_id = reply->session_id;
+            info->machine    = reply->machine;
+        }
+    }
+    SERVER_END_REQ;
+    if (!status) cache_ptid_handle( handle, info->id, PTID_CACHE_PROCESS, seq );
+    return status;
+}
+
 #define UNIMPLEMENTED_INFO_CLASS(c) \
     case c: \
         FIXME( "(process=%p) Unimplemented information class: " #c "\n", handle); \
@@ -1162,33 +1193,29 @@ NTSTATUS WINAPI NtQueryInformationProcess( HANDLE handle, PROCESSINFOCLASS class
         {
             PROCESS_BASIC_INFORMATION pbi;
             const ULONG_PTR affinity_mask = get_system_affinity_mask();
+            struct ptid_shared_memory shared;
 
             if (size >= sizeof(PROCESS_BASIC_INFORMATION))
             {
                 if (!info) ret = STATUS_ACCESS_VIOLATION;
                 else
                 {
-                    SERVER_START_REQ(get_process_info)
+                    if ((ret = query_process_info( handle, &shared )) == STATUS_SUCCESS)
                     {
-                        req->handle = wine_server_obj_handle( handle );
-                        if ((ret = wine_server_call( req )) == STATUS_SUCCESS)
+                        pbi.ExitStatus = shared.exit_code;
+                        pbi.PebBaseAddress = wine_server_get_ptr( shared.base );
+                        pbi.AffinityMask = shared.affinity & affinity_mask;
+                        pbi.BasePriority = shared.priority;
+                        pbi.UniqueProcessId = shared.id;
+                        pbi.InheritedFromUniqueProcessId = shared.pid;
+                        if (is_old_wow64())
                         {
-                            pbi.ExitStatus = reply->exit_code;
-                            pbi.PebBaseAddress = wine_server_get_ptr( reply->peb );
-                            pbi.AffinityMask = reply->affinity & affinity_mask;
-                            pbi.BasePriority = reply->priority;
-                            pbi.UniqueProcessId = reply->pid;
-                            pbi.InheritedFromUniqueProcessId = reply->ppid;
-                            if (is_old_wow64())
-                            {
-                                if (reply->machine != native_machine)
-                                    pbi.PebBaseAddress = (PEB *)((char *)pbi.PebBaseAddress + 0x1000);
-                                else
-                                    pbi.PebBaseAddress = NULL;
-                            }
+                            if (shared.machine != native_machine)
+                                pbi.PebBaseAddress = (PEB *)((char *)pbi.PebBaseAddress + 0x1000);
+                            else
+                                pbi.PebBaseAddress = NULL;
                         }
                     }
-                    SERVER_END_REQ;
 
                     memcpy( info, &pbi, sizeof(PROCESS_BASIC_INFORMATION) );
                     len = sizeof(PROCESS_BASIC_INFORMATION);
@@ -1309,6 +1336,7 @@ NTSTATUS WINAPI NtQueryInformationProcess( HANDLE handle, PROCESSINFOCLASS class
     case ProcessTimes:
         {
             KERNEL_USER_TIMES pti = {{{0}}};
+            struct ptid_shared_memory shared;
 
             if (size >= sizeof(KERNEL_USER_TIMES))
             {
@@ -1326,16 +1354,11 @@ NTSTATUS WINAPI NtQueryInformationProcess( HANDLE handle, PROCESSINFOCLASS class
                         pti.KernelTime.QuadPart = (ULONGLONG)tms.tms_stime * 10000000 / ticks;
                     }
 
-                    SERVER_START_REQ(get_process_info)
+                    if ((ret = query_process_info( handle, &shared )) == STATUS_SUCCESS)
                     {
-                        req->handle = wine_server_obj_handle( handle );
-                        if ((ret = wine_server_call( req )) == STATUS_SUCCESS)
-                        {
-                            pti.CreateTime.QuadPart = reply->start_time;
-                            pti.ExitTime.QuadPart = reply->end_time;
-                        }
+                        pti.CreateTime.QuadPart = shared.start_time;
+                        pti.ExitTime.QuadPart = shared.end_time;
                     }
-                    SERVER_END_REQ;
 
                     memcpy(info, &pti, sizeof(KERNEL_USER_TIMES));
                     len = sizeof(KERNEL_USER_TIMES);
@@ -1451,14 +1474,10 @@ NTSTATUS WINAPI NtQueryInformationProcess( HANDLE handle, PROCESSINFOCLASS class
         if (size == len)
         {
             const ULONG_PTR system_mask = get_system_affinity_mask();
+            struct ptid_shared_memory shared;
 
-            SERVER_START_REQ(get_process_info)
-            {
-                req->handle = wine_server_obj_handle( handle );
-                if (!(ret = wine_server_call( req )))
-                    *(ULONG_PTR *)info = reply->affinity & system_mask;
-            }
-            SERVER_END_REQ;
+            if (!(ret = query_process_info( handle, &shared )))
+                *(ULONG_PTR *)info = shared.affinity & system_mask;
         }
         else return STATUS_INFO_LENGTH_MISMATCH;
         break;
@@ -1467,13 +1486,10 @@ NTSTATUS WINAPI NtQueryInformationProcess( HANDLE handle, PROCESSINFOCLASS class
         len = sizeof(DWORD);
         if (size == len)
         {
-            SERVER_START_REQ(get_process_info)
-            {
-                req->handle = wine_server_obj_handle( handle );
-                if (!(ret = wine_server_call( req )))
-                    *(DWORD *)info = reply->session_id;
-            }
-            SERVER_END_REQ;
+            struct ptid_shared_memory shared;
+
+            if (!(ret = query_process_info( handle, &shared )))
+                *(DWORD *)info = shared.session_id;
         }
         else ret = STATUS_INFO_LENGTH_MISMATCH;
         break;
@@ -1545,18 +1561,14 @@ NTSTATUS WINAPI NtQueryInformationProcess( HANDLE handle, PROCESSINFOCLASS class
             else
             {
                 PROCESS_PRIORITY_CLASS *priority = info;
+                struct ptid_shared_memory shared;
 
-                SERVER_START_REQ(get_process_info)
+                if ((ret = query_process_info( handle, &shared )) == STATUS_SUCCESS)
                 {
-                    req->handle = wine_server_obj_handle( handle );
-                    if ((ret = wine_server_call( req )) == STATUS_SUCCESS)
-                    {
-                        priority->PriorityClass = reply->priority;
-                        /* FIXME: Not yet supported by the wineserver */
-                        priority->Foreground = FALSE;
-                    }
+                    priority->PriorityClass = shared.priority;
+                    /* FIXME: Not yet supported by the wineserver */
+                    priority->Foreground = FALSE;
                 }
-                SERVER_END_REQ;
             }
         }
         else ret = STATUS_INFO_LENGTH_MISMATCH;
@@ -1150,6 +1150,38 @@ static int remove_fd_from_cache( HANDLE handle )
 }
 
 
+/* fds replaced in the cache while other threads may still be using them;
+ * they are closed when the handle is closed or reopened again, so that
+ * there is at most one per handle */
+struct stale_fd
+{
+    struct list entry;
+    HANDLE      handle;
+    int         fd;
+};
+
+static struct list stale_fds = LIST_INIT( stale_fds );
+
+
+/***********************************************************************
+ *           close_stale_fds
+ *
+ * Caller must hold fd_cache_mutex.
+ */
+static void close_stale_fds( HANDLE handle )
+{
+    struct stale_fd *stale, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( stale, next, &stale_fds, struct stale_fd, entry )
+    {
+        if (stale->handle != handle) continue;
+        list_remove( &stale->entry );
+        close( stale->fd );
+        free( stale );
+    }
+}
+
+
 /***********************************************************************
  *           server_get_unix_fd
  *
@@ -1211,6 +1243,70 @@ done:
 }
 
 
+/***********************************************************************
+ *           server_reopen_unix_fd
+ *
+ * Ask the server again for the unix fd of a handle whose fd may be stale, for
+ * instance a pipe end that got reconnected. If the server returns a different
+ * file, it replaces unix_fd and the cached fd. The old cached fd may still be
+ * in use by other threads, so it is only closed along with the handle, or by
+ * the next reopen, which closes the stale fd of the previous one.
+ */
+unsigned int server_reopen_unix_fd( HANDLE handle, int *unix_fd, int *needs_close, BOOL *reopened )
+{
+    sigset_t sigset;
+    obj_handle_t fd_handle;
+    struct stat old_st, new_st;
+    struct stale_fd *stale;
+    unsigned int ret;
+    int fd, cached;
+
+    *reopened = FALSE;
+
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    SERVER_START_REQ( get_handle_fd )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        if (!(ret = wine_server_call( req )))
+        {
+            if ((fd = receive_fd( &fd_handle )) != -1)
+            {
+                assert( wine_server_ptr_handle(fd_handle) == handle );
+                if (!fstat( *unix_fd, &old_st ) && !fstat( fd, &new_st ) &&
+                    old_st.st_dev == new_st.st_dev && old_st.st_ino == new_st.st_ino)
+                {
+                    close( fd );
+                }
+                else
+                {
+                    if (!list_empty( &stale_fds )) close_stale_fds( handle );
+                    if (*needs_close) close( *unix_fd );
+                    else if ((cached = remove_fd_from_cache( handle )) != -1)
+                    {
+                        if ((stale = malloc( sizeof(*stale) )))
+                        {
+                            stale->handle = handle;
+                            stale->fd = cached;
+                            list_add_tail( &stale_fds, &stale->entry );
+                        }
+                        else WARN( "leaking stale fd %d for %p\n", cached, handle );
+                    }
+                    *needs_close = (*needs_close || !reply->cacheable ||
+                                    !add_fd_to_cache( handle, fd, reply->type,
+                                                      reply->access, reply->options ));
+                    *unix_fd = fd;
+                    *reopened = TRUE;
+                }
+            }
+            else ret = STATUS_TOO_MANY_OPENED_FILES;
+        }
+    }
+    SERVER_END_REQ;
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+    return ret;
+}
+
+
 /***********************************************************************
  *           wine_server_fd_to_handle
  */
@@ -1867,7 +1963,12 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     if (options & DUPLICATE_CLOSE_SOURCE)
+    {
         fd = remove_fd_from_cache( source );
+        if (!list_empty( &stale_fds )) close_stale_fds( source );
+        sock_remove_from_cache( source );
+        ptid_remove_from_cache( source );
+    }
 
     SERVER_START_REQ( dup_handle )
     {
@@ -1928,6 +2029,9 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     fd = remove_fd_from_cache( handle );
+    if (!list_empty( &stale_fds )) close_stale_fds( handle );
+    sock_remove_from_cache( handle );
+    ptid_remove_from_cache( handle );
 
     if (do_fsync())
         fsync_close( handle );
@@ -25,9 +25,11 @@
 #include "config.h"
 #include <assert.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
@@ -856,6 +858,116 @@ static BOOL is_icmp_over_dgram( int fd )
 #endif
 }
 
+/* The server publishes, for each socket, whether a recv() or send() which
+ * completes immediately would require any work on its side. If not, the
+ * client may issue the system call directly and skip the server round trip. */
+
+#define SOCK_SHM_CACHE_SIZE 16384
+
+static const socket_shm_t *sock_shm;
+static LONG64 *sock_shm_cache;  /* per handle: (seq << 32) | (slot + 1) */
+static pthread_once_t sock_shm_once = PTHREAD_ONCE_INIT;
+
+static void sock_shm_init(void)
+{
+    static const WCHAR nameW[] = {'\\','K','e','r','n','e','l','O','b','j','e','c','t','s',
+                                  '\\','_','_','w','i','n','e','_','t','h','r','e','a','d','_',
+                                  'm','a','p','p','i','n','g','s','\\','s','o','c','k','e','t','s',0};
+    SIZE_T size = SOCKET_SHM_COUNT * sizeof(*sock_shm);
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    void *ptr = NULL;
+    HANDLE section;
+    NTSTATUS status;
+
+    init_unicode_string( &name, nameW );
+    InitializeObjectAttributes( &attr, &name, 0, 0, NULL );
+    if ((status = NtOpenSection( &section, SECTION_MAP_READ, &attr )))
+    {
+        WARN( "failed to open socket shared memory, status %#x\n", status );
+        return;
+    }
+    status = NtMapViewOfSection( section, NtCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                 ViewShare, 0, PAGE_READONLY );
+    NtClose( section );
+    if (status)
+    {
+        WARN( "failed to map socket shared memory, status %#x\n", status );
+        return;
+    }
+
+    sock_shm_cache = anon_mmap_alloc( SOCK_SHM_CACHE_SIZE * sizeof(*sock_shm_cache), PROT_READ | PROT_WRITE );
+    if (sock_shm_cache == MAP_FAILED)
+    {
+        sock_shm_cache = NULL;
+        return;
+    }
+    sock_shm = ptr;
+}
+
+/* caller must hold fd_cache_mutex */
+void sock_remove_from_cache( HANDLE handle )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+
+    if (sock_shm_cache && idx < SOCK_SHM_CACHE_SIZE)
+        __atomic_store_n( &sock_shm_cache[idx], 0, __ATOMIC_RELAXED );
+}
+
+/* Like the fd cache, the slot is looked up while holding fd_cache_mutex,
+ * so that NtClose() can't drop the entry between the server reply and
+ * storing it, leaving another socket's slot attached to a reused handle. */
+static LONG64 sock_lookup_shm_slot( HANDLE handle, unsigned int idx )
+{
+    unsigned int status, slot, shm_seq;
+    sigset_t sigset;
+    LONG64 entry;
+
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    if (!(entry = __atomic_load_n( &sock_shm_cache[idx], __ATOMIC_RELAXED )))
+    {
+        SERVER_START_REQ( socket_get_shm_slot )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            status  = wine_server_call( req );
+            slot    = reply->shm_slot;
+            shm_seq = reply->shm_seq;
+        }
+        SERVER_END_REQ;
+        if (!status)
+        {
+            /* sockets without a slot are cached too, so that we don't ask again */
+            if (slot >= SOCKET_SHM_COUNT) slot = SOCKET_SHM_COUNT;
+            entry = ((LONG64)shm_seq << 32) | (slot + 1);
+            __atomic_store_n( &sock_shm_cache[idx], entry, __ATOMIC_RELAXED );
+        }
+    }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+    return entry;
+}
+
+/* returns the SOCKET_SHM_* flags of a socket, or 0 if unknown */
+static unsigned int sock_get_shm_flags( HANDLE handle )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+    unsigned int slot, flags;
+    LONG64 entry;
+
+    if (idx >= SOCK_SHM_CACHE_SIZE) return 0;
+    pthread_once( &sock_shm_once, sock_shm_init );
+    if (!sock_shm_cache) return 0;
+    if (!(entry = __atomic_load_n( &sock_shm_cache[idx], __ATOMIC_RELAXED )) &&
+        !(entry = sock_lookup_shm_slot( handle, idx )))
+        return 0;
+    if ((slot = (ULONG)entry - 1) >= SOCKET_SHM_COUNT) return 0;
+
+    /* the server clears the flags before bumping the sequence number when
+     * a slot is released, so check them in the opposite order */
+    flags = __atomic_load_n( &sock_shm[slot].flags, __ATOMIC_ACQUIRE );
+    if (__atomic_load_n( &sock_shm[slot].seq, __ATOMIC_ACQUIRE ) != (ULONG)(entry >> 32)) return 0;
+    return flags;
+}
+
 static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
                            int fd, struct async_recv_ioctl *async, int force_async )
 {
@@ -873,6 +985,25 @@ static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
         }
     }
 
+    if (!force_async && !apc && !apc_user && !(async->unix_flags & MSG_OOB) && !async->icmp_over_dgram
+        && (sock_get_shm_flags( handle ) & SOCKET_SHM_RECV))
+    {
+        ULONG_PTR information;
+
+        status = try_recv( fd, async, &information );
+        if (status != STATUS_DEVICE_NOT_READY)
+        {
+            if (!NT_ERROR(status))
+            {
+                io->Status = status;
+                io->Information = information;
+                if (event) NtSetEvent( event, NULL );
+            }
+            release_fileio( &async->io );
+            return status;
+        }
+    }
+
     SERVER_START_REQ( recv_socket )
     {
         req->force_async = force_async;
@@ -1152,6 +1283,26 @@ static NTSTATUS sock_send( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
     unsigned int status;
     ULONG options;
 
+    if (!server_flags && !apc && !apc_user && (sock_get_shm_flags( handle ) & SOCKET_SHM_SEND))
+    {
+        /* a short write leaves the iovec cursor advanced, and the server
+         * path below picks up the remaining data */
+        status = try_send( fd, async );
+        hack_update_status( handle, &status );
+        if (status != STATUS_DEVICE_NOT_READY)
+        {
+            if (!NT_ERROR(status))
+            {
+                io->Status = status;
+                io->Information = async->sent_len;
+                if (event) NtSetEvent( event, NULL );
+            }
+            if (async->fd != -1) close( async->fd );
+            release_fileio( &async->io );
+            return status;
+        }
+    }
+
     SERVER_START_REQ( send_socket )
     {
         req->flags = server_flags;
@@ -1594,6 +1745,150 @@ static int get_sock_type( HANDLE handle )
 }
 
 
+/* Check readiness of a socket set without involving the server. This is only
+ * done if none of the sockets is in a state where the server would act on
+ * what poll() reports, i.e. connection state changes, errors, or asyncs
+ * waiting for the same events. Returns STATUS_NOT_SUPPORTED if the request
+ * has to go through the server. */
+static NTSTATUS sock_poll( HANDLE handle, HANDLE event, IO_STATUS_BLOCK *io, const void *in_buffer, UINT in_size,
+                           void *out_buffer, UINT out_size )
+{
+    const struct afd_poll_params_64 *params64 = in_buffer;
+    const struct afd_poll_params_32 *params32 = in_buffer;
+    BOOL wow64 = in_wow64_call();
+    struct pollfd fds_buffer[64], *fds = fds_buffer;
+    unsigned int i, count, signaled = 0;
+    unsigned int *masks = NULL, *shm_flags = NULL;
+    char *needs_close = NULL;
+    NTSTATUS status = STATUS_NOT_SUPPORTED;
+    LONGLONG timeout;
+    SIZE_T size;
+    void *output;
+
+    if (wow64)
+    {
+        if (in_size < offsetof( struct afd_poll_params_32, sockets[0] )) return STATUS_NOT_SUPPORTED;
+        count = params32->count;
+        timeout = params32->timeout;
+        if (params32->exclusive || in_size < offsetof( struct afd_poll_params_32, sockets[count] ))
+            return STATUS_NOT_SUPPORTED;
+    }
+    else
+    {
+        if (in_size < offsetof( struct afd_poll_params_64, sockets[0] )) return STATUS_NOT_SUPPORTED;
+        count = params64->count;
+        timeout = params64->timeout;
+        if (params64->exclusive || in_size < offsetof( struct afd_poll_params_64, sockets[count] ))
+            return STATUS_NOT_SUPPORTED;
+    }
+    if (!count) return STATUS_NOT_SUPPORTED;
+
+    if (count > ARRAY_SIZE(fds_buffer) && !(fds = malloc( count * sizeof(*fds) ))) return STATUS_NOT_SUPPORTED;
+    masks = malloc( count * sizeof(*masks) );
+    shm_flags = malloc( count * sizeof(*shm_flags) );
+    needs_close = calloc( count, sizeof(*needs_close) );
+    if (!masks || !shm_flags || !needs_close) goto done;
+
+    for (i = 0; i < count; ++i)
+    {
+        HANDLE sock = wow64 ? ULongToHandle( params32->sockets[i].socket ) : (HANDLE)(ULONG_PTR)params64->sockets[i].socket;
+        int needs_close_fd;
+
+        fds[i].fd = -1;
+        masks[i] = wow64 ? params32->sockets[i].flags : params64->sockets[i].flags;
+        if (!((shm_flags[i] = sock_get_shm_flags( sock )) & SOCKET_SHM_POLL)) goto done;
+        if (server_get_unix_fd( sock, 0, &fds[i].fd, &needs_close_fd, NULL, NULL ))
+        {
+            fds[i].fd = -1;
+            goto done;
+        }
+        needs_close[i] = needs_close_fd;
+
+        fds[i].events = 0;
+        if (masks[i] & (AFD_POLL_READ | AFD_POLL_ACCEPT)) fds[i].events |= POLLIN;
+        if ((masks[i] & AFD_POLL_HUP) && (shm_flags[i] & SOCKET_SHM_STREAM)) fds[i].events |= POLLIN;
+        if (masks[i] & AFD_POLL_OOB) fds[i].events |= POLLPRI;
+        if (masks[i] & AFD_POLL_WRITE) fds[i].events |= POLLOUT;
+    }
+
+    if (poll( fds, count, 0 ) < 0) goto done;
+
+    for (i = 0; i < count; ++i)
+    {
+        int revents = fds[i].revents, flags;
+
+        /* hangups, errors and urgent data change the server's view of the
+         * socket, so let it handle them */
+        if (revents & (POLLERR | POLLHUP | POLLNVAL | POLLPRI)) goto done;
+
+        if ((revents & POLLIN) && (shm_flags[i] & SOCKET_SHM_STREAM))
+        {
+            char dummy;
+            int ret = recv( fds[i].fd, &dummy, 1, MSG_PEEK );
+
+            if (!ret || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) goto done;
+            if (ret < 0) revents &= ~POLLIN;
+        }
+
+        flags = 0;
+        if (revents & POLLIN) flags |= AFD_POLL_READ;
+        if (revents & POLLOUT) flags |= AFD_POLL_WRITE;
+        if (shm_flags[i] & SOCKET_SHM_CONNECTED) flags |= AFD_POLL_CONNECT;
+        if ((masks[i] &= flags)) ++signaled;
+    }
+
+    /* waiting is left to the server */
+    if (!signaled && timeout) goto done;
+
+    size = wow64 ? offsetof( struct afd_poll_params_32, sockets[signaled] )
+                 : offsetof( struct afd_poll_params_64, sockets[signaled] );
+    if (out_size < size || !(output = calloc( 1, size ))) goto done;
+
+    if (wow64)
+    {
+        struct afd_poll_params_32 *out = output;
+
+        out->timeout = timeout;
+        for (i = 0; i < count; ++i)
+        {
+            if (!masks[i]) continue;
+            out->sockets[out->count].socket = params32->sockets[i].socket;
+            out->sockets[out->count].flags = masks[i];
+            out->sockets[out->count].status = STATUS_SUCCESS;
+            ++out->count;
+        }
+    }
+    else
+    {
+        struct afd_poll_params_64 *out = output;
+
+        out->timeout = timeout;
+        for (i = 0; i < count; ++i)
+        {
+            if (!masks[i]) continue;
+            out->sockets[out->count].socket = params64->sockets[i].socket;
+            out->sockets[out->count].flags = masks[i];
+            out->sockets[out->count].status = STATUS_SUCCESS;
+            ++out->count;
+        }
+    }
+    /* the output buffer usually aliases the input */
+    memcpy( out_buffer, output, size );
+    free( output );
+
+    status = STATUS_SUCCESS;
+    complete_async( handle, event, NULL, NULL, io, status, size );
+
+done:
+    for (i = 0; needs_close && i < count; ++i)
+        if (needs_close[i] && fds[i].fd != -1) close( fds[i].fd );
+    if (fds != fds_buffer) free( fds );
+    free( masks );
+    free( shm_flags );
+    free( needs_close );
+    return status;
+}
+
 NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
                      UINT code, void *in_buffer, UINT in_size, void *out_buffer, UINT out_size )
 {
@@ -1674,6 +1969,9 @@ NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc
         }
 
         case IOCTL_AFD_POLL:
+            if (!apc && !apc_user &&
+                (status = sock_poll( handle, event, io, in_buffer, in_size, out_buffer, out_size )) != STATUS_NOT_SUPPORTED)
+                return status;
             status = STATUS_BAD_DEVICE_TYPE;
             break;
 
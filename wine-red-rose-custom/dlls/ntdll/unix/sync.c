@@ -2017,6 +2017,12 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value
 
     TRACE( "(%p, %lx, %lx, %x, %lx)\n", handle, key, value, (int)status, count );
 
+    if (do_fsync())
+    {
+        ret = fsync_set_io_completion( handle, key, value, status, count );
+        if (ret != STATUS_NOT_IMPLEMENTED) return ret;
+    }
+
     SERVER_START_REQ( add_completion )
     {
         req->handle      = wine_server_obj_handle( handle );
@@ -2042,6 +2048,24 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
 
     TRACE( "(%p, %p, %p, %p, %p)\n", handle, key, value, io, timeout );
 
+    if (do_fsync())
+    {
+        FILE_IO_COMPLETION_INFORMATION info;
+        ULONG written;
+
+        status = fsync_remove_io_completion( handle, &info, 1, &written, timeout, FALSE );
+        if (status != STATUS_NOT_IMPLEMENTED)
+        {
+            if (!status)
+            {
+                *key   = info.CompletionKey;
+                *value = info.CompletionValue;
+                *io    = info.IoStatusBlock;
+            }
+            return status;
+        }
+    }
+
     if (timeout && !timeout->QuadPart && (do_esync() || do_fsync()))
     {
         status = NtWaitForSingleObject( handle, FALSE, timeout );
@@ -2095,6 +2119,17 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORM
 
     TRACE( "%p %p %u %p %p %u\n", handle, info, (int)count, written, timeout, alertable );
 
+    if (do_fsync() && count)
+    {
+        status = fsync_remove_io_completion( handle, info, count, &i, timeout, alertable );
+        if (status == STATUS_USER_APC)
+        {
+            status = NtDelayExecution( TRUE, NULL );
+            assert( status == STATUS_USER_APC );
+        }
+        if (status != STATUS_NOT_IMPLEMENTED) goto done;
+    }
+
     if (timeout && !timeout->QuadPart && (do_esync() || do_fsync()))
     {
         status = NtWaitForSingleObject( handle, alertable, timeout );
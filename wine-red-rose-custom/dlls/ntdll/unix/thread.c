@@ -1927,6 +1927,168 @@ BOOL get_thread_times(int unix_pid, int unix_tid, LARGE_INTEGER *kernel_time, LA
 #endif
 }
 
+/* The server publishes the information returned by get_thread_info and
+ * get_process_info in a mapping indexed by thread and process id. Handles
+ * are associated with the id they refer to the first time they are queried,
+ * after which most queries don't need a server round trip. */
+
+#define PTID_CACHE_SIZE 16384
+
+static const ptid_shm_t *ptid_shm;
+static ULONG64 *ptid_cache;  /* per handle: (PTID_CACHE_* flags << 32) | id */
+static unsigned int *ptid_cache_seq;  /* per handle, bumped when it's closed */
+static pthread_once_t ptid_shm_once = PTHREAD_ONCE_INIT;
+
+static void ptid_shm_init(void)
+{
+    static const WCHAR nameW[] = {'\\','K','e','r','n','e','l','O','b','j','e','c','t','s',
+                                  '\\','_','_','w','i','n','e','_','t','h','r','e','a','d','_',
+                                  'm','a','p','p','i','n','g','s','\\','p','t','i','d','s',0};
+    SIZE_T size = PTID_SHM_COUNT * sizeof(*ptid_shm);
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    void *ptr = NULL;
+    HANDLE section;
+    NTSTATUS status;
+
+    init_unicode_string( &name, nameW );
+    InitializeObjectAttributes( &attr, &name, 0, 0, NULL );
+    if ((status = NtOpenSection( &section, SECTION_MAP_READ, &attr )))
+    {
+        WARN( "failed to open thread shared memory, status %#x\n", status );
+        return;
+    }
+    status = NtMapViewOfSection( section, NtCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                 ViewShare, 0, PAGE_READONLY );
+    NtClose( section );
+    if (status)
+    {
+        WARN( "failed to map thread shared memory, status %#x\n", status );
+        return;
+    }
+
+    ptid_cache = anon_mmap_alloc( PTID_CACHE_SIZE * (sizeof(*ptid_cache) + sizeof(*ptid_cache_seq)),
+                                  PROT_READ | PROT_WRITE );
+    if (ptid_cache == MAP_FAILED)
+    {
+        ptid_cache = NULL;
+        return;
+    }
+    ptid_cache_seq = (unsigned int *)(ptid_cache + PTID_CACHE_SIZE);
+    ptid_shm = ptr;
+}
+
+/* returns the value to pass to cache_ptid_handle(), to be called before
+ * asking the server about the handle */
+unsigned int get_ptid_cache_seq( HANDLE handle )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+
+    if (idx >= PTID_CACHE_SIZE) return 0;
+    pthread_once( &ptid_shm_once, ptid_shm_init );
+    if (!ptid_cache) return 0;
+    return __atomic_load_n( &ptid_cache_seq[idx], __ATOMIC_ACQUIRE );
+}
+
+/* remember the thread or process id a handle refers to; like the fd cache,
+ * the entry is only stored under fd_cache_mutex, and not at all if the
+ * handle was closed since get_ptid_cache_seq(), since it may now refer to
+ * another object */
+void cache_ptid_handle( HANDLE handle, unsigned int id, unsigned int flags, unsigned int seq )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+    sigset_t sigset;
+
+    if (handle == GetCurrentThread() || handle == GetCurrentProcess()) return;
+    if (idx >= PTID_CACHE_SIZE || !ptid_cache) return;
+
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    if (__atomic_load_n( &ptid_cache_seq[idx], __ATOMIC_RELAXED ) == seq)
+        __atomic_store_n( &ptid_cache[idx], ((ULONG64)flags << 32) | id, __ATOMIC_RELAXED );
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+}
+
+/* caller must hold fd_cache_mutex */
+void ptid_remove_from_cache( HANDLE handle )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+
+    if (ptid_cache && idx < PTID_CACHE_SIZE)
+    {
+        __atomic_store_n( &ptid_cache[idx], 0, __ATOMIC_RELAXED );
+        __atomic_store_n( &ptid_cache_seq[idx], ptid_cache_seq[idx] + 1, __ATOMIC_RELEASE );
+    }
+}
+
+/* read the shared information of a thread or process handle; flags are the
+ * PTID_CACHE_* flags the handle must have been cached with */
+BOOL get_shared_ptid_info( HANDLE handle, unsigned int flags, struct ptid_shared_memory *info )
+{
+    const ptid_shm_t *shared;
+    unsigned int id, index, seq;
+
+    if (handle == GetCurrentThread() && (flags & PTID_CACHE_THREAD))
+        id = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    else if (handle == GetCurrentProcess() && (flags & PTID_CACHE_PROCESS))
+        id = HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess );
+    else
+    {
+        unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+        ULONG64 entry;
+
+        if (idx >= PTID_CACHE_SIZE || !ptid_cache) return FALSE;
+        entry = __atomic_load_n( &ptid_cache[idx], __ATOMIC_RELAXED );
+        if (((entry >> 32) & flags) != flags) return FALSE;
+        id = (ULONG)entry;
+    }
+
+    pthread_once( &ptid_shm_once, ptid_shm_init );
+    if (!ptid_shm || (index = PTID_SHM_INDEX( id )) >= PTID_SHM_COUNT) return FALSE;
+    shared = &ptid_shm[index];
+
+    do
+    {
+        while ((seq = __atomic_load_n( &shared->seq, __ATOMIC_ACQUIRE )) & 1) YieldProcessor();
+        *info = *(const struct ptid_shared_memory *)shared;
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    } while (__atomic_load_n( &shared->seq, __ATOMIC_RELAXED ) != seq);
+
+    /* the entry is cleared when the object is destroyed, which can't happen
+     * while we hold a handle to it */
+    return info->id == id;
+}
+
+/* retrieve the information returned by get_thread_info, from shared memory if possible */
+static unsigned int query_thread_info( HANDLE handle, unsigned int access, struct ptid_shared_memory *info )
+{
+    unsigned int flags = PTID_CACHE_THREAD, status, seq;
+
+    if (access == THREAD_QUERY_INFORMATION) flags |= PTID_CACHE_QUERY_INFORMATION;
+    if (get_shared_ptid_info( handle, flags, info )) return STATUS_SUCCESS;
+
+    seq = get_ptid_cache_seq( handle );
+    memset( info, 0, sizeof(*info) );
+    SERVER_START_REQ( get_thread_info )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        req->access = access;
+        if (!(status = wine_server_call( req )))
+        {
+            info->id            = reply->tid;
+            info->base          = reply->teb;
+            info->affinity      = reply->affinity;
+            info->pid           = reply->pid;
+            info->exit_code     = reply->exit_code;
+            info->priority      = reply->priority;
+            info->flags         = reply->flags;
+            info->suspend_count = reply->suspend_count;
+        }
+    }
+    SERVER_END_REQ;
+    if (!status) cache_ptid_handle( handle, info->id, flags, seq );
+    return status;
+}
+
 static void set_native_thread_name( HANDLE handle, const UNICODE_STRING *name )
 {
 #ifdef linux
@@ -2049,24 +2211,17 @@ NTSTATUS WINAPI NtQueryInformationThread( HANDLE handle, THREADINFOCLASS class,
     {
         THREAD_BASIC_INFORMATION info;
         const ULONG_PTR affinity_mask = get_system_affinity_mask();
+        struct ptid_shared_memory shared;
 
-        SERVER_START_REQ( get_thread_info )
-        {
-            req->handle = wine_server_obj_handle( handle );
-            if (!(status = wine_server_call( req )))
-            {
-                info.ExitStatus             = reply->exit_code;
-                info.TebBaseAddress         = wine_server_get_ptr( reply->teb );
-                info.ClientId.UniqueProcess = ULongToHandle(reply->pid);
-                info.ClientId.UniqueThread  = ULongToHandle(reply->tid);
-                info.AffinityMask           = reply->affinity & affinity_mask;
-                info.Priority               = reply->priority;
-                info.BasePriority           = reply->priority;  /* FIXME */
-            }
-        }
-        SERVER_END_REQ;
-        if (status == STATUS_SUCCESS)
+        if (!(status = query_thread_info( handle, 0, &shared )))
         {
+            info.ExitStatus             = shared.exit_code;
+            info.TebBaseAddress         = wine_server_get_ptr( shared.base );
+            info.ClientId.UniqueProcess = ULongToHandle(shared.pid);
+            info.ClientId.UniqueThread  = ULongToHandle(shared.id);
+            info.AffinityMask           = shared.affinity & affinity_mask;
+            info.Priority               = shared.priority;
+            info.BasePriority           = shared.priority;  /* FIXME */
             if (is_old_wow64())
             {
                 if (is_process_wow64( &info.ClientId ))
@@ -2083,17 +2238,12 @@ NTSTATUS WINAPI NtQueryInformationThread( HANDLE handle, THREADINFOCLASS class,
     case ThreadAffinityMask:
     {
         const ULONG_PTR affinity_mask = get_system_affinity_mask();
+        struct ptid_shared_memory shared;
         ULONG_PTR affinity = 0;
 
-        SERVER_START_REQ( get_thread_info )
-        {
-            req->handle = wine_server_obj_handle( handle );
-            req->access = THREAD_QUERY_INFORMATION;
-            if (!(status = wine_server_call( req ))) affinity = reply->affinity & affinity_mask;
-        }
-        SERVER_END_REQ;
-        if (status == STATUS_SUCCESS)
+        if (!(status = query_thread_info( handle, THREAD_QUERY_INFORMATION, &shared )))
         {
+            affinity = shared.affinity & affinity_mask;
             if (data) memcpy( data, &affinity, min( length, sizeof(affinity) ));
             if (ret_len) *ret_len = min( length, sizeof(affinity) );
         }
@@ -2103,21 +2253,33 @@ NTSTATUS WINAPI NtQueryInformationThread( HANDLE handle, THREADINFOCLASS class,
     case ThreadTimes:
     {
         KERNEL_USER_TIMES kusrt;
+        struct ptid_shared_memory shared;
         int unix_pid, unix_tid;
 
-        SERVER_START_REQ( get_thread_times )
+        if (get_shared_ptid_info( handle, PTID_CACHE_THREAD, &shared ))
         {
-            req->handle = wine_server_obj_handle( handle );
-            status = wine_server_call( req );
-            if (status == STATUS_SUCCESS)
+            kusrt.CreateTime.QuadPart = shared.start_time;
+            kusrt.ExitTime.QuadPart = shared.end_time;
+            unix_pid = shared.unix_pid;
+            unix_tid = shared.unix_tid;
+            status = STATUS_SUCCESS;
+        }
+        else
+        {
+            SERVER_START_REQ( get_thread_times )
             {
-                kusrt.CreateTime.QuadPart = reply->creation_time;
-                kusrt.ExitTime.QuadPart = reply->exit_time;
-                unix_pid = reply->unix_pid;
-                unix_tid = reply->unix_tid;
+                req->handle = wine_server_obj_handle( handle );
+                status = wine_server_call( req );
+                if (status == STATUS_SUCCESS)
+                {
+                    kusrt.CreateTime.QuadPart = reply->creation_time;
+                    kusrt.ExitTime.QuadPart = reply->exit_time;
+                    unix_pid = reply->unix_pid;
+                    unix_tid = reply->unix_tid;
+                }
             }
+            SERVER_END_REQ;
         }
-        SERVER_END_REQ;
         if (status == STATUS_SUCCESS)
         {
             BOOL ret = FALSE;
@@ -2183,19 +2345,15 @@ NTSTATUS WINAPI NtQueryInformationThread( HANDLE handle, THREADINFOCLASS class,
     case ThreadGroupInformation:
     {
         const ULONG_PTR affinity_mask = get_system_affinity_mask();
+        struct ptid_shared_memory shared;
         GROUP_AFFINITY affinity;
 
         memset( &affinity, 0, sizeof(affinity) );
         affinity.Group = 0; /* Wine only supports max 64 processors */
 
-        SERVER_START_REQ( get_thread_info )
-        {
-            req->handle = wine_server_obj_handle( handle );
-            if (!(status = wine_server_call( req ))) affinity.Mask = reply->affinity & affinity_mask;
-        }
-        SERVER_END_REQ;
-        if (status == STATUS_SUCCESS)
+        if (!(status = query_thread_info( handle, 0, &shared )))
         {
+            affinity.Mask = shared.affinity & affinity_mask;
             if (data) memcpy( data, &affinity, min( length, sizeof(affinity) ));
             if (ret_len) *ret_len = min( length, sizeof(affinity) );
         }
@@ -2212,34 +2370,27 @@ NTSTATUS WINAPI NtQueryInformationThread( HANDLE handle, THREADINFOCLASS class,
 
     case ThreadIsTerminated:
     {
-        ULONG terminated;
+        struct ptid_shared_memory shared;
 
         if (length != sizeof(ULONG)) return STATUS_INFO_LENGTH_MISMATCH;
-        SERVER_START_REQ( get_thread_info )
+        if (!(status = query_thread_info( handle, 0, &shared )))
         {
-            req->handle = wine_server_obj_handle( handle );
-            if (!(status = wine_server_call( req ))) terminated = !!(reply->flags & GET_THREAD_INFO_FLAG_TERMINATED);
-        }
-        SERVER_END_REQ;
-        if (!status)
-        {
-            *(ULONG *)data = terminated;
+            *(ULONG *)data = !!(shared.flags & GET_THREAD_INFO_FLAG_TERMINATED);
             if (ret_len) *ret_len = sizeof(ULONG);
         }
         return status;
     }
 
     case ThreadSuspendCount:
+    {
+        struct ptid_shared_memory shared;
+
         if (length != sizeof(ULONG)) return STATUS_INFO_LENGTH_MISMATCH;
         if (!data) return STATUS_ACCESS_VIOLATION;
 
-        SERVER_START_REQ( get_thread_info )
-        {
-            req->handle = wine_server_obj_handle( handle );
-            if (!(status = wine_server_call( req ))) *(ULONG *)data = reply->suspend_count;
-        }
-        SERVER_END_REQ;
+        if (!(status = query_thread_info( handle, 0, &shared ))) *(ULONG *)data = shared.suspend_count;
         return status;
+    }
 
     case ThreadNameInformation:
     {
@@ -209,6 +209,7 @@ extern NTSTATUS load_main_exe( const WCHAR *name, const char *unix_name, const W
 extern NTSTATUS load_start_exe( WCHAR **image, void **module );
 extern void start_server( BOOL debug );
 
+extern pthread_mutex_t fd_cache_mutex;
 extern unsigned int server_call_unlocked( void *req_ptr );
 extern void server_enter_uninterrupted_section( pthread_mutex_t *mutex, sigset_t *sigset );
 extern void server_leave_uninterrupted_section( pthread_mutex_t *mutex, sigset_t *sigset );
@@ -221,6 +222,7 @@ extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *
                                               apc_result_t *result );
 extern int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options );
+extern unsigned int server_reopen_unix_fd( HANDLE handle, int *unix_fd, int *needs_close, BOOL *reopened );
 extern void wine_server_send_fd( int fd );
 extern void process_exit_wrapper( int status ) DECLSPEC_NORETURN;
 extern size_t server_init_process(void);
@@ -316,6 +318,15 @@ extern void *get_native_context( CONTEXT *context );
 extern void *get_wow_context( CONTEXT *context );
 extern BOOL get_thread_times( int unix_pid, int unix_tid, LARGE_INTEGER *kernel_time,
                               LARGE_INTEGER *user_time );
+
+#define PTID_CACHE_THREAD             0x01  /* handle refers to a thread */
+#define PTID_CACHE_QUERY_INFORMATION  0x02  /* handle has THREAD_QUERY_INFORMATION access */
+#define PTID_CACHE_PROCESS            0x04  /* handle refers to a process */
+
+extern unsigned int get_ptid_cache_seq( HANDLE handle );
+extern void cache_ptid_handle( HANDLE handle, unsigned int id, unsigned int flags, unsigned int seq );
+extern void ptid_remove_from_cache( HANDLE handle );
+extern BOOL get_shared_ptid_info( HANDLE handle, unsigned int flags, struct ptid_shared_memory *info );
 extern void signal_init_threading(void);
 extern NTSTATUS signal_alloc_thread( TEB *teb );
 extern void set_thread_teb( TEB *teb );
@@ -342,6 +353,7 @@ extern NTSTATUS serial_DeviceIoControl( HANDLE device, HANDLE event, PIO_APC_ROU
 extern NTSTATUS serial_FlushBuffersFile( int fd );
 extern NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
                             UINT code, void *in_buffer, UINT in_size, void *out_buffer, UINT out_size );
+extern void sock_remove_from_cache( HANDLE handle );
 extern NTSTATUS sock_read( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
                            IO_STATUS_BLOCK *io, void *buffer, ULONG length );
 extern NTSTATUS sock_write( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
@@ -41,6 +41,8 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(storage);
 
+#define MAX_MAPPED_SIZE_32 (256 * 1024 * 1024)
+
 typedef struct FileLockBytesImpl
 {
     ILockBytes ILockBytes_iface;
@@ -48,6 +50,11 @@ typedef struct FileLockBytesImpl
     HANDLE hfile;
     DWORD flProtect;
     LPWSTR pwcsName;
+    BOOL can_map;       /* the file can't change while we have it open */
+    BOOL map_failed;
+    HANDLE mapping;
+    const BYTE *view;
+    ULONGLONG view_size;
 } FileLockBytesImpl;
 
 static const ILockBytesVtbl FileLockBytesImpl_Vtbl;
@@ -100,6 +107,13 @@ HRESULT FileLockBytesImpl_Construct(HANDLE hFile, DWORD openFlags, LPCWSTR pwcsN
   This->ref = 1;
   This->hfile = hFile;
   This->flProtect = GetProtectMode(openFlags);
+  This->can_map = This->flProtect == PAGE_READONLY &&
+                  (STGM_SHARE_MODE(openFlags) == STGM_SHARE_DENY_WRITE ||
+                   STGM_SHARE_MODE(openFlags) == STGM_SHARE_EXCLUSIVE);
+  This->map_failed = FALSE;
+  This->mapping = NULL;
+  This->view = NULL;
+  This->view_size = 0;
 
   if(pwcsName) {
     if (!GetFullPathNameW(pwcsName, MAX_PATH, fullpath, NULL))
@@ -156,6 +170,8 @@ static ULONG WINAPI FileLockBytesImpl_Release(ILockBytes *iface)
 
     if (ref == 0)
     {
+        if (This->view) UnmapViewOfFile(This->view);
+        if (This->mapping) CloseHandle(This->mapping);
         CloseHandle(This->hfile);
         HeapFree(GetProcessHeap(), 0, This->pwcsName);
         HeapFree(GetProcessHeap(), 0, This);
@@ -164,6 +180,48 @@ static ULONG WINAPI FileLockBytesImpl_Release(ILockBytes *iface)
     return ref;
 }
 
+/******************************************************************************
+ *      FileLockBytesImpl_MapFile
+ *
+ * Maps a file that is only read and that nobody can write to, so that reads
+ * are plain copies. Returns FALSE if the file has to be read instead.
+ */
+static BOOL FileLockBytesImpl_MapFile(FileLockBytesImpl *This)
+{
+    LARGE_INTEGER size;
+
+    if (This->view) return TRUE;
+    if (!This->can_map || This->map_failed) return FALSE;
+
+    /* Don't try again if anything fails. */
+    This->map_failed = TRUE;
+
+    if (!GetFileSizeEx(This->hfile, &size) || !size.QuadPart)
+        return FALSE;
+
+    /* Leave some address space to the application. */
+    if (sizeof(void *) == 4 && size.QuadPart > MAX_MAPPED_SIZE_32)
+        return FALSE;
+
+    if (!(This->mapping = CreateFileMappingW(This->hfile, NULL, PAGE_READONLY, 0, 0, NULL)))
+    {
+        WARN("failed to create mapping, error %lu\n", GetLastError());
+        return FALSE;
+    }
+
+    if (!(This->view = MapViewOfFile(This->mapping, FILE_MAP_READ, 0, 0, 0)))
+    {
+        WARN("failed to map file, error %lu\n", GetLastError());
+        CloseHandle(This->mapping);
+        This->mapping = NULL;
+        return FALSE;
+    }
+
+    This->view_size = size.QuadPart;
+    This->map_failed = FALSE;
+    return TRUE;
+}
+
 /******************************************************************************
  * This method is part of the ILockBytes interface.
  *
@@ -194,6 +252,19 @@ static HRESULT WINAPI FileLockBytesImpl_ReadAt(
     if (pcbRead)
         *pcbRead = 0;
 
+    if (FileLockBytesImpl_MapFile(This))
+    {
+        if (ulOffset.QuadPart >= This->view_size)
+            return cb ? STG_E_READFAULT : S_OK;
+
+        cbRead = min(cb, This->view_size - ulOffset.QuadPart);
+        memcpy(pv, This->view + ulOffset.QuadPart, cbRead);
+        if (pcbRead)
+            *pcbRead = cbRead;
+
+        return cbRead == cb ? S_OK : STG_E_READFAULT;
+    }
+
     offset.QuadPart = ulOffset.QuadPart;
 
     ret = SetFilePointerEx(This->hfile, offset, NULL, FILE_BEGIN);
@@ -2851,6 +2851,157 @@ static HRESULT StorageBaseImpl_DeleteStorageTree(StorageBaseImpl *This, DirRef e
 }
 
 
+/************************************************************************
+ * StorageImpl implementation : Sector cache
+ *
+ * Recently read sectors are kept in an LRU cache shared by all the streams
+ * of a file. Writes update the cached copies, so the cache stays valid as
+ * long as nobody else writes to the file.
+ ***********************************************************************/
+
+#define SECTOR_CACHE_BYTES   (1024 * 1024)
+#define SECTOR_CACHE_BUCKETS 256
+
+typedef struct CachedSector
+{
+  struct list entry;        /* in the LRU list, most recently used first */
+  struct list bucketEntry;
+  ULONG sector;
+  BYTE data[1];
+} CachedSector;
+
+struct SectorCache
+{
+  struct list lru;
+  struct list buckets[SECTOR_CACHE_BUCKETS];
+  ULONG count;
+};
+
+static struct SectorCache *SectorCache_Construct(void)
+{
+  struct SectorCache *cache;
+  int i;
+
+  cache = HeapAlloc(GetProcessHeap(), 0, sizeof(*cache));
+  if (!cache)
+    return NULL;
+
+  list_init(&cache->lru);
+  for (i = 0; i < SECTOR_CACHE_BUCKETS; i++)
+    list_init(&cache->buckets[i]);
+  cache->count = 0;
+
+  return cache;
+}
+
+static void SectorCache_Discard(struct SectorCache *cache)
+{
+  CachedSector *sector, *next;
+  int i;
+
+  if (!cache)
+    return;
+
+  LIST_FOR_EACH_ENTRY_SAFE(sector, next, &cache->lru, CachedSector, entry)
+    HeapFree(GetProcessHeap(), 0, sector);
+
+  list_init(&cache->lru);
+  for (i = 0; i < SECTOR_CACHE_BUCKETS; i++)
+    list_init(&cache->buckets[i]);
+  cache->count = 0;
+}
+
+static void SectorCache_Destroy(struct SectorCache *cache)
+{
+  SectorCache_Discard(cache);
+  HeapFree(GetProcessHeap(), 0, cache);
+}
+
+static CachedSector *SectorCache_Find(struct SectorCache *cache, ULONG index)
+{
+  CachedSector *sector;
+
+  LIST_FOR_EACH_ENTRY(sector, &cache->buckets[index % SECTOR_CACHE_BUCKETS], CachedSector, bucketEntry)
+    if (sector->sector == index)
+      return sector;
+
+  return NULL;
+}
+
+/* Returns the cached copy of a sector, reading it first if needed. */
+static CachedSector *StorageImpl_GetCachedSector(StorageImpl *This, ULONG index)
+{
+  struct SectorCache *cache = This->sectorCache;
+  CachedSector *sector;
+  ULARGE_INTEGER offset;
+  ULONG read;
+  HRESULT hr;
+
+  if ((sector = SectorCache_Find(cache, index)))
+  {
+    list_remove(&sector->entry);
+    list_add_head(&cache->lru, &sector->entry);
+    return sector;
+  }
+
+  if (cache->count < SECTOR_CACHE_BYTES / This->bigBlockSize)
+  {
+    sector = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(CachedSector, data[This->bigBlockSize]));
+    if (!sector)
+      return NULL;
+    cache->count++;
+  }
+  else
+  {
+    sector = LIST_ENTRY(list_tail(&cache->lru), CachedSector, entry);
+    list_remove(&sector->entry);
+    list_remove(&sector->bucketEntry);
+  }
+
+  offset.QuadPart = (ULONGLONG)(index+1) * This->bigBlockSize;
+  hr = ILockBytes_ReadAt(This->lockBytes, offset, sector->data, This->bigBlockSize, &read);
+
+  /* Only complete sectors are cached. */
+  if (FAILED(hr) || read != This->bigBlockSize)
+  {
+    HeapFree(GetProcessHeap(), 0, sector);
+    cache->count--;
+    return NULL;
+  }
+
+  sector->sector = index;
+  list_add_head(&cache->lru, &sector->entry);
+  list_add_head(&cache->buckets[index % SECTOR_CACHE_BUCKETS], &sector->bucketEntry);
+
+  return sector;
+}
+
+/* Copies written data to the cached sectors it overlaps. */
+static void StorageImpl_UpdateCachedSectors(StorageImpl *This, ULONGLONG offset,
+  const BYTE *buffer, ULONG size)
+{
+  ULONGLONG end = offset + size;
+  ULONGLONG sectorStart;
+  CachedSector *sector;
+
+  if (!This->sectorCache || !This->sectorCache->count)
+    return;
+
+  for (sectorStart = offset - offset % This->bigBlockSize; sectorStart < end;
+       sectorStart += This->bigBlockSize)
+  {
+    ULONGLONG from = max(sectorStart, offset);
+    ULONGLONG to = min(sectorStart + This->bigBlockSize, end);
+
+    /* The header isn't cached. */
+    if (!sectorStart)
+      continue;
+
+    if ((sector = SectorCache_Find(This->sectorCache, sectorStart / This->bigBlockSize - 1)))
+      memcpy(sector->data + (from - sectorStart), buffer + (from - offset), to - from);
+  }
+}
+
 /************************************************************************
  * StorageImpl implementation
  ***********************************************************************/
@@ -2870,7 +3021,17 @@ static HRESULT StorageImpl_WriteAt(StorageImpl* This,
   const ULONG    size,
   ULONG*         bytesWritten)
 {
-    return ILockBytes_WriteAt(This->lockBytes,offset,buffer,size,bytesWritten);
+    HRESULT hr;
+
+    hr = ILockBytes_WriteAt(This->lockBytes,offset,buffer,size,bytesWritten);
+
+    /* We don't know what was written on failure. */
+    if (SUCCEEDED(hr) && *bytesWritten == size)
+      StorageImpl_UpdateCachedSectors(This, offset.QuadPart, buffer, size);
+    else
+      SectorCache_Discard(This->sectorCache);
+
+    return hr;
 }
 
 /******************************************************************************
@@ -3515,6 +3676,14 @@ static HRESULT StorageImpl_ReadBigBlock(
   ULARGE_INTEGER ulOffset;
   DWORD  read=0;
   HRESULT hr;
+  CachedSector *sector;
+
+  if (This->sectorCache && (sector = StorageImpl_GetCachedSector(This, blockIndex)))
+  {
+    memcpy(buffer, sector->data, This->bigBlockSize);
+    if (out_read) *out_read = This->bigBlockSize;
+    return S_OK;
+  }
 
   ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This, blockIndex);
 
@@ -3540,6 +3709,13 @@ static BOOL StorageImpl_ReadDWordFromBigBlock(
   ULARGE_INTEGER ulOffset;
   DWORD  read;
   DWORD  tmp;
+  CachedSector *sector;
+
+  if (This->sectorCache && (sector = StorageImpl_GetCachedSector(This, blockIndex)))
+  {
+    StorageUtl_ReadDWord(sector->data, offset, value);
+    return TRUE;
+  }
 
   ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This, blockIndex);
   ulOffset.QuadPart += offset;
@@ -3549,6 +3725,30 @@ static BOOL StorageImpl_ReadDWordFromBigBlock(
   return (read == sizeof(DWORD));
 }
 
+/* Reads part of a big block, through the sector cache when there is one. */
+static HRESULT StorageImpl_ReadFromBigBlock(
+  StorageImpl*  This,
+  ULONG         blockIndex,
+  ULONG         offset,
+  void*         buffer,
+  ULONG         size,
+  ULONG*        bytesRead)
+{
+  ULARGE_INTEGER ulOffset;
+  CachedSector *sector;
+
+  if (This->sectorCache && (sector = StorageImpl_GetCachedSector(This, blockIndex)))
+  {
+    memcpy(buffer, sector->data + offset, size);
+    *bytesRead = size;
+    return S_OK;
+  }
+
+  ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This, blockIndex) + offset;
+
+  return StorageImpl_ReadAt(This, ulOffset, buffer, size, bytesRead);
+}
+
 static BOOL StorageImpl_WriteBigBlock(
   StorageImpl*  This,
   ULONG         blockIndex,
@@ -3957,6 +4157,60 @@ static ULONG Storage32Impl_AddExtBlockDepot(StorageImpl* This)
   return index;
 }
 
+/******************************************************************************
+ *      StorageImpl_LoadBigBlockDepot
+ *
+ * Reads the big block depot blocks that aren't in memory yet, so that the
+ * chains can be followed without reading the file.
+ */
+static HRESULT StorageImpl_LoadBigBlockDepot(StorageImpl* This)
+{
+  ULONG blocksPerDepot = This->bigBlockSize / sizeof(ULONG);
+  BYTE depotBuffer[MAX_BIG_BLOCK_SIZE];
+  ULONG depotIndex, depotBlockIndexPos;
+  ULONG read, index;
+
+  if (This->bigBlockDepotCount > This->bigBlockDepotAllocated)
+  {
+    ULONG new_size = max(This->bigBlockDepotCount, This->bigBlockDepotAllocated * 2);
+    ULONG *new_depot;
+
+    if (new_size > ~0u / This->bigBlockSize)
+      return E_OUTOFMEMORY;
+
+    if (This->bigBlockDepot)
+      new_depot = HeapReAlloc(GetProcessHeap(), 0, This->bigBlockDepot, new_size * This->bigBlockSize);
+    else
+      new_depot = HeapAlloc(GetProcessHeap(), 0, new_size * This->bigBlockSize);
+    if (!new_depot)
+      return E_OUTOFMEMORY;
+
+    This->bigBlockDepot = new_depot;
+    This->bigBlockDepotAllocated = new_size;
+  }
+
+  for (depotIndex = This->bigBlockDepotLoaded; depotIndex < This->bigBlockDepotCount; depotIndex++)
+  {
+    if (depotIndex < COUNT_BBDEPOTINHEADER)
+      depotBlockIndexPos = This->bigBlockDepotStart[depotIndex];
+    else
+      depotBlockIndexPos = Storage32Impl_GetExtDepotBlock(This, depotIndex);
+
+    StorageImpl_ReadBigBlock(This, depotBlockIndexPos, depotBuffer, &read);
+
+    if (!read)
+      return STG_E_READFAULT;
+
+    for (index = 0; index < blocksPerDepot; index++)
+      StorageUtl_ReadDWord(depotBuffer, index*sizeof(ULONG),
+                           &This->bigBlockDepot[depotIndex * blocksPerDepot + index]);
+
+    This->bigBlockDepotLoaded = depotIndex + 1;
+  }
+
+  return S_OK;
+}
+
 /************************************************************************
  * StorageImpl_GetNextBlockInChain
  *
@@ -4002,6 +4256,13 @@ static HRESULT StorageImpl_GetNextBlockInChain(
     return STG_E_READFAULT;
   }
 
+  if (This->cacheEnabled &&
+      (depotBlockCount < This->bigBlockDepotLoaded || SUCCEEDED(StorageImpl_LoadBigBlockDepot(This))))
+  {
+    *nextBlockIndex = This->bigBlockDepot[blockIndex];
+    return S_OK;
+  }
+
   /*
    * Cache the currently accessed depot block.
    */
@@ -4121,6 +4382,8 @@ static void StorageImpl_SetNextBlockInChain(
   {
     This->blockDepotCached[depotBlockOffset/sizeof(ULONG)] = nextBlock;
   }
+  if (depotBlockCount < This->bigBlockDepotLoaded)
+    This->bigBlockDepot[blockIndex] = nextBlock;
 }
 
 /******************************************************************************
@@ -4589,6 +4852,13 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
   DirRef      currentEntryRef;
   BlockChainStream *blockChainStream;
 
+  /* Someone else may have changed the file, forget what we've read. */
+  SectorCache_Discard(This->sectorCache);
+  This->bigBlockDepotLoaded = 0;
+  HeapFree(GetProcessHeap(), 0, This->smallBlockDepot);
+  This->smallBlockDepot = NULL;
+  This->smallBlockDepotLen = 0;
+
   if (create)
   {
     ULARGE_INTEGER size;
@@ -5155,6 +5425,8 @@ static void StorageImpl_Destroy(StorageBaseImpl* iface)
   StorageImpl_Invalidate(iface);
 
   HeapFree(GetProcessHeap(), 0, This->extBigBlockDepotLocations);
+  HeapFree(GetProcessHeap(), 0, This->bigBlockDepot);
+  HeapFree(GetProcessHeap(), 0, This->smallBlockDepot);
 
   BlockChainStream_Destroy(This->smallBlockRootChain);
   BlockChainStream_Destroy(This->rootBlockChain);
@@ -5176,6 +5448,7 @@ static void StorageImpl_Destroy(StorageBaseImpl* iface)
 
   if (This->lockBytes)
     ILockBytes_Release(This->lockBytes);
+  SectorCache_Destroy(This->sectorCache);
   HeapFree(GetProcessHeap(), 0, This);
 }
 
@@ -5296,6 +5569,16 @@ static HRESULT StorageImpl_Construct(
     hr = StorageImpl_GrabLocks(This, openFlags);
   }
 
+  /*
+   * The depots and sectors can be kept in memory when nobody else can write
+   * to the file. Only files are worth caching, other ILockBytes are usually
+   * in memory already.
+   */
+  This->cacheEnabled = STGM_SHARE_MODE(openFlags) == STGM_SHARE_DENY_WRITE ||
+                       STGM_SHARE_MODE(openFlags) == STGM_SHARE_EXCLUSIVE;
+  if (This->cacheEnabled && hFile)
+    This->sectorCache = SectorCache_Construct();
+
   if (SUCCEEDED(hr))
     hr = StorageImpl_Refresh(This, TRUE, create);
 
@@ -7218,6 +7501,24 @@ static HRESULT BlockChainStream_GetBlockAtOffset(BlockChainStream *This,
   return S_OK;
 }
 
+/* Returns how many of the count blocks starting at index are in consecutive
+ * sectors, stopping at blocks held in the block cache. */
+static ULONG BlockChainStream_GetContiguousBlocks(BlockChainStream *This,
+    ULONG index, ULONG sector, ULONG count)
+{
+  ULONG i;
+
+  for (i = 1; i < count; i++)
+  {
+    if (This->cachedBlocks[0].index == index + i || This->cachedBlocks[1].index == index + i)
+      break;
+    if (BlockChainStream_GetSectorOfOffset(This, index + i) != sector + i)
+      break;
+  }
+
+  return i;
+}
+
 BlockChainStream* BlockChainStream_Construct(
   StorageImpl* parentStorage,
   ULONG*         headOfStreamPlaceHolder,
@@ -7613,17 +7914,33 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
     if (FAILED(hr))
       return hr;
 
-    if (!cachedBlock)
+    if (!cachedBlock && offsetInBlock)
     {
       /* Not in cache, and we're going to read past the end of the block. */
-      ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex) +
-                               offsetInBlock;
+      StorageImpl_ReadFromBigBlock(This->parentStorage,
+           blockIndex,
+           offsetInBlock,
+           bufferWalker,
+           bytesToReadInBuffer,
+           &bytesReadAt);
+    }
+    else if (!cachedBlock)
+    {
+      /* Whole blocks in consecutive sectors are read at once, the last
+       * block is left for the block cache. */
+      ULONG count = BlockChainStream_GetContiguousBlocks(This, blockNoInSequence, blockIndex,
+          (size - 1) / This->parentStorage->bigBlockSize);
+
+      bytesToReadInBuffer = count * This->parentStorage->bigBlockSize;
+      ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex);
 
       StorageImpl_ReadAt(This->parentStorage,
            ulOffset,
            bufferWalker,
            bytesToReadInBuffer,
            &bytesReadAt);
+
+      blockNoInSequence += count - 1;
     }
     else
     {
@@ -7793,25 +8110,71 @@ static ULONG SmallBlockChainStream_GetHeadOfChain(
 }
 
 /******************************************************************************
- *      SmallBlockChainStream_GetNextBlockInChain
+ *      StorageImpl_LoadSmallBlockDepot
  *
- * Returns the index of the next small block in this chain.
+ * Reads the whole small block depot in memory.
+ */
+static HRESULT StorageImpl_LoadSmallBlockDepot(StorageImpl* This)
+{
+  ULARGE_INTEGER offset, size;
+  ULONG *depot;
+  ULONG read, index;
+  HRESULT hr;
+
+  size = BlockChainStream_GetSize(This->smallBlockDepotChain);
+  if (size.HighPart)
+    return E_OUTOFMEMORY;
+
+  depot = HeapAlloc(GetProcessHeap(), 0, max(size.LowPart, sizeof(ULONG)));
+  if (!depot)
+    return E_OUTOFMEMORY;
+
+  offset.QuadPart = 0;
+  hr = BlockChainStream_ReadAt(This->smallBlockDepotChain, offset, size.LowPart, depot, &read);
+
+  if (SUCCEEDED(hr) && read != size.LowPart)
+    hr = STG_E_READFAULT;
+
+  if (FAILED(hr))
+  {
+    HeapFree(GetProcessHeap(), 0, depot);
+    return hr;
+  }
+
+  for (index = 0; index < read / sizeof(ULONG); index++)
+    StorageUtl_ReadDWord((BYTE *)depot, index*sizeof(ULONG), &depot[index]);
+
+  This->smallBlockDepot = depot;
+  This->smallBlockDepotLen = read / sizeof(ULONG);
+
+  return S_OK;
+}
+
+/******************************************************************************
+ *      StorageImpl_GetNextSmallBlock
  *
- * Return Values:
- *    - BLOCK_END_OF_CHAIN: end of this chain
- *    - BLOCK_UNUSED: small block 'blockIndex' is free
+ * Reads an entry of the small block depot, from memory when possible.
+ * Fails past the end of the depot.
  */
-static HRESULT SmallBlockChainStream_GetNextBlockInChain(
-  SmallBlockChainStream* This,
-  ULONG                  blockIndex,
-  ULONG*                 nextBlockInChain)
+static HRESULT StorageImpl_GetNextSmallBlock(
+  StorageImpl* This,
+  ULONG        blockIndex,
+  ULONG*       nextBlockInChain)
 {
   ULARGE_INTEGER offsetOfBlockInDepot;
   DWORD  buffer;
   ULONG  bytesRead;
   HRESULT res;
 
-  *nextBlockInChain = BLOCK_END_OF_CHAIN;
+  if (This->cacheEnabled &&
+      (This->smallBlockDepot || SUCCEEDED(StorageImpl_LoadSmallBlockDepot(This))))
+  {
+    if (blockIndex >= This->smallBlockDepotLen)
+      return STG_E_READFAULT;
+
+    *nextBlockInChain = This->smallBlockDepot[blockIndex];
+    return S_OK;
+  }
 
   offsetOfBlockInDepot.QuadPart  = (ULONGLONG)blockIndex * sizeof(ULONG);
 
@@ -7819,7 +8182,7 @@ static HRESULT SmallBlockChainStream_GetNextBlockInChain(
    * Read those bytes in the buffer from the small block file.
    */
   res = BlockChainStream_ReadAt(
-              This->parentStorage->smallBlockDepotChain,
+              This->smallBlockDepotChain,
               offsetOfBlockInDepot,
               sizeof(DWORD),
               &buffer,
@@ -7829,14 +8192,30 @@ static HRESULT SmallBlockChainStream_GetNextBlockInChain(
     res = STG_E_READFAULT;
 
   if (SUCCEEDED(res))
-  {
     StorageUtl_ReadDWord((BYTE *)&buffer, 0, nextBlockInChain);
-    return S_OK;
-  }
 
   return res;
 }
 
+/******************************************************************************
+ *      SmallBlockChainStream_GetNextBlockInChain
+ *
+ * Returns the index of the next small block in this chain.
+ *
+ * Return Values:
+ *    - BLOCK_END_OF_CHAIN: end of this chain
+ *    - BLOCK_UNUSED: small block 'blockIndex' is free
+ */
+static HRESULT SmallBlockChainStream_GetNextBlockInChain(
+  SmallBlockChainStream* This,
+  ULONG                  blockIndex,
+  ULONG*                 nextBlockInChain)
+{
+  *nextBlockInChain = BLOCK_END_OF_CHAIN;
+
+  return StorageImpl_GetNextSmallBlock(This->parentStorage, blockIndex, nextBlockInChain);
+}
+
 /******************************************************************************
  *       SmallBlockChainStream_SetNextBlockInChain
  *
@@ -7867,6 +8246,9 @@ static void SmallBlockChainStream_SetNextBlockInChain(
     sizeof(DWORD),
     &buffer,
     &bytesWritten);
+
+  if (blockIndex < This->parentStorage->smallBlockDepotLen)
+    This->parentStorage->smallBlockDepot[blockIndex] = nextBlock;
 }
 
 /******************************************************************************
@@ -7891,9 +8273,6 @@ static void SmallBlockChainStream_FreeBlock(
 static ULONG SmallBlockChainStream_GetNextFreeBlock(
   SmallBlockChainStream* This)
 {
-  ULARGE_INTEGER offsetOfBlockInDepot;
-  DWORD buffer;
-  ULONG bytesRead;
   ULONG blockIndex = This->parentStorage->firstFreeSmallBlock;
   ULONG nextBlockIndex = BLOCK_END_OF_CHAIN;
   HRESULT res = S_OK;
@@ -7902,29 +8281,18 @@ static ULONG SmallBlockChainStream_GetNextFreeBlock(
   ULONG blocksRequired;
   ULARGE_INTEGER old_size, size_required;
 
-  offsetOfBlockInDepot.HighPart = 0;
-
   /*
    * Scan the small block depot for a free block
    */
   while (nextBlockIndex != BLOCK_UNUSED)
   {
-    offsetOfBlockInDepot.QuadPart = (ULONGLONG)blockIndex * sizeof(ULONG);
-
-    res = BlockChainStream_ReadAt(
-                This->parentStorage->smallBlockDepotChain,
-                offsetOfBlockInDepot,
-                sizeof(DWORD),
-                &buffer,
-                &bytesRead);
+    res = StorageImpl_GetNextSmallBlock(This->parentStorage, blockIndex, &nextBlockIndex);
 
     /*
      * If we run out of space for the small block depot, enlarge it
      */
-    if (SUCCEEDED(res) && bytesRead == sizeof(DWORD))
+    if (SUCCEEDED(res))
     {
-      StorageUtl_ReadDWord((BYTE *)&buffer, 0, &nextBlockIndex);
-
       if (nextBlockIndex != BLOCK_UNUSED)
         blockIndex++;
     }
@@ -7948,6 +8316,30 @@ static ULONG SmallBlockChainStream_GetNextFreeBlock(
       BlockChainStream_WriteAt(This->parentStorage->smallBlockDepotChain,
         offset, This->parentStorage->bigBlockSize, smallBlockDepot, &bytesWritten);
 
+      /* Extend the in-memory copy of the depot as well. */
+      if (This->parentStorage->smallBlockDepot)
+      {
+        ULONG oldLen = This->parentStorage->smallBlockDepotLen;
+        ULONG newLen = oldLen + This->parentStorage->bigBlockSize / sizeof(ULONG);
+        ULONG *newDepot;
+
+        newDepot = HeapReAlloc(GetProcessHeap(), 0, This->parentStorage->smallBlockDepot,
+                               newLen * sizeof(ULONG));
+        if (newDepot)
+        {
+          memset(newDepot + oldLen, BLOCK_UNUSED, (newLen - oldLen) * sizeof(ULONG));
+          This->parentStorage->smallBlockDepot = newDepot;
+          This->parentStorage->smallBlockDepotLen = newLen;
+        }
+        else
+        {
+          /* Loaded again with the next lookup. */
+          HeapFree(GetProcessHeap(), 0, This->parentStorage->smallBlockDepot);
+          This->parentStorage->smallBlockDepot = NULL;
+          This->parentStorage->smallBlockDepotLen = 0;
+        }
+      }
+
       StorageImpl_SaveFileHeader(This->parentStorage);
     }
   }
@@ -411,6 +411,18 @@ struct StorageImpl
   BlockChainStream* blockChainCache[BLOCKCHAIN_CACHE_SIZE];
   UINT blockChainToEvict;
 
+  /*
+   * In-memory copies of the depots and a cache of recently read sectors, only
+   * used when nobody else can write to the file.
+   */
+  BOOL cacheEnabled;
+  ULONG *bigBlockDepot;
+  ULONG bigBlockDepotLoaded;     /* number of depot blocks in bigBlockDepot */
+  ULONG bigBlockDepotAllocated;
+  ULONG *smallBlockDepot;
+  ULONG smallBlockDepotLen;
+  struct SectorCache *sectorCache;
+
   ULONG locks_supported;
 
   ILockBytes* lockBytes;
@@ -3921,6 +3921,258 @@ static void test_custom_lockbytes(void)
     DeleteTestLockBytes(lockbytes);
 }
 
+static BYTE stream_pattern(ULONG offset, int stream)
+{
+    return offset * 7 + offset / 251 + stream;
+}
+
+static void fill_pattern(BYTE *buffer, ULONG offset, ULONG size, int stream)
+{
+    ULONG i;
+
+    for (i = 0; i < size; i++)
+        buffer[i] = stream_pattern(offset + i, stream);
+}
+
+static BOOL check_pattern(const BYTE *buffer, ULONG offset, ULONG size, int stream)
+{
+    ULONG i;
+
+    for (i = 0; i < size; i++)
+        if (buffer[i] != stream_pattern(offset + i, stream)) return FALSE;
+    return TRUE;
+}
+
+/* creates streams whose sectors are interleaved, and small streams */
+static void create_read_test_file(ULONG big_size, ULONG chunk, ULONG small_count, ULONG small_size)
+{
+    IStream *stm[2], *small;
+    IStorage *stg;
+    WCHAR name[16];
+    ULONG offset, i;
+    BYTE *buffer;
+    HRESULT r;
+
+    DeleteFileA(filenameA);
+
+    r = StgCreateDocfile(filename, STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE, 0, &stg);
+    ok(r == S_OK, "StgCreateDocfile failed %lx\n", r);
+    r = IStorage_CreateStream(stg, strmA_name, STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &stm[0]);
+    ok(r == S_OK, "IStorage->CreateStream failed %lx\n", r);
+    r = IStorage_CreateStream(stg, strmB_name, STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &stm[1]);
+    ok(r == S_OK, "IStorage->CreateStream failed %lx\n", r);
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, max(chunk, small_size));
+
+    for (offset = 0; offset < big_size; offset += chunk)
+    {
+        ULONG size = min(chunk, big_size - offset);
+
+        for (i = 0; i < 2; i++)
+        {
+            fill_pattern(buffer, offset, size, i);
+            r = IStream_Write(stm[i], buffer, size, NULL);
+            ok(r == S_OK, "IStream->Write failed %lx\n", r);
+        }
+    }
+    IStream_Release(stm[0]);
+    IStream_Release(stm[1]);
+
+    for (i = 0; i < small_count; i++)
+    {
+        swprintf(name, ARRAY_SIZE(name), L"small%lu", i);
+        r = IStorage_CreateStream(stg, name, STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &small);
+        ok(r == S_OK, "IStorage->CreateStream failed %lx\n", r);
+        fill_pattern(buffer, 0, small_size, i + 2);
+        r = IStream_Write(small, buffer, small_size, NULL);
+        ok(r == S_OK, "IStream->Write failed %lx\n", r);
+        IStream_Release(small);
+    }
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    IStorage_Release(stg);
+}
+
+static HRESULT read_stream_at(IStream *stm, ULONG offset, void *buffer, ULONG size, ULONG *read)
+{
+    LARGE_INTEGER pos;
+    HRESULT r;
+
+    pos.QuadPart = offset;
+    r = IStream_Seek(stm, pos, STREAM_SEEK_SET, NULL);
+    if (FAILED(r)) return r;
+    return IStream_Read(stm, buffer, size, read);
+}
+
+static void test_stream_reads(void)
+{
+    static const ULONG big_size = 200000, chunk = 3000, small_count = 20, small_size = 1000;
+    IStream *stm, *small;
+    IStorage *stg;
+    BYTE buffer[10000];
+    ULONG offset, read, i;
+    WCHAR name[16];
+    HRESULT r;
+
+    create_read_test_file(big_size, chunk, small_count, small_size);
+
+    /* read only, with nobody else writing */
+    r = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_DENY_WRITE, NULL, 0, &stg);
+    ok(r == S_OK, "StgOpenStorage failed %lx\n", r);
+    r = IStorage_OpenStream(stg, strmA_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stm);
+    ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+
+    for (offset = 0; offset < big_size; offset += read)
+    {
+        r = read_stream_at(stm, offset, buffer, sizeof(buffer), &read);
+        ok(r == S_OK, "IStream->Read failed %lx\n", r);
+        ok(read == min(sizeof(buffer), big_size - offset), "got %lu bytes at %lu\n", read, offset);
+        ok(check_pattern(buffer, offset, read, 0), "wrong data at %lu\n", offset);
+        if (!read) break;
+    }
+
+    for (i = 0; i < 200; i++)
+    {
+        offset = (i * 7919) % (big_size - 700);
+        r = read_stream_at(stm, offset, buffer, 700, &read);
+        ok(r == S_OK, "IStream->Read failed %lx\n", r);
+        ok(read == 700, "got %lu bytes at %lu\n", read, offset);
+        ok(check_pattern(buffer, offset, read, 0), "wrong data at %lu\n", offset);
+    }
+
+    r = read_stream_at(stm, big_size - 100, buffer, sizeof(buffer), &read);
+    ok(r == S_OK, "IStream->Read failed %lx\n", r);
+    ok(read == 100, "got %lu bytes\n", read);
+    ok(check_pattern(buffer, big_size - 100, read, 0), "wrong data\n");
+    IStream_Release(stm);
+
+    for (i = 0; i < small_count; i++)
+    {
+        swprintf(name, ARRAY_SIZE(name), L"small%lu", i);
+        r = IStorage_OpenStream(stg, name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &small);
+        ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+        r = read_stream_at(small, 100, buffer, sizeof(buffer), &read);
+        ok(r == S_OK, "IStream->Read failed %lx\n", r);
+        ok(read == small_size - 100, "got %lu bytes\n", read);
+        ok(check_pattern(buffer, 100, read, i + 2), "wrong data in stream %lu\n", i);
+        IStream_Release(small);
+    }
+    IStorage_Release(stg);
+
+    /* reads see the data written through the same storage */
+    r = StgOpenStorage(filename, NULL, STGM_READWRITE | STGM_SHARE_EXCLUSIVE, NULL, 0, &stg);
+    ok(r == S_OK, "StgOpenStorage failed %lx\n", r);
+    r = IStorage_OpenStream(stg, strmB_name, NULL, STGM_READWRITE | STGM_SHARE_EXCLUSIVE, 0, &stm);
+    ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+
+    r = read_stream_at(stm, 40000, buffer, sizeof(buffer), &read);
+    ok(r == S_OK, "IStream->Read failed %lx\n", r);
+    ok(check_pattern(buffer, 40000, read, 1), "wrong data\n");
+
+    memset(buffer, 'x', 5000);
+    r = IStream_Write(stm, buffer, 5000, NULL);
+    ok(r == S_OK, "IStream->Write failed %lx\n", r);
+
+    r = read_stream_at(stm, 49000, buffer, 7000, &read);
+    ok(r == S_OK, "IStream->Read failed %lx\n", r);
+    ok(read == 7000, "got %lu bytes\n", read);
+    ok(check_pattern(buffer, 49000, 1000, 1), "wrong data before the write\n");
+    for (i = 1000; i < 6000; i++) if (buffer[i] != 'x') break;
+    ok(i == 6000, "wrong data at %lu\n", 49000 + i);
+    ok(check_pattern(buffer + 6000, 55000, 1000, 1), "wrong data after the write\n");
+
+    r = IStorage_OpenStream(stg, L"small3", NULL, STGM_READWRITE | STGM_SHARE_EXCLUSIVE, 0, &small);
+    ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+    r = read_stream_at(small, 0, buffer, sizeof(buffer), &read);
+    ok(r == S_OK, "IStream->Read failed %lx\n", r);
+    ok(read == small_size, "got %lu bytes\n", read);
+    ok(check_pattern(buffer, 0, read, 5), "wrong data\n");
+    IStream_Release(small);
+
+    IStream_Release(stm);
+    IStorage_Release(stg);
+
+    r = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_DENY_WRITE, NULL, 0, &stg);
+    ok(r == S_OK, "StgOpenStorage failed %lx\n", r);
+    r = IStorage_OpenStream(stg, strmB_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stm);
+    ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+    r = read_stream_at(stm, 44000, buffer, sizeof(buffer), &read);
+    ok(r == S_OK, "IStream->Read failed %lx\n", r);
+    ok(check_pattern(buffer, 44000, 6000, 1), "wrong data before the write\n");
+    for (i = 6000; i < read; i++) if (buffer[i] != 'x') break;
+    ok(i == read, "wrong data at %lu\n", 44000 + i);
+    IStream_Release(stm);
+    IStorage_Release(stg);
+
+    DeleteFileA(filenameA);
+}
+
+static double elapsed_ms(LARGE_INTEGER start, LARGE_INTEGER freq)
+{
+    LARGE_INTEGER now;
+
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+static void benchmark_stream_reads(void)
+{
+    static const ULONG big_size = 16 * 1024 * 1024, chunk = 64 * 1024, small_count = 2000, small_size = 2000;
+    LARGE_INTEGER freq, start;
+    IStream *stm, *small;
+    IStorage *stg;
+    ULONG offset, read, i;
+    WCHAR name[16];
+    BYTE *buffer;
+    HRESULT r;
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, chunk);
+    QueryPerformanceFrequency(&freq);
+
+    QueryPerformanceCounter(&start);
+    create_read_test_file(big_size, chunk, small_count, small_size);
+    trace("created the file in %.1f ms\n", elapsed_ms(start, freq));
+
+    r = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_DENY_WRITE, NULL, 0, &stg);
+    ok(r == S_OK, "StgOpenStorage failed %lx\n", r);
+    r = IStorage_OpenStream(stg, strmA_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stm);
+    ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+
+    QueryPerformanceCounter(&start);
+    for (offset = 0; offset < big_size; offset += chunk)
+    {
+        r = read_stream_at(stm, offset, buffer, chunk, &read);
+        ok(r == S_OK && read == chunk, "IStream->Read failed %lx, read %lu\n", r, read);
+    }
+    trace("sequential reads of %lu bytes: %.1f ms\n", chunk, elapsed_ms(start, freq));
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 50000; i++)
+    {
+        offset = (i * 104729u) % (big_size - 512);
+        r = read_stream_at(stm, offset, buffer, 512, &read);
+        ok(r == S_OK && read == 512, "IStream->Read failed %lx, read %lu\n", r, read);
+    }
+    trace("50000 random reads of 512 bytes: %.1f ms\n", elapsed_ms(start, freq));
+    IStream_Release(stm);
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < small_count; i++)
+    {
+        swprintf(name, ARRAY_SIZE(name), L"small%lu", (i * 7919) % small_count);
+        r = IStorage_OpenStream(stg, name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &small);
+        ok(r == S_OK, "IStorage->OpenStream failed %lx\n", r);
+        r = read_stream_at(small, 0, buffer, small_size, &read);
+        ok(r == S_OK && read == small_size, "IStream->Read failed %lx, read %lu\n", r, read);
+        IStream_Release(small);
+    }
+    trace("%lu small stream reads: %.1f ms\n", small_count, elapsed_ms(start, freq));
+
+    IStorage_Release(stg);
+    HeapFree(GetProcessHeap(), 0, buffer);
+    DeleteFileA(filenameA);
+}
+
 START_TEST(storage32)
 {
     CHAR temp[MAX_PATH];
@@ -3970,4 +4222,6 @@ START_TEST(storage32)
     test_transacted_shared();
     test_overwrite();
     test_custom_lockbytes();
+    test_stream_reads();
+    if (winetest_interactive) benchmark_stream_reads();
 }
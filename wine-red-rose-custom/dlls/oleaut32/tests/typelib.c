@@ -7572,6 +7572,95 @@ static void test_FindName(void)
     ITypeLib_Release(tl);
 }
 
+static void test_GetIDsOfNames(void)
+{
+    OLECHAR *names[3];
+    MEMBERID ids[3], memid;
+    ITypeInfo *ti;
+    ITypeLib *tl;
+    FUNCDESC *fd;
+    HRESULT hr;
+    int i, j;
+
+    hr = LoadTypeLib(wszStdOle2, &tl);
+    ok(hr == S_OK, "got 0x%08lx\n", hr);
+
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &IID_IFont, &ti);
+    ok(hr == S_OK, "got 0x%08lx\n", hr);
+
+    /* Name is the first funcdesc, the propget should be found */
+    hr = ITypeInfo_GetFuncDesc(ti, 0, &fd);
+    ok(hr == S_OK, "got 0x%08lx\n", hr);
+    memid = fd->memid;
+    ITypeInfo_ReleaseFuncDesc(ti, fd);
+
+    /* repeated lookups go through the name cache */
+    for (i = 0; i < 2; i++)
+    {
+        static const WCHAR *name_variants[] = { L"Name", L"name", L"NAME", L"nAmE" };
+
+        for (j = 0; j < ARRAY_SIZE(name_variants); j++)
+        {
+            names[0] = (OLECHAR *)name_variants[j];
+            ids[0] = 0xdeadbeef;
+            hr = ITypeInfo_GetIDsOfNames(ti, names, 1, ids);
+            ok(hr == S_OK, "%s: got 0x%08lx\n", wine_dbgstr_w(names[0]), hr);
+            ok(ids[0] == memid, "%s: got %ld, expected %ld\n", wine_dbgstr_w(names[0]), ids[0], memid);
+        }
+
+        names[0] = (OLECHAR *)L"setratio";
+        names[1] = (OLECHAR *)L"CYHIMETRIC";
+        names[2] = (OLECHAR *)L"cyLogical";
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 3, ids);
+        ok(hr == S_OK, "got 0x%08lx\n", hr);
+        ok(ids[0] != MEMBERID_NIL, "got %ld\n", ids[0]);
+        ok(ids[1] == 1, "got %ld\n", ids[1]);
+        ok(ids[2] == 0, "got %ld\n", ids[2]);
+
+        names[1] = (OLECHAR *)L"bogus";
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 2, ids);
+        ok(hr == DISP_E_UNKNOWNNAME, "got 0x%08lx\n", hr);
+        ok(ids[0] != MEMBERID_NIL, "got %ld\n", ids[0]);
+        ok(ids[1] == MEMBERID_NIL, "got %ld\n", ids[1]);
+
+        /* inherited from IUnknown */
+        names[0] = (OLECHAR *)L"queryinterface";
+        ids[0] = 0xdeadbeef;
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 1, ids);
+        ok(hr == S_OK, "got 0x%08lx\n", hr);
+        ok(ids[0] != MEMBERID_NIL, "got %ld\n", ids[0]);
+
+        names[0] = (OLECHAR *)L"bogus";
+        ids[0] = 0xdeadbeef;
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 1, ids);
+        ok(hr == DISP_E_UNKNOWNNAME, "got 0x%08lx\n", hr);
+        ok(ids[0] == MEMBERID_NIL, "got %ld\n", ids[0]);
+    }
+    ITypeInfo_Release(ti);
+
+    /* properties of a dispinterface are vardescs */
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &IID_IFontDisp, &ti);
+    ok(hr == S_OK, "got 0x%08lx\n", hr);
+
+    for (i = 0; i < 2; i++)
+    {
+        names[0] = (OLECHAR *)L"bold";
+        ids[0] = 0xdeadbeef;
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 1, ids);
+        ok(hr == S_OK, "got 0x%08lx\n", hr);
+        ok(ids[0] == DISPID_FONT_BOLD, "got %ld\n", ids[0]);
+
+        names[0] = (OLECHAR *)L"Charset";
+        ids[0] = 0xdeadbeef;
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 1, ids);
+        ok(hr == S_OK, "got 0x%08lx\n", hr);
+        ok(ids[0] == DISPID_FONT_CHARSET, "got %ld\n", ids[0]);
+    }
+    ITypeInfo_Release(ti);
+
+    ITypeLib_Release(tl);
+}
+
 static void test_TypeInfo2_GetContainingTypeLib(void)
 {
     static const WCHAR test[] = {'t','e','s','t','.','t','l','b',0};
@@ -8595,6 +8684,7 @@ START_TEST(typelib)
     test_SetFuncAndParamNames();
     test_SetDocString();
     test_FindName();
+    test_GetIDsOfNames();
 
     if ((filename = create_test_typelib(2)))
     {
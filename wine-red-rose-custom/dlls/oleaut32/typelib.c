@@ -1114,8 +1114,15 @@ typedef struct tagITypeLibImpl
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
     struct list entry;
+    struct list guid_entry;     /* entry in the guid/version/lcid hash */
     WCHAR *path;
     INT index;
+
+    /* MSFT typelibs keep their image mapped so that member records can be parsed on demand */
+    IUnknown *file;
+    void *mapping;
+    DWORD mapping_length;
+    MSFT_SegDir segdir;
 } ITypeLibImpl;
 
 static const ITypeLib2Vtbl tlbvt;
@@ -1143,7 +1150,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1248,6 +1255,13 @@ typedef struct tagITypeInfoImpl
     /* Implemented Interfaces  */
     TLBImplType *impltypes;
 
+    /* offset of the member records in the mapping while they have not been parsed yet */
+    LONG members_pending;
+    int members_offset;
+
+    /* hash of member names used by GetIDsOfNames, built on first use */
+    struct tlb_name_cache *name_cache;
+
     struct list *pcustdata_list;
     struct list custdata_list;
 } ITypeInfoImpl;
@@ -1278,6 +1292,7 @@ static const ICreateTypeInfo2Vtbl CreateTypeInfo2Vtbl;
 
 static ITypeInfoImpl* ITypeInfoImpl_Constructor(void);
 static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This);
+static ITypeInfoImpl *TLB_load_members(ITypeInfoImpl *info);
 
 typedef struct tagTLBContext
 {
@@ -1741,6 +1756,138 @@ static inline TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *typeinfo, const
     return NULL;
 }
 
+/* GetIDsOfNames is called for every late bound call made through IDispatch, so
+ * member names are hashed once per typeinfo instead of being compared against
+ * every funcdesc and vardesc on each call. Only ASCII names are hashed, anything
+ * else falls back to lstrcmpiW on every member. */
+struct tlb_name_cache
+{
+    UINT mask;
+    struct
+    {
+        ULONG hash;
+        int member;     /* i + 1 for funcdescs[i], -(i + 1) for vardescs[i], 0 if unused */
+    } entries[1];
+};
+
+static struct tlb_name_cache no_name_cache;
+
+static BOOL TLB_hash_name(const OLECHAR *name, ULONG *hash)
+{
+    ULONG h = 0;
+
+    for (; *name; name++)
+    {
+        WCHAR c = *name;
+
+        if (c >= 0x80) return FALSE;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        h = h * 31 + c;
+    }
+
+    *hash = h;
+    return TRUE;
+}
+
+static inline const TLBString *TLB_get_member_name(ITypeInfoImpl *typeinfo, int member)
+{
+    if (member > 0) return typeinfo->funcdescs[member - 1].Name;
+    return typeinfo->vardescs[-member - 1].Name;
+}
+
+static int TLB_name_cache_find(ITypeInfoImpl *typeinfo, const struct tlb_name_cache *cache,
+                               const OLECHAR *name, ULONG hash)
+{
+    UINT i;
+
+    for (i = hash & cache->mask; cache->entries[i].member; i = (i + 1) & cache->mask)
+    {
+        if (cache->entries[i].hash == hash &&
+            !lstrcmpiW(TLB_get_bstr(TLB_get_member_name(typeinfo, cache->entries[i].member)), name))
+            return cache->entries[i].member;
+    }
+
+    return 0;
+}
+
+static BOOL TLB_name_cache_add(ITypeInfoImpl *typeinfo, struct tlb_name_cache *cache, int member)
+{
+    const OLECHAR *name = TLB_get_bstr(TLB_get_member_name(typeinfo, member));
+    ULONG hash;
+    UINT i;
+
+    if (!name) return TRUE;
+    if (!TLB_hash_name(name, &hash)) return FALSE;
+    /* the first member with a given name wins, as in a linear scan */
+    if (TLB_name_cache_find(typeinfo, cache, name, hash)) return TRUE;
+
+    for (i = hash & cache->mask; cache->entries[i].member; i = (i + 1) & cache->mask);
+    cache->entries[i].hash = hash;
+    cache->entries[i].member = member;
+    return TRUE;
+}
+
+static struct tlb_name_cache *TLB_get_name_cache(ITypeInfoImpl *typeinfo)
+{
+    UINT count = typeinfo->typeattr.cFuncs + typeinfo->typeattr.cVars, size = 8, i;
+    struct tlb_name_cache *cache;
+    BOOL hashed = TRUE;
+
+    if ((cache = typeinfo->name_cache)) return cache;
+
+    while (size < count * 2) size <<= 1;
+    if (!(cache = calloc(1, offsetof(struct tlb_name_cache, entries[size]))))
+        return &no_name_cache;
+    cache->mask = size - 1;
+
+    for (i = 0; hashed && i < typeinfo->typeattr.cFuncs; i++)
+        hashed = TLB_name_cache_add(typeinfo, cache, i + 1);
+    for (i = 0; hashed && i < typeinfo->typeattr.cVars; i++)
+        hashed = TLB_name_cache_add(typeinfo, cache, -(int)i - 1);
+
+    if (!hashed)
+    {
+        TRACE("not hashing non-ASCII member names of %p\n", typeinfo);
+        free(cache);
+        cache = &no_name_cache;
+    }
+
+    if (InterlockedCompareExchangePointer((void **)&typeinfo->name_cache, cache, NULL) &&
+        cache != &no_name_cache)
+        free(cache);
+    return typeinfo->name_cache;
+}
+
+static void TLB_free_name_cache(ITypeInfoImpl *typeinfo)
+{
+    if (typeinfo->name_cache != &no_name_cache) free(typeinfo->name_cache);
+    typeinfo->name_cache = NULL;
+}
+
+/* Finds the funcdesc or, failing that, the vardesc called name. */
+static void TLB_get_member_by_name(ITypeInfoImpl *typeinfo, const OLECHAR *name,
+                                   TLBFuncDesc **func, TLBVarDesc **var)
+{
+    struct tlb_name_cache *cache = TLB_get_name_cache(typeinfo);
+    ULONG hash;
+    int member;
+
+    *func = NULL;
+    *var = NULL;
+
+    if (cache != &no_name_cache && name && TLB_hash_name(name, &hash))
+    {
+        if ((member = TLB_name_cache_find(typeinfo, cache, name, hash)) > 0)
+            *func = &typeinfo->funcdescs[member - 1];
+        else if (member < 0)
+            *var = &typeinfo->vardescs[-member - 1];
+        return;
+    }
+
+    if (!(*func = TLB_get_funcdesc_by_name(typeinfo, name)))
+        *var = TLB_get_vardesc_by_name(typeinfo, name);
+}
+
 static inline TLBCustData *TLB_get_custdata_by_guid(const struct list *custdata_list, REFGUID guid)
 {
     TLBCustData *cust_data;
@@ -1757,7 +1904,7 @@ static inline ITypeInfoImpl *TLB_get_typeinfo_by_name(ITypeLibImpl *typelib, con
     for (i = 0; i < typelib->TypeInfoCount; ++i)
     {
         if (!lstrcmpiW(TLB_get_bstr(typelib->typeinfos[i]->Name), name))
-            return typelib->typeinfos[i];
+            return TLB_load_members(typelib->typeinfos[i]);
     }
 
     return NULL;
@@ -1769,7 +1916,7 @@ static inline ITypeInfoImpl *TLB_get_typeinfo_by_guid(ITypeLibImpl *typelib, REF
         ITypeInfoImpl *pTInfo = typelib->typeinfos[i];
 
         if (IsEqualIID(TLB_get_guid_null(pTInfo->guid), guid))
-            return pTInfo;
+            return TLB_load_members(pTInfo);
     }
 
     return NULL;
@@ -2657,6 +2804,52 @@ static void MSFT_DoImplTypes(TLBContext *pcx, ITypeInfoImpl *pTI, int count,
     }
 }
 
+static CRITICAL_SECTION members_section;
+static CRITICAL_SECTION_DEBUG members_section_debug =
+{
+    0, 0, &members_section,
+    { &members_section_debug.ProcessLocksList, &members_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": typeinfo members") }
+};
+static CRITICAL_SECTION members_section = { &members_section_debug, -1, 0, 0, 0, 0 };
+
+/* MSFT typeinfos only read their header when the typelib is loaded. The function
+ * and variable records are parsed from the still mapped image the first time the
+ * typeinfo is handed out or searched, most applications only touch a few of the
+ * typeinfos of large typelibs like stdole or the Office ones. */
+static ITypeInfoImpl *TLB_load_members(ITypeInfoImpl *info)
+{
+    ITypeLibImpl *lib = info->pTypeLib;
+    TLBContext cx;
+
+    if (!ReadAcquire(&info->members_pending)) return info;
+
+    EnterCriticalSection(&members_section);
+    if (info->members_pending)
+    {
+        TRACE_(typelib)("parsing members of %s\n", debugstr_w(TLB_get_bstr(info->Name)));
+
+        cx.oStart = 0;
+        cx.pos = 0;
+        cx.length = lib->mapping_length;
+        cx.mapping = lib->mapping;
+        cx.pTblDir = &lib->segdir;
+        cx.pLibInfo = lib;
+
+        if (info->typeattr.cFuncs > 0)
+            MSFT_DoFuncs(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                         info->members_offset, &info->funcdescs);
+        if (info->typeattr.cVars > 0)
+            MSFT_DoVars(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                        info->members_offset, &info->vardescs);
+
+        InterlockedExchange(&info->members_pending, FALSE);
+    }
+    LeaveCriticalSection(&members_section);
+
+    return info;
+}
+
 /* when a typelib is loaded in a different 32/64-bit mode, we need to resize pointers
  * and some structures, and fix the alignment */
 static void TLB_fix_typeinfo_ptr_size(ITypeInfoImpl *info)
@@ -2756,16 +2949,12 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->typeattr.cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		    ptiRet->typeattr.cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->typeattr.cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		   ptiRet->typeattr.cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are parsed by TLB_load_members() when first needed */
+    if(ptiRet->typeattr.cFuncs > 0 || ptiRet->typeattr.cVars > 0)
+    {
+        ptiRet->members_offset = tiBase.memoffset;
+        ptiRet->members_pending = TRUE;
+    }
     if(ptiRet->typeattr.cImplTypes >0 ) {
         switch(ptiRet->typeattr.typekind)
         {
@@ -2894,7 +3083,10 @@ static HRESULT MSFT_ReadAllRefs(TLBContext *pcx)
  * place. This will cause a deliberate memory leak, but generally losing RAM for cycles is an acceptable
  * tradeoff here.
  */
-static struct list tlb_cache = LIST_INIT(tlb_cache);
+#define TLB_CACHE_BUCKETS 64
+static struct list tlb_cache[TLB_CACHE_BUCKETS];      /* keyed by path and index */
+static struct list tlb_guid_cache[TLB_CACHE_BUCKETS]; /* keyed by guid, version and lcid */
+static BOOL tlb_cache_initialized;
 static CRITICAL_SECTION cache_section;
 static CRITICAL_SECTION_DEBUG cache_section_debug =
 {
@@ -2904,6 +3096,33 @@ static CRITICAL_SECTION_DEBUG cache_section_debug =
 };
 static CRITICAL_SECTION cache_section = { &cache_section_debug, -1, 0, 0, 0, 0 };
 
+/* must be called with cache_section held */
+static void tlb_cache_init(void)
+{
+    unsigned int i;
+
+    if (tlb_cache_initialized) return;
+    for (i = 0; i < TLB_CACHE_BUCKETS; i++)
+    {
+        list_init(&tlb_cache[i]);
+        list_init(&tlb_guid_cache[i]);
+    }
+    tlb_cache_initialized = TRUE;
+}
+
+static struct list *tlb_cache_bucket(const WCHAR *path, INT index)
+{
+    unsigned int hash = index;
+
+    for (; *path; path++) hash = hash * 31 + towlower(*path);
+    return &tlb_cache[hash % TLB_CACHE_BUCKETS];
+}
+
+static struct list *tlb_guid_cache_bucket(const GUID *guid, WORD major, WORD minor, LCID lcid)
+{
+    return &tlb_guid_cache[(guid->Data1 ^ MAKELONG(major, minor) ^ lcid) % TLB_CACHE_BUCKETS];
+}
+
 
 typedef struct TLB_PEFile
 {
@@ -3381,7 +3600,8 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 
     /* We look the path up in the typelib cache. If found, we just addref it, and return the pointer. */
     EnterCriticalSection(&cache_section);
-    LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
+    tlb_cache_init();
+    LIST_FOR_EACH_ENTRY(entry, tlb_cache_bucket(pszPath, index), ITypeLibImpl, entry)
     {
         if (!wcsicmp(entry->path, pszPath) && entry->index == index)
         {
@@ -3407,7 +3627,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3423,17 +3643,35 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 
     if(*ppTypeLib) {
 	ITypeLibImpl *impl = impl_from_ITypeLib2(*ppTypeLib);
+        struct list *bucket = tlb_cache_bucket(pszPath, index);
+
+        ret = S_OK;
+
+        /* another thread may have loaded the same typelib in the meantime */
+        EnterCriticalSection(&cache_section);
+        LIST_FOR_EACH_ENTRY(entry, bucket, ITypeLibImpl, entry)
+        {
+            if (!wcsicmp(entry->path, pszPath) && entry->index == index)
+            {
+                TRACE("lost race, using cached %p\n", entry);
+                ITypeLib2_AddRef(&entry->ITypeLib2_iface);
+                LeaveCriticalSection(&cache_section);
+                ITypeLib2_Release(*ppTypeLib);
+                *ppTypeLib = &entry->ITypeLib2_iface;
+                return ret;
+            }
+        }
 
 	TRACE("adding to cache\n");
 	impl->path = wcsdup(pszPath);
 	/* We should really canonicalise the path here. */
         impl->index = index;
 
-        /* FIXME: check if it has added already in the meantime */
-        EnterCriticalSection(&cache_section);
-        list_add_head(&tlb_cache, &impl->entry);
+        list_add_head(bucket, &impl->entry);
+        if (impl->guid)
+            list_add_head(tlb_guid_cache_bucket(&impl->guid->guid, impl->ver_major, impl->ver_minor,
+                                                impl->set_lcid), &impl->guid_entry);
         LeaveCriticalSection(&cache_section);
-        ret = S_OK;
     }
     else
     {
@@ -3477,7 +3715,7 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *
  * loading an MSFT typelib from an in-memory image
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file)
 {
     TLBContext cx;
     LONG lPSegDir;
@@ -3666,6 +3904,13 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 
     pTypeLibImpl->dispatch_href = tlbHeader.dispatchpos;
 
+    /* keep the image around for TLB_load_members() */
+    IUnknown_AddRef(file);
+    pTypeLibImpl->file = file;
+    pTypeLibImpl->mapping = pLib;
+    pTypeLibImpl->mapping_length = dwTLBLength;
+    pTypeLibImpl->segdir = tlbSegDir;
+
     /* type infos */
     if(tlbHeader.nrtypeinfos >= 0 )
     {
@@ -4867,6 +5112,8 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           TRACE("removing from cache list\n");
           if(This->entry.next)
               list_remove(&This->entry);
+          if(This->guid_entry.next)
+              list_remove(&This->guid_entry);
           free(This->path);
       }
       TRACE(" destroying ITypeLib(%p)\n",This);
@@ -4917,6 +5164,7 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
       }
       free(This->typeinfos);
+      if (This->file) IUnknown_Release(This->file);
       free(This);
     }
 
@@ -4954,7 +5202,7 @@ static HRESULT WINAPI ITypeLib2_fnGetTypeInfo(
     if(index >= This->TypeInfoCount)
         return TYPE_E_ELEMENTNOTFOUND;
 
-    *ppTInfo = (ITypeInfo *)&This->typeinfos[index]->ITypeInfo2_iface;
+    *ppTInfo = (ITypeInfo *)&TLB_load_members(This->typeinfos[index])->ITypeInfo2_iface;
     ITypeInfo_AddRef(*ppTInfo);
 
     return S_OK;
@@ -5170,7 +5418,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
 
     *pfName=TRUE;
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
-        ITypeInfoImpl *pTInfo = This->typeinfos[tic];
+        ITypeInfoImpl *pTInfo = TLB_load_members(This->typeinfos[tic]);
         TLBFuncDesc *pFDesc;
         TLBParDesc *pPDesc;
         TLBVarDesc *pVDesc;
@@ -5233,7 +5481,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
 
     // TODO: factor out common impl with fnIsName().
     for(tic = 0; count < *found && tic < This->TypeInfoCount; ++tic) {
-        ITypeInfoImpl *pTInfo = This->typeinfos[tic];
+        ITypeInfoImpl *pTInfo = TLB_load_members(This->typeinfos[tic]);
         TLBFuncDesc *pFDesc;
         TLBVarDesc *pVDesc;
 
@@ -5500,7 +5748,7 @@ static HRESULT WINAPI ITypeLibComp_fnBind(
     *ppTInfo = NULL;
 
     for(i = 0; i < This->TypeInfoCount; ++i){
-        ITypeInfoImpl *pTypeInfo = This->typeinfos[i];
+        ITypeInfoImpl *pTypeInfo = TLB_load_members(This->typeinfos[i]);
         TRACE("testing %s\n", debugstr_w(TLB_get_bstr(pTypeInfo->Name)));
 
         /* FIXME: check wFlags here? */
@@ -5748,6 +5996,11 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
+    TLB_free_name_cache(This);
+
+    if (This->members_pending)
+        This->typeattr.cFuncs = This->typeattr.cVars = 0;
+
     for (i = 0; i < This->typeattr.cFuncs; ++i)
     {
         typeinfo_release_funcdesc(&This->funcdescs[i]);
@@ -5792,7 +6045,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release(&This->pTypeLib->ITypeLib2_iface);
         if (not_attached_to_typelib)
+        {
+            TLB_free_name_cache(This);
             free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -6416,7 +6672,7 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (UINT i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    pFDesc = TLB_get_funcdesc_by_name(This, *rgszNames);
+    TLB_get_member_by_name(This, *rgszNames, &pFDesc, &pVDesc);
     if (pFDesc) {
         if (cNames) *pMemId = pFDesc->funcdesc.memid;
 
@@ -6436,7 +6692,6 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         return ret;
     }
 
-    pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
     if (pVDesc) {
         if (cNames) *pMemId = pVDesc->vardesc.memid;
         return ret;
@@ -8034,6 +8289,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
 
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
+        pTypeInfoImpl->name_cache = NULL;
         list_init(&pTypeInfoImpl->custdata_list);
 
         if (This->typeattr.typekind == TKIND_INTERFACE)
@@ -8063,7 +8319,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
             if (This->pTypeLib->typeinfos[i]->hreftype == (hRefType&(~0x3)))
             {
                 result = S_OK;
-                type_info = (ITypeInfo*)&This->pTypeLib->typeinfos[i]->ITypeInfo2_iface;
+                type_info = (ITypeInfo*)&TLB_load_members(This->pTypeLib->typeinfos[i])->ITypeInfo2_iface;
                 ITypeInfo_AddRef(type_info);
                 break;
             }
@@ -8100,7 +8356,10 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
                 ITypeLibImpl *entry;
 
                 EnterCriticalSection(&cache_section);
-                LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
+                tlb_cache_init();
+                LIST_FOR_EACH_ENTRY(entry, tlb_guid_cache_bucket(TLB_get_guid_null(ref_type->pImpTLInfo->guid),
+                        ref_type->pImpTLInfo->wVersionMajor, ref_type->pImpTLInfo->wVersionMinor,
+                        ref_type->pImpTLInfo->lcid), ITypeLibImpl, guid_entry)
                 {
                     if (entry->guid
                         && IsEqualIID(&entry->guid->guid, TLB_get_guid_null(ref_type->pImpTLInfo->guid))
@@ -10315,8 +10574,11 @@ static HRESULT WINAPI ICreateTypeLib2_fnSaveAllChanges(ICreateTypeLib2 *iface)
     TRACE("%p\n", This);
 
     for(i = 0; i < This->TypeInfoCount; ++i)
+    {
+        TLB_load_members(This->typeinfos[i]);
         if(This->typeinfos[i]->needs_layout)
             ICreateTypeInfo2_LayOut(&This->typeinfos[i]->ICreateTypeInfo2_iface);
+    }
 
     memset(&file, 0, sizeof(file));
 
@@ -10815,6 +11077,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, funcDesc);
 
+    TLB_free_name_cache(This);
+
     if (!funcDesc || funcDesc->oVft & 3)
         return E_INVALIDARG;
 
@@ -11048,6 +11312,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, varDesc);
 
+    TLB_free_name_cache(This);
+
     if (This->vardescs){
         UINT i;
 
@@ -11116,6 +11382,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         }
     }
 
+    TLB_free_name_cache(This);
     func_desc->Name = TLB_append_str(&This->pTypeLib->name_list, *names);
 
     for (i = 1; i < numNames; ++i) {
@@ -11139,6 +11406,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_free_name_cache(This);
     This->vardescs[index].Name = TLB_append_str(&This->pTypeLib->name_list, name);
     return S_OK;
 }
@@ -11414,6 +11682,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnDeleteFuncDesc(ICreateTypeInfo2 *iface,
     if (index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_free_name_cache(This);
     typeinfo_release_funcdesc(&This->funcdescs[index]);
 
     --This->typeattr.cFuncs;
@@ -6858,6 +6858,46 @@ static void WINAPI NdrBaseTypeBufferSize(
     }
 }
 
+/***********************************************************************
+ *           ndr_fixed_buffer_size [internal]
+ *
+ * Used by the stubless interpreter for base types and simple structures,
+ * whose wire representation is a copy of the memory one.
+ */
+void ndr_fixed_buffer_size(PMIDL_STUB_MESSAGE pStubMsg, ULONG size, unsigned int align)
+{
+    align_length(&pStubMsg->BufferLength, align);
+    safe_buffer_length_increment(pStubMsg, size);
+}
+
+/***********************************************************************
+ *           ndr_fixed_marshall [internal]
+ */
+void ndr_fixed_marshall(PMIDL_STUB_MESSAGE pStubMsg, const unsigned char *pMemory, ULONG size,
+                        unsigned int align)
+{
+    align_pointer_clear(&pStubMsg->Buffer, align);
+    safe_copy_to_buffer(pStubMsg, pMemory, size);
+}
+
+/***********************************************************************
+ *           ndr_fixed_unmarshall [internal]
+ *
+ * Same as NdrBaseTypeUnmarshall without fMustAlloc.
+ */
+void ndr_fixed_unmarshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char **ppMemory, ULONG size,
+                          unsigned int align)
+{
+    align_pointer(&pStubMsg->Buffer, align);
+    if (!pStubMsg->IsClient && !*ppMemory)
+    {
+        *ppMemory = pStubMsg->Buffer;
+        safe_buffer_increment(pStubMsg, size);
+    }
+    else
+        safe_copy_from_buffer(pStubMsg, *ppMemory, size);
+}
+
 /***********************************************************************
  *           NdrBaseTypeMemorySize [internal]
  */
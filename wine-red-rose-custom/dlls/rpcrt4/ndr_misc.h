@@ -64,4 +64,10 @@ extern const NDR_FREE       NdrFreer[];
 
 ULONG ComplexStructSize(PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat);
 
+void ndr_fixed_buffer_size(PMIDL_STUB_MESSAGE pStubMsg, ULONG size, unsigned int align);
+void ndr_fixed_marshall(PMIDL_STUB_MESSAGE pStubMsg, const unsigned char *pMemory, ULONG size,
+                        unsigned int align);
+void ndr_fixed_unmarshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char **ppMemory, ULONG size,
+                          unsigned int align);
+
 #endif  /* __WINE_NDR_MISC_H */
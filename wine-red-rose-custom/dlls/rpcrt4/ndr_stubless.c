@@ -541,6 +541,357 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
     }
 }
 
+/* Procedure plans
+ *
+ * The -Oicf parameter descriptions of a procedure are decoded once into a
+ * plan, which resolves the type format and the marshalling routines of every
+ * parameter and precomputes the sizes that don't depend on the arguments.
+ * Base types and simple structures are then sized and copied directly instead
+ * of going through the NdrBufferSizer / NdrMarshaller tables.
+ *
+ * Plans are keyed by the address of the parameter descriptions, the type
+ * format string and the offset of each parameter's type in it, and are never
+ * freed. The first bytes of each type are kept as well, so that a proxy dll
+ * replaced by another one at the same address doesn't match a stale plan. */
+
+#define NDR_SIZE_DYNAMIC (~0u)
+
+enum ndr_op_kind
+{
+    NDR_OP_GENERIC,
+    NDR_OP_BASETYPE,
+    NDR_OP_STRUCT,      /* FC_STRUCT, no embedded pointers */
+};
+
+struct ndr_param_op
+{
+    PARAM_ATTRIBUTES attr;
+    unsigned short stack_offset;
+    unsigned short type_offset;
+    unsigned char type_start[4]; /* first bytes of the type format, or the base type */
+    unsigned char kind;
+    BOOL deref;             /* the stack slot holds a pointer to the data */
+    BOOL float_arg;         /* float passed as a double through varargs */
+    unsigned int align;     /* wire alignment of fixed size ops */
+    ULONG size;             /* wire size of fixed size ops */
+    ULONG out_size;         /* size of [out] memory to clear or allocate */
+    PFORMAT_STRING format;
+    NDR_BUFFERSIZE sizer;
+    NDR_MARSHALL marshaller;
+    NDR_UNMARSHALL unmarshaller;
+    NDR_FREE freer;
+};
+
+struct ndr_proc_plan
+{
+    struct ndr_proc_plan *next;
+    PFORMAT_STRING params;
+    const MIDL_STUB_DESC *stub_desc;
+    const unsigned char *format_types;
+    unsigned int count;
+    struct ndr_param_op ops[1];
+};
+
+#define NDR_PLAN_BUCKETS 256
+static struct ndr_proc_plan *plan_cache[NDR_PLAN_BUCKETS];
+
+static CRITICAL_SECTION plan_cache_cs;
+static CRITICAL_SECTION_DEBUG plan_cache_cs_debug =
+{
+    0, 0, &plan_cache_cs,
+    { &plan_cache_cs_debug.ProcessLocksList, &plan_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": plan_cache_cs") }
+};
+static CRITICAL_SECTION plan_cache_cs = { &plan_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+/* base types that are copied as is between memory and the wire */
+static ULONG fixed_basetype_size( unsigned char fc )
+{
+    switch (fc)
+    {
+    case FC_BYTE:
+    case FC_CHAR:
+    case FC_SMALL:
+    case FC_USMALL:
+        return 1;
+    case FC_WCHAR:
+    case FC_SHORT:
+    case FC_USHORT:
+        return 2;
+    case FC_LONG:
+    case FC_ULONG:
+    case FC_ERROR_STATUS_T:
+    case FC_ENUM32:
+    case FC_FLOAT:
+        return 4;
+    case FC_HYPER:
+    case FC_DOUBLE:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/* whether calc_arg_size() only depends on the format string */
+static BOOL is_arg_size_fixed( PFORMAT_STRING format )
+{
+    switch (*format)
+    {
+    case FC_RP:
+        if (format[1] & FC_SIMPLE_POINTER) return TRUE;
+        return is_arg_size_fixed( &format[2] + *(const SHORT *)&format[2] );
+    case FC_STRUCT:
+    case FC_PSTRUCT:
+    case FC_SMFARRAY:
+    case FC_SMVARRAY:
+    case FC_LGFARRAY:
+    case FC_LGVARRAY:
+    case FC_USER_MARSHAL:
+    case FC_CSTRING:
+    case FC_WSTRING:
+    case FC_UP:
+    case FC_OP:
+    case FC_FP:
+    case FC_IP:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static struct ndr_proc_plan *create_proc_plan( MIDL_STUB_MESSAGE *stub_msg, PFORMAT_STRING format,
+                                               unsigned int count )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)format;
+    struct ndr_proc_plan *plan;
+    unsigned int i;
+
+    if (!(plan = malloc( offsetof( struct ndr_proc_plan, ops[count] ) ))) return NULL;
+    plan->next = NULL;
+    plan->params = format;
+    plan->stub_desc = stub_msg->StubDesc;
+    plan->format_types = stub_msg->StubDesc->pFormatTypes;
+    plan->count = count;
+
+    for (i = 0; i < count; i++)
+    {
+        struct ndr_param_op *op = &plan->ops[i];
+        PARAM_ATTRIBUTES attr = params[i].attr;
+        unsigned char fc;
+
+        memset( op, 0, sizeof(*op) );
+        op->attr = attr;
+        op->stack_offset = params[i].stack_offset;
+
+        if (attr.IsBasetype)
+        {
+            op->format = &params[i].u.type_format_char;
+            op->type_start[0] = op->format[0];
+            op->deref = attr.IsSimpleRef;
+            op->float_arg = op->format[0] == FC_FLOAT && !attr.IsSimpleRef;
+            if ((op->size = fixed_basetype_size( op->format[0] )))
+            {
+                op->kind = NDR_OP_BASETYPE;
+                op->align = op->size;
+            }
+        }
+        else
+        {
+            op->type_offset = params[i].u.type_offset;
+            op->format = &stub_msg->StubDesc->pFormatTypes[op->type_offset];
+            memcpy( op->type_start, op->format, sizeof(op->type_start) );
+            op->deref = !attr.IsByValue;
+            if (op->format[0] == FC_STRUCT)
+            {
+                op->kind = NDR_OP_STRUCT;
+                op->align = op->format[1] + 1;
+                op->size = *(const WORD *)&op->format[2];
+            }
+        }
+
+        fc = op->format[0] & NDR_TABLE_MASK;
+        op->sizer = NdrBufferSizer[fc];
+        op->marshaller = NdrMarshaller[fc];
+        op->unmarshaller = NdrUnmarshaller[fc];
+        op->freer = NdrFreer[fc];
+        if (!op->sizer || !op->marshaller || !op->unmarshaller)
+        {
+            /* let the interpreter report it */
+            free( plan );
+            return NULL;
+        }
+
+        if (param_needs_alloc( attr ))
+            op->out_size = is_arg_size_fixed( op->format ) ? calc_arg_size( stub_msg, op->format ) : NDR_SIZE_DYNAMIC;
+        else if (param_is_out_basetype( attr ))
+            op->out_size = basetype_arg_size( op->format[0] );
+    }
+
+    return plan;
+}
+
+static BOOL plan_matches( const struct ndr_proc_plan *plan, const MIDL_STUB_MESSAGE *stub_msg,
+                          PFORMAT_STRING format, unsigned int count )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)format;
+    const unsigned char *format_types = stub_msg->StubDesc->pFormatTypes;
+    unsigned int i;
+
+    if (plan->params != format || plan->count != count || plan->format_types != format_types ||
+        plan->stub_desc != stub_msg->StubDesc)
+        return FALSE;
+
+    for (i = 0; i < count; i++)
+    {
+        const struct ndr_param_op *op = &plan->ops[i];
+
+        if (memcmp( &op->attr, &params[i].attr, sizeof(op->attr) ) ||
+            op->stack_offset != params[i].stack_offset)
+            return FALSE;
+        if (op->attr.IsBasetype)
+        {
+            if (op->type_start[0] != params[i].u.type_format_char) return FALSE;
+        }
+        else if (op->type_offset != params[i].u.type_offset ||
+                 memcmp( op->type_start, &format_types[op->type_offset], sizeof(op->type_start) ))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static const struct ndr_proc_plan *get_proc_plan( MIDL_STUB_MESSAGE *stub_msg, PFORMAT_STRING format,
+                                                  unsigned int count )
+{
+    ULONG_PTR key = (ULONG_PTR)format ^ ((ULONG_PTR)stub_msg->StubDesc->pFormatTypes >> 4);
+    struct ndr_proc_plan **bucket = &plan_cache[(key >> 1) % NDR_PLAN_BUCKETS];
+    struct ndr_proc_plan *plan, *iter;
+
+    for (plan = *(struct ndr_proc_plan * volatile *)bucket; plan; plan = plan->next)
+        if (plan_matches( plan, stub_msg, format, count )) return plan;
+
+    if (!(plan = create_proc_plan( stub_msg, format, count ))) return NULL;
+
+    EnterCriticalSection( &plan_cache_cs );
+    for (iter = *bucket; iter; iter = iter->next)
+        if (plan_matches( iter, stub_msg, format, count )) break;
+    if (iter)
+    {
+        free( plan );
+        plan = iter;
+    }
+    else
+    {
+        TRACE( "new plan %p for %p, %u params\n", plan, format, count );
+        plan->next = *bucket;
+        InterlockedExchangePointer( (void **)bucket, plan );
+    }
+    LeaveCriticalSection( &plan_cache_cs );
+
+    return plan;
+}
+
+static inline void op_buffer_size( MIDL_STUB_MESSAGE *stub_msg, const struct ndr_param_op *op,
+                                   unsigned char *memory )
+{
+    if (op->deref) memory = *(unsigned char **)memory;
+    if (op->kind != NDR_OP_GENERIC) ndr_fixed_buffer_size( stub_msg, op->size, op->align );
+    else op->sizer( stub_msg, memory, op->format );
+}
+
+static inline void op_marshall( MIDL_STUB_MESSAGE *stub_msg, const struct ndr_param_op *op,
+                                unsigned char *memory )
+{
+    if (op->deref) memory = *(unsigned char **)memory;
+    switch (op->kind)
+    {
+    case NDR_OP_BASETYPE:
+        ndr_fixed_marshall( stub_msg, memory, op->size, op->align );
+        break;
+    case NDR_OP_STRUCT:
+        ndr_fixed_marshall( stub_msg, memory, op->size, op->align );
+        stub_msg->BufferMark = stub_msg->Buffer - op->size;
+        break;
+    default:
+        op->marshaller( stub_msg, memory, op->format );
+        break;
+    }
+}
+
+static inline void op_unmarshall( MIDL_STUB_MESSAGE *stub_msg, const struct ndr_param_op *op,
+                                  unsigned char **memory )
+{
+    if (op->deref) memory = (unsigned char **)*memory;
+    if (op->kind == NDR_OP_BASETYPE) ndr_fixed_unmarshall( stub_msg, memory, op->size, op->align );
+    else op->unmarshaller( stub_msg, memory, op->format, 0 );
+}
+
+static inline void op_free( MIDL_STUB_MESSAGE *stub_msg, const struct ndr_param_op *op,
+                            unsigned char *memory )
+{
+    if (op->attr.IsBasetype || !op->freer) return;
+    if (op->deref) memory = *(unsigned char **)memory;
+    op->freer( stub_msg, memory, op->format );
+}
+
+/* client_do_args() using a plan */
+static void client_do_plan( PMIDL_STUB_MESSAGE pStubMsg, const struct ndr_proc_plan *plan,
+                            enum stubless_phase phase, void **fpu_args, unsigned char *pRetVal )
+{
+    unsigned int i;
+
+    for (i = 0; i < plan->count; i++)
+    {
+        const struct ndr_param_op *op = &plan->ops[i];
+        unsigned char *pArg = pStubMsg->StackTop + op->stack_offset;
+
+#ifdef __x86_64__  /* floats are passed as doubles through varargs functions */
+        float f;
+
+        if (op->float_arg && !fpu_args)
+        {
+            f = *(double *)pArg;
+            pArg = (unsigned char *)&f;
+        }
+#endif
+
+        TRACE("param[%d]: %p type %02x %s\n", i, pArg, op->format[0], debugstr_PROC_PF( op->attr ));
+
+        switch (phase)
+        {
+        case STUBLESS_INITOUT:
+            if (op->out_size && *(unsigned char **)pArg)
+                memset( *(unsigned char **)pArg, 0, op->out_size == NDR_SIZE_DYNAMIC ?
+                        calc_arg_size( pStubMsg, op->format ) : op->out_size );
+            break;
+        case STUBLESS_CALCSIZE:
+            if (op->attr.IsSimpleRef && !*(unsigned char **)pArg)
+                RpcRaiseException(RPC_X_NULL_REF_POINTER);
+            if (op->attr.IsIn) op_buffer_size( pStubMsg, op, pArg );
+            break;
+        case STUBLESS_MARSHAL:
+            if (op->attr.IsIn) op_marshall( pStubMsg, op, pArg );
+            break;
+        case STUBLESS_UNMARSHAL:
+            if (op->attr.IsOut)
+            {
+                if (op->attr.IsReturn && pRetVal) pArg = pRetVal;
+                op_unmarshall( pStubMsg, op, &pArg );
+            }
+            break;
+        default:
+            RpcRaiseException(RPC_S_INTERNAL_ERROR);
+        }
+    }
+}
+
+static inline void do_client_args( PMIDL_STUB_MESSAGE pStubMsg, const struct ndr_proc_plan *plan,
+                                   PFORMAT_STRING pFormat, enum stubless_phase phase, void **fpu_args,
+                                   unsigned short number_of_params, unsigned char *pRetVal )
+{
+    if (plan) client_do_plan( pStubMsg, plan, phase, fpu_args, pRetVal );
+    else client_do_args( pStubMsg, pFormat, phase, fpu_args, number_of_params, pRetVal );
+}
+
 static unsigned int type_stack_size(unsigned char fc)
 {
     switch (fc)
@@ -716,6 +1067,8 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
     void *This = NULL;
     /* correlation cache */
     ULONG_PTR NdrCorrCache[256];
+    /* decoded parameters, for -Oicf procedures */
+    const struct ndr_proc_plan *plan;
 
     /* create the full pointer translation tables, if requested */
     if (proc_header->Oi_flags & Oi_FULL_PTR_USED)
@@ -742,6 +1095,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
             NdrClientInitializeNew(&rpc_msg, stub_msg, stub_desc, procedure_number);
 
         stub_msg->StackTop = (unsigned char *)stack_top;
+        plan = is_oicf_stubdesc(stub_desc) ? get_proc_plan(stub_msg, format, number_of_params) : NULL;
 
         /* we only need a handle if this isn't an object method */
         if (!(proc_header->Oi_flags & Oi_OBJECT_PROC))
@@ -789,13 +1143,13 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         if (proc_header->Oi_flags & Oi_OBJECT_PROC)
         {
             TRACE( "INITOUT\n" );
-            client_do_args(stub_msg, format, STUBLESS_INITOUT, fpu_stack,
+            do_client_args(stub_msg, plan, format, STUBLESS_INITOUT, fpu_stack,
                            number_of_params, (unsigned char *)&retval);
         }
 
         /* 2. CALCSIZE */
         TRACE( "CALCSIZE\n" );
-        client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
+        do_client_args(stub_msg, plan, format, STUBLESS_CALCSIZE, fpu_stack,
                        number_of_params, (unsigned char *)&retval);
 
         /* 3. GETBUFFER */
@@ -815,7 +1169,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 4. MARSHAL */
         TRACE( "MARSHAL\n" );
-        client_do_args(stub_msg, format, STUBLESS_MARSHAL, fpu_stack,
+        do_client_args(stub_msg, plan, format, STUBLESS_MARSHAL, fpu_stack,
                        number_of_params, (unsigned char *)&retval);
 
         /* 5. SENDRECEIVE */
@@ -841,7 +1195,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 6. UNMARSHAL */
         TRACE( "UNMARSHAL\n" );
-        client_do_args(stub_msg, format, STUBLESS_UNMARSHAL, fpu_stack,
+        do_client_args(stub_msg, plan, format, STUBLESS_UNMARSHAL, fpu_stack,
                        number_of_params, (unsigned char *)&retval);
     }
     __FINALLY_CTX(ndr_client_call_finally, &finally_ctx)
@@ -1299,6 +1653,76 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
     return retval_ptr;
 }
 
+/* stub_do_args() using a plan */
+static LONG_PTR *stub_do_plan(MIDL_STUB_MESSAGE *pStubMsg, const struct ndr_proc_plan *plan,
+                              enum stubless_phase phase)
+{
+    LONG_PTR *retval_ptr = NULL;
+    unsigned int i;
+
+    for (i = 0; i < plan->count; i++)
+    {
+        const struct ndr_param_op *op = &plan->ops[i];
+        unsigned char *pArg = pStubMsg->StackTop + op->stack_offset;
+
+        TRACE("param[%d]: %p -> %p type %02x %s\n", i, pArg, *(unsigned char **)pArg,
+              op->format[0], debugstr_PROC_PF( op->attr ));
+
+        switch (phase)
+        {
+        case STUBLESS_MARSHAL:
+            if (op->attr.IsOut || op->attr.IsReturn) op_marshall( pStubMsg, op, pArg );
+            break;
+        case STUBLESS_MUSTFREE:
+            if (op->attr.MustFree) op_free( pStubMsg, op, pArg );
+            break;
+        case STUBLESS_FREE:
+            if (op->attr.ServerAllocSize)
+                free(*(void **)pArg);
+            else if (param_needs_alloc(op->attr) && (!op->attr.MustFree || op->attr.IsSimpleRef))
+            {
+                if (op->format[0] != FC_BIND_CONTEXT) pStubMsg->pfnFree(*(void **)pArg);
+            }
+            break;
+        case STUBLESS_INITOUT:
+            if (param_needs_alloc(op->attr) && !op->attr.ServerAllocSize)
+            {
+                if (op->format[0] == FC_BIND_CONTEXT)
+                {
+                    NDR_SCONTEXT ctxt = NdrContextHandleInitialize(pStubMsg, op->format);
+                    *(void **)pArg = NDRSContextValue(ctxt);
+                    if (op->attr.IsReturn) retval_ptr = (LONG_PTR *)NDRSContextValue(ctxt);
+                }
+                else
+                {
+                    DWORD size = op->out_size == NDR_SIZE_DYNAMIC ? calc_arg_size(pStubMsg, op->format)
+                                                                  : op->out_size;
+                    if (size)
+                    {
+                        *(void **)pArg = NdrAllocate(pStubMsg, size);
+                        memset(*(void **)pArg, 0, size);
+                    }
+                }
+            }
+            if (!retval_ptr && op->attr.IsReturn) retval_ptr = (LONG_PTR *)pArg;
+            break;
+        case STUBLESS_UNMARSHAL:
+            if (op->attr.ServerAllocSize)
+                *(void **)pArg = calloc(op->attr.ServerAllocSize, 8);
+
+            if (op->attr.IsIn) op_unmarshall( pStubMsg, op, &pArg );
+            break;
+        case STUBLESS_CALCSIZE:
+            if (op->attr.IsOut || op->attr.IsReturn) op_buffer_size( pStubMsg, op, pArg );
+            break;
+        default:
+            RpcRaiseException(RPC_S_INTERNAL_ERROR);
+        }
+        TRACE("\tmemory addr (after): %p -> %p\n", pArg, *(unsigned char **)pArg);
+    }
+    return retval_ptr;
+}
+
 /***********************************************************************
  *            NdrStubCall2 [RPCRT4.@]
  *
@@ -1336,6 +1760,8 @@ LONG WINAPI NdrStubCall2(
     LONG_PTR *retval_ptr = NULL;
     /* correlation cache */
     ULONG_PTR NdrCorrCache[256];
+    /* decoded parameters, for -Oicf procedures */
+    const struct ndr_proc_plan *plan = NULL;
 
     TRACE("pThis %p, pChannel %p, pRpcMsg %p, pdwStubPhase %p\n", pThis, pChannel, pRpcMsg, pdwStubPhase);
 
@@ -1466,6 +1892,8 @@ LONG WINAPI NdrStubCall2(
             if (ext_flags.Unused & 0x2) /* has range on conformance */
                 stubMsg.CorrDespIncrement = 12;
         }
+
+        plan = get_proc_plan( &stubMsg, pFormat, number_of_params );
     }
     else
     {
@@ -1539,7 +1967,10 @@ LONG WINAPI NdrStubCall2(
         case STUBLESS_MARSHAL:
         case STUBLESS_MUSTFREE:
         case STUBLESS_FREE:
-            retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
+            if (plan)
+                retval_ptr = stub_do_plan(&stubMsg, plan, phase);
+            else
+                retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
             break;
         default:
             ERR("shouldn't reach here. phase %d\n", phase);
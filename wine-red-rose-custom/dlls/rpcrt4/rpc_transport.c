@@ -178,30 +178,13 @@ static char *ncalrpc_pipe_name(const char *endpoint)
   static const char prefix[] = "\\\\.\\pipe\\lrpc\\";
   char *pipe_name;
 
-  /* protseq=ncalrpc: supposed to use NT LPC ports,
-   * but we'll implement it with named pipes for now */
+  /* protseq=ncalrpc: supposed to use NT LPC ports, we use a named pipe
+   * to set up the connection and shared memory for the data */
   pipe_name = I_RpcAllocate(sizeof(prefix) + strlen(endpoint));
   strcat(strcpy(pipe_name, prefix), endpoint);
   return pipe_name;
 }
 
-static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
-{
-  RpcConnection_np *npc = (RpcConnection_np *) Connection;
-  RPC_STATUS r;
-  LPSTR pname;
-
-  /* already connected? */
-  if (npc->pipe)
-    return RPC_S_OK;
-
-  pname = ncalrpc_pipe_name(Connection->Endpoint);
-  r = rpcrt4_conn_open_pipe(Connection, pname, TRUE);
-  I_RpcFree(pname);
-
-  return r;
-}
-
 static RPC_STATUS rpcrt4_protseq_ncalrpc_open_endpoint(RpcServerProtseq* protseq, const char *endpoint)
 {
   RPC_STATUS r;
@@ -897,6 +880,480 @@ static RPC_STATUS rpcrt4_ncalrpc_inquire_client_pid(RpcConnection *conn, ULONG *
     return GetNamedPipeClientProcessId(connection->pipe, pid) ? RPC_S_OK : RPC_S_INVALID_BINDING;
 }
 
+/**** ncalrpc shared memory support ****/
+
+/* The client creates an unnamed section holding a ring buffer for each
+ * direction, and events to wake up each side, and sends their handles over
+ * the pipe. The server duplicates them from the client process and replies,
+ * then all packets go through the rings. The pipe is only kept to identify
+ * and impersonate the client, and a read is left pending on it, which only
+ * completes when the other side goes away. */
+
+#define LRPC_MAGIC         0x4350524c  /* "LRPC" */
+#define LRPC_RING_SIZE     0x10000
+#define LRPC_DATA_OFFSET   0x1000
+#define LRPC_SHM_SIZE      (LRPC_DATA_OFFSET + 2 * LRPC_RING_SIZE)
+#define LRPC_SPIN_COUNT    4000
+
+enum lrpc_ring_id
+{
+    LRPC_RING_REQUEST,   /* client to server */
+    LRPC_RING_RESPONSE,  /* server to client */
+};
+
+struct lrpc_ring
+{
+    LONG head;           /* total bytes written */
+    LONG tail;           /* total bytes read */
+    LONG reader_waiting;
+    LONG writer_waiting;
+    LONG closed;
+    LONG pad[11];        /* keep the rings on separate cache lines */
+};
+
+struct lrpc_shm
+{
+    DWORD magic;
+    DWORD ring_size;
+    DWORD pad[14];
+    struct lrpc_ring ring[2];
+};
+
+struct lrpc_connect_msg
+{
+    DWORD magic;
+    DWORD section;       /* 0 if the client only wants to use the pipe */
+    DWORD events[2][2];
+};
+
+struct lrpc_connect_reply
+{
+    DWORD magic;
+    DWORD status;
+};
+
+enum lrpc_event
+{
+    LRPC_EVENT_DATA,     /* waited on by the reader of a ring */
+    LRPC_EVENT_SPACE,    /* waited on by the writer of a ring */
+};
+
+typedef struct _RpcConnection_lrpc
+{
+    RpcConnection_np np;
+    BOOL negotiated;
+    HANDLE section;
+    struct lrpc_shm *shm;
+    HANDLE events[2][2];
+    struct lrpc_ring *send;
+    struct lrpc_ring *recv;
+    unsigned char *send_data;
+    unsigned char *recv_data;
+    HANDLE send_space_event;
+    HANDLE send_data_event;
+    HANDLE recv_space_event;
+    HANDLE recv_data_event;
+    HANDLE cancel_event;
+    HANDLE closed_event;
+    IO_STATUS_BLOCK closed_io;
+    BOOL watching;
+    char closed_buf;
+    SRWLOCK write_lock;
+} RpcConnection_lrpc;
+
+static RpcConnection *rpcrt4_conn_lrpc_alloc(void)
+{
+    RpcConnection_lrpc *lrpc = calloc(1, sizeof(*lrpc));
+    if (!lrpc) return NULL;
+    lrpc->cancel_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    lrpc->closed_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!lrpc->cancel_event || !lrpc->closed_event)
+    {
+        if (lrpc->cancel_event) CloseHandle(lrpc->cancel_event);
+        if (lrpc->closed_event) CloseHandle(lrpc->closed_event);
+        free(lrpc);
+        return NULL;
+    }
+    InitializeSRWLock(&lrpc->write_lock);
+    return &lrpc->np.common;
+}
+
+static void lrpc_free_shm(RpcConnection_lrpc *lrpc)
+{
+    unsigned int i, j;
+
+    if (lrpc->watching)
+    {
+        IO_STATUS_BLOCK io_status;
+
+        NtCancelIoFileEx(lrpc->np.pipe, &lrpc->closed_io, &io_status);
+        WaitForSingleObject(lrpc->closed_event, INFINITE);
+        lrpc->watching = FALSE;
+    }
+    if (lrpc->shm) UnmapViewOfFile(lrpc->shm);
+    if (lrpc->section) CloseHandle(lrpc->section);
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 2; j++)
+            if (lrpc->events[i][j]) CloseHandle(lrpc->events[i][j]);
+    lrpc->shm = NULL;
+    lrpc->section = NULL;
+    memset(lrpc->events, 0, sizeof(lrpc->events));
+}
+
+static BOOL lrpc_map_shm(RpcConnection_lrpc *lrpc)
+{
+    unsigned int send_id = lrpc->np.common.server ? LRPC_RING_RESPONSE : LRPC_RING_REQUEST;
+    unsigned int recv_id = !send_id;
+
+    if (!(lrpc->shm = MapViewOfFile(lrpc->section, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, LRPC_SHM_SIZE)))
+        return FALSE;
+    if (!lrpc->np.common.server)
+    {
+        lrpc->shm->magic = LRPC_MAGIC;
+        lrpc->shm->ring_size = LRPC_RING_SIZE;
+    }
+    else if (lrpc->shm->magic != LRPC_MAGIC || lrpc->shm->ring_size != LRPC_RING_SIZE)
+        return FALSE;
+
+    lrpc->send = &lrpc->shm->ring[send_id];
+    lrpc->recv = &lrpc->shm->ring[recv_id];
+    lrpc->send_data = (unsigned char *)lrpc->shm + LRPC_DATA_OFFSET + send_id * LRPC_RING_SIZE;
+    lrpc->recv_data = (unsigned char *)lrpc->shm + LRPC_DATA_OFFSET + recv_id * LRPC_RING_SIZE;
+    lrpc->send_data_event = lrpc->events[send_id][LRPC_EVENT_DATA];
+    lrpc->send_space_event = lrpc->events[send_id][LRPC_EVENT_SPACE];
+    lrpc->recv_data_event = lrpc->events[recv_id][LRPC_EVENT_DATA];
+    lrpc->recv_space_event = lrpc->events[recv_id][LRPC_EVENT_SPACE];
+    return TRUE;
+}
+
+/* client side: the objects are unnamed, so only processes given a handle
+ * can get at them */
+static BOOL lrpc_create_shm(RpcConnection_lrpc *lrpc)
+{
+    unsigned int i, j;
+
+    if (!(lrpc->section = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, LRPC_SHM_SIZE, NULL)))
+        goto failed;
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 2; j++)
+            if (!(lrpc->events[i][j] = CreateEventW(NULL, FALSE, FALSE, NULL))) goto failed;
+    if (lrpc_map_shm(lrpc)) return TRUE;
+
+failed:
+    WARN("failed to create the shared section, error %lu\n", GetLastError());
+    lrpc_free_shm(lrpc);
+    return FALSE;
+}
+
+/* server side: duplicate the client's handles */
+static BOOL lrpc_import_shm(RpcConnection_lrpc *lrpc, const struct lrpc_connect_msg *msg)
+{
+    HANDLE process = NULL;
+    unsigned int i, j;
+    ULONG pid;
+
+    if (!GetNamedPipeClientProcessId(lrpc->np.pipe, &pid) ||
+        !(process = OpenProcess(PROCESS_DUP_HANDLE, FALSE, pid)))
+        goto failed;
+    if (!DuplicateHandle(process, ULongToHandle(msg->section), GetCurrentProcess(), &lrpc->section,
+                         SECTION_MAP_READ | SECTION_MAP_WRITE, FALSE, 0))
+        goto failed;
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 2; j++)
+            if (!DuplicateHandle(process, ULongToHandle(msg->events[i][j]), GetCurrentProcess(),
+                                 &lrpc->events[i][j], EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, 0))
+                goto failed;
+    CloseHandle(process);
+    process = NULL;
+    if (lrpc_map_shm(lrpc)) return TRUE;
+
+failed:
+    WARN("failed to get the client's shared section, error %lu\n", GetLastError());
+    if (process) CloseHandle(process);
+    lrpc_free_shm(lrpc);
+    return FALSE;
+}
+
+/* nothing else is sent over the pipe once the rings are in use, so this
+ * read only completes when the other side closes it */
+static void lrpc_watch_pipe(RpcConnection_lrpc *lrpc)
+{
+    NTSTATUS status;
+
+    ResetEvent(lrpc->closed_event);
+    status = NtReadFile(lrpc->np.pipe, lrpc->closed_event, NULL, NULL, &lrpc->closed_io,
+                        &lrpc->closed_buf, sizeof(lrpc->closed_buf), NULL, NULL);
+    if (status == STATUS_PENDING)
+        lrpc->watching = TRUE;
+    else
+        SetEvent(lrpc->closed_event);
+}
+
+/* client side: offer a shared section to the server */
+static RPC_STATUS lrpc_connect(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_connect_msg msg;
+    struct lrpc_connect_reply reply;
+    unsigned int i, j;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.magic = LRPC_MAGIC;
+    if (lrpc_create_shm(lrpc))
+    {
+        msg.section = HandleToULong(lrpc->section);
+        for (i = 0; i < 2; i++)
+            for (j = 0; j < 2; j++)
+                msg.events[i][j] = HandleToULong(lrpc->events[i][j]);
+    }
+
+    if (rpcrt4_conn_np_write(&lrpc->np.common, &msg, sizeof(msg)) != sizeof(msg) ||
+        rpcrt4_conn_np_read(&lrpc->np.common, &reply, sizeof(reply)) != sizeof(reply) ||
+        reply.magic != LRPC_MAGIC)
+    {
+        WARN("connection setup failed\n");
+        lrpc_free_shm(lrpc);
+        return RPC_S_SERVER_UNAVAILABLE;
+    }
+
+    if (reply.status && lrpc->shm)
+    {
+        TRACE("server refused the shared section, using the pipe\n");
+        lrpc_free_shm(lrpc);
+    }
+    if (lrpc->shm) lrpc_watch_pipe(lrpc);
+    lrpc->negotiated = TRUE;
+    return RPC_S_OK;
+}
+
+/* server side: called before reading the first packet */
+static RPC_STATUS lrpc_accept(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_connect_msg msg;
+    struct lrpc_connect_reply reply;
+
+    if (rpcrt4_conn_np_read(&lrpc->np.common, &msg, sizeof(msg)) != sizeof(msg) ||
+        msg.magic != LRPC_MAGIC)
+    {
+        WARN("invalid connection request\n");
+        return RPC_S_PROTOCOL_ERROR;
+    }
+
+    reply.magic = LRPC_MAGIC;
+    reply.status = msg.section && lrpc_import_shm(lrpc, &msg) ? 0 : 1;
+    if (rpcrt4_conn_np_write(&lrpc->np.common, &reply, sizeof(reply)) != sizeof(reply))
+    {
+        lrpc_free_shm(lrpc);
+        return RPC_S_PROTOCOL_ERROR;
+    }
+
+    TRACE("using %s\n", lrpc->shm ? "shared memory" : "the pipe");
+    if (lrpc->shm) lrpc_watch_pipe(lrpc);
+    lrpc->negotiated = TRUE;
+    return RPC_S_OK;
+}
+
+static inline void lrpc_wake(LONG *waiting, HANDLE event)
+{
+    if (ReadAcquire(waiting) && InterlockedExchange(waiting, 0)) SetEvent(event);
+}
+
+/* wait until *pos is no longer equal to value, spinning for a while first
+ * since the other side usually answers quickly */
+static BOOL lrpc_wait(RpcConnection_lrpc *lrpc, struct lrpc_ring *ring, LONG *pos, LONG value,
+                      LONG *waiting, HANDLE event)
+{
+    HANDLE handles[3] = { event, lrpc->cancel_event, lrpc->closed_event };
+    unsigned int spin;
+
+    for (spin = 0; spin < LRPC_SPIN_COUNT; spin++)
+    {
+        if (ReadAcquire(pos) != value) return TRUE;
+        YieldProcessor();
+    }
+
+    for (;;)
+    {
+        InterlockedExchange(waiting, 1);
+        if (ReadAcquire(pos) != value) return TRUE;
+        if (ReadAcquire(&ring->closed) || lrpc->np.read_closed) return FALSE;
+
+        switch (WaitForMultipleObjects(ARRAY_SIZE(handles), handles, FALSE, INFINITE))
+        {
+        case WAIT_OBJECT_0:
+            break;
+        case WAIT_OBJECT_0 + 1:
+            TRACE("call cancelled\n");
+            return FALSE;
+        case WAIT_OBJECT_0 + 2:
+            /* the last data may have been written without waking us up */
+            if (ReadAcquire(pos) != value) return TRUE;
+            WARN("peer went away, status %#lx\n", lrpc->closed_io.Status);
+            return FALSE;
+        default:
+            ERR("WaitForMultipleObjects() failed with error %lu\n", GetLastError());
+            return FALSE;
+        }
+    }
+}
+
+static int rpcrt4_conn_lrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    struct lrpc_ring *ring;
+    unsigned int done = 0;
+
+    if (!lrpc->negotiated && conn->server && lrpc_accept(lrpc) != RPC_S_OK)
+        return -1;
+    if (!lrpc->shm)
+        return rpcrt4_conn_np_read(conn, buffer, count);
+
+    ring = lrpc->recv;
+    while (done < count)
+    {
+        ULONG tail = ring->tail, avail = ReadAcquire(&ring->head) - tail;
+        unsigned int offset = tail & (LRPC_RING_SIZE - 1), len;
+
+        if (lrpc->np.read_closed) return -1;
+        if (!avail)
+        {
+            if (!lrpc_wait(lrpc, ring, &ring->head, tail, &ring->reader_waiting, lrpc->recv_data_event))
+                return -1;
+            continue;
+        }
+
+        len = min(min(avail, count - done), LRPC_RING_SIZE - offset);
+        if (buffer) memcpy((unsigned char *)buffer + done, lrpc->recv_data + offset, len);
+        InterlockedExchange(&ring->tail, tail + len);
+        lrpc_wake(&ring->writer_waiting, lrpc->recv_space_event);
+        done += len;
+    }
+    return count;
+}
+
+static int rpcrt4_conn_lrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    struct lrpc_ring *ring = lrpc->send;
+    unsigned int done = 0;
+
+    if (!lrpc->shm)
+        return rpcrt4_conn_np_write(conn, buffer, count);
+
+    /* a cancel only applies to the call it was made for */
+    if (!conn->server && count >= sizeof(RpcPktCommonHdr))
+    {
+        const RpcPktCommonHdr *hdr = buffer;
+        if (hdr->ptype == PKT_REQUEST && (hdr->flags & RPC_FLG_FIRST)) ResetEvent(lrpc->cancel_event);
+    }
+
+    /* responses may be written by several threads, keep the packets whole */
+    AcquireSRWLockExclusive(&lrpc->write_lock);
+    while (done < count)
+    {
+        ULONG head = ring->head, space = LRPC_RING_SIZE - (head - ReadAcquire(&ring->tail));
+        unsigned int offset = head & (LRPC_RING_SIZE - 1), len;
+
+        if (ReadAcquire(&ring->closed)) break;
+        if (!space)
+        {
+            LONG tail = head - LRPC_RING_SIZE;
+            if (!lrpc_wait(lrpc, ring, &ring->tail, tail, &ring->writer_waiting, lrpc->send_space_event))
+                break;
+            continue;
+        }
+
+        len = min(min(space, count - done), LRPC_RING_SIZE - offset);
+        memcpy(lrpc->send_data + offset, (const unsigned char *)buffer + done, len);
+        InterlockedExchange(&ring->head, head + len);
+        lrpc_wake(&ring->reader_waiting, lrpc->send_data_event);
+        done += len;
+    }
+    ReleaseSRWLockExclusive(&lrpc->write_lock);
+
+    return done == count ? count : -1;
+}
+
+static int rpcrt4_conn_lrpc_close(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (lrpc->shm)
+    {
+        InterlockedExchange(&lrpc->send->closed, TRUE);
+        InterlockedExchange(&lrpc->recv->closed, TRUE);
+        SetEvent(lrpc->send_data_event);
+        SetEvent(lrpc->recv_space_event);
+        lrpc_free_shm(lrpc);
+    }
+    lrpc->negotiated = FALSE;
+    rpcrt4_conn_np_close(conn);
+    if (lrpc->cancel_event)
+    {
+        CloseHandle(lrpc->cancel_event);
+        lrpc->cancel_event = 0;
+    }
+    if (lrpc->closed_event)
+    {
+        CloseHandle(lrpc->closed_event);
+        lrpc->closed_event = 0;
+    }
+    return 0;
+}
+
+static void rpcrt4_conn_lrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    rpcrt4_conn_np_close_read(conn);
+    if (lrpc->shm) SetEvent(lrpc->recv_data_event);
+}
+
+static void rpcrt4_conn_lrpc_cancel_call(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (!lrpc->shm)
+    {
+        rpcrt4_conn_np_cancel_call(conn);
+        return;
+    }
+    SetEvent(lrpc->cancel_event);
+}
+
+static int rpcrt4_conn_lrpc_wait_for_incoming_data(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    struct lrpc_ring *ring = lrpc->recv;
+    LONG tail;
+
+    if (!lrpc->shm)
+        return rpcrt4_conn_np_wait_for_incoming_data(conn);
+
+    tail = ring->tail;
+    if (ReadAcquire(&ring->head) != tail) return 0;
+    return lrpc_wait(lrpc, ring, &ring->head, tail, &ring->reader_waiting, lrpc->recv_data_event) ? 0 : -1;
+}
+
+static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+  RPC_STATUS r;
+  LPSTR pname;
+
+  /* already connected? */
+  if (lrpc->np.pipe)
+    return RPC_S_OK;
+
+  pname = ncalrpc_pipe_name(Connection->Endpoint);
+  r = rpcrt4_conn_open_pipe(Connection, pname, TRUE);
+  I_RpcFree(pname);
+
+  if (r == RPC_S_OK && (r = lrpc_connect(lrpc)) != RPC_S_OK)
+    rpcrt4_conn_np_close(Connection);
+
+  return r;
+}
+
 /**** ncacn_ip_tcp support ****/
 
 static size_t rpcrt4_ip_tcp_get_top_of_tower(unsigned char *tower_data,
@@ -3142,16 +3599,16 @@ static const struct connection_ops conn_protseq_list[] = {
   },
   { "ncalrpc",
     { EPM_PROTOCOL_NCALRPC, EPM_PROTOCOL_PIPE },
-    rpcrt4_conn_np_alloc,
+    rpcrt4_conn_lrpc_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_conn_lrpc_read,
+    rpcrt4_conn_lrpc_write,
+    rpcrt4_conn_lrpc_close,
+    rpcrt4_conn_lrpc_close_read,
+    rpcrt4_conn_lrpc_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_conn_lrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
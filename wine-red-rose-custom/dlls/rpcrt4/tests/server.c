@@ -2001,6 +2001,80 @@ static void test_handle_return(void)
     test_handle(handle2);
 }
 
+/* Stubless calls decode the parameters of a procedure once and reuse that,
+ * so make the same calls several times, interleaved, with changing values. */
+static void
+plan_tests(void)
+{
+  vector_t a = {1, 2, 3}, b = {4, 5, 6};
+  double u, v;
+  float s, t;
+  hyper y;
+  short h;
+  int i, x;
+
+  for (i = 0; i < 4; i++)
+  {
+    h = sum_short(1000 * i, -7);
+    ok(h == 1000 * i - 7, "%d: RPC sum_short got %d\n", i, h);
+    y = sum_hyper((hyper)i << 32, 5 - i);
+    ok(y == ((hyper)i << 32) + 5 - i, "%d: RPC sum_hyper got %s\n", i, wine_dbgstr_longlong(y));
+
+    x = 0;
+    square_out(i + 3, &x);
+    ok(x == (i + 3) * (i + 3), "%d: RPC square_out got %d\n", i, x);
+
+    v = 0.0;
+    u = square_half(i + 1.0, &v);
+    ok(u == (i + 1.0) * (i + 1.0), "%d: RPC square_half got %f\n", i, u);
+    ok(v == (i + 1.0) / 2.0, "%d: RPC square_half got %f\n", i, v);
+    t = 0.0f;
+    s = square_half_float(i + 1.0f, &t);
+    ok(s == (i + 1.0f) * (i + 1.0f), "%d: RPC square_half_float got %f\n", i, s);
+    ok(t == (i + 1.0f) / 2.0f, "%d: RPC square_half_float got %f\n", i, t);
+
+    a.z = i;
+    b.x = -i;
+    x = dot_copy_vectors(a, b);
+    ok(x == -i + 10 + 6 * i, "%d: RPC dot_copy_vectors got %d\n", i, x);
+    x = dot_self(&a);
+    ok(x == 5 + i * i, "%d: RPC dot_self got %d\n", i, x);
+  }
+}
+
+static void
+benchmark_calls(void)
+{
+  static const int count = 20000;
+  vector_t vec1 = {1, -2, 3}, vec2 = {4, -5, 6};
+  LARGE_INTEGER freq, start, end;
+  int i, x;
+
+  QueryPerformanceFrequency(&freq);
+
+  QueryPerformanceCounter(&start);
+  for (i = 0; i < count; i++) int_return();
+  QueryPerformanceCounter(&end);
+  trace("int_return round trip: %.2f us\n", (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / count);
+
+  QueryPerformanceCounter(&start);
+  for (i = 0; i < count; i++) sum(i, 1);
+  QueryPerformanceCounter(&end);
+  trace("sum: %.2f us per call\n", (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / count);
+
+  QueryPerformanceCounter(&start);
+  for (i = 0; i < count; i++) square_out(i & 0xff, &x);
+  QueryPerformanceCounter(&end);
+  trace("square_out: %.2f us per call\n", (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / count);
+
+  QueryPerformanceCounter(&start);
+  for (i = 0; i < count; i++) dot_copy_vectors(vec1, vec2);
+  QueryPerformanceCounter(&end);
+  trace("dot_copy_vectors: %.2f us per call\n", (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / count);
+
+  ok(x == 255 * 255, "RPC square_out got %d\n", x);
+}
+
 static void
 run_tests(void)
 {
@@ -2010,6 +2084,8 @@ run_tests(void)
   array_tests();
   context_handle_test();
   test_handle_return();
+  plan_tests();
+  if (winetest_interactive) benchmark_calls();
 }
 
 static void
@@ -47,6 +47,17 @@ static REFIID tid_ids[] = {
 static ITypeLib *typelib;
 static ITypeInfo *typeinfos[REGEXP_LAST_tid];
 
+static struct regexp_cache *regexp_cache;
+
+static CRITICAL_SECTION regexp_cache_cs;
+static CRITICAL_SECTION_DEBUG regexp_cache_cs_debug =
+{
+    0, 0, &regexp_cache_cs,
+    { &regexp_cache_cs_debug.ProcessLocksList, &regexp_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": regexp_cache_cs") }
+};
+static CRITICAL_SECTION regexp_cache_cs = { &regexp_cache_cs_debug, -1, 0, 0, 0, 0 };
+
 static HRESULT init_regexp_typeinfo(regexp_tid_t tid)
 {
     HRESULT hres;
@@ -1118,7 +1129,7 @@ static ULONG WINAPI RegExp2_Release(IRegExp2 *iface)
     if(!ref) {
         free(This->pattern);
         if(This->regexp)
-            regexp_destroy(This->regexp);
+            regexp_release(This->regexp);
         heap_pool_free(&This->pool);
         free(This);
     }
@@ -1211,7 +1222,7 @@ static HRESULT WINAPI RegExp2_put_Pattern(IRegExp2 *iface, BSTR pattern)
     This->pattern = new_pattern;
 
     if(This->regexp) {
-        regexp_destroy(This->regexp);
+        regexp_release(This->regexp);
         This->regexp = NULL;
     }
     return S_OK;
@@ -1295,6 +1306,31 @@ static HRESULT WINAPI RegExp2_put_Multiline(IRegExp2 *iface, VARIANT_BOOL multil
     return S_OK;
 }
 
+void regexp_report_error(void *cx, regexp_error_t error)
+{
+}
+
+/* Compiled patterns are shared between RegExp objects through regexp_cache. */
+static HRESULT compile_regexp(RegExp2 *This)
+{
+    regexp_t *regexp;
+
+    if(This->regexp && This->regexp->flags == This->flags)
+        return S_OK;
+
+    EnterCriticalSection(&regexp_cache_cs);
+    regexp = regexp_new_cached(&regexp_cache, NULL, &This->pool, This->pattern,
+            lstrlenW(This->pattern), This->flags);
+    LeaveCriticalSection(&regexp_cache_cs);
+    if(!regexp)
+        return E_FAIL;
+
+    if(This->regexp)
+        regexp_release(This->regexp);
+    This->regexp = regexp;
+    return S_OK;
+}
+
 static HRESULT WINAPI RegExp2_Execute(IRegExp2 *iface,
         BSTR sourceString, IDispatch **ppMatches)
 {
@@ -1337,16 +1373,9 @@ static HRESULT WINAPI RegExp2_Execute(IRegExp2 *iface,
         return S_OK;
     }
 
-    if(!This->regexp) {
-        This->regexp = regexp_new(NULL, &This->pool, This->pattern,
-                lstrlenW(This->pattern), This->flags, FALSE);
-        if(!This->regexp)
-            return E_FAIL;
-    }else {
-        hres = regexp_set_flags(&This->regexp, NULL, &This->pool, This->flags);
-        if(FAILED(hres))
-            return hres;
-    }
+    hres = compile_regexp(This);
+    if(FAILED(hres))
+        return hres;
 
     hres = create_match_collection2(&match_collection);
     if(FAILED(hres))
@@ -1404,16 +1433,9 @@ static HRESULT WINAPI RegExp2_Test(IRegExp2 *iface, BSTR sourceString, VARIANT_B
         return S_OK;
     }
 
-    if(!This->regexp) {
-        This->regexp = regexp_new(NULL, &This->pool, This->pattern,
-                lstrlenW(This->pattern), This->flags, FALSE);
-        if(!This->regexp)
-            return E_FAIL;
-    }else {
-        hres = regexp_set_flags(&This->regexp, NULL, &This->pool, This->flags);
-        if(FAILED(hres))
-            return hres;
-    }
+    hres = compile_regexp(This);
+    if(FAILED(hres))
+        return hres;
 
     mark = heap_pool_mark(&This->pool);
     result = alloc_match_state(This->regexp, &This->pool, sourceString);
@@ -1493,16 +1515,9 @@ static HRESULT WINAPI RegExp2_Replace(IRegExp2 *iface, BSTR source, VARIANT repl
     TRACE("(%p)->(%s %s %p)\n", This, debugstr_w(source), debugstr_variant(&replaceVar), ret);
 
     if(This->pattern) {
-        if(!This->regexp) {
-            This->regexp = regexp_new(NULL, &This->pool, This->pattern,
-                                      lstrlenW(This->pattern), This->flags, FALSE);
-            if(!This->regexp)
-                return E_OUTOFMEMORY;
-        }else {
-            hres = regexp_set_flags(&This->regexp, NULL, &This->pool, This->flags);
-            if(FAILED(hres))
-                return hres;
-        }
+        hres = compile_regexp(This);
+        if(FAILED(hres))
+            return hres;
     }
 
     V_VT(&strv) = VT_EMPTY;
@@ -1856,4 +1871,5 @@ void release_regexp_typelib(void)
     }
     if(typelib)
         ITypeLib_Release(typelib);
+    regexp_cache_free(regexp_cache);
 }
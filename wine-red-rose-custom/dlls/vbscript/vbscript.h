@@ -33,7 +33,7 @@
 
 #include "wine/list.h"
 
-typedef struct {
+typedef struct heap_pool_t {
     void **blocks;
     DWORD block_cnt;
     DWORD last_block;
@@ -407,7 +407,10 @@ void flush_window_surfaces( BOOL idle )
     else if ((int)(now - last_idle) < 50) goto done;
 
     LIST_FOR_EACH_ENTRY( surface, &window_surfaces, struct window_surface, entry )
+    {
+        surface->draw_start_ticks = 0;
         surface->funcs->flush( surface );
+    }
 done:
     pthread_mutex_unlock( &surfaces_lock );
 }
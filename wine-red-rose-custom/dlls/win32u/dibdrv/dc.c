@@ -744,7 +744,9 @@ static inline void lock_surface( struct windrv_physdev *dev )
 {
     /* gdi_lock should not be locked */
     dev->surface->funcs->lock( dev->surface );
-    if (IsRectEmpty( dev->dibdrv->bounds ) || dev->surface->draw_start_ticks == 0)
+    /* drivers may move the bounds to their own dirty list on unlock, so track the start
+     * of drawing until the next flush instead of relying on the bounds being empty */
+    if (dev->surface->draw_start_ticks == 0)
         dev->surface->draw_start_ticks = NtGetTickCount();
 }
 
@@ -752,7 +754,11 @@ static inline void unlock_surface( struct windrv_physdev *dev )
 {
     BOOL should_flush = NtGetTickCount() - dev->surface->draw_start_ticks > FLUSH_PERIOD;
     dev->surface->funcs->unlock( dev->surface );
-    if (should_flush) dev->surface->funcs->flush( dev->surface );
+    if (should_flush)
+    {
+        dev->surface->draw_start_ticks = 0;
+        dev->surface->funcs->flush( dev->surface );
+    }
 }
 
 static void unlock_bits_surface( struct gdi_image_bits *bits )
@@ -209,7 +209,8 @@ static void adapter_vk_destroy(struct wined3d_adapter *adapter)
 }
 
 static HRESULT wined3d_select_vulkan_queue_family(const struct wined3d_adapter_vk *adapter_vk,
-        uint32_t *queue_family_index, uint32_t *timestamp_bits)
+        uint32_t *queue_family_index, uint32_t *timestamp_bits,
+        uint32_t *transfer_queue_family_index, VkExtent3D *transfer_granularity)
 {
     VkPhysicalDevice physical_device = adapter_vk->physical_device;
     const struct wined3d_vk_info *vk_info = &adapter_vk->vk_info;
@@ -223,6 +224,22 @@ static HRESULT wined3d_select_vulkan_queue_family(const struct wined3d_adapter_v
 
     VK_CALL(vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, queue_properties));
 
+    /* Look for a dedicated transfer queue family, i.e. a DMA engine that
+     * can run copies concurrently with the graphics queue. */
+    *transfer_queue_family_index = ~0u;
+    for (i = 0; i < count; ++i)
+    {
+        if ((queue_properties[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT))
+                == VK_QUEUE_TRANSFER_BIT && queue_properties[i].queueCount)
+        {
+            *transfer_queue_family_index = i;
+            *transfer_granularity = queue_properties[i].minImageTransferGranularity;
+            TRACE("Using queue family %u for transfers, granularity %ux%ux%u.\n", i,
+                    transfer_granularity->width, transfer_granularity->height, transfer_granularity->depth);
+            break;
+        }
+    }
+
     for (i = 0; i < count; ++i)
     {
         if (queue_properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
@@ -245,6 +262,7 @@ struct wined3d_physical_device_info
     VkPhysicalDeviceVertexAttributeDivisorFeaturesEXT vertex_divisor_features;
     VkPhysicalDeviceHostQueryResetFeatures host_query_reset_features;
     VkPhysicalDeviceShaderDrawParametersFeatures draw_parameters_features;
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features;
 
     VkPhysicalDeviceFeatures2 features2;
 };
@@ -338,6 +356,7 @@ static void get_physical_device_info(const struct wined3d_adapter_vk *adapter_vk
 {
     VkPhysicalDeviceVertexAttributeDivisorFeaturesEXT *vertex_divisor_features = &info->vertex_divisor_features;
     VkPhysicalDeviceShaderDrawParametersFeatures *draw_parameters_features = &info->draw_parameters_features;
+    VkPhysicalDeviceTimelineSemaphoreFeatures *timeline_semaphore_features = &info->timeline_semaphore_features;
     VkPhysicalDeviceHostQueryResetFeatures *host_query_reset_features = &info->host_query_reset_features;
     VkPhysicalDeviceTransformFeedbackFeaturesEXT *xfb_features = &info->xfb_features;
     VkPhysicalDevice physical_device = adapter_vk->physical_device;
@@ -361,8 +380,11 @@ static void get_physical_device_info(const struct wined3d_adapter_vk *adapter_vk
     host_query_reset_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
     host_query_reset_features->pNext = vertex_divisor_features;
 
+    timeline_semaphore_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timeline_semaphore_features->pNext = host_query_reset_features;
+
     features2->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-    features2->pNext = host_query_reset_features;
+    features2->pNext = timeline_semaphore_features;
 
     if (vk_info->vk_ops.vkGetPhysicalDeviceFeatures2)
         VK_CALL(vkGetPhysicalDeviceFeatures2(physical_device, features2));
@@ -381,10 +403,13 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     static const float priorities[] = {1.0f};
     struct wined3d_device_vk *device_vk;
     VkDevice vk_device = VK_NULL_HANDLE;
-    VkDeviceQueueCreateInfo queue_info;
+    VkDeviceQueueCreateInfo queue_info[2];
+    uint32_t transfer_queue_family_index;
     VkPhysicalDevice physical_device;
+    VkExtent3D transfer_granularity;
     VkDeviceCreateInfo device_info;
     uint32_t queue_family_index;
+    uint32_t queue_info_count;
     uint32_t timestamp_bits;
     VkResult vr;
     HRESULT hr;
@@ -392,26 +417,40 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     if (!(device_vk = heap_alloc_zero(sizeof(*device_vk))))
         return E_OUTOFMEMORY;
 
-    if (FAILED(hr = wined3d_select_vulkan_queue_family(adapter_vk, &queue_family_index, &timestamp_bits)))
+    if (FAILED(hr = wined3d_select_vulkan_queue_family(adapter_vk, &queue_family_index, &timestamp_bits,
+            &transfer_queue_family_index, &transfer_granularity)))
         goto fail;
 
+    /* The transfer queue hands uploads off to the graphics queue through
+     * timeline semaphores. */
+    if (!wined3d_settings.transfer_queue || !vk_info->supported[WINED3D_VK_KHR_TIMELINE_SEMAPHORE])
+        transfer_queue_family_index = ~0u;
+
     physical_device = adapter_vk->physical_device;
 
     get_physical_device_info(adapter_vk, &physical_device_info);
     wined3d_disable_vulkan_features(&physical_device_info);
 
-    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queue_info.pNext = NULL;
-    queue_info.flags = 0;
-    queue_info.queueFamilyIndex = queue_family_index;
-    queue_info.queueCount = ARRAY_SIZE(priorities);
-    queue_info.pQueuePriorities = priorities;
+    queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info[0].pNext = NULL;
+    queue_info[0].flags = 0;
+    queue_info[0].queueFamilyIndex = queue_family_index;
+    queue_info[0].queueCount = ARRAY_SIZE(priorities);
+    queue_info[0].pQueuePriorities = priorities;
+    queue_info_count = 1;
+
+    if (transfer_queue_family_index != ~0u)
+    {
+        queue_info[1] = queue_info[0];
+        queue_info[1].queueFamilyIndex = transfer_queue_family_index;
+        queue_info_count = 2;
+    }
 
     device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_info.pNext = physical_device_info.features2.pNext;
     device_info.flags = 0;
-    device_info.queueCreateInfoCount = 1;
-    device_info.pQueueCreateInfos = &queue_info;
+    device_info.queueCreateInfoCount = queue_info_count;
+    device_info.pQueueCreateInfos = queue_info;
     device_info.enabledLayerCount = 0;
     device_info.ppEnabledLayerNames = NULL;
     device_info.enabledExtensionCount = adapter_vk->device_extension_count;
@@ -430,6 +469,12 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     VK_CALL(vkGetDeviceQueue(vk_device, queue_family_index, 0, &device_vk->vk_queue));
     device_vk->vk_queue_family_index = queue_family_index;
     device_vk->timestamp_bits = timestamp_bits;
+    if (transfer_queue_family_index != ~0u)
+    {
+        VK_CALL(vkGetDeviceQueue(vk_device, transfer_queue_family_index, 0, &device_vk->vk_transfer_queue));
+        device_vk->vk_transfer_queue_family_index = transfer_queue_family_index;
+        device_vk->transfer_granularity = transfer_granularity;
+    }
 
     device_vk->vk_info = *vk_info;
 #define VK_DEVICE_PFN(name) \
@@ -2271,6 +2316,9 @@ static void wined3d_adapter_vk_init_d3d_info(struct wined3d_adapter_vk *adapter_
     if (!device_info.xfb_features.transformFeedback)
         adapter_vk->vk_info.supported[WINED3D_VK_EXT_TRANSFORM_FEEDBACK] = FALSE;
 
+    if (!device_info.timeline_semaphore_features.timelineSemaphore)
+        adapter_vk->vk_info.supported[WINED3D_VK_KHR_TIMELINE_SEMAPHORE] = FALSE;
+
     adapter_vk->a.shader_backend->shader_get_caps(&adapter_vk->a, &shader_caps);
     adapter_vk->a.vertex_pipe->vp_get_caps(&adapter_vk->a, &vertex_caps);
     adapter_vk->a.fragment_pipe->get_caps(&adapter_vk->a, &d3d_info->ffp_fragment_caps);
@@ -2363,6 +2411,7 @@ static bool wined3d_adapter_vk_init_device_extensions(struct wined3d_adapter_vk
         {VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,      VK_API_VERSION_1_1},
         {VK_KHR_SWAPCHAIN_EXTENSION_NAME,                   ~0u,                true},
         {VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME,            VK_API_VERSION_1_2},
+        {VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,          VK_API_VERSION_1_2},
     };
 
     static const struct
@@ -2376,6 +2425,7 @@ static bool wined3d_adapter_vk_init_device_extensions(struct wined3d_adapter_vk
         {VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE_EXTENSION_NAME, WINED3D_VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE},
         {VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,       WINED3D_VK_KHR_SHADER_DRAW_PARAMETERS},
         {VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME,             WINED3D_VK_EXT_HOST_QUERY_RESET},
+        {VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,           WINED3D_VK_KHR_TIMELINE_SEMAPHORE},
     };
 
     if ((vr = VK_CALL(vkEnumerateDeviceExtensionProperties(physical_device, NULL, &count, NULL))) < 0)
@@ -586,6 +586,7 @@ BOOL wined3d_context_vk_create_image(struct wined3d_context_vk *context_vk, VkIm
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     VkMemoryRequirements memory_requirements;
+    uint32_t queue_family_indices[2];
     VkImageCreateInfo create_info;
     unsigned int memory_type_idx;
     VkResult vr;
@@ -609,6 +610,22 @@ BOOL wined3d_context_vk_create_image(struct wined3d_context_vk *context_vk, VkIm
     create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
     image->command_buffer_id = 0;
+    image->transfer_id = 0;
+    image->concurrent = false;
+
+    /* Plain sampled images may be uploaded on the transfer queue. Sharing
+     * them between both queue families avoids queue family ownership
+     * transfers; render targets and UAVs stay exclusive. */
+    if (context_vk->transfer.vk_semaphore && sample_count == 1 && usage
+            == (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT))
+    {
+        queue_family_indices[0] = device_vk->vk_queue_family_index;
+        queue_family_indices[1] = device_vk->vk_transfer_queue_family_index;
+        create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        create_info.queueFamilyIndexCount = ARRAY_SIZE(queue_family_indices);
+        create_info.pQueueFamilyIndices = queue_family_indices;
+        image->concurrent = true;
+    }
 
     vr = VK_CALL(vkCreateImage(device_vk->vk_device, &create_info, NULL, &image->vk_image));
     if (vr != VK_SUCCESS)
@@ -1061,6 +1078,8 @@ void wined3d_context_vk_destroy_vk_event(struct wined3d_context_vk *context_vk,
 
 void wined3d_context_vk_destroy_image(struct wined3d_context_vk *context_vk, struct wined3d_image_vk *image)
 {
+    /* Retired objects are tracked by graphics command buffer id only. */
+    wined3d_context_vk_wait_transfer(context_vk, image->transfer_id);
     wined3d_context_vk_destroy_vk_image(context_vk, image->vk_image, image->command_buffer_id);
     if (image->memory)
         wined3d_context_vk_destroy_allocator_block(context_vk, image->memory,
@@ -1692,6 +1711,327 @@ done:
     return true;
 }
 
+static void wined3d_context_vk_poll_transfers(struct wined3d_context_vk *context_vk)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    struct wined3d_command_buffer_vk *buffer;
+    uint64_t value;
+    SIZE_T i;
+
+    if (VK_CALL(vkGetSemaphoreCounterValueKHR(device_vk->vk_device, transfer->vk_semaphore, &value)) < 0)
+        return;
+    transfer->completed_id = value;
+
+    for (i = 0; i < transfer->submitted.buffer_count;)
+    {
+        buffer = &transfer->submitted.buffers[i];
+        if (buffer->id > value)
+        {
+            ++i;
+            continue;
+        }
+
+        TRACE("Transfer command buffer %p with id 0x%s has finished.\n",
+                buffer->vk_command_buffer, wine_dbgstr_longlong(buffer->id));
+        if (wined3d_array_reserve((void **)&transfer->completed.buffers, &transfer->completed.buffers_size,
+                transfer->completed.buffer_count + 1, sizeof(*transfer->completed.buffers)))
+            transfer->completed.buffers[transfer->completed.buffer_count++] = *buffer;
+        else
+            VK_CALL(vkFreeCommandBuffers(device_vk->vk_device,
+                    transfer->vk_command_pool, 1, &buffer->vk_command_buffer));
+        *buffer = transfer->submitted.buffers[--transfer->submitted.buffer_count];
+    }
+
+    for (i = 0; i < transfer->staging.region_count; ++i)
+    {
+        if (transfer->staging.regions[i].transfer_id > value)
+            break;
+        transfer->staging_tail = transfer->staging.regions[i].end;
+    }
+
+    if (!(transfer->staging.region_count -= i))
+        transfer->staging_head = transfer->staging_tail = 0;
+    else if (i)
+        memmove(transfer->staging.regions, &transfer->staging.regions[i],
+                transfer->staging.region_count * sizeof(*transfer->staging.regions));
+}
+
+void wined3d_context_vk_submit_transfer_command_buffer(struct wined3d_context_vk *context_vk)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkTimelineSemaphoreSubmitInfo timeline_info;
+    struct wined3d_command_buffer_vk *buffer;
+    VkPipelineStageFlags wait_stage;
+    VkSubmitInfo submit_info;
+    VkResult vr;
+
+    buffer = &transfer->current_command_buffer;
+    if (!buffer->vk_command_buffer)
+        return;
+
+    TRACE("Submitting transfer command buffer %p with id 0x%s, waiting for command buffer 0x%s.\n",
+            buffer->vk_command_buffer, wine_dbgstr_longlong(buffer->id),
+            wine_dbgstr_longlong(transfer->wait_command_buffer_id));
+
+    VK_CALL(vkEndCommandBuffer(buffer->vk_command_buffer));
+
+    wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.pNext = NULL;
+    timeline_info.waitSemaphoreValueCount = transfer->wait_command_buffer_id ? 1 : 0;
+    timeline_info.pWaitSemaphoreValues = &transfer->wait_command_buffer_id;
+    timeline_info.signalSemaphoreValueCount = 1;
+    timeline_info.pSignalSemaphoreValues = &buffer->id;
+
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
+    submit_info.waitSemaphoreCount = timeline_info.waitSemaphoreValueCount;
+    submit_info.pWaitSemaphores = &transfer->vk_graphics_semaphore;
+    submit_info.pWaitDstStageMask = &wait_stage;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &buffer->vk_command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &transfer->vk_semaphore;
+
+    if ((vr = VK_CALL(vkQueueSubmit(device_vk->vk_transfer_queue, 1, &submit_info, VK_NULL_HANDLE))) < 0)
+        ERR("Failed to submit transfer command buffer %p, vr %s.\n",
+                buffer->vk_command_buffer, wined3d_debug_vkresult(vr));
+
+    if (wined3d_array_reserve((void **)&transfer->submitted.buffers, &transfer->submitted.buffers_size,
+            transfer->submitted.buffer_count + 1, sizeof(*transfer->submitted.buffers)))
+    {
+        transfer->submitted.buffers[transfer->submitted.buffer_count++] = *buffer;
+    }
+    else
+    {
+        VkSemaphoreWaitInfo wait_info;
+
+        /* We can't track the command buffer; wait for it and free it right away. */
+        ERR("Failed to grow submitted transfer command buffer array.\n");
+        if (vr < 0)
+        {
+            VK_CALL(vkFreeCommandBuffers(device_vk->vk_device, transfer->vk_command_pool, 1, &buffer->vk_command_buffer));
+        }
+        else
+        {
+            wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            wait_info.pNext = NULL;
+            wait_info.flags = 0;
+            wait_info.semaphoreCount = 1;
+            wait_info.pSemaphores = &transfer->vk_semaphore;
+            wait_info.pValues = &buffer->id;
+            if ((vr = VK_CALL(vkWaitSemaphoresKHR(device_vk->vk_device, &wait_info, UINT64_MAX))) < 0)
+                ERR("Failed to wait for transfer 0x%s, vr %s.\n",
+                        wine_dbgstr_longlong(buffer->id), wined3d_debug_vkresult(vr));
+            else
+                VK_CALL(vkFreeCommandBuffers(device_vk->vk_device, transfer->vk_command_pool,
+                        1, &buffer->vk_command_buffer));
+        }
+    }
+
+    buffer->vk_command_buffer = VK_NULL_HANDLE;
+    ++buffer->id;
+    transfer->wait_command_buffer_id = 0;
+    transfer->pending_size = 0;
+}
+
+void wined3d_context_vk_wait_transfer(struct wined3d_context_vk *context_vk, uint64_t id)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkSemaphoreWaitInfo wait_info;
+    VkResult vr;
+
+    if (id <= transfer->completed_id)
+        return;
+
+    if (id == transfer->current_command_buffer.id)
+        wined3d_context_vk_submit_transfer_command_buffer(context_vk);
+
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.pNext = NULL;
+    wait_info.flags = 0;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &transfer->vk_semaphore;
+    wait_info.pValues = &id;
+    if ((vr = VK_CALL(vkWaitSemaphoresKHR(device_vk->vk_device, &wait_info, UINT64_MAX))) < 0)
+        ERR("Failed to wait for transfer 0x%s, vr %s.\n", wine_dbgstr_longlong(id), wined3d_debug_vkresult(vr));
+
+    wined3d_context_vk_poll_transfers(context_vk);
+}
+
+VkCommandBuffer wined3d_context_vk_get_transfer_command_buffer(struct wined3d_context_vk *context_vk,
+        struct wined3d_image_vk *image)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    struct wined3d_command_buffer_vk *buffer;
+    VkCommandBufferBeginInfo begin_info;
+    VkResult vr;
+
+    if (!transfer->vk_semaphore || !image->concurrent)
+        return VK_NULL_HANDLE;
+
+    /* Work recorded on the transfer queue can't be ordered after commands in
+     * the graphics command buffer that is still being recorded. */
+    if (image->command_buffer_id == context_vk->current_command_buffer.id)
+        return VK_NULL_HANDLE;
+
+    buffer = &transfer->current_command_buffer;
+    if (!buffer->vk_command_buffer)
+    {
+        if (transfer->completed.buffer_count)
+        {
+            buffer->vk_command_buffer = transfer->completed.buffers[--transfer->completed.buffer_count].vk_command_buffer;
+        }
+        else
+        {
+            VkCommandBufferAllocateInfo command_buffer_info;
+
+            command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            command_buffer_info.pNext = NULL;
+            command_buffer_info.commandPool = transfer->vk_command_pool;
+            command_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            command_buffer_info.commandBufferCount = 1;
+            if ((vr = VK_CALL(vkAllocateCommandBuffers(device_vk->vk_device,
+                    &command_buffer_info, &buffer->vk_command_buffer))) < 0)
+            {
+                WARN("Failed to allocate transfer command buffer, vr %s.\n", wined3d_debug_vkresult(vr));
+                return buffer->vk_command_buffer = VK_NULL_HANDLE;
+            }
+        }
+
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.pNext = NULL;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        begin_info.pInheritanceInfo = NULL;
+        if ((vr = VK_CALL(vkBeginCommandBuffer(buffer->vk_command_buffer, &begin_info))) < 0)
+        {
+            WARN("Failed to begin transfer command buffer, vr %s.\n", wined3d_debug_vkresult(vr));
+            VK_CALL(vkFreeCommandBuffers(device_vk->vk_device, transfer->vk_command_pool,
+                    1, &buffer->vk_command_buffer));
+            return buffer->vk_command_buffer = VK_NULL_HANDLE;
+        }
+
+        TRACE("Created new transfer command buffer %p with id 0x%s.\n",
+                buffer->vk_command_buffer, wine_dbgstr_longlong(buffer->id));
+    }
+
+    /* Wait for earlier graphics work using the image; uploads are always
+     * write operations. */
+    if (image->command_buffer_id > context_vk->completed_command_buffer_id
+            && image->command_buffer_id > transfer->wait_command_buffer_id)
+        transfer->wait_command_buffer_id = image->command_buffer_id;
+    image->transfer_id = buffer->id;
+
+    return buffer->vk_command_buffer;
+}
+
+bool wined3d_context_vk_allocate_staging_memory(struct wined3d_context_vk *context_vk,
+        VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset)
+{
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    struct wined3d_staging_region_vk *region;
+    VkDeviceSize start;
+
+    if (!transfer->vk_semaphore || size > WINED3D_TRANSFER_STAGING_SIZE / 2)
+        return false;
+
+    if (!transfer->staging_bo.vk_buffer && !wined3d_context_vk_create_bo(context_vk, WINED3D_TRANSFER_STAGING_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &transfer->staging_bo))
+    {
+        ERR("Failed to create staging bo.\n");
+        transfer->staging_bo.vk_buffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    wined3d_context_vk_poll_transfers(context_vk);
+
+    for (;;)
+    {
+        if (!transfer->staging.region_count)
+        {
+            start = 0;
+            break;
+        }
+
+        /* Used space is [tail, head) if head > tail, and [tail, end) + [0, head)
+         * otherwise. Never let head catch up with tail, so that a full ring can
+         * be distinguished from an empty one. */
+        start = transfer->staging_head + alignment - 1;
+        start -= start % alignment;
+        if (transfer->staging_head > transfer->staging_tail)
+        {
+            if (start + size <= WINED3D_TRANSFER_STAGING_SIZE)
+                break;
+            if (size < transfer->staging_tail)
+            {
+                start = 0;
+                break;
+            }
+        }
+        else if (start + size < transfer->staging_tail)
+        {
+            break;
+        }
+
+        /* Don't submit the transfer command buffer from under the caller;
+         * let it fall back to an upload on the graphics queue instead. */
+        region = &transfer->staging.regions[0];
+        if (region->transfer_id == transfer->current_command_buffer.id)
+            return false;
+        TRACE("Staging ring is full, waiting for transfer 0x%s.\n", wine_dbgstr_longlong(region->transfer_id));
+        wined3d_context_vk_wait_transfer(context_vk, region->transfer_id);
+    }
+
+    region = transfer->staging.region_count ? &transfer->staging.regions[transfer->staging.region_count - 1] : NULL;
+    if (!region || region->transfer_id != transfer->current_command_buffer.id)
+    {
+        if (!wined3d_array_reserve((void **)&transfer->staging.regions, &transfer->staging.regions_size,
+                transfer->staging.region_count + 1, sizeof(*transfer->staging.regions)))
+            return false;
+        region = &transfer->staging.regions[transfer->staging.region_count++];
+        region->transfer_id = transfer->current_command_buffer.id;
+    }
+    region->end = start + size;
+
+    transfer->staging_head = start + size;
+    transfer->pending_size += size;
+    *offset = start;
+
+    return true;
+}
+
+static void wined3d_context_vk_cleanup_transfer(struct wined3d_context_vk *context_vk)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    SIZE_T i;
+
+    wined3d_context_vk_submit_transfer_command_buffer(context_vk);
+    wined3d_context_vk_wait_transfer(context_vk, transfer->current_command_buffer.id - 1);
+
+    for (i = 0; i < transfer->completed.buffer_count; ++i)
+        VK_CALL(vkFreeCommandBuffers(device_vk->vk_device, transfer->vk_command_pool,
+                1, &transfer->completed.buffers[i].vk_command_buffer));
+    VK_CALL(vkDestroyCommandPool(device_vk->vk_device, transfer->vk_command_pool, NULL));
+    VK_CALL(vkDestroySemaphore(device_vk->vk_device, transfer->vk_semaphore, NULL));
+    VK_CALL(vkDestroySemaphore(device_vk->vk_device, transfer->vk_graphics_semaphore, NULL));
+    if (transfer->staging_bo.vk_buffer)
+        wined3d_context_vk_destroy_bo(context_vk, &transfer->staging_bo);
+    heap_free(transfer->submitted.buffers);
+    heap_free(transfer->completed.buffers);
+    heap_free(transfer->staging.regions);
+}
+
 void wined3d_context_vk_cleanup(struct wined3d_context_vk *context_vk)
 {
     struct wined3d_command_buffer_vk *buffer = &context_vk->current_command_buffer;
@@ -1710,6 +2050,9 @@ void wined3d_context_vk_cleanup(struct wined3d_context_vk *context_vk)
     for (i = 0; i < context_vk->completed.buffer_count; ++i)
         free_command_buffer(context_vk, &context_vk->completed.buffers[i]);
 
+    if (context_vk->transfer.vk_semaphore)
+        wined3d_context_vk_cleanup_transfer(context_vk);
+
     heap_free(context_vk->compute.bindings.bindings);
     heap_free(context_vk->graphics.bindings.bindings);
     for (i = 0; i < context_vk->vk_descriptor_pool_count; ++i)
@@ -1835,10 +2178,17 @@ void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context
         unsigned int signal_semaphore_count, const VkSemaphore *signal_semaphores)
 {
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_query_pool_vk *pool_vk, *pool_vk_next;
+    VkPipelineStageFlags vk_wait_stages[2];
+    VkTimelineSemaphoreSubmitInfo timeline_info;
+    VkSemaphore vk_signal_semaphores[2];
     struct wined3d_command_buffer_vk *buffer;
+    VkSemaphore vk_wait_semaphores[2];
     struct wined3d_query_vk *query_vk;
+    uint64_t signal_values[2];
+    uint64_t wait_values[2];
     VkSubmitInfo submit_info;
     VkResult vr;
 
@@ -1847,6 +2197,10 @@ void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context
             context_vk, wait_semaphore_count, wait_semaphores, wait_stages,
             signal_semaphore_count, signal_semaphores);
 
+    /* Uploads this command buffer depends on need to be submitted first. */
+    if (transfer->vk_semaphore)
+        wined3d_context_vk_submit_transfer_command_buffer(context_vk);
+
     buffer = &context_vk->current_command_buffer;
     if (!buffer->vk_command_buffer)
         return;
@@ -1894,6 +2248,53 @@ void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context
     submit_info.signalSemaphoreCount = signal_semaphore_count;
     submit_info.pSignalSemaphores = signal_semaphores;
 
+    if (transfer->vk_semaphore)
+    {
+        unsigned int i;
+
+        assert(wait_semaphore_count < ARRAY_SIZE(vk_wait_semaphores));
+        assert(signal_semaphore_count < ARRAY_SIZE(vk_signal_semaphores));
+
+        /* Values for binary semaphores are ignored. */
+        for (i = 0; i < wait_semaphore_count; ++i)
+        {
+            vk_wait_semaphores[i] = wait_semaphores[i];
+            vk_wait_stages[i] = wait_stages[i];
+            wait_values[i] = 0;
+        }
+        for (i = 0; i < signal_semaphore_count; ++i)
+        {
+            vk_signal_semaphores[i] = signal_semaphores[i];
+            signal_values[i] = 0;
+        }
+
+        if (transfer->graphics_wait_id > transfer->completed_id)
+        {
+            TRACE("Waiting for transfer 0x%s.\n", wine_dbgstr_longlong(transfer->graphics_wait_id));
+            vk_wait_semaphores[wait_semaphore_count] = transfer->vk_semaphore;
+            vk_wait_stages[wait_semaphore_count] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            wait_values[wait_semaphore_count++] = transfer->graphics_wait_id;
+        }
+        transfer->graphics_wait_id = 0;
+
+        vk_signal_semaphores[signal_semaphore_count] = transfer->vk_graphics_semaphore;
+        signal_values[signal_semaphore_count++] = buffer->id;
+
+        timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_info.pNext = NULL;
+        timeline_info.waitSemaphoreValueCount = wait_semaphore_count;
+        timeline_info.pWaitSemaphoreValues = wait_values;
+        timeline_info.signalSemaphoreValueCount = signal_semaphore_count;
+        timeline_info.pSignalSemaphoreValues = signal_values;
+
+        submit_info.pNext = &timeline_info;
+        submit_info.waitSemaphoreCount = wait_semaphore_count;
+        submit_info.pWaitSemaphores = vk_wait_semaphores;
+        submit_info.pWaitDstStageMask = vk_wait_stages;
+        submit_info.signalSemaphoreCount = signal_semaphore_count;
+        submit_info.pSignalSemaphores = vk_signal_semaphores;
+    }
+
     if ((vr = VK_CALL(vkQueueSubmit(device_vk->vk_queue, 1, &submit_info, buffer->vk_fence))) < 0)
         ERR("Failed to submit command buffer %p, vr %s.\n",
                 buffer->vk_command_buffer, wined3d_debug_vkresult(vr));
@@ -1914,6 +2315,8 @@ void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context
     }
     context_vk->retired_bo_size = 0;
     wined3d_context_vk_cleanup_resources(context_vk, VK_NULL_HANDLE);
+    if (transfer->vk_semaphore)
+        wined3d_context_vk_poll_transfers(context_vk);
 }
 
 void wined3d_context_vk_wait_command_buffer(struct wined3d_context_vk *context_vk, uint64_t id)
@@ -3870,6 +4273,68 @@ VkCommandBuffer wined3d_context_vk_apply_compute_state(struct wined3d_context_vk
     return vk_command_buffer;
 }
 
+static void wined3d_context_vk_init_transfer(struct wined3d_context_vk *context_vk)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkCommandPoolCreateInfo command_pool_info;
+    VkSemaphoreTypeCreateInfo semaphore_type;
+    VkSemaphoreCreateInfo semaphore_info;
+    VkResult vr;
+
+    if (!device_vk->vk_transfer_queue)
+        return;
+
+    if (!vk_info->vk_ops.vkGetSemaphoreCounterValueKHR || !vk_info->vk_ops.vkWaitSemaphoresKHR)
+    {
+        WARN("Timeline semaphore functions are not available.\n");
+        return;
+    }
+
+    command_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_info.pNext = NULL;
+    command_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    command_pool_info.queueFamilyIndex = device_vk->vk_transfer_queue_family_index;
+    if ((vr = VK_CALL(vkCreateCommandPool(device_vk->vk_device,
+            &command_pool_info, NULL, &transfer->vk_command_pool))) < 0)
+    {
+        WARN("Failed to create transfer command pool, vr %s.\n", wined3d_debug_vkresult(vr));
+        return;
+    }
+
+    semaphore_type.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphore_type.pNext = NULL;
+    semaphore_type.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphore_type.initialValue = 0;
+
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &semaphore_type;
+    semaphore_info.flags = 0;
+
+    if ((vr = VK_CALL(vkCreateSemaphore(device_vk->vk_device,
+            &semaphore_info, NULL, &transfer->vk_graphics_semaphore))) < 0)
+    {
+        WARN("Failed to create timeline semaphore, vr %s.\n", wined3d_debug_vkresult(vr));
+        VK_CALL(vkDestroyCommandPool(device_vk->vk_device, transfer->vk_command_pool, NULL));
+        return;
+    }
+
+    if ((vr = VK_CALL(vkCreateSemaphore(device_vk->vk_device,
+            &semaphore_info, NULL, &transfer->vk_semaphore))) < 0)
+    {
+        WARN("Failed to create timeline semaphore, vr %s.\n", wined3d_debug_vkresult(vr));
+        VK_CALL(vkDestroySemaphore(device_vk->vk_device, transfer->vk_graphics_semaphore, NULL));
+        VK_CALL(vkDestroyCommandPool(device_vk->vk_device, transfer->vk_command_pool, NULL));
+        transfer->vk_semaphore = VK_NULL_HANDLE;
+        return;
+    }
+
+    transfer->current_command_buffer.id = 1;
+
+    TRACE("Using transfer queue %p.\n", device_vk->vk_transfer_queue);
+}
+
 HRESULT wined3d_context_vk_init(struct wined3d_context_vk *context_vk, struct wined3d_swapchain *swapchain)
 {
     VkCommandPoolCreateInfo command_pool_info;
@@ -3899,6 +4364,7 @@ HRESULT wined3d_context_vk_init(struct wined3d_context_vk *context_vk, struct wi
     }
     context_vk->current_command_buffer.id = 1;
 
+    wined3d_context_vk_init_transfer(context_vk);
     wined3d_context_vk_init_graphics_pipeline_key(context_vk);
 
     list_init(&context_vk->render_pass_queries);
@@ -20,6 +20,7 @@
 #include "wined3d_gl.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(cs_stats);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
@@ -638,6 +639,213 @@ static struct wined3d_cs_packet *wined3d_next_cs_packet(const uint8_t *data, SIZ
     return packet;
 }
 
+C_ASSERT(WINED3D_CS_OP_STOP <= WINED3D_CS_STATS_MAX_OPS);
+
+static void wined3d_cs_stats_init(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_stats *stats;
+    WCHAR name[64];
+    unsigned int i;
+
+    if (!(stats = heap_alloc_zero(sizeof(*stats))))
+        return;
+
+    QueryPerformanceFrequency(&stats->frequency);
+    QueryPerformanceCounter(&stats->frame_start);
+    stats->log_start = stats->frame_start;
+
+    if (wined3d_settings.cs_stats)
+    {
+        swprintf(name, ARRAY_SIZE(name), L"Local\\wined3d_cs_stats_%u", GetCurrentProcessId());
+        stats->mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                0, sizeof(*stats->shm), name);
+        if (stats->mapping && GetLastError() == ERROR_ALREADY_EXISTS)
+        {
+            /* Only the first device of the process publishes its statistics. */
+            CloseHandle(stats->mapping);
+            stats->mapping = NULL;
+        }
+        if (stats->mapping && !(stats->shm = MapViewOfFile(stats->mapping, FILE_MAP_WRITE, 0, 0, 0)))
+        {
+            ERR("Failed to map command stream statistics section.\n");
+            CloseHandle(stats->mapping);
+            stats->mapping = NULL;
+        }
+        if (stats->shm)
+        {
+            stats->shm->version = WINED3D_CS_STATS_VERSION;
+            stats->shm->size = sizeof(*stats->shm);
+            stats->shm->op_count = WINED3D_CS_OP_STOP;
+            stats->shm->frequency = stats->frequency.QuadPart;
+            for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+                lstrcpynA(stats->shm->op_names[i], debug_cs_op(i), WINED3D_CS_STATS_OP_NAME_SIZE);
+            TRACE("Publishing command stream statistics in %s.\n", debugstr_w(name));
+        }
+    }
+
+    cs->stats = stats;
+}
+
+static void wined3d_cs_stats_cleanup(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+
+    if (!stats)
+        return;
+
+    if (stats->shm)
+        UnmapViewOfFile(stats->shm);
+    if (stats->mapping)
+        CloseHandle(stats->mapping);
+    heap_free(stats);
+}
+
+static LONG64 wined3d_cs_stats_take(LONG64 *counter)
+{
+    LONG64 value;
+
+    do
+    {
+        value = *(volatile LONG64 *)counter;
+    } while (InterlockedCompareExchange64(counter, 0, value) != value);
+    return value;
+}
+
+static inline void wined3d_cs_stats_add_ticks(LONG64 *counter, LONGLONG start)
+{
+    InterlockedAdd64(counter, wined3d_cs_stats_time() - start);
+}
+
+static void wined3d_cs_stats_sample_queue(struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+    LONG occupancy, max;
+
+    occupancy = (queue->head - *(volatile ULONG *)&queue->tail) & WINED3D_CS_QUEUE_MASK;
+    InterlockedAdd64(&stats->occupancy_sum, occupancy);
+    InterlockedIncrement(&stats->occupancy_samples);
+    while (occupancy > (max = stats->occupancy_max)
+            && InterlockedCompareExchange(&stats->occupancy_max, occupancy, max) != max)
+        ;
+}
+
+static void wined3d_cs_stats_log(struct wined3d_cs_stats *stats, LONGLONG now)
+{
+    const struct wined3d_cs_stats_shm *totals = &stats->totals;
+    double ms = 1000.0 / stats->frequency.QuadPart;
+    unsigned int i, j, top[5], top_count = 0;
+
+    TRACE_(cs_stats)("%u frames, %.3f ms/frame, exec %.3f ms/frame, require_space %.3f ms/frame, "
+            "finish %u (%.3f ms/frame), map syncs %u (%.3f ms/frame), queue %u bytes avg, %u max.\n",
+            stats->log_frames, totals->frame_ticks * ms / stats->log_frames,
+            totals->exec_ticks * ms / stats->log_frames, totals->require_space_ticks * ms / stats->log_frames,
+            totals->finish_count, totals->finish_ticks * ms / stats->log_frames,
+            totals->map_sync_count, totals->map_sync_ticks * ms / stats->log_frames,
+            totals->queue_occupancy_avg / stats->log_frames, totals->queue_occupancy_max);
+
+    /* Report the most expensive ops. */
+    for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+    {
+        if (!totals->ops[i].count)
+            continue;
+        for (j = top_count; j > 0 && totals->ops[top[j - 1]].ticks < totals->ops[i].ticks; --j)
+        {
+            if (j < ARRAY_SIZE(top))
+                top[j] = top[j - 1];
+        }
+        if (j < ARRAY_SIZE(top))
+        {
+            top[j] = i;
+            top_count = min(top_count + 1, ARRAY_SIZE(top));
+        }
+    }
+    for (i = 0; i < top_count; ++i)
+    {
+        TRACE_(cs_stats)("    %s: %.1f/frame, %.3f ms/frame, %.2f us/op.\n", debug_cs_op(top[i]),
+                (double)totals->ops[top[i]].count / stats->log_frames,
+                totals->ops[top[i]].ticks * ms / stats->log_frames,
+                totals->ops[top[i]].ticks * ms * 1000.0 / totals->ops[top[i]].count);
+    }
+
+    memset(&stats->totals, 0, sizeof(stats->totals));
+    stats->log_frames = 0;
+    stats->log_start.QuadPart = now;
+}
+
+/* Called by the thread executing the commands at the end of each frame. */
+static void wined3d_cs_stats_end_frame(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+    struct wined3d_cs_stats_shm frame = {0};
+    LONG samples;
+    LONGLONG now;
+    unsigned int i;
+
+    now = wined3d_cs_stats_time();
+    frame.frame = ++stats->frame;
+    frame.frame_ticks = now - stats->frame_start.QuadPart;
+    stats->frame_start.QuadPart = now;
+
+    frame.require_space_ticks = wined3d_cs_stats_take(&stats->require_space_ticks);
+    frame.finish_ticks = wined3d_cs_stats_take(&stats->finish_ticks);
+    frame.map_sync_ticks = wined3d_cs_stats_take(&stats->map_sync_ticks);
+    frame.finish_count = InterlockedExchange(&stats->finish_count, 0);
+    frame.map_sync_count = InterlockedExchange(&stats->map_sync_count, 0);
+    frame.queue_occupancy_max = InterlockedExchange(&stats->occupancy_max, 0);
+    samples = InterlockedExchange(&stats->occupancy_samples, 0);
+    frame.queue_occupancy_avg = samples ? wined3d_cs_stats_take(&stats->occupancy_sum) / samples : 0;
+    for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+    {
+        frame.ops[i].count = stats->ops[i].count;
+        frame.ops[i].ticks = stats->ops[i].ticks;
+        frame.exec_ticks += stats->ops[i].ticks;
+        stats->ops[i].count = 0;
+        stats->ops[i].ticks = 0;
+    }
+
+    if (stats->shm)
+    {
+        struct wined3d_cs_stats_shm *shm = stats->shm;
+
+        InterlockedIncrement(&shm->sequence);
+        shm->frame = frame.frame;
+        shm->frame_ticks = frame.frame_ticks;
+        shm->exec_ticks = frame.exec_ticks;
+        shm->require_space_ticks = frame.require_space_ticks;
+        shm->finish_ticks = frame.finish_ticks;
+        shm->map_sync_ticks = frame.map_sync_ticks;
+        shm->finish_count = frame.finish_count;
+        shm->map_sync_count = frame.map_sync_count;
+        shm->queue_occupancy_avg = frame.queue_occupancy_avg;
+        shm->queue_occupancy_max = frame.queue_occupancy_max;
+        memcpy(shm->ops, frame.ops, sizeof(shm->ops));
+        InterlockedIncrement(&shm->sequence);
+    }
+
+    if (!TRACE_ON(cs_stats))
+        return;
+
+    stats->totals.frame_ticks += frame.frame_ticks;
+    stats->totals.exec_ticks += frame.exec_ticks;
+    stats->totals.require_space_ticks += frame.require_space_ticks;
+    stats->totals.finish_ticks += frame.finish_ticks;
+    stats->totals.map_sync_ticks += frame.map_sync_ticks;
+    stats->totals.finish_count += frame.finish_count;
+    stats->totals.map_sync_count += frame.map_sync_count;
+    stats->totals.queue_occupancy_avg += frame.queue_occupancy_avg;
+    stats->totals.queue_occupancy_max = max(stats->totals.queue_occupancy_max, frame.queue_occupancy_max);
+    for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+    {
+        stats->totals.ops[i].count += frame.ops[i].count;
+        stats->totals.ops[i].ticks += frame.ops[i].ticks;
+    }
+    ++stats->log_frames;
+
+    /* every 1.5 seconds */
+    if ((now - stats->log_start.QuadPart) * 2 > stats->frequency.QuadPart * 3)
+        wined3d_cs_stats_log(stats, now);
+}
+
 static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
@@ -736,6 +944,9 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
         }
     }
 
+    if (cs->stats)
+        wined3d_cs_stats_end_frame(cs);
+
     InterlockedDecrement(&cs->pending_presents);
     if (InterlockedCompareExchange(&cs->waiting_for_present, FALSE, TRUE))
         SetEvent(cs->present_event);
@@ -2471,7 +2682,9 @@ HRESULT wined3d_device_context_emit_map(struct wined3d_device_context *context,
         struct wined3d_resource *resource, unsigned int sub_resource_idx,
         struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags)
 {
+    struct wined3d_cs_stats *stats;
     struct wined3d_cs_map *op;
+    LONGLONG start = 0;
     HRESULT hr;
 
     /* Mapping resources from the worker thread isn't an issue by itself, but
@@ -2488,6 +2701,12 @@ HRESULT wined3d_device_context_emit_map(struct wined3d_device_context *context,
 
     TRACE_(d3d_perf)("Mapping resource %p (type %u), flags %#x through the CS.\n", resource, resource->type, flags);
 
+    if ((stats = context->device->cs->stats))
+    {
+        InterlockedIncrement(&stats->map_sync_count);
+        start = wined3d_cs_stats_time();
+    }
+
     wined3d_resource_wait_idle(resource);
 
     /* We might end up invalidating the resource on the CS thread. */
@@ -2506,6 +2725,9 @@ HRESULT wined3d_device_context_emit_map(struct wined3d_device_context *context,
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_MAP);
     wined3d_device_context_finish(context, WINED3D_CS_QUEUE_MAP);
 
+    if (stats)
+        wined3d_cs_stats_add_ticks(&stats->map_sync_ticks, start);
+
     if (SUCCEEDED(hr))
         wined3d_resource_get_sub_resource_map_pitch(resource, sub_resource_idx,
                 &map_desc->row_pitch, &map_desc->slice_pitch);
@@ -2973,6 +3195,26 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_EXECUTE_COMMAND_LIST        */ wined3d_cs_exec_execute_command_list,
 };
 
+static void wined3d_cs_exec_op(struct wined3d_cs *cs, enum wined3d_cs_op opcode, const void *data)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+    LONGLONG start;
+
+    /* Ops executed from within other ops are accounted to the outer op. */
+    if (!stats || stats->exec_depth)
+    {
+        wined3d_cs_op_handlers[opcode](cs, data);
+        return;
+    }
+
+    ++stats->exec_depth;
+    start = wined3d_cs_stats_time();
+    wined3d_cs_op_handlers[opcode](cs, data);
+    stats->ops[opcode].ticks += wined3d_cs_stats_time() - start;
+    ++stats->ops[opcode].count;
+    --stats->exec_depth;
+}
+
 void wined3d_device_context_emit_execute_command_list(struct wined3d_device_context *context,
         struct wined3d_command_list *list, bool restore_state)
 {
@@ -3035,7 +3277,7 @@ static void wined3d_cs_st_submit(struct wined3d_device_context *context, enum wi
     if (opcode >= WINED3D_CS_OP_STOP)
         ERR("Invalid opcode %#x.\n", opcode);
     else
-        wined3d_cs_op_handlers[opcode](cs, &data[start]);
+        wined3d_cs_exec_op(cs, opcode, &data[start]);
 
     if (cs->data == data)
         cs->start = cs->end = start;
@@ -3223,6 +3465,9 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
     InterlockedExchange((LONG *)&queue->head, queue->head + packet_size);
 
+    if (cs->stats && queue == &cs->queue[WINED3D_CS_QUEUE_DEFAULT])
+        wined3d_cs_stats_sample_queue(cs, queue);
+
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
     {
         if (pNtAlertThreadByThreadId)
@@ -3248,6 +3493,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
     ULONG head = queue->head & WINED3D_CS_QUEUE_MASK;
+    LONGLONG wait_start = 0;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
@@ -3294,10 +3540,16 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         if (new_pos < tail && new_pos)
             break;
 
+        if (!wait_start && cs->stats)
+            wait_start = wined3d_cs_stats_time();
+
         TRACE_(d3d_perf)("Waiting for free space. Head %lu, tail %lu, packet size %Iu.\n",
                 head, tail, packet_size);
     }
 
+    if (wait_start)
+        wined3d_cs_stats_add_ticks(&cs->stats->require_space_ticks, wait_start);
+
     packet = (struct wined3d_cs_packet *)&queue->data[head];
     packet->size = size;
     return packet->data;
@@ -3318,14 +3570,24 @@ static void wined3d_cs_mt_finish(struct wined3d_device_context *context, enum wi
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
     unsigned int spin_count = 0;
+    LONGLONG start = 0;
 
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(context, queue_id);
 
+    if (cs->stats)
+    {
+        start = wined3d_cs_stats_time();
+        InterlockedIncrement(&cs->stats->finish_count);
+    }
+
     TRACE_(d3d_perf)("Waiting for queue %u to be empty.\n", queue_id);
     while (cs->queue[queue_id].head != *(volatile ULONG *)&cs->queue[queue_id].tail)
         wined3d_pause(&spin_count);
     TRACE_(d3d_perf)("Queue is now empty.\n");
+
+    if (cs->stats)
+        wined3d_cs_stats_add_ticks(&cs->stats->finish_ticks, start);
 }
 
 static const struct wined3d_device_context_ops wined3d_cs_mt_ops =
@@ -3418,7 +3680,7 @@ static inline bool wined3d_cs_execute_next(struct wined3d_cs *cs, struct wined3d
         }
 
         wined3d_cs_command_lock(cs);
-        wined3d_cs_op_handlers[opcode](cs, packet->data);
+        wined3d_cs_exec_op(cs, opcode, packet->data);
         wined3d_cs_command_unlock(cs);
         TRACE("%s at %p executed.\n", debug_cs_op(opcode), packet);
     }
@@ -3564,6 +3826,9 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
 
     state_init(&cs->state, d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT, cs->c.state->feature_level);
 
+    if (TRACE_ON(cs_stats) || wined3d_settings.cs_stats)
+        wined3d_cs_stats_init(cs);
+
     cs->data_size = WINED3D_INITIAL_CS_SIZE;
     if (!(cs->data = heap_alloc(cs->data_size)))
         goto fail;
@@ -3630,6 +3895,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
     return cs;
 
 fail:
+    wined3d_cs_stats_cleanup(cs);
     wined3d_state_destroy(cs->c.state);
     state_cleanup(&cs->state);
     heap_free(cs);
@@ -3648,6 +3914,7 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
             ERR("Closing event failed.\n");
     }
 
+    wined3d_cs_stats_cleanup(cs);
     wined3d_state_destroy(cs->c.state);
     state_cleanup(&cs->state);
     heap_free(cs->data);
@@ -4910,6 +4910,149 @@ const VkDescriptorImageInfo *wined3d_texture_vk_get_default_image_info(struct wi
     return &texture_vk->default_image_info;
 }
 
+/* Barriers on the transfer queue. Queue family ownership doesn't need to be
+ * transferred, since images used there are created with concurrent sharing.
+ * Synchronisation with the graphics queue happens through semaphores. */
+static void wined3d_texture_vk_transfer_barrier(struct wined3d_context_vk *context_vk,
+        VkCommandBuffer vk_command_buffer, VkPipelineStageFlags src_stage_mask, VkAccessFlags src_access_mask,
+        VkImageLayout old_layout, VkImageLayout new_layout, VkImage image, const VkImageSubresourceRange *range)
+{
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkImageMemoryBarrier barrier;
+
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = src_access_mask;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = *range;
+
+    VK_CALL(vkCmdPipelineBarrier(vk_command_buffer, src_stage_mask,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier));
+}
+
+static bool wined3d_texture_vk_check_transfer_granularity(const struct wined3d_texture_vk *texture_vk,
+        const struct wined3d_device_vk *device_vk, unsigned int level, const VkOffset3D *offset,
+        const VkExtent3D *extent)
+{
+    const VkExtent3D *granularity = &device_vk->transfer_granularity;
+    const struct wined3d_format *format = texture_vk->t.resource.format;
+    unsigned int width, height, depth;
+
+    width = wined3d_texture_get_level_width(&texture_vk->t, level);
+    height = wined3d_texture_get_level_height(&texture_vk->t, level);
+    depth = wined3d_texture_get_level_depth(&texture_vk->t, level);
+
+    /* A zero granularity means only whole subresources can be copied. */
+    if (!granularity->width || !granularity->height || !granularity->depth)
+        return !offset->x && !offset->y && !offset->z
+                && extent->width == width && extent->height == height && extent->depth == depth;
+
+    /* For block-compressed formats the granularity is in blocks. */
+    if (offset->x % (granularity->width * format->block_width)
+            || offset->y % (granularity->height * format->block_height)
+            || offset->z % granularity->depth)
+        return false;
+
+    if ((extent->width % (granularity->width * format->block_width) && offset->x + extent->width != width)
+            || (extent->height % (granularity->height * format->block_height) && offset->y + extent->height != height)
+            || (extent->depth % granularity->depth && offset->z + extent->depth != depth))
+        return false;
+
+    return true;
+}
+
+/* Upload system memory data through the transfer queue. The staging copy
+ * comes from the transfer ring buffer, and graphics command buffers using
+ * the texture wait for the transfer through its timeline semaphore. */
+static bool wined3d_texture_vk_upload_data_async(struct wined3d_context_vk *context_vk,
+        const void *src_data, const struct wined3d_format *src_format, unsigned int src_row_pitch,
+        unsigned int src_slice_pitch, struct wined3d_texture_vk *dst_texture_vk,
+        const VkImageSubresourceRange *vk_range, const VkOffset3D *dst_offset, const VkExtent3D *extent)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    unsigned int staging_row_pitch, staging_slice_pitch;
+    struct wined3d_bo_address staging_bo_addr;
+    VkCommandBuffer vk_command_buffer;
+    VkDeviceSize staging_offset;
+    VkDeviceSize staging_size;
+    struct wined3d_range range;
+    VkBufferImageCopy region;
+    void *map_ptr;
+
+    if (!dst_texture_vk->image.concurrent)
+        return false;
+
+    if (!wined3d_texture_vk_check_transfer_granularity(dst_texture_vk, device_vk,
+            vk_range->baseMipLevel, dst_offset, extent))
+    {
+        TRACE("Copy doesn't match the transfer queue granularity.\n");
+        return false;
+    }
+
+    wined3d_format_calculate_pitch(src_format, 1, extent->width, extent->height,
+            &staging_row_pitch, &staging_slice_pitch);
+    staging_size = staging_slice_pitch * extent->depth;
+
+    if (!(vk_command_buffer = wined3d_context_vk_get_transfer_command_buffer(context_vk, &dst_texture_vk->image)))
+        return false;
+
+    /* Buffer offsets need to be aligned to both 4 and the texel block size. */
+    if (!wined3d_context_vk_allocate_staging_memory(context_vk, staging_size,
+            src_format->block_byte_count * 4, &staging_offset))
+        return false;
+
+    staging_bo_addr.buffer_object = &transfer->staging_bo.b;
+    staging_bo_addr.addr = (void *)(uintptr_t)staging_offset;
+    if (!(map_ptr = wined3d_context_map_bo_address(&context_vk->c, &staging_bo_addr,
+            staging_size, WINED3D_MAP_WRITE | WINED3D_MAP_NOOVERWRITE)))
+    {
+        ERR("Failed to map staging bo.\n");
+        return false;
+    }
+
+    wined3d_format_copy_data(src_format, src_data, src_row_pitch, src_slice_pitch,
+            map_ptr, staging_row_pitch, staging_slice_pitch, extent->width, extent->height, extent->depth);
+
+    range.offset = staging_offset;
+    range.size = staging_size;
+    wined3d_context_unmap_bo_address(&context_vk->c, &staging_bo_addr, 1, &range);
+
+    wined3d_texture_vk_transfer_barrier(context_vk, vk_command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            dst_texture_vk->layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            dst_texture_vk->image.vk_image, vk_range);
+
+    region.bufferOffset = transfer->staging_bo.b.buffer_offset + staging_offset;
+    region.bufferRowLength = (staging_row_pitch / src_format->block_byte_count) * src_format->block_width;
+    region.bufferImageHeight = (staging_slice_pitch / staging_row_pitch) * src_format->block_height;
+    region.imageSubresource.aspectMask = vk_range->aspectMask;
+    region.imageSubresource.mipLevel = vk_range->baseMipLevel;
+    region.imageSubresource.baseArrayLayer = vk_range->baseArrayLayer;
+    region.imageSubresource.layerCount = vk_range->layerCount;
+    region.imageOffset = *dst_offset;
+    region.imageExtent = *extent;
+
+    VK_CALL(vkCmdCopyBufferToImage(vk_command_buffer, transfer->staging_bo.vk_buffer,
+            dst_texture_vk->image.vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region));
+
+    wined3d_texture_vk_transfer_barrier(context_vk, vk_command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dst_texture_vk->layout,
+            dst_texture_vk->image.vk_image, vk_range);
+
+    if (transfer->pending_size >= WINED3D_TRANSFER_SUBMIT_THRESHOLD)
+        wined3d_context_vk_submit_transfer_command_buffer(context_vk);
+
+    return true;
+}
+
 static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
         const struct wined3d_const_bo_address *src_bo_addr, const struct wined3d_format *src_format,
         const struct wined3d_box *src_box, unsigned int src_row_pitch, unsigned int src_slice_pitch,
@@ -4986,6 +5129,22 @@ static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
             + (src_box->top / src_format->block_height) * src_row_pitch
             + (src_box->left / src_format->block_width) * src_format->block_byte_count;
 
+    vk_range.aspectMask = aspect_mask;
+    vk_range.baseMipLevel = dst_level;
+    vk_range.levelCount = 1;
+    vk_range.baseArrayLayer = dst_sub_resource_idx / dst_texture_vk->t.level_count;
+    vk_range.layerCount = 1;
+
+    if (!src_bo_addr->buffer_object)
+    {
+        VkOffset3D dst_offset = {dst_x, dst_y, dst_z};
+        VkExtent3D extent = {src_width, src_height, src_depth};
+
+        if (wined3d_texture_vk_upload_data_async(context_vk, src_bo_addr->addr + src_offset, src_format,
+                src_row_pitch, src_slice_pitch, dst_texture_vk, &vk_range, &dst_offset, &extent))
+            return;
+    }
+
     if (!(vk_command_buffer = wined3d_context_vk_get_command_buffer(context_vk)))
     {
         ERR("Failed to get command buffer.\n");
@@ -5054,12 +5213,6 @@ static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
                     VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &vk_barrier, 0, NULL));
     }
 
-    vk_range.aspectMask = aspect_mask;
-    vk_range.baseMipLevel = dst_level;
-    vk_range.levelCount = 1;
-    vk_range.baseArrayLayer = dst_sub_resource_idx / dst_texture_vk->t.level_count;
-    vk_range.layerCount = 1;
-
     wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
             vk_access_mask_from_bind_flags(dst_texture_vk->t.resource.bind_flags),
@@ -5452,6 +5605,7 @@ BOOL wined3d_texture_vk_prepare_texture(struct wined3d_texture_vk *texture_vk,
         struct wined3d_context_vk *context_vk)
 {
     const struct wined3d_format_vk *format_vk;
+    VkCommandBuffer vk_transfer_command_buffer;
     struct wined3d_resource *resource;
     VkCommandBuffer vk_command_buffer;
     VkImageSubresourceRange vk_range;
@@ -5541,12 +5695,23 @@ BOOL wined3d_texture_vk_prepare_texture(struct wined3d_texture_vk *texture_vk,
     vk_range.baseArrayLayer = 0;
     vk_range.layerCount = VK_REMAINING_ARRAY_LAYERS;
 
-    wined3d_context_vk_reference_texture(context_vk, texture_vk);
-    wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-            0, 0,
-            VK_IMAGE_LAYOUT_UNDEFINED, texture_vk->layout,
-            texture_vk->image.vk_image, &vk_range);
+    /* Images shared with the transfer queue are transitioned there, so that
+     * the initial upload doesn't have to wait for the graphics queue. */
+    if ((vk_transfer_command_buffer = wined3d_context_vk_get_transfer_command_buffer(context_vk, &texture_vk->image)))
+    {
+        wined3d_texture_vk_transfer_barrier(context_vk, vk_transfer_command_buffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, texture_vk->layout,
+                texture_vk->image.vk_image, &vk_range);
+    }
+    else
+    {
+        wined3d_context_vk_reference_texture(context_vk, texture_vk);
+        wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0, 0,
+                VK_IMAGE_LAYOUT_UNDEFINED, texture_vk->layout,
+                texture_vk->image.vk_image, &vk_range);
+    }
 
     texture_vk->t.flags |= WINED3D_TEXTURE_RGB_ALLOCATED;
 
@@ -132,6 +132,7 @@ struct wined3d_settings wined3d_settings =
     .max_sm_cs = UINT_MAX,
     .renderer = WINED3D_RENDERER_AUTO,
     .shader_backend = WINED3D_SHADER_BACKEND_AUTO,
+    .transfer_queue = TRUE,
 };
 
 enum wined3d_renderer CDECL wined3d_get_renderer(void)
@@ -480,6 +481,10 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Forcing all constant buffers to be write-mappable.\n");
             wined3d_settings.cb_access_map_w = TRUE;
         }
+        if (!get_config_key_dword(hkey, appkey, env, "cs_stats", &wined3d_settings.cs_stats))
+            ERR_(winediag)("Setting command stream statistics to %#x.\n", wined3d_settings.cs_stats);
+        if (!get_config_key_dword(hkey, appkey, env, "transfer_queue", &wined3d_settings.transfer_queue))
+            TRACE("Setting Vulkan transfer queue uploads to %#x.\n", wined3d_settings.transfer_queue);
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -485,6 +485,8 @@ struct wined3d_settings
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
     BOOL cb_access_map_w;
+    unsigned int cs_stats;
+    unsigned int transfer_queue;
 };
 
 extern struct wined3d_settings wined3d_settings;
@@ -3583,6 +3585,46 @@ struct wined3d_cs_queue
     BYTE data[WINED3D_CS_QUEUE_SIZE];
 };
 
+struct wined3d_cs_stats
+{
+    /* Updated by the application thread. */
+    LONG64 require_space_ticks;
+    LONG64 finish_ticks;
+    LONG64 map_sync_ticks;
+    LONG finish_count;
+    LONG map_sync_count;
+    LONG64 occupancy_sum;
+    LONG occupancy_max;
+    LONG occupancy_samples;
+
+    /* Updated by the thread executing the commands. */
+    struct
+    {
+        unsigned int count;
+        LONGLONG ticks;
+    } ops[WINED3D_CS_STATS_MAX_OPS];
+    unsigned int exec_depth;
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER frame_start;
+    UINT64 frame;
+
+    /* Totals for the periodic log. */
+    struct wined3d_cs_stats_shm totals;
+    unsigned int log_frames;
+    LARGE_INTEGER log_start;
+
+    HANDLE mapping;
+    struct wined3d_cs_stats_shm *shm;
+};
+
+static inline LONGLONG wined3d_cs_stats_time(void)
+{
+    LARGE_INTEGER time;
+
+    QueryPerformanceCounter(&time);
+    return time.QuadPart;
+}
+
 struct wined3d_device_context_ops
 {
     void *(*require_space)(struct wined3d_device_context *context, size_t size, enum wined3d_cs_queue_id queue_id);
@@ -3626,6 +3668,8 @@ struct wined3d_cs
     LONG waiting_for_event;
     LONG waiting_for_present;
     LONG pending_presents;
+
+    struct wined3d_cs_stats *stats;
 };
 
 static inline void wined3d_device_context_lock(struct wined3d_device_context *context)
@@ -185,6 +185,9 @@ struct wined3d_device_vk;
     VK_DEVICE_EXT_PFN(vkCmdBindTransformFeedbackBuffersEXT) \
     VK_DEVICE_EXT_PFN(vkCmdEndQueryIndexedEXT) \
     VK_DEVICE_EXT_PFN(vkCmdEndTransformFeedbackEXT) \
+    /* VK_KHR_timeline_semaphore */ \
+    VK_DEVICE_EXT_PFN(vkGetSemaphoreCounterValueKHR) \
+    VK_DEVICE_EXT_PFN(vkWaitSemaphoresKHR) \
     /* VK_KHR_swapchain */ \
     VK_DEVICE_PFN(vkAcquireNextImageKHR) \
     VK_DEVICE_PFN(vkCreateSwapchainKHR) \
@@ -219,6 +222,7 @@ enum wined3d_vk_extension
     WINED3D_VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE,
     WINED3D_VK_KHR_SHADER_DRAW_PARAMETERS,
     WINED3D_VK_EXT_HOST_QUERY_RESET,
+    WINED3D_VK_KHR_TIMELINE_SEMAPHORE,
 
     WINED3D_VK_EXT_COUNT,
 };
@@ -324,6 +328,8 @@ struct wined3d_image_vk
     struct wined3d_allocator_block *memory;
     VkDeviceMemory vk_memory;
     uint64_t command_buffer_id;
+    uint64_t transfer_id;
+    bool concurrent;
 };
 
 struct wined3d_query_pool_vk
@@ -448,6 +454,51 @@ struct wined3d_retired_objects_vk
     SIZE_T count;
 };
 
+#define WINED3D_TRANSFER_STAGING_SIZE       (32 * 1024 * 1024)
+#define WINED3D_TRANSFER_SUBMIT_THRESHOLD   (4 * 1024 * 1024)
+
+struct wined3d_staging_region_vk
+{
+    VkDeviceSize end;
+    uint64_t transfer_id;
+};
+
+/* Uploads recorded on the dedicated transfer queue. Each transfer command
+ * buffer signals its id on "vk_semaphore", a timeline semaphore; graphics
+ * command buffers signal their own id on "vk_graphics_semaphore". Staging
+ * memory is sub-allocated from a ring buffer and recycled once the transfer
+ * id of the last upload using a region has been reached. */
+struct wined3d_transfer_vk
+{
+    VkCommandPool vk_command_pool;
+    VkSemaphore vk_semaphore;
+    VkSemaphore vk_graphics_semaphore;
+
+    struct wined3d_command_buffer_vk current_command_buffer;
+    uint64_t completed_id;
+    /* Graphics command buffer id the current transfer command buffer waits for. */
+    uint64_t wait_command_buffer_id;
+    /* Transfer id the current graphics command buffer waits for. */
+    uint64_t graphics_wait_id;
+    VkDeviceSize pending_size;
+
+    struct
+    {
+        struct wined3d_command_buffer_vk *buffers;
+        SIZE_T buffers_size;
+        SIZE_T buffer_count;
+    } submitted, completed;
+
+    struct wined3d_bo_vk staging_bo;
+    VkDeviceSize staging_head, staging_tail;
+    struct
+    {
+        struct wined3d_staging_region_vk *regions;
+        SIZE_T regions_size;
+        SIZE_T region_count;
+    } staging;
+};
+
 #define WINED3D_FB_ATTACHMENT_FLAG_DISCARDED   1
 #define WINED3D_FB_ATTACHMENT_FLAG_CLEAR_C     2
 #define WINED3D_FB_ATTACHMENT_FLAG_CLEAR_S     4
@@ -617,6 +668,7 @@ struct wined3d_context_vk
     struct list free_stream_output_statistics_query_pools;
 
     struct wined3d_retired_objects_vk retired;
+    struct wined3d_transfer_vk transfer;
     struct wine_rb_tree render_passes;
     struct wine_rb_tree pipeline_layouts;
     struct wine_rb_tree graphics_pipelines;
@@ -630,6 +682,8 @@ static inline struct wined3d_context_vk *wined3d_context_vk(struct wined3d_conte
 
 bool wined3d_context_vk_allocate_query(struct wined3d_context_vk *context_vk,
         enum wined3d_query_type type, struct wined3d_query_pool_idx_vk *pool_idx);
+bool wined3d_context_vk_allocate_staging_memory(struct wined3d_context_vk *context_vk,
+        VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset);
 VkDeviceMemory wined3d_context_vk_allocate_vram_chunk_memory(struct wined3d_context_vk *context_vk,
         unsigned int pool, size_t size);
 VkCommandBuffer wined3d_context_vk_apply_compute_state(struct wined3d_context_vk *context_vk,
@@ -667,6 +721,8 @@ void wined3d_context_vk_destroy_vk_pipeline(struct wined3d_context_vk *context_v
         VkPipeline vk_pipeline, uint64_t command_buffer_id);
 void wined3d_context_vk_end_current_render_pass(struct wined3d_context_vk *context_vk);
 VkCommandBuffer wined3d_context_vk_get_command_buffer(struct wined3d_context_vk *context_vk);
+VkCommandBuffer wined3d_context_vk_get_transfer_command_buffer(struct wined3d_context_vk *context_vk,
+        struct wined3d_image_vk *image);
 struct wined3d_pipeline_layout_vk *wined3d_context_vk_get_pipeline_layout(struct wined3d_context_vk *context_vk,
         VkDescriptorSetLayoutBinding *bindings, SIZE_T binding_count);
 VkRenderPass wined3d_context_vk_get_render_pass(struct wined3d_context_vk *context_vk,
@@ -681,7 +737,9 @@ HRESULT wined3d_context_vk_init(struct wined3d_context_vk *context_vk,
 void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context_vk,
         unsigned int wait_semaphore_count, const VkSemaphore *wait_semaphores, const VkPipelineStageFlags *wait_stages,
         unsigned int signal_semaphore_count, const VkSemaphore *signal_semaphores);
+void wined3d_context_vk_submit_transfer_command_buffer(struct wined3d_context_vk *context_vk);
 void wined3d_context_vk_wait_command_buffer(struct wined3d_context_vk *context_vk, uint64_t id);
+void wined3d_context_vk_wait_transfer(struct wined3d_context_vk *context_vk, uint64_t id);
 VkDescriptorSet wined3d_context_vk_create_vk_descriptor_set(struct wined3d_context_vk *context_vk,
         VkDescriptorSetLayout vk_set_layout);
 
@@ -791,6 +849,10 @@ struct wined3d_device_vk
     uint32_t vk_queue_family_index;
     uint32_t timestamp_bits;
 
+    VkQueue vk_transfer_queue;
+    uint32_t vk_transfer_queue_family_index;
+    VkExtent3D transfer_granularity;
+
     struct wined3d_vk_info vk_info;
 
     struct wined3d_null_resources_vk null_resources_vk;
@@ -1058,19 +1120,24 @@ static inline void wined3d_context_vk_reference_bo(const struct wined3d_context_
     bo->command_buffer_id = context_vk->current_command_buffer.id;
 }
 
-static inline void wined3d_context_vk_reference_image(const struct wined3d_context_vk *context_vk,
+static inline void wined3d_context_vk_reference_image(struct wined3d_context_vk *context_vk,
         struct wined3d_image_vk *image)
 {
+    struct wined3d_transfer_vk *transfer = &context_vk->transfer;
+
     image->command_buffer_id = context_vk->current_command_buffer.id;
+    /* Only wait for uploads to images actually used by this command buffer. */
+    if (image->transfer_id > transfer->completed_id && image->transfer_id > transfer->graphics_wait_id)
+        transfer->graphics_wait_id = image->transfer_id;
 }
 
-static inline void wined3d_context_vk_reference_texture(const struct wined3d_context_vk *context_vk,
+static inline void wined3d_context_vk_reference_texture(struct wined3d_context_vk *context_vk,
         struct wined3d_texture_vk *texture_vk)
 {
     wined3d_context_vk_reference_image(context_vk, &texture_vk->image);
 }
 
-static inline void wined3d_context_vk_reference_resource(const struct wined3d_context_vk *context_vk,
+static inline void wined3d_context_vk_reference_resource(struct wined3d_context_vk *context_vk,
         struct wined3d_resource *resource)
 {
     if (resource->type == WINED3D_RTYPE_BUFFER)
@@ -1091,21 +1158,21 @@ static inline void wined3d_context_vk_reference_sampler(const struct wined3d_con
     sampler_vk->command_buffer_id = context_vk->current_command_buffer.id;
 }
 
-static inline void wined3d_context_vk_reference_rendertarget_view(const struct wined3d_context_vk *context_vk,
+static inline void wined3d_context_vk_reference_rendertarget_view(struct wined3d_context_vk *context_vk,
         struct wined3d_rendertarget_view_vk *rtv_vk)
 {
     wined3d_context_vk_reference_resource(context_vk, rtv_vk->v.resource);
     rtv_vk->command_buffer_id = context_vk->current_command_buffer.id;
 }
 
-static inline void wined3d_context_vk_reference_shader_resource_view(const struct wined3d_context_vk *context_vk,
+static inline void wined3d_context_vk_reference_shader_resource_view(struct wined3d_context_vk *context_vk,
         struct wined3d_shader_resource_view_vk *srv_vk)
 {
     wined3d_context_vk_reference_resource(context_vk, srv_vk->v.resource);
     srv_vk->view_vk.command_buffer_id = context_vk->current_command_buffer.id;
 }
 
-static inline void wined3d_context_vk_reference_unordered_access_view(const struct wined3d_context_vk *context_vk,
+static inline void wined3d_context_vk_reference_unordered_access_view(struct wined3d_context_vk *context_vk,
         struct wined3d_unordered_access_view_vk *uav_vk)
 {
     wined3d_context_vk_reference_resource(context_vk, uav_vk->v.resource);
@@ -45,6 +45,9 @@
 #  include <sys/ipc.h>
 # endif
 #endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "x11drv.h"
 #include "winternl.h"
@@ -1571,6 +1574,8 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+#define MAX_DIRTY_RECTS 8
+
 struct x11drv_window_surface
 {
     struct window_surface header;
@@ -1579,6 +1584,8 @@ struct x11drv_window_surface
     GC                    gc;
     XImage               *image;
     RECT                  bounds;
+    RECT                  dirty[MAX_DIRTY_RECTS];  /* areas modified since the last flush */
+    int                   dirty_count;
     BOOL                  byteswap;
     BOOL                  is_argb;
     DWORD                 alpha_bits;
@@ -1587,6 +1594,12 @@ struct x11drv_window_surface
     void                 *bits;
 #ifdef HAVE_LIBXXSHM
     XShmSegmentInfo       shminfo;
+    XImage               *back_image;   /* second image, only used for asynchronous flushing */
+    XShmSegmentInfo       back_shminfo;
+    XImage               *flush_image;  /* image to fill on the next asynchronous flush */
+    RECT                  stale[MAX_DIRTY_RECTS];  /* areas where flush_image is out of date */
+    int                   stale_count;
+    unsigned int          busy;         /* images queued to the flush thread, protected by flush_mutex */
 #endif
     pthread_mutex_t       mutex;
     BITMAPINFO            info;   /* variable size, must be last */
@@ -1800,6 +1813,207 @@ static void set_color_key( struct x11drv_window_surface *surface, COLORREF key )
                              get_color_component( GetBValue(key), masks[2] );
 }
 
+static inline LONGLONG get_rect_area( const RECT *rect )
+{
+    return (LONGLONG)(rect->right - rect->left) * (rect->bottom - rect->top);
+}
+
+/* merging two rects is worth it if it doesn't add more pixels than the cost of an extra request */
+#define DIRTY_MERGE_SLACK (64 * 64)
+
+/***********************************************************************
+ *           add_dirty_rect
+ *
+ * Add a rect to a dirty list, coalescing it with the rects it overlaps or is close to.
+ */
+static void add_dirty_rect( RECT *rects, int *count, const RECT *rect )
+{
+    RECT tmp, merged;
+    LONGLONG cost, best_cost = 0;
+    int i, best;
+
+    if (IsRectEmpty( rect )) return;
+    tmp = *rect;
+
+restart:
+    best = -1;
+    for (i = 0; i < *count; i++)
+    {
+        union_rect( &merged, &rects[i], &tmp );
+        cost = get_rect_area( &merged ) - get_rect_area( &rects[i] ) - get_rect_area( &tmp );
+        if (cost <= DIRTY_MERGE_SLACK)
+        {
+            best = i;
+            break;
+        }
+    }
+    if (best == -1 && *count == MAX_DIRTY_RECTS)
+    {
+        /* the list is full, merge with the rect that grows the least */
+        for (i = 0; i < *count; i++)
+        {
+            union_rect( &merged, &rects[i], &tmp );
+            cost = get_rect_area( &merged ) - get_rect_area( &rects[i] );
+            if (best == -1 || cost < best_cost)
+            {
+                best = i;
+                best_cost = cost;
+            }
+        }
+    }
+    if (best != -1)
+    {
+        union_rect( &tmp, &rects[best], &tmp );
+        rects[best] = rects[--*count];
+        /* the merged rect may now be close to other ones */
+        goto restart;
+    }
+    rects[(*count)++] = tmp;
+}
+
+static void set_alpha_bits( ULONG *ptr, int count, ULONG alpha_bits )
+{
+    int x = 0;
+#ifdef __SSE2__
+    __m128i alpha = _mm_set1_epi32( alpha_bits );
+
+    for (; x + 4 <= count; x += 4)
+        _mm_storeu_si128( (__m128i *)(ptr + x), _mm_or_si128( _mm_loadu_si128( (__m128i *)(ptr + x) ), alpha ));
+#endif
+    for (; x < count; x++) ptr[x] |= alpha_bits;
+}
+
+static void copy_alpha_bits( ULONG *dst, const ULONG *src, int count, ULONG alpha_bits )
+{
+    int x = 0;
+#ifdef __SSE2__
+    __m128i alpha = _mm_set1_epi32( alpha_bits );
+
+    for (; x + 4 <= count; x += 4)
+        _mm_storeu_si128( (__m128i *)(dst + x),
+                          _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + x) ), alpha ));
+#endif
+    for (; x < count; x++) dst[x] = src[x] | alpha_bits;
+}
+
+static void copy_byteswap_16( USHORT *dst, const USHORT *src, int count )
+{
+    int x = 0;
+#ifdef __SSE2__
+    for (; x + 8 <= count; x += 8)
+    {
+        __m128i val = _mm_loadu_si128( (const __m128i *)(src + x) );
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_or_si128( _mm_slli_epi16( val, 8 ), _mm_srli_epi16( val, 8 )));
+    }
+#endif
+    for (; x < count; x++) dst[x] = RtlUshortByteSwap( src[x] );
+}
+
+static void copy_byteswap_32( ULONG *dst, const ULONG *src, int count, ULONG alpha_bits )
+{
+    int x = 0;
+#ifdef __SSE2__
+    __m128i alpha = _mm_set1_epi32( alpha_bits ), mask = _mm_set1_epi32( 0x00ff00ff );
+
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i val = _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + x) ), alpha );
+        /* swap the bytes in each word, then the words in each dword */
+        val = _mm_or_si128( _mm_and_si128( _mm_srli_epi32( val, 8 ), mask ),
+                            _mm_slli_epi32( _mm_and_si128( val, mask ), 8 ));
+        val = _mm_or_si128( _mm_srli_epi32( val, 16 ), _mm_slli_epi32( val, 16 ));
+        _mm_storeu_si128( (__m128i *)(dst + x), val );
+    }
+#endif
+    for (; x < count; x++) dst[x] = RtlUlongByteSwap( src[x] | alpha_bits );
+}
+
+/***********************************************************************
+ *           copy_surface_rect
+ *
+ * Copy a rect of the surface bits to an image, converting the pixels as necessary.
+ */
+static void copy_surface_rect( struct x11drv_window_surface *surface, XImage *image,
+                               const RECT *rect, const int *mapping )
+{
+    int bpp = surface->info.bmiHeader.biBitCount, stride = image->bytes_per_line;
+    int left = rect->left * bpp / 8, right = (rect->right * bpp + 7) / 8;
+    int x, y, width = rect->right - rect->left, height = rect->bottom - rect->top;
+    const unsigned char *src = (const unsigned char *)surface->bits + rect->top * stride;
+    unsigned char *dst = (unsigned char *)image->data + rect->top * stride;
+
+    if (src == dst)
+    {
+        if (surface->alpha_bits)
+            for (y = 0; y < height; y++, dst += stride)
+                set_alpha_bits( (ULONG *)dst + rect->left, width, surface->alpha_bits );
+        return;
+    }
+
+    if (!surface->byteswap && !mapping)
+    {
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+        {
+            if (surface->alpha_bits)
+                copy_alpha_bits( (ULONG *)dst + rect->left, (const ULONG *)src + rect->left,
+                                 width, surface->alpha_bits );
+            else
+                memcpy( dst + left, src + left, right - left );
+        }
+        return;
+    }
+
+    switch (bpp)
+    {
+    case 1:
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+            for (x = left; x < right; x++) dst[x] = bit_swap[src[x]];
+        break;
+    case 4:
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+        {
+            if (mapping)
+            {
+                if (surface->byteswap)
+                    for (x = left; x < right; x++)
+                        dst[x] = (mapping[src[x] & 0x0f] << 4) | mapping[src[x] >> 4];
+                else
+                    for (x = left; x < right; x++)
+                        dst[x] = mapping[src[x] & 0x0f] | (mapping[src[x] >> 4] << 4);
+            }
+            else
+                for (x = left; x < right; x++)
+                    dst[x] = (src[x] << 4) | (src[x] >> 4);
+        }
+        break;
+    case 8:
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+            for (x = left; x < right; x++) dst[x] = mapping[src[x]];
+        break;
+    case 16:
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+            copy_byteswap_16( (USHORT *)dst + rect->left, (const USHORT *)src + rect->left, width );
+        break;
+    case 24:
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+        {
+            for (x = left; x < right; x += 3)
+            {
+                unsigned char tmp = src[x];
+                dst[x]     = src[x + 2];
+                dst[x + 1] = src[x + 1];
+                dst[x + 2] = tmp;
+            }
+        }
+        break;
+    case 32:
+        for (y = 0; y < height; y++, src += stride, dst += stride)
+            copy_byteswap_32( (ULONG *)dst + rect->left, (const ULONG *)src + rect->left,
+                              width, surface->alpha_bits );
+        break;
+    }
+}
+
 #ifdef HAVE_LIBXXSHM
 static int xshm_error_handler( Display *display, XErrorEvent *event, void *arg )
 {
@@ -1842,6 +2056,149 @@ failed:
     XDestroyImage( image );
     return NULL;
 }
+
+static void destroy_shm_image( XImage *image, XShmSegmentInfo *shminfo )
+{
+    XShmDetach( gdi_display, shminfo );
+    shmdt( shminfo->shmaddr );
+    image->data = NULL;
+    XDestroyImage( image );
+}
+
+/* asynchronous flushing: painting threads fill one of the two shm images of a surface
+ * and queue it to the flush thread, which submits it to the X server */
+
+struct flush_request
+{
+    struct list                    entry;
+    struct x11drv_window_surface  *surface;
+    XImage                        *image;
+    int                            count;
+    RECT                           rects[MAX_DIRTY_RECTS];
+};
+
+static pthread_mutex_t flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flush_cond = PTHREAD_COND_INITIALIZER;       /* requests have been queued */
+static pthread_cond_t flush_done_cond = PTHREAD_COND_INITIALIZER;  /* requests have been processed */
+static struct list flush_queue = LIST_INIT( flush_queue );
+static pthread_once_t flush_thread_once = PTHREAD_ONCE_INIT;
+static BOOL flush_thread_running;
+
+static inline unsigned int get_image_busy_mask( struct x11drv_window_surface *surface, XImage *image )
+{
+    return image == surface->image ? 1 : 2;
+}
+
+static void *flush_thread( void *arg )
+{
+    struct flush_request *req, *next;
+    struct list requests;
+    int i;
+
+    pthread_mutex_lock( &flush_mutex );
+    for (;;)
+    {
+        while (list_empty( &flush_queue )) pthread_cond_wait( &flush_cond, &flush_mutex );
+        list_init( &requests );
+        list_move_tail( &requests, &flush_queue );
+        pthread_mutex_unlock( &flush_mutex );
+
+        LIST_FOR_EACH_ENTRY( req, &requests, struct flush_request, entry )
+        {
+            struct x11drv_window_surface *surface = req->surface;
+
+            for (i = 0; i < req->count; i++)
+                XShmPutImage( gdi_display, surface->window, surface->gc, req->image,
+                              req->rects[i].left, req->rects[i].top,
+                              surface->header.rect.left + req->rects[i].left,
+                              surface->header.rect.top + req->rects[i].top,
+                              req->rects[i].right - req->rects[i].left,
+                              req->rects[i].bottom - req->rects[i].top, False );
+        }
+        /* the images can only be reused once the server is done reading them */
+        XSync( gdi_display, False );
+
+        pthread_mutex_lock( &flush_mutex );
+        LIST_FOR_EACH_ENTRY_SAFE( req, next, &requests, struct flush_request, entry )
+        {
+            req->surface->busy &= ~get_image_busy_mask( req->surface, req->image );
+            free( req );
+        }
+        pthread_cond_broadcast( &flush_done_cond );
+    }
+    return NULL;
+}
+
+static void start_flush_thread(void)
+{
+    pthread_t id;
+    pthread_attr_t attr;
+
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    if (!pthread_create( &id, &attr, flush_thread, NULL )) flush_thread_running = TRUE;
+    else WARN( "failed to create flush thread, using synchronous flushing\n" );
+    pthread_attr_destroy( &attr );
+}
+
+/***********************************************************************
+ *           flush_surface_async
+ *
+ * Fill the next image of the surface and queue it to the flush thread.
+ */
+static void flush_surface_async( struct x11drv_window_surface *surface, const RECT *rects, int count,
+                                 const int *mapping, BOOL fshack )
+{
+    XImage *image = surface->flush_image;
+    unsigned int mask = get_image_busy_mask( surface, image );
+    struct flush_request *req = NULL;
+    int i;
+
+    /* only wait if the server is more than one frame behind */
+    pthread_mutex_lock( &flush_mutex );
+    while (surface->busy & mask) pthread_cond_wait( &flush_done_cond, &flush_mutex );
+    pthread_mutex_unlock( &flush_mutex );
+
+    for (i = 0; i < surface->stale_count; i++) copy_surface_rect( surface, image, &surface->stale[i], mapping );
+    for (i = 0; i < count; i++) copy_surface_rect( surface, image, &rects[i], mapping );
+
+    if (fshack && fs_hack_put_image_scaled( surface->hwnd, surface->window, surface->gc, image,
+                                            surface->header.rect.left, surface->header.rect.top,
+                                            surface->header.rect.right - surface->header.rect.left,
+                                            surface->header.rect.bottom - surface->header.rect.top,
+                                            surface->is_argb ))
+        XFlush( gdi_display );
+    else if ((req = malloc( sizeof(*req) )))
+    {
+        req->surface = surface;
+        req->image = image;
+        req->count = count;
+        memcpy( req->rects, rects, count * sizeof(*rects) );
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+            XShmPutImage( gdi_display, surface->window, surface->gc, image,
+                          rects[i].left, rects[i].top,
+                          surface->header.rect.left + rects[i].left, surface->header.rect.top + rects[i].top,
+                          rects[i].right - rects[i].left, rects[i].bottom - rects[i].top, False );
+        XFlush( gdi_display );
+    }
+
+    pthread_mutex_lock( &flush_mutex );
+    if (req)
+    {
+        surface->busy |= mask;
+        list_add_tail( &flush_queue, &req->entry );
+        pthread_cond_signal( &flush_cond );
+    }
+    pthread_mutex_unlock( &flush_mutex );
+
+    /* the other image is now missing the rects we just updated */
+    surface->flush_image = image == surface->image ? surface->back_image : surface->image;
+    memcpy( surface->stale, rects, count * sizeof(*rects) );
+    surface->stale_count = count;
+}
 #endif /* HAVE_LIBXXSHM */
 
 /***********************************************************************
@@ -1861,6 +2218,12 @@ static void x11drv_surface_unlock( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
+    /* keep separate paint operations as separate dirty rects */
+    if (!IsRectEmpty( &surface->bounds ))
+    {
+        add_dirty_rect( surface->dirty, &surface->dirty_count, &surface->bounds );
+        reset_bounds( &surface->bounds );
+    }
     pthread_mutex_unlock( &surface->mutex );
 }
 
@@ -1922,10 +2285,9 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
 static void x11drv_surface_flush( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
-    unsigned char *src = surface->bits;
-    unsigned char *dst = (unsigned char *)surface->image->data;
     struct x11drv_win_data *data;
-    struct bitblt_coords coords;
+    RECT rects[MAX_DIRTY_RECTS], rect;
+    int i, count = 0, width, height;
     BOOL fshack = FALSE;
 
     if ((data = get_win_data( surface->hwnd )))
@@ -1935,64 +2297,62 @@ static void x11drv_surface_flush( struct window_surface *window_surface )
     }
 
     window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (intersect_rect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    add_dirty_rect( surface->dirty, &surface->dirty_count, &surface->bounds );
+    reset_bounds( &surface->bounds );
+
+    width  = surface->header.rect.right - surface->header.rect.left;
+    height = surface->header.rect.bottom - surface->header.rect.top;
+    SetRect( &rect, 0, 0, width, height );
+    for (i = 0; i < surface->dirty_count; i++)
+        if (intersect_rect( &rects[count], &surface->dirty[i], &rect )) count++;
+    surface->dirty_count = 0;
+
+    if (count)
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
-               wine_dbgstr_rect( &surface->bounds ), surface->bits );
+        int map[256], *mapping = get_window_surface_mapping( surface->image->bits_per_pixel, map );
+
+        TRACE( "flushing %p %dx%d %d rects first %s bits %p\n",
+               surface, width, height, count, wine_dbgstr_rect( &rects[0] ), surface->bits );
 
         if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
 
-        if (src != dst)
-        {
-            int map[256], *mapping = get_window_surface_mapping( surface->image->bits_per_pixel, map );
-            int width_bytes = surface->image->bytes_per_line;
-
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
-            copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
-                                 surface->byteswap, mapping, ~0u, surface->alpha_bits );
-        }
-        else if (surface->alpha_bits)
+#ifdef HAVE_LIBXXSHM
+        if (surface->back_image)
         {
-            int x, y, stride = surface->image->bytes_per_line / sizeof(ULONG);
-            ULONG *ptr = (ULONG *)dst + coords.visrect.top * stride;
-
-            for (y = coords.visrect.top; y < coords.visrect.bottom; y++, ptr += stride)
-                for (x = coords.visrect.left; x < coords.visrect.right; x++)
-                    ptr[x] |= surface->alpha_bits;
+            flush_surface_async( surface, rects, count, mapping, fshack );
+            window_surface->funcs->unlock( window_surface );
+            return;
         }
+#endif
+        for (i = 0; i < count; i++) copy_surface_rect( surface, surface->image, &rects[i], mapping );
 
 #ifdef HAVE_LIBXXSHM
         if (surface->shminfo.shmid != -1)
         {
             if (!fshack || !fs_hack_put_image_scaled( surface->hwnd, surface->window, surface->gc, surface->image,
                                                       surface->header.rect.left, surface->header.rect.top,
-                                                      coords.width, coords.height, surface->is_argb ))
-                XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                              coords.visrect.left, coords.visrect.top,
-                              surface->header.rect.left + coords.visrect.left,
-                              surface->header.rect.top + coords.visrect.top,
-                              coords.visrect.right - coords.visrect.left,
-                              coords.visrect.bottom - coords.visrect.top, False );
+                                                      width, height, surface->is_argb ))
+            {
+                for (i = 0; i < count; i++)
+                    XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                                  rects[i].left, rects[i].top,
+                                  surface->header.rect.left + rects[i].left,
+                                  surface->header.rect.top + rects[i].top,
+                                  rects[i].right - rects[i].left,
+                                  rects[i].bottom - rects[i].top, False );
+            }
         }
         else
 #endif
-        XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
+        for (i = 0; i < count; i++)
+            XPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                       rects[i].left, rects[i].top,
+                       surface->header.rect.left + rects[i].left,
+                       surface->header.rect.top + rects[i].top,
+                       rects[i].right - rects[i].left,
+                       rects[i].bottom - rects[i].top );
         XFlush( gdi_display );
     }
-    reset_bounds( &surface->bounds );
     window_surface->funcs->unlock( window_surface );
 }
 
@@ -2004,21 +2364,30 @@ static void x11drv_surface_destroy( struct window_surface *window_surface )
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
     TRACE( "freeing %p bits %p\n", surface, surface->bits );
+#ifdef HAVE_LIBXXSHM
+    if (surface->back_image)
+    {
+        /* wait for the flush thread to release the images */
+        pthread_mutex_lock( &flush_mutex );
+        while (surface->busy) pthread_cond_wait( &flush_done_cond, &flush_mutex );
+        pthread_mutex_unlock( &flush_mutex );
+        destroy_shm_image( surface->back_image, &surface->back_shminfo );
+    }
+#endif
     if (surface->gc) XFreeGC( gdi_display, surface->gc );
     if (surface->image)
     {
         if (surface->image->data != surface->bits) free( surface->bits );
 #ifdef HAVE_LIBXXSHM
         if (surface->shminfo.shmid != -1)
-        {
-            XShmDetach( gdi_display, &surface->shminfo );
-            shmdt( surface->shminfo.shmaddr );
-        }
+            destroy_shm_image( surface->image, &surface->shminfo );
         else
 #endif
-        free( surface->image->data );
-        surface->image->data = NULL;
-        XDestroyImage( surface->image );
+        {
+            free( surface->image->data );
+            surface->image->data = NULL;
+            XDestroyImage( surface->image );
+        }
     }
     if (surface->region) NtGdiDeleteObjectApp( surface->region );
     free( surface );
@@ -2069,6 +2438,13 @@ struct window_surface *create_surface( HWND hwnd, Window window, const XVisualIn
 
 #ifdef HAVE_LIBXXSHM
     surface->image = create_shm_image( vis, width, height, &surface->shminfo );
+    if (surface->image && async_surface_flush)
+    {
+        pthread_once( &flush_thread_once, start_flush_thread );
+        if (flush_thread_running)
+            surface->back_image = create_shm_image( vis, width, height, &surface->back_shminfo );
+        surface->flush_image = surface->back_image;
+    }
     if (!surface->image)
 #endif
     {
@@ -2086,9 +2462,13 @@ struct window_surface *create_surface( HWND hwnd, Window window, const XVisualIn
     if (vis->depth == 32 && !surface->is_argb)
         surface->alpha_bits = ~(vis->red_mask | vis->green_mask | vis->blue_mask);
 
-    if (surface->byteswap || format->bits_per_pixel == 4 || format->bits_per_pixel == 8)
+    if (surface->byteswap || format->bits_per_pixel == 4 || format->bits_per_pixel == 8
+#ifdef HAVE_LIBXXSHM
+        || surface->back_image
+#endif
+        )
     {
-        /* allocate separate surface bits if byte swapping or palette mapping is required */
+        /* allocate separate surface bits if byte swapping, palette mapping or double buffering is required */
         if (!(surface->bits  = calloc( 1, surface->info.bmiHeader.biSizeImage )))
             goto failed;
     }
@@ -296,6 +296,7 @@ extern INT X11DRV_YWStoDS( HDC hdc, INT height );
 extern BOOL client_side_graphics;
 extern BOOL client_side_with_render;
 extern BOOL shape_layered_windows;
+extern BOOL async_surface_flush;
 extern const struct gdi_dc_funcs *X11DRV_XRender_Init(void);
 
 extern struct opengl_funcs *get_glx_driver(UINT);
@@ -14642,6 +14642,257 @@ static void test_afunix(void)
     }
 }
 
+/* Recv and send calls which can complete immediately may skip the server,
+ * check that this doesn't bypass anything the server needs to see. */
+static void test_immediate_send_recv(void)
+{
+    const struct sockaddr_in bind_addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    WSANETWORKEVENTS events;
+    struct sockaddr_in addr;
+    SOCKET client, server;
+    OVERLAPPED overlapped;
+    DWORD size, flags;
+    char buffer[16];
+    WSABUF wsabuf;
+    u_long zero = 0;
+    HANDLE event;
+    int ret, len;
+
+    tcp_socketpair(&client, &server);
+
+    ret = send(client, "data", 4, 0);
+    ok(ret == 4, "got %d, error %u\n", ret, WSAGetLastError());
+    memset(buffer, 0, sizeof(buffer));
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == 4, "got %d, error %u\n", ret, WSAGetLastError());
+    ok(!memcmp(buffer, "data", 4), "got %s\n", debugstr_an(buffer, ret));
+
+    /* FD_READ must be reenabled by recv() */
+    event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ret = WSAEventSelect(server, event, FD_READ);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = send(client, "a", 1, 0);
+    ok(ret == 1, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = WaitForSingleObject(event, 1000);
+    ok(!ret, "got %d\n", ret);
+    ret = WSAEnumNetworkEvents(server, event, &events);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(events.lNetworkEvents == FD_READ, "got events %#lx\n", events.lNetworkEvents);
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == 1, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = send(client, "b", 1, 0);
+    ok(ret == 1, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = WaitForSingleObject(event, 1000);
+    ok(!ret, "got %d\n", ret);
+    ret = WSAEnumNetworkEvents(server, event, &events);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(events.lNetworkEvents == FD_READ, "got events %#lx\n", events.lNetworkEvents);
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == 1, "got %d, error %u\n", ret, WSAGetLastError());
+    ok(buffer[0] == 'b', "got %#x\n", buffer[0]);
+
+    /* WSAEventSelect() leaves the socket nonblocking */
+    ret = WSAEventSelect(server, NULL, 0);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = ioctlsocket(server, FIONBIO, &zero);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    /* a queued overlapped recv gets the data first */
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.hEvent = event;
+    ResetEvent(event);
+    wsabuf.buf = buffer;
+    wsabuf.len = sizeof(buffer);
+    flags = 0;
+    memset(buffer, 0, sizeof(buffer));
+    ret = WSARecv(server, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+    ret = send(client, "first", 5, 0);
+    ok(ret == 5, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = WaitForSingleObject(event, 1000);
+    ok(!ret, "got %d\n", ret);
+    ret = GetOverlappedResult((HANDLE)server, &overlapped, &size, FALSE);
+    ok(ret, "got error %lu\n", GetLastError());
+    ok(size == 5, "got size %lu\n", size);
+    ok(!memcmp(buffer, "first", 5), "got %s\n", debugstr_an(buffer, size));
+    ret = send(client, "second", 6, 0);
+    ok(ret == 6, "got %d, error %u\n", ret, WSAGetLastError());
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == 6, "got %d, error %u\n", ret, WSAGetLastError());
+    ok(!memcmp(buffer, "second", 6), "got %s\n", debugstr_an(buffer, ret));
+
+    /* sends after a shutdown fail, and the peer sees the end of the stream */
+    ret = shutdown(client, SD_SEND);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = send(client, "c", 1, 0);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == WSAESHUTDOWN, "got error %u\n", WSAGetLastError());
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(!ret, "got %d, error %u\n", ret, WSAGetLastError());
+
+    closesocket(client);
+    closesocket(server);
+
+    /* sending on an unbound datagram socket binds it */
+    server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ret = bind(server, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = sendto(client, "udp", 3, 0, (struct sockaddr *)&addr, sizeof(addr));
+    ok(ret == 3, "got %d, error %u\n", ret, WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(client, (struct sockaddr *)&addr, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(addr.sin_port, "expected a port\n");
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == 3, "got %d, error %u\n", ret, WSAGetLastError());
+    ok(!memcmp(buffer, "udp", 3), "got %s\n", debugstr_an(buffer, ret));
+
+    closesocket(client);
+    closesocket(server);
+    CloseHandle(event);
+}
+
+/* Synchronous polls on idle sockets are answered without the server. */
+static void test_immediate_poll(void)
+{
+    static const struct timeval zero_timeout;
+    SOCKET client, server, listener;
+    struct sockaddr_in addr;
+    WSAPOLLFD fds[2];
+    char buffer[16];
+    fd_set readfds;
+    DWORD start;
+    int ret, len;
+
+    if (!pWSAPoll)
+    {
+        win_skip("WSAPoll() is not available\n");
+        return;
+    }
+
+    tcp_socketpair(&client, &server);
+
+    fds[0].fd = client;
+    fds[0].events = POLLRDNORM | POLLWRNORM;
+    fds[0].revents = 0xdead;
+    fds[1].fd = server;
+    fds[1].events = POLLRDNORM | POLLWRNORM;
+    fds[1].revents = 0xdead;
+    ret = pWSAPoll(fds, 2, 0);
+    ok(ret == 2, "got %d\n", ret);
+    ok(fds[0].revents == POLLWRNORM, "got events %#x\n", fds[0].revents);
+    ok(fds[1].revents == POLLWRNORM, "got events %#x\n", fds[1].revents);
+
+    fds[1].events = POLLRDNORM;
+    ret = pWSAPoll(&fds[1], 1, 0);
+    ok(!ret, "got %d\n", ret);
+    ok(!fds[1].revents, "got events %#x\n", fds[1].revents);
+
+    /* nothing ready, this has to wait in the server */
+    start = GetTickCount();
+    ret = pWSAPoll(&fds[1], 1, 100);
+    ok(!ret, "got %d\n", ret);
+    ok(!fds[1].revents, "got events %#x\n", fds[1].revents);
+    ok(GetTickCount() - start >= 80, "poll returned after %lu ms\n", GetTickCount() - start);
+
+    ret = send(client, "data", 4, 0);
+    ok(ret == 4, "got %d, error %u\n", ret, WSAGetLastError());
+    check_poll_mask(server, POLLRDNORM, POLLRDNORM);
+
+    FD_ZERO(&readfds);
+    FD_SET(server, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero_timeout);
+    ok(ret == 1, "got %d\n", ret);
+    ok(FD_ISSET(server, &readfds), "socket should be readable\n");
+
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == 4, "got %d, error %u\n", ret, WSAGetLastError());
+    check_poll_mask(server, POLLRDNORM, 0);
+
+    /* the end of the stream is reported as a hangup */
+    closesocket(client);
+    check_poll_mask(server, 0, POLLHUP);
+    closesocket(server);
+
+    /* a pending connection makes a listening socket readable */
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    len = sizeof(addr);
+    listener = setup_server_socket(&addr, &len);
+    check_poll_mask(listener, POLLRDNORM, 0);
+    client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ret = connect(client, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    check_poll_mask(listener, POLLRDNORM, POLLRDNORM);
+    server = accept(listener, NULL, NULL);
+    ok(server != INVALID_SOCKET, "got error %u\n", WSAGetLastError());
+    check_poll_mask(listener, POLLRDNORM, 0);
+
+    closesocket(server);
+    closesocket(client);
+    closesocket(listener);
+}
+
+static void test_udp_throughput(void)
+{
+    const struct sockaddr_in bind_addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    static const unsigned int batch = 32, count = 200000;
+    LARGE_INTEGER freq, start, end;
+    struct sockaddr_in addr;
+    SOCKET client, server;
+    unsigned int i, j;
+    char buffer[64];
+    double secs;
+    int ret, len;
+
+    if (!winetest_interactive)
+    {
+        skip("Skipping UDP throughput benchmark, set WINETEST_INTERACTIVE to run it.\n");
+        return;
+    }
+
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ret = bind(server, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = connect(client, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    memset(buffer, 0xcc, sizeof(buffer));
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; i += batch)
+    {
+        /* stay well below the receive buffer size so no packet is dropped */
+        for (j = 0; j < batch; ++j)
+        {
+            ret = send(client, buffer, sizeof(buffer), 0);
+            ok(ret == sizeof(buffer), "got %d, error %u\n", ret, WSAGetLastError());
+        }
+        for (j = 0; j < batch; ++j)
+        {
+            ret = recv(server, buffer, sizeof(buffer), 0);
+            ok(ret == sizeof(buffer), "got %d, error %u\n", ret, WSAGetLastError());
+        }
+    }
+    QueryPerformanceCounter(&end);
+
+    secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    trace("%u UDP packets sent and received in %.3f s, %.0f packets/s\n", count, secs, count / secs);
+
+    closesocket(client);
+    closesocket(server);
+}
+
 START_TEST( sock )
 {
     int i;
@@ -14755,6 +15006,9 @@ START_TEST( sock )
 
     /* this is an io heavy test, do it at the end so the kernel doesn't start dropping packets */
     test_send();
+    test_immediate_send_recv();
+    test_immediate_poll();
+    test_udp_throughput();
 
     Exit();
 }
@@ -0,0 +1,67 @@
+/*
+ * Lock contention profile definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_LOCK_PROFILE_H
+#define __WINE_WINE_LOCK_PROFILE_H
+
+/* When WINELOCKPROFILE=1 is set, ntdll records contention statistics for
+ * critical sections and SRW locks in a section named
+ * \__wine_lock_profile_<process id in hex>, which other processes can map
+ * read-only while the profiled process is running. A summary is also
+ * printed when the process exits. */
+
+#define LOCK_PROFILE_VERSION  1
+#define LOCK_PROFILE_ENTRIES  4096  /* must be a power of two */
+#define LOCK_PROFILE_SITES    4
+
+enum lock_profile_type
+{
+    LOCK_PROFILE_CRITICAL_SECTION = 1,
+    LOCK_PROFILE_SRWLOCK          = 2,
+};
+
+struct lock_profile_site
+{
+    ULONG64 address;          /* return address of the contended acquire call */
+    LONG64  count;            /* approximate number of contended acquisitions */
+    LONG64  wait_time;        /* time spent waiting, in counter ticks */
+};
+
+struct lock_profile_entry
+{
+    ULONG64 lock;             /* address of the lock, 0 if the entry is unused */
+    LONG    type;             /* enum lock_profile_type */
+    LONG    reserved;
+    LONG64  acquire_count;    /* number of blocking acquire calls */
+    LONG64  contended_count;  /* number of acquisitions that had to wait */
+    LONG64  wait_time;        /* total time spent waiting, in counter ticks */
+    LONG64  max_wait_time;    /* longest single wait, in counter ticks */
+    struct lock_profile_site sites[LOCK_PROFILE_SITES];  /* call sites which waited the most */
+};
+
+struct lock_profile
+{
+    ULONG   version;          /* LOCK_PROFILE_VERSION */
+    ULONG   entry_count;      /* LOCK_PROFILE_ENTRIES */
+    LONG    used;             /* number of entries in use */
+    LONG    dropped;          /* number of locks which didn't fit in the table */
+    LONG64  frequency;        /* counter ticks per second */
+    struct lock_profile_entry entries[LOCK_PROFILE_ENTRIES];
+};
+
+#endif  /* __WINE_WINE_LOCK_PROFILE_H */
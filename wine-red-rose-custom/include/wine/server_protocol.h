@@ -953,6 +953,44 @@ struct input_shared_memory
 };
 typedef volatile struct input_shared_memory input_shm_t;
 
+struct socket_shared_memory
+{
+    unsigned int         seq;
+    unsigned int         flags;
+};
+typedef volatile struct socket_shared_memory socket_shm_t;
+
+#define SOCKET_SHM_COUNT      16384
+#define SOCKET_SHM_NO_SLOT    (~0u)
+#define SOCKET_SHM_RECV       0x01
+#define SOCKET_SHM_SEND       0x02
+#define SOCKET_SHM_POLL       0x04
+#define SOCKET_SHM_CONNECTED  0x08
+#define SOCKET_SHM_STREAM     0x10
+
+struct ptid_shared_memory
+{
+    unsigned int         seq;
+    unsigned int         id;
+    timeout_t            start_time;
+    timeout_t            end_time;
+    client_ptr_t         base;
+    affinity_t           affinity;
+    process_id_t         pid;
+    int                  exit_code;
+    int                  priority;
+    unsigned int         flags;
+    int                  suspend_count;
+    int                  unix_pid;
+    int                  unix_tid;
+    unsigned int         session_id;
+    unsigned short       machine;
+};
+typedef volatile struct ptid_shared_memory ptid_shm_t;
+
+#define PTID_SHM_COUNT        16384
+#define PTID_SHM_INDEX(id)    ((id) / 4 - 8)
+
 
 
 
@@ -1925,6 +1963,20 @@ struct send_socket_reply
 #define SERVER_SOCKET_IO_SYSTEM      0x02
 
 
+struct socket_get_shm_slot_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct socket_get_shm_slot_reply
+{
+    struct reply_header __header;
+    unsigned int shm_slot;
+    unsigned int shm_seq;
+};
+
+
+
 struct socket_get_events_request
 {
     struct request_header __header;
@@ -3481,6 +3533,25 @@ struct get_window_parents_reply
 
 
 
+struct get_window_list_request
+{
+    struct request_header __header;
+    obj_handle_t   desktop;
+    user_handle_t  handle;
+    thread_id_t    tid;
+    int            children;
+    char __pad_28[4];
+};
+struct get_window_list_reply
+{
+    struct reply_header __header;
+    int            count;
+    /* VARARG(windows,user_handles); */
+    char __pad_12[4];
+};
+
+
+
 struct get_window_children_request
 {
     struct request_header __header;
@@ -5457,7 +5528,7 @@ struct remove_completion_request
     struct request_header __header;
     obj_handle_t handle;
     int          alertable;
-    char __pad_20[4];
+    int          ring;
 };
 struct remove_completion_reply
 {
@@ -6066,6 +6137,47 @@ struct fsync_free_shm_idx_reply
     struct reply_header __header;
 };
 
+#define COMPLETION_RING_SIZE 128
+
+typedef struct
+{
+    unsigned int  seq;
+    unsigned int  status;
+    apc_param_t   ckey;
+    apc_param_t   cvalue;
+    apc_param_t   information;
+} completion_ring_entry_t;
+
+
+typedef struct
+{
+    unsigned int  enqueue_pos;
+    unsigned int  __pad1[15];
+    unsigned int  dequeue_pos;
+    unsigned int  __pad2[15];
+    int           signal;
+    int           waiters;
+    int           overflow;
+    int           closed;
+    unsigned int  event_idx;
+    int           retired;
+    unsigned int  __pad3[10];
+    completion_ring_entry_t entries[COMPLETION_RING_SIZE];
+} completion_ring_t;
+
+
+struct get_completion_ring_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct get_completion_ring_reply
+{
+    struct reply_header __header;
+    unsigned int ring_idx;
+    char __pad_12[4];
+};
+
 
 enum request
 {
@@ -6125,6 +6237,7 @@ enum request
     REQ_unlock_file,
     REQ_recv_socket,
     REQ_send_socket,
+    REQ_socket_get_shm_slot,
     REQ_socket_get_events,
     REQ_socket_send_icmp_id,
     REQ_socket_get_icmp_id,
@@ -6217,6 +6330,7 @@ enum request
     REQ_set_window_info,
     REQ_set_parent,
     REQ_get_window_parents,
+    REQ_get_window_list,
     REQ_get_window_children,
     REQ_get_window_children_from_point,
     REQ_get_window_tree,
@@ -6370,6 +6484,7 @@ enum request
     REQ_fsync_msgwait,
     REQ_get_fsync_apc_idx,
     REQ_fsync_free_shm_idx,
+    REQ_get_completion_ring,
     REQ_NB_REQUESTS
 };
 
@@ -6433,6 +6548,7 @@ union generic_request
     struct unlock_file_request unlock_file_request;
     struct recv_socket_request recv_socket_request;
     struct send_socket_request send_socket_request;
+    struct socket_get_shm_slot_request socket_get_shm_slot_request;
     struct socket_get_events_request socket_get_events_request;
     struct socket_send_icmp_id_request socket_send_icmp_id_request;
     struct socket_get_icmp_id_request socket_get_icmp_id_request;
@@ -6525,6 +6641,7 @@ union generic_request
     struct set_window_info_request set_window_info_request;
     struct set_parent_request set_parent_request;
     struct get_window_parents_request get_window_parents_request;
+    struct get_window_list_request get_window_list_request;
     struct get_window_children_request get_window_children_request;
     struct get_window_children_from_point_request get_window_children_from_point_request;
     struct get_window_tree_request get_window_tree_request;
@@ -6678,6 +6795,7 @@ union generic_request
     struct fsync_msgwait_request fsync_msgwait_request;
     struct get_fsync_apc_idx_request get_fsync_apc_idx_request;
     struct fsync_free_shm_idx_request fsync_free_shm_idx_request;
+    struct get_completion_ring_request get_completion_ring_request;
 };
 union generic_reply
 {
@@ -6739,6 +6857,7 @@ union generic_reply
     struct unlock_file_reply unlock_file_reply;
     struct recv_socket_reply recv_socket_reply;
     struct send_socket_reply send_socket_reply;
+    struct socket_get_shm_slot_reply socket_get_shm_slot_reply;
     struct socket_get_events_reply socket_get_events_reply;
     struct socket_send_icmp_id_reply socket_send_icmp_id_reply;
     struct socket_get_icmp_id_reply socket_get_icmp_id_reply;
@@ -6831,6 +6950,7 @@ union generic_reply
     struct set_window_info_reply set_window_info_reply;
     struct set_parent_reply set_parent_reply;
     struct get_window_parents_reply get_window_parents_reply;
+    struct get_window_list_reply get_window_list_reply;
     struct get_window_children_reply get_window_children_reply;
     struct get_window_children_from_point_reply get_window_children_from_point_reply;
     struct get_window_tree_reply get_window_tree_reply;
@@ -6984,11 +7104,12 @@ union generic_reply
     struct fsync_msgwait_reply fsync_msgwait_reply;
     struct get_fsync_apc_idx_reply get_fsync_apc_idx_reply;
     struct fsync_free_shm_idx_reply fsync_free_shm_idx_reply;
+    struct get_completion_ring_reply get_completion_ring_reply;
 };
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 787
+#define SERVER_PROTOCOL_VERSION 793
 
 /* ### protocol_version end ### */
 
@@ -2285,6 +2285,41 @@ struct wined3d_private_data
     } content;
 };
 
+#define WINED3D_CS_STATS_VERSION                                1
+#define WINED3D_CS_STATS_MAX_OPS                                64
+#define WINED3D_CS_STATS_OP_NAME_SIZE                           48
+
+/* Command stream statistics for the last completed frame, published in the
+ * "Local\wined3d_cs_stats_<pid>" section when the "cs_stats" setting is
+ * enabled. "sequence" is odd while the block is being updated; readers should
+ * retry if it is odd or changed during the read. Times are in ticks of
+ * "frequency". */
+struct wined3d_cs_stats_shm
+{
+    UINT32 version;
+    UINT32 size;
+    volatile LONG sequence;
+    UINT32 op_count;
+    UINT64 frequency;
+    UINT64 frame;
+    UINT64 frame_ticks;
+    UINT64 exec_ticks;              /* time the CS thread spent executing ops */
+    UINT64 require_space_ticks;     /* time the application waited for queue space */
+    UINT64 finish_ticks;            /* time the application waited for the CS to idle */
+    UINT64 map_sync_ticks;          /* time spent in maps that went through the CS */
+    UINT32 finish_count;
+    UINT32 map_sync_count;
+    UINT32 queue_occupancy_avg;     /* bytes queued when submitting */
+    UINT32 queue_occupancy_max;
+    struct
+    {
+        UINT32 count;
+        UINT32 reserved;
+        UINT64 ticks;
+    } ops[WINED3D_CS_STATS_MAX_OPS];
+    char op_names[WINED3D_CS_STATS_MAX_OPS][WINED3D_CS_STATS_OP_NAME_SIZE];
+};
+
 typedef HRESULT (CDECL *wined3d_device_reset_cb)(struct wined3d_resource *resource);
 
 struct wined3d_streaming_buffer
@@ -23,6 +23,7 @@
 
 #include "config.h"
 
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 
@@ -81,8 +82,124 @@ struct completion
     int            closed;
     int                esync_fd;
     unsigned int       fsync_idx;
+    unsigned int       ring_idx;   /* shared queue, see get_completion_ring */
+    completion_ring_t *ring;
 };
 
+/* Messages are posted to the shared ring whenever it has room and the server
+ * list is empty; the list only holds the overflow, which is always newer than
+ * the ring contents. Clients post and remove through the ring directly.
+ *
+ * A client which can't wait on the ring (no fsync on its side, no ring
+ * mapping, or an alertable wait without an APC futex) has to wait here, but
+ * the server doesn't see posts that go through the ring. Such a wait retires
+ * the ring: the port falls back to the server queue for good, and clients
+ * stop using the ring once they see the retired flag. */
+
+static int completion_ring_push( completion_ring_t *ring, apc_param_t ckey, apc_param_t cvalue,
+                                 unsigned int status, apc_param_t information )
+{
+    unsigned int pos = __atomic_load_n( &ring->enqueue_pos, __ATOMIC_RELAXED );
+    completion_ring_entry_t *entry;
+    int diff;
+
+    for (;;)
+    {
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = (int)(__atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - pos);
+        if (!diff)
+        {
+            if (__atomic_compare_exchange_n( &ring->enqueue_pos, &pos, pos + 1, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+                break;
+        }
+        else if (diff < 0) return 0;  /* full */
+        else pos = __atomic_load_n( &ring->enqueue_pos, __ATOMIC_RELAXED );
+    }
+
+    entry->ckey = ckey;
+    entry->cvalue = cvalue;
+    entry->status = status;
+    entry->information = information;
+    __atomic_store_n( &entry->seq, pos + 1, __ATOMIC_RELEASE );
+    return 1;
+}
+
+static int completion_ring_pop( completion_ring_t *ring, struct comp_msg *msg )
+{
+    unsigned int pos = __atomic_load_n( &ring->dequeue_pos, __ATOMIC_RELAXED );
+    completion_ring_entry_t *entry;
+    int diff;
+
+    for (;;)
+    {
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = (int)(__atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - (pos + 1));
+        if (!diff)
+        {
+            if (__atomic_compare_exchange_n( &ring->dequeue_pos, &pos, pos + 1, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+                break;
+        }
+        else if (diff < 0) return 0;  /* empty */
+        else pos = __atomic_load_n( &ring->dequeue_pos, __ATOMIC_RELAXED );
+    }
+
+    msg->ckey = entry->ckey;
+    msg->cvalue = entry->cvalue;
+    msg->status = entry->status;
+    msg->information = entry->information;
+    __atomic_store_n( &entry->seq, pos + COMPLETION_RING_SIZE, __ATOMIC_RELEASE );
+    return 1;
+}
+
+static unsigned int completion_ring_depth( struct completion *completion )
+{
+    if (!completion->ring) return 0;
+    return __atomic_load_n( &completion->ring->enqueue_pos, __ATOMIC_SEQ_CST ) -
+           __atomic_load_n( &completion->ring->dequeue_pos, __ATOMIC_SEQ_CST );
+}
+
+/* move messages left in a ring into the server queue, at its head when
+ * retiring the ring since those messages are older than the overflow */
+static int drain_completion_ring( struct completion *completion, int at_head )
+{
+    struct list *prev = at_head ? &completion->queue : list_tail( &completion->queue );
+    struct comp_msg *msg;
+    int count = 0;
+
+    if (!prev) prev = &completion->queue;
+    for (;;)
+    {
+        if (!(msg = mem_alloc( sizeof(*msg) ))) break;
+        if (!completion_ring_pop( completion->ring, msg ))
+        {
+            free( msg );
+            break;
+        }
+        list_add_after( prev, &msg->queue_entry );
+        prev = &msg->queue_entry;
+        completion->depth++;
+        count++;
+    }
+    return count;
+}
+
+static void retire_completion_ring( struct completion *completion )
+{
+    __atomic_store_n( &completion->ring->retired, 1, __ATOMIC_SEQ_CST );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    drain_completion_ring( completion, 1 );
+    __atomic_store_n( &completion->ring->overflow, completion->depth, __ATOMIC_SEQ_CST );
+    /* let threads sleeping on the ring notice */
+    fsync_wake_completion_ring( completion->ring, INT_MAX );
+}
+
+static int completion_ring_retired( struct completion *completion )
+{
+    return completion->ring && __atomic_load_n( &completion->ring->retired, __ATOMIC_SEQ_CST );
+}
+
 static void completion_wait_dump( struct object*, int );
 static int completion_wait_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void completion_wait_satisfied( struct object *obj, struct wait_queue_entry *entry );
@@ -204,6 +321,7 @@ static void completion_destroy( struct object *obj)
 
     if (do_esync()) close( completion->esync_fd );
     if (completion->fsync_idx) fsync_free_shm_idx( completion->fsync_idx );
+    if (completion->ring_idx) fsync_free_completion_ring( completion->ring_idx );
 
     LIST_FOR_EACH_ENTRY_SAFE( tmp, next, &completion->queue, struct comp_msg, queue_entry )
     {
@@ -216,14 +334,14 @@ static void completion_dump( struct object *obj, int verbose )
     struct completion *completion = (struct completion *) obj;
 
     assert( obj->ops == &completion_ops );
-    fprintf( stderr, "Completion depth=%u\n", completion->depth );
+    fprintf( stderr, "Completion depth=%u\n", completion->depth + completion_ring_depth( completion ) );
 }
 
 static int completion_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct completion *completion = (struct completion *)obj;
 
-    return !list_empty( &completion->queue ) || completion->closed;
+    return !list_empty( &completion->queue ) || completion_ring_depth( completion ) || completion->closed;
 }
 
 static int completion_get_esync_fd( struct object *obj, enum esync_type *type )
@@ -262,6 +380,11 @@ static int completion_close_handle( struct object *obj, struct process *process,
         }
     }
     completion->closed = 1;
+    if (completion->ring)
+    {
+        __atomic_store_n( &completion->ring->closed, 1, __ATOMIC_SEQ_CST );
+        fsync_wake_completion_ring( completion->ring, INT_MAX );
+    }
     wake_up( obj, 0 );
     return 1;
 }
@@ -311,11 +434,18 @@ static struct completion *create_completion( struct object *root, const struct u
             list_init( &completion->wait_queue );
             completion->depth = 0;
             completion->closed = 0;
+            completion->ring_idx = 0;
+            completion->ring = NULL;
         }
     }
     if (do_esync()) completion->esync_fd = esync_create_fd( 0, 0 );
     completion->fsync_idx = 0;
     if (do_fsync()) completion->fsync_idx = fsync_alloc_shm( 0, 0 );
+    if (do_fsync() && !completion->ring_idx &&
+        (completion->ring_idx = fsync_alloc_completion_ring( completion->fsync_idx )))
+        completion->ring = fsync_get_completion_ring( completion->ring_idx );
+    else if (completion->ring)
+        completion->ring->event_idx = completion->fsync_idx;
     return completion;
 }
 
@@ -327,10 +457,21 @@ struct completion *get_completion_obj( struct process *process, obj_handle_t han
 void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
                      unsigned int status, apc_param_t information )
 {
-    struct comp_msg *msg = mem_alloc( sizeof( *msg ) );
+    struct comp_msg *msg;
     struct completion_wait *wait;
 
-    if (!msg)
+    /* pick up anything posted to a retired ring before the client noticed */
+    if (completion_ring_retired( completion )) drain_completion_ring( completion, 0 );
+
+    if (completion->ring && !completion_ring_retired( completion ) && list_empty( &completion->queue ) &&
+        completion_ring_push( completion->ring, ckey, cvalue, status, information ))
+    {
+        fsync_wake_completion_ring( completion->ring, 1 );
+        wake_up( &completion->obj, 0 );
+        return;
+    }
+
+    if (!(msg = mem_alloc( sizeof( *msg ) )))
         return;
 
     msg->ckey = ckey;
@@ -340,6 +481,11 @@ void add_completion( struct completion *completion, apc_param_t ckey, apc_param_
 
     list_add_tail( &completion->queue, &msg->queue_entry );
     completion->depth++;
+    if (completion->ring)
+    {
+        __atomic_store_n( &completion->ring->overflow, completion->depth, __ATOMIC_SEQ_CST );
+        fsync_wake_completion_ring( completion->ring, 1 );
+    }
     LIST_FOR_EACH_ENTRY( wait, &completion->wait_queue, struct completion_wait, wait_queue_entry )
     {
         wake_up( &wait->obj, 1 );
@@ -390,6 +536,40 @@ DECL_HANDLER(add_completion)
     release_object( completion );
 }
 
+static void remove_completion_from_ring( struct completion *completion, struct remove_completion_reply *reply )
+{
+    struct comp_msg ring_msg, *msg = NULL;
+    struct list *entry;
+
+    reply->wait_handle = 0;
+    if (completion_ring_pop( completion->ring, &ring_msg )) msg = &ring_msg;
+    else if ((entry = list_head( &completion->queue )))
+    {
+        list_remove( entry );
+        completion->depth--;
+        __atomic_store_n( &completion->ring->overflow, completion->depth, __ATOMIC_SEQ_CST );
+        msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+    }
+    else
+    {
+        set_error( STATUS_PENDING );
+        return;
+    }
+
+    reply->ckey = msg->ckey;
+    reply->cvalue = msg->cvalue;
+    reply->status = msg->status;
+    reply->information = msg->information;
+    if (msg != &ring_msg) free( msg );
+
+    if (list_empty( &completion->queue ) && !completion_ring_depth( completion ))
+    {
+        fsync_clear( &completion->obj );
+        /* a client may have posted in the meantime */
+        if (completion_ring_depth( completion )) fsync_wake_up( &completion->obj );
+    }
+}
+
 /* get completion from completion port */
 DECL_HANDLER(remove_completion)
 {
@@ -400,6 +580,19 @@ DECL_HANDLER(remove_completion)
 
     if (!completion) return;
 
+    if (completion->ring && req->ring && !completion_ring_retired( completion ))
+    {
+        /* clients wait on the ring themselves and only come here for the overflow */
+        remove_completion_from_ring( completion, reply );
+        release_object( completion );
+        return;
+    }
+    if (completion->ring)
+    {
+        if (!completion_ring_retired( completion )) retire_completion_ring( completion );
+        else drain_completion_ring( completion, 0 );
+    }
+
     entry = list_head( &completion->queue );
     if (current->completion_wait && current->completion_wait->completion != completion)
         cleanup_thread_completion( current );
@@ -464,7 +657,23 @@ DECL_HANDLER(query_completion)
 
     if (!completion) return;
 
-    reply->depth = completion->depth;
+    reply->depth = completion->depth + completion_ring_depth( completion );
+
+    release_object( completion );
+}
+
+/* get the shared queue of a completion port */
+DECL_HANDLER(get_completion_ring)
+{
+    struct completion *completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+
+    if (!completion) return;
+
+    if (!(reply->ring_idx = completion->ring_idx) || completion_ring_retired( completion ))
+    {
+        reply->ring_idx = 0;
+        set_error( STATUS_NOT_IMPLEMENTED );
+    }
 
     release_object( completion );
 }
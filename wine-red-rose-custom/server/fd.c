@@ -594,7 +594,9 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (epoll_fd == -1) break;  /* an error occurred with epoll */
 
+        allow_request_workers();
         ret = epoll_wait( epoll_fd, events, ARRAY_SIZE( events ), timeout );
+        wait_for_request_workers();
         set_current_time();
 
         /* put the events into the pollfd array first, like poll does */
@@ -688,6 +690,7 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (kqueue_fd == -1) break;  /* an error occurred with kqueue */
 
+        allow_request_workers();
         if (timeout != -1)
         {
             struct timespec ts;
@@ -697,6 +700,7 @@ static inline void main_loop_epoll(void)
             ret = kevent( kqueue_fd, NULL, 0, events, ARRAY_SIZE( events ), &ts );
         }
         else ret = kevent( kqueue_fd, NULL, 0, events, ARRAY_SIZE( events ), NULL );
+        wait_for_request_workers();
 
         set_current_time();
 
@@ -791,6 +795,7 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (port_fd == -1) break;  /* an error occurred with event completion */
 
+        allow_request_workers();
         if (timeout != -1)
         {
             struct timespec ts;
@@ -800,6 +805,7 @@ static inline void main_loop_epoll(void)
             ret = port_getn( port_fd, events, ARRAY_SIZE( events ), &nget, &ts );
         }
         else ret = port_getn( port_fd, events, ARRAY_SIZE( events ), &nget, NULL );
+        wait_for_request_workers();
 
 	if (ret == -1) break;  /* an error occurred with event completion */
 
@@ -973,7 +979,9 @@ void main_loop(void)
 
         if (!active_users) break;  /* last user removed by a timeout */
 
+        allow_request_workers();
         ret = poll( pollfd, nb_users, timeout );
+        wait_for_request_workers();
         set_current_time();
 
         if (ret > 0)
@@ -1765,6 +1773,33 @@ struct fd *alloc_pseudo_fd( const struct fd_ops *fd_user_ops, struct object *use
     return fd;
 }
 
+/* attach a unix fd to a pseudo fd, so that clients can do the I/O on it themselves */
+/* the fd object takes ownership of unix_fd on success */
+int attach_pseudo_fd_unix_fd( struct fd *fd, int unix_fd )
+{
+    assert( !fd->inode && fd->unix_fd == -1 && fd->poll_index == -1 );
+
+    if ((fd->poll_index = add_poll_user( fd )) == -1) return 0;
+    fd->unix_fd   = unix_fd;
+    fd->cacheable = 1;
+    return 1;
+}
+
+/* close the unix fd attached to a pseudo fd; it can no longer be cached by clients */
+void detach_pseudo_fd_unix_fd( struct fd *fd )
+{
+    assert( !fd->inode );
+
+    if (fd->poll_index != -1)
+    {
+        remove_poll_user( fd, fd->poll_index );
+        fd->poll_index = -1;
+    }
+    if (fd->unix_fd != -1) close( fd->unix_fd );
+    fd->unix_fd   = -1;
+    fd->cacheable = 0;
+}
+
 /* duplicate an fd object for a different user */
 struct fd *dup_fd_object( struct fd *orig, unsigned int access, unsigned int sharing, unsigned int options )
 {
@@ -81,6 +81,8 @@ struct fd_ops
 
 extern struct fd *alloc_pseudo_fd( const struct fd_ops *fd_user_ops, struct object *user,
                                    unsigned int options );
+extern int attach_pseudo_fd_unix_fd( struct fd *fd, int unix_fd );
+extern void detach_pseudo_fd_unix_fd( struct fd *fd );
 extern struct fd *open_fd( struct fd *root, const char *name, struct unicode_str nt_name,
                            int flags, mode_t *mode, unsigned int access,
                            unsigned int sharing, unsigned int options );
@@ -82,6 +82,8 @@ static uint32_t shm_idx_free_search_start_hint;
 
 #define BITS_IN_FREE_MAP_WORD (8 * sizeof(*shm_idx_free_map))
 
+static void init_completion_rings(void);
+
 static void shm_cleanup(void)
 {
     close( shm_fd );
@@ -125,6 +127,8 @@ void fsync_init(void)
     shm_idx_free_map[0] &= ~(uint64_t)1; /* Avoid allocating shm_index 0. */
 
     atexit( shm_cleanup );
+
+    init_completion_rings();
 }
 
 static struct list mutex_list = LIST_INIT(mutex_list);
@@ -497,6 +501,136 @@ void fsync_reset_event( struct fsync *fsync )
     __atomic_store_n( &event->signaled, 0, __ATOMIC_SEQ_CST );
 }
 
+/* Completion port queues live in a separate shared memory file, since they
+ * don't fit in a 16-byte slot. Like the slots they are never moved once
+ * mapped, so clients can keep using them without further server calls. */
+
+#define COMPLETION_RINGS_PER_PAGE (FSYNC_SHM_PAGE_SIZE / sizeof(completion_ring_t))
+
+static char ring_shm_name[40];
+static int ring_shm_fd = -1;
+static off_t ring_shm_size;
+static void **ring_shm_addrs;
+static int ring_shm_addrs_size;
+static unsigned int ring_count;     /* number of ring indices handed out so far */
+static unsigned int *ring_free_list;
+static unsigned int ring_free_count, ring_free_size;
+
+static void ring_shm_cleanup(void)
+{
+    close( ring_shm_fd );
+    if (shm_unlink( ring_shm_name ) == -1)
+        perror( "shm_unlink" );
+}
+
+static void init_completion_rings(void)
+{
+    sprintf( ring_shm_name, "%s-iocp", shm_name );
+
+    shm_unlink( ring_shm_name );
+    if ((ring_shm_fd = shm_open( ring_shm_name, O_RDWR | O_CREAT | O_EXCL, 0644 )) == -1)
+    {
+        perror( "shm_open" );
+        return;
+    }
+    ring_count = 1;  /* avoid allocating index 0 */
+    atexit( ring_shm_cleanup );
+}
+
+completion_ring_t *fsync_get_completion_ring( unsigned int idx )
+{
+    int entry  = idx / COMPLETION_RINGS_PER_PAGE;
+    int offset = (idx % COMPLETION_RINGS_PER_PAGE) * sizeof(completion_ring_t);
+
+    if (entry >= ring_shm_addrs_size)
+    {
+        int new_size = max(ring_shm_addrs_size * 2, entry + 1);
+        void **new_addrs;
+
+        if (!(new_addrs = realloc( ring_shm_addrs, new_size * sizeof(ring_shm_addrs[0]) )))
+        {
+            fprintf( stderr, "fsync: couldn't expand ring_shm_addrs array to size %d\n", new_size );
+            return NULL;
+        }
+        memset( new_addrs + ring_shm_addrs_size, 0,
+                (new_size - ring_shm_addrs_size) * sizeof(ring_shm_addrs[0]) );
+        ring_shm_addrs = new_addrs;
+        ring_shm_addrs_size = new_size;
+    }
+
+    if (!ring_shm_addrs[entry])
+    {
+        void *addr = mmap( NULL, FSYNC_SHM_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, ring_shm_fd,
+                           (off_t)entry * FSYNC_SHM_PAGE_SIZE );
+        if (addr == MAP_FAILED)
+        {
+            fprintf( stderr, "fsync: failed to map ring page %d: ", entry );
+            perror( "mmap" );
+            return NULL;
+        }
+        ring_shm_addrs[entry] = addr;
+    }
+
+    return (completion_ring_t *)((char *)ring_shm_addrs[entry] + offset);
+}
+
+unsigned int fsync_alloc_completion_ring( unsigned int event_idx )
+{
+    completion_ring_t *ring;
+    unsigned int i, idx;
+
+    if (ring_shm_fd == -1) return 0;
+
+    if (ring_free_count) idx = ring_free_list[--ring_free_count];
+    else
+    {
+        idx = ring_count;
+        while ((off_t)(idx / COMPLETION_RINGS_PER_PAGE + 1) * FSYNC_SHM_PAGE_SIZE > ring_shm_size)
+        {
+            if (ftruncate( ring_shm_fd, ring_shm_size + FSYNC_SHM_PAGE_SIZE ) == -1)
+            {
+                fprintf( stderr, "fsync: couldn't expand %s to size %jd: ",
+                         ring_shm_name, (intmax_t)(ring_shm_size + FSYNC_SHM_PAGE_SIZE) );
+                perror( "ftruncate" );
+                return 0;
+            }
+            ring_shm_size += FSYNC_SHM_PAGE_SIZE;
+        }
+        if (!fsync_get_completion_ring( idx )) return 0;
+        ring_count++;
+    }
+
+    ring = fsync_get_completion_ring( idx );
+    memset( ring, 0, offsetof( completion_ring_t, entries ) );
+    for (i = 0; i < COMPLETION_RING_SIZE; ++i)
+        ring->entries[i].seq = i;
+    ring->event_idx = event_idx;
+    return idx;
+}
+
+void fsync_free_completion_ring( unsigned int idx )
+{
+    if (ring_free_count == ring_free_size)
+    {
+        unsigned int new_size = max( ring_free_size * 2, 64 );
+        unsigned int *new_list;
+
+        /* leak the index rather than failing */
+        if (!(new_list = realloc( ring_free_list, new_size * sizeof(*new_list) ))) return;
+        ring_free_list = new_list;
+        ring_free_size = new_size;
+    }
+    ring_free_list[ring_free_count++] = idx;
+}
+
+/* Bump the ring futex after messages were posted, or the port was closed. */
+void fsync_wake_completion_ring( completion_ring_t *ring, int count )
+{
+    __atomic_add_fetch( &ring->signal, 1, __ATOMIC_SEQ_CST );
+    if (__atomic_load_n( &ring->waiters, __ATOMIC_SEQ_CST ))
+        futex_wake( &ring->signal, count );
+}
+
 struct mutex
 {
     int tid;
@@ -34,3 +34,7 @@ extern void fsync_set_event( struct fsync *fsync );
 extern void fsync_reset_event( struct fsync *fsync );
 extern void fsync_abandon_mutexes( struct thread *thread );
 extern void fsync_cleanup_process_shm_indices( process_id_t id );
+extern unsigned int fsync_alloc_completion_ring( unsigned int event_idx );
+extern void fsync_free_completion_ring( unsigned int idx );
+extern completion_ring_t *fsync_get_completion_ring( unsigned int idx );
+extern void fsync_wake_completion_ring( completion_ring_t *ring, int count );
@@ -380,6 +380,7 @@ int send_thread_signal( struct thread *thread, int sig )
         {
             thread->unix_pid = -1;
             thread->unix_tid = -1;
+            update_thread_shared_info( thread );
         }
     }
     if (debug_level && ret != -1)
@@ -249,6 +249,7 @@ int main( int argc, char *argv[] )
     init_directories( load_intl_file() );
     init_threading();
     init_registry();
+    init_request_workers();
     main_loop();
     return 0;
 }
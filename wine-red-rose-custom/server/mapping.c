@@ -439,6 +439,7 @@ static void set_process_machine( struct process *process, struct memory_view *vi
         process->machine = native_machine;
     else
         process->machine = view->image.machine;
+    update_process_shared_info( process );
 }
 
 static int generate_dll_event( struct thread *thread, int code, struct memory_view *view )
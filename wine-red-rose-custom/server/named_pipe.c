@@ -23,11 +23,30 @@
 #include "config.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#ifdef HAVE_SYS_FILIO_H
+#include <sys/filio.h>
+#endif
+#if defined(__linux__) && !defined(SIOCOUTQ)
+#define SIOCOUTQ TIOCOUTQ  /* from linux/sockios.h */
+#endif
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE)
+#include <sys/epoll.h>
+#endif
+
+/* flushes need to know when the other end has read all the socket data */
+#if defined(SIOCOUTQ) && defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE)
+#define USE_PIPE_SOCKETS
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -67,6 +86,8 @@ struct pipe_end
     struct list          message_queue;
     struct async_queue   read_q;     /* read queue */
     struct async_queue   write_q;    /* write queue */
+    int                  socket;     /* byte data is transferred by the clients over the fd socket */
+    struct fd           *flush_fd;   /* epoll fd waiting for the other end to read the socket data */
 };
 
 struct pipe_server
@@ -152,8 +173,11 @@ static void pipe_end_read( struct fd *fd, struct async *async, file_pos_t pos );
 static void pipe_end_write( struct fd *fd, struct async *async_data, file_pos_t pos );
 static void pipe_end_flush( struct fd *fd, struct async *async );
 static void pipe_end_get_volume_info( struct fd *fd, struct async *async, unsigned int info_class );
+static void pipe_end_queue_async( struct fd *fd, struct async *async, int type, int count );
 static void pipe_end_reselect_async( struct fd *fd, struct async_queue *queue );
 static void pipe_end_get_file_info( struct fd *fd, obj_handle_t handle, unsigned int info_class );
+static int pipe_end_get_poll_events( struct fd *fd );
+static void pipe_end_poll_event( struct fd *fd, int event );
 
 /* server end functions */
 static void pipe_server_dump( struct object *obj, int verbose );
@@ -192,8 +216,8 @@ static const struct object_ops pipe_server_ops =
 
 static const struct fd_ops pipe_server_fd_ops =
 {
-    default_fd_get_poll_events,   /* get_poll_events */
-    default_poll_event,           /* poll_event */
+    pipe_end_get_poll_events,     /* get_poll_events */
+    pipe_end_poll_event,          /* poll_event */
     pipe_end_get_fd_type,         /* get_fd_type */
     pipe_end_read,                /* read */
     pipe_end_write,               /* write */
@@ -202,7 +226,7 @@ static const struct fd_ops pipe_server_fd_ops =
     pipe_end_get_volume_info,     /* get_volume_info */
     pipe_server_ioctl,            /* ioctl */
     default_fd_cancel_async,      /* cancel_async */
-    no_fd_queue_async,            /* queue_async */
+    pipe_end_queue_async,         /* queue_async */
     pipe_end_reselect_async       /* reselect_async */
 };
 
@@ -238,8 +262,8 @@ static const struct object_ops pipe_client_ops =
 
 static const struct fd_ops pipe_client_fd_ops =
 {
-    default_fd_get_poll_events,   /* get_poll_events */
-    default_poll_event,           /* poll_event */
+    pipe_end_get_poll_events,     /* get_poll_events */
+    pipe_end_poll_event,          /* poll_event */
     pipe_end_get_fd_type,         /* get_fd_type */
     pipe_end_read,                /* read */
     pipe_end_write,               /* write */
@@ -248,7 +272,7 @@ static const struct fd_ops pipe_client_fd_ops =
     pipe_end_get_volume_info,     /* get_volume_info */
     pipe_client_ioctl,            /* ioctl */
     default_fd_cancel_async,      /* cancel_async */
-    no_fd_queue_async,            /* queue_async */
+    pipe_end_queue_async,         /* queue_async */
     pipe_end_reselect_async       /* reselect_async */
 };
 
@@ -418,12 +442,182 @@ static void free_message( struct pipe_message *message )
     free( message );
 }
 
+static int use_pipe_sockets(void)
+{
+#ifdef USE_PIPE_SOCKETS
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEPIPESOCKETS" );
+        enabled = env && atoi( env );
+    }
+    return enabled;
+#else
+    return 0;
+#endif
+}
+
+/* let the clients transfer byte mode data directly over a socketpair */
+static void pipe_end_create_socket( struct pipe_end *server, struct pipe_end *client )
+{
+    int fds[2];
+
+    /* a stream socket doesn't keep the message boundaries, message mode needs the message queue */
+    if (!use_pipe_sockets() || server->pipe->message_mode) return;
+    if ((server->flags | client->flags) & NAMED_PIPE_NONBLOCKING_MODE) return;
+    if (socketpair( PF_UNIX, SOCK_STREAM, 0, fds )) return;
+
+    fcntl( fds[0], F_SETFL, O_NONBLOCK );
+    fcntl( fds[1], F_SETFL, O_NONBLOCK );
+    if (!attach_pseudo_fd_unix_fd( server->fd, fds[0] ))
+    {
+        close( fds[0] );
+        close( fds[1] );
+        return;
+    }
+    if (!attach_pseudo_fd_unix_fd( client->fd, fds[1] ))
+    {
+        detach_pseudo_fd_unix_fd( server->fd );
+        close( fds[1] );
+        return;
+    }
+    server->socket = client->socket = 1;
+}
+
+/* amount of data that can be read from the socket of a pipe end */
+static data_size_t pipe_end_socket_avail( struct pipe_end *pipe_end )
+{
+    int avail;
+
+    if (ioctl( get_unix_fd( pipe_end->fd ), FIONREAD, &avail ) == -1 || avail < 0) return 0;
+    return avail;
+}
+
+/* amount of data written to the socket of a pipe end that the other end didn't read yet */
+static data_size_t pipe_end_socket_pending( struct pipe_end *pipe_end )
+{
+#ifdef SIOCOUTQ
+    int pending;
+
+    if (ioctl( get_unix_fd( pipe_end->fd ), SIOCOUTQ, &pending ) == -1 || pending < 0) return 0;
+    return pending;
+#else
+    return 0;
+#endif
+}
+
+static void pipe_end_unwatch_flush( struct pipe_end *pipe_end )
+{
+    if (!pipe_end->flush_fd) return;
+    release_object( pipe_end->flush_fd );
+    pipe_end->flush_fd = NULL;
+}
+
+#ifdef USE_PIPE_SOCKETS
+
+static int pipe_flush_get_poll_events( struct fd *fd );
+static void pipe_flush_poll_event( struct fd *fd, int event );
+
+static const struct fd_ops pipe_flush_fd_ops =
+{
+    pipe_flush_get_poll_events,   /* get_poll_events */
+    pipe_flush_poll_event,        /* poll_event */
+    NULL,                         /* get_fd_type */
+    no_fd_read,                   /* read */
+    no_fd_write,                  /* write */
+    no_fd_flush,                  /* flush */
+    no_fd_get_file_info,          /* get_file_info */
+    no_fd_get_volume_info,        /* get_volume_info */
+    no_fd_ioctl,                  /* ioctl */
+    NULL,                         /* cancel_async */
+    NULL,                         /* queue_async */
+    NULL                          /* reselect_async */
+};
+
+static int pipe_flush_get_poll_events( struct fd *fd )
+{
+    return POLLIN;
+}
+
+/* the other end read some data, check if the flush is complete */
+static void pipe_flush_poll_event( struct fd *fd, int event )
+{
+    struct pipe_end *pipe_end = get_fd_user( fd );
+    struct epoll_event ev;
+
+    epoll_wait( get_unix_fd( fd ), &ev, 1, 0 );
+    if (pipe_end->connection && pipe_end_socket_pending( pipe_end )) return;
+
+    pipe_end_unwatch_flush( pipe_end );
+    fd_async_wake_up( pipe_end->fd, ASYNC_TYPE_WAIT, STATUS_SUCCESS );
+}
+
+/* The socket wakes up its writers whenever the other end frees some of the
+ * queued data, but it stays writable while data is queued, so the main loop
+ * can't wait for that. An edge-triggered epoll fd gets readable once per
+ * wakeup instead, and that one can be polled like any other fd. */
+static int pipe_end_watch_flush( struct pipe_end *pipe_end )
+{
+    struct epoll_event ev;
+    int epoll_fd;
+
+    if (pipe_end->flush_fd) return 1;
+
+    /* adding the socket reports it right away if the data got read in the meantime */
+    if ((epoll_fd = epoll_create( 1 )) == -1)
+    {
+        file_set_error();
+        return 0;
+    }
+    memset( &ev, 0, sizeof(ev) );
+    ev.events = EPOLLOUT | EPOLLET;
+    if (epoll_ctl( epoll_fd, EPOLL_CTL_ADD, get_unix_fd( pipe_end->fd ), &ev ) == -1)
+    {
+        file_set_error();
+        close( epoll_fd );
+        return 0;
+    }
+    if (!(pipe_end->flush_fd = create_anonymous_fd( &pipe_flush_fd_ops, epoll_fd, &pipe_end->obj, 0 )))
+        return 0;
+    set_fd_events( pipe_end->flush_fd, POLLIN );
+    return 1;
+}
+
+#else  /* USE_PIPE_SOCKETS */
+
+static int pipe_end_watch_flush( struct pipe_end *pipe_end )
+{
+    set_error( STATUS_NOT_SUPPORTED );
+    return 0;
+}
+
+#endif  /* USE_PIPE_SOCKETS */
+
+static void pipe_end_close_socket( struct pipe_end *pipe_end, unsigned int status )
+{
+    if (!pipe_end->socket) return;
+
+    shutdown( get_unix_fd( pipe_end->fd ), SHUT_RDWR );
+    pipe_end_unwatch_flush( pipe_end );
+
+    /* the data still queued can be read when the other end is closed, but not after a disconnect */
+    if (status != STATUS_PIPE_DISCONNECTED) return;
+
+    fd_async_wake_up( pipe_end->fd, ASYNC_TYPE_READ, status );
+    fd_async_wake_up( pipe_end->fd, ASYNC_TYPE_WRITE, status );
+    async_wake_up( &pipe_end->write_q, status );
+    detach_pseudo_fd_unix_fd( pipe_end->fd );
+    pipe_end->socket = 0;
+}
+
 static void pipe_end_disconnect( struct pipe_end *pipe_end, unsigned int status )
 {
     struct pipe_end *connection = pipe_end->connection;
     struct pipe_message *message, *next;
     struct async *async;
 
+    pipe_end_close_socket( pipe_end, status );
     pipe_end->connection = NULL;
 
     pipe_end->state = status == STATUS_PIPE_DISCONNECTED
@@ -624,6 +818,16 @@ static void pipe_end_flush( struct fd *fd, struct async *async )
         return;
     }
 
+    if (pipe_end->socket)
+    {
+        if (pipe_end->connection && pipe_end_socket_pending( pipe_end ) && pipe_end_watch_flush( pipe_end ))
+        {
+            fd_queue_async( pipe_end->fd, async, ASYNC_TYPE_WAIT );
+            set_error( STATUS_PENDING );
+        }
+        return;
+    }
+
     if (pipe_end->connection && !list_empty( &pipe_end->connection->message_queue ))
     {
         fd_queue_async( pipe_end->fd, async, ASYNC_TYPE_WAIT );
@@ -636,6 +840,8 @@ static data_size_t pipe_end_get_avail( struct pipe_end *pipe_end )
     struct pipe_message *message;
     data_size_t avail = 0;
 
+    if (pipe_end->socket) return pipe_end_socket_avail( pipe_end );
+
     LIST_FOR_EACH_ENTRY( message, &pipe_end->message_queue, struct pipe_message, entry )
         avail += message->iosb->in_size - message->read_pos;
 
@@ -971,6 +1177,109 @@ static void reselect_write_queue( struct pipe_end *pipe_end )
     reselect_read_queue( reader, 0 );
 }
 
+/* The clients normally do the I/O on the socket themselves. Requests only
+ * get here when they raced with the socket creation, or when a synchronous
+ * operation has to wait, so that the wait can be canceled or interrupted
+ * by APCs. These return STATUS_PENDING when the async has to wait for the
+ * socket to become ready, and complete it on success. */
+static unsigned int pipe_end_socket_read( struct pipe_end *pipe_end, struct async *async )
+{
+    struct iosb *iosb = async_get_iosb( async );
+    data_size_t size = iosb->out_size;
+    ssize_t ret;
+    char *buf;
+
+    release_object( iosb );
+    if (!(buf = mem_alloc( max( size, 1 ) ))) return STATUS_NO_MEMORY;
+
+    /* zero-length reads only wait for data to be available */
+    if (size) ret = recv( get_unix_fd( pipe_end->fd ), buf, size, MSG_DONTWAIT );
+    else ret = recv( get_unix_fd( pipe_end->fd ), buf, 1, MSG_PEEK | MSG_DONTWAIT );
+    if (ret <= 0)
+    {
+        free( buf );
+        if (ret == -1 && (errno == EAGAIN || errno == EINTR)) return STATUS_PENDING;
+        return STATUS_PIPE_BROKEN;
+    }
+    if (!size) ret = 0;
+    async_request_complete( async, STATUS_SUCCESS, ret, ret, buf );
+    return STATUS_SUCCESS;
+}
+
+static unsigned int pipe_end_socket_write( struct pipe_end *pipe_end, struct async *async )
+{
+    struct iosb *iosb = async_get_iosb( async );
+    unsigned int status = STATUS_SUCCESS;
+    ssize_t ret;
+
+    while (iosb->result < iosb->in_size)
+    {
+        if ((ret = send( get_unix_fd( pipe_end->fd ), (const char *)iosb->in_data + iosb->result,
+                         iosb->in_size - iosb->result, MSG_DONTWAIT | MSG_NOSIGNAL )) >= 0)
+        {
+            iosb->result += ret;
+            continue;
+        }
+        if (errno == EINTR) continue;
+        status = errno == EAGAIN ? STATUS_PENDING : STATUS_PIPE_CLOSING;
+        break;
+    }
+    if (!status) async_request_complete( async, STATUS_SUCCESS, iosb->result, 0, NULL );
+    release_object( iosb );
+    return status;
+}
+
+/* complete the waiting socket asyncs that can proceed */
+static void pipe_end_socket_reselect( struct pipe_end *pipe_end, int event )
+{
+    struct async *async;
+    unsigned int status;
+
+    ignore_reselect = 1;
+    if (event & (POLLIN | POLLERR | POLLHUP))
+    {
+        while ((async = find_pending_async( &pipe_end->read_q )))
+        {
+            status = pipe_end_socket_read( pipe_end, async );
+            if (status && status != STATUS_PENDING) async_request_complete( async, status, 0, 0, NULL );
+            release_object( async );
+            if (status == STATUS_PENDING) break;
+        }
+    }
+    if (event & (POLLOUT | POLLERR | POLLHUP))
+    {
+        while ((async = find_pending_async( &pipe_end->write_q )))
+        {
+            status = pipe_end_socket_write( pipe_end, async );
+            if (status && status != STATUS_PENDING) async_request_complete( async, status, 0, 0, NULL );
+            release_object( async );
+            if (status == STATUS_PENDING) break;
+        }
+    }
+    ignore_reselect = 0;
+}
+
+static int pipe_end_get_poll_events( struct fd *fd )
+{
+    struct pipe_end *pipe_end = get_fd_user( fd );
+    int events = default_fd_get_poll_events( fd );
+
+    if (pipe_end->socket)
+    {
+        if (async_waiting( &pipe_end->read_q )) events |= POLLIN;
+        if (async_waiting( &pipe_end->write_q )) events |= POLLOUT;
+    }
+    return events;
+}
+
+static void pipe_end_poll_event( struct fd *fd, int event )
+{
+    struct pipe_end *pipe_end = get_fd_user( fd );
+
+    if (pipe_end->socket) pipe_end_socket_reselect( pipe_end, event );
+    default_poll_event( fd, event );
+}
+
 static void pipe_end_read( struct fd *fd, struct async *async, file_pos_t pos )
 {
     struct pipe_end *pipe_end = get_fd_user( fd );
@@ -996,6 +1305,20 @@ static void pipe_end_read( struct fd *fd, struct async *async, file_pos_t pos )
         return;
     }
 
+    if (pipe_end->socket)
+    {
+        unsigned int status = STATUS_PENDING;
+
+        if (!async_waiting( &pipe_end->read_q )) status = pipe_end_socket_read( pipe_end, async );
+        if (status == STATUS_PENDING)
+        {
+            queue_async( &pipe_end->read_q, async );
+            set_fd_events( fd, pipe_end_get_poll_events( fd ) );
+        }
+        set_error( status ? status : STATUS_PENDING );
+        return;
+    }
+
     queue_async( &pipe_end->read_q, async );
     reselect_read_queue( pipe_end, 0 );
     set_error( STATUS_PENDING );
@@ -1024,6 +1347,20 @@ static void pipe_end_write( struct fd *fd, struct async *async, file_pos_t pos )
 
     if (!pipe_end->pipe->message_mode && !get_req_data_size()) return;
 
+    if (pipe_end->socket)
+    {
+        unsigned int status = STATUS_PENDING;
+
+        if (!async_waiting( &pipe_end->write_q )) status = pipe_end_socket_write( pipe_end, async );
+        if (status == STATUS_PENDING)
+        {
+            queue_async( &pipe_end->write_q, async );
+            set_fd_events( fd, pipe_end_get_poll_events( fd ) );
+        }
+        set_error( status ? status : STATUS_PENDING );
+        return;
+    }
+
     iosb = async_get_iosb( async );
     message = queue_message( pipe_end->connection, iosb );
     release_object( iosb );
@@ -1041,17 +1378,67 @@ static void pipe_end_reselect_async( struct fd *fd, struct async_queue *queue )
 
     if (ignore_reselect) return;
 
-    if (&pipe_end->write_q == queue)
+    if (pipe_end->socket)
+    {
+        if (&pipe_end->read_q == queue || &pipe_end->write_q == queue)
+            set_fd_events( fd, pipe_end_get_poll_events( fd ) );
+        else
+            default_fd_reselect_async( fd, queue );
+    }
+    else if (&pipe_end->write_q == queue)
         reselect_write_queue( pipe_end );
     else if (&pipe_end->read_q == queue)
         reselect_read_queue( pipe_end, 0 );
 }
 
+static void pipe_end_queue_async( struct fd *fd, struct async *async, int type, int count )
+{
+    struct pipe_end *pipe_end = get_fd_user( fd );
+
+    /* the clients wait for the socket to become ready through the fd queues */
+    if (pipe_end->socket)
+        default_fd_queue_async( fd, async, type, count );
+    else
+        no_fd_queue_async( fd, async, type, count );
+}
+
 static enum server_fd_type pipe_end_get_fd_type( struct fd *fd )
 {
     return FD_TYPE_PIPE;
 }
 
+static void pipe_end_peek_socket( struct pipe_end *pipe_end, data_size_t reply_size )
+{
+    data_size_t avail = pipe_end_socket_avail( pipe_end );
+    FILE_PIPE_PEEK_BUFFER *buffer;
+    char *data = NULL;
+    ssize_t ret = 0;
+
+    if (pipe_end->state == FILE_PIPE_CLOSING_STATE && !avail)
+    {
+        set_error( STATUS_PIPE_BROKEN );
+        return;
+    }
+
+    reply_size = min( reply_size, avail );
+    if (reply_size)
+    {
+        if (!(data = mem_alloc( reply_size ))) return;
+        if ((ret = recv( get_unix_fd( pipe_end->fd ), data, reply_size, MSG_PEEK | MSG_DONTWAIT )) < 0)
+            ret = 0;
+    }
+
+    if ((buffer = set_reply_data_size( offsetof( FILE_PIPE_PEEK_BUFFER, Data[ret] ))))
+    {
+        buffer->NamedPipeState    = pipe_end->state;
+        buffer->ReadDataAvailable = avail;
+        buffer->NumberOfMessages  = 0;
+        buffer->MessageLength     = 0;
+        if (ret) memcpy( buffer->Data, data, ret );
+    }
+    free( data );
+}
+
 static void pipe_end_peek( struct pipe_end *pipe_end )
 {
     unsigned reply_size = get_reply_max_size();
@@ -1067,6 +1454,12 @@ static void pipe_end_peek( struct pipe_end *pipe_end )
     }
     reply_size -= offsetof( FILE_PIPE_PEEK_BUFFER, Data );
 
+    if (pipe_end->socket)
+    {
+        pipe_end_peek_socket( pipe_end, reply_size );
+        return;
+    }
+
     switch (pipe_end->state)
     {
     case FILE_PIPE_CONNECTED_STATE:
@@ -1296,6 +1689,8 @@ static void init_pipe_end( struct pipe_end *pipe_end, struct named_pipe *pipe,
     pipe_end->flags = pipe_flags;
     pipe_end->connection = NULL;
     pipe_end->buffer_size = buffer_size;
+    pipe_end->socket = 0;
+    pipe_end->flush_fd = NULL;
     init_async_queue( &pipe_end->read_q );
     init_async_queue( &pipe_end->write_q );
     list_init( &pipe_end->message_queue );
@@ -1322,7 +1717,8 @@ static struct pipe_server *create_pipe_server( struct named_pipe *pipe, unsigned
         release_object( server );
         return NULL;
     }
-    allow_fd_caching( server->pipe_end.fd );
+    /* byte mode server ends only become cacheable once they get a socket */
+    if (pipe->message_mode || !use_pipe_sockets()) allow_fd_caching( server->pipe_end.fd );
     set_fd_signaled( server->pipe_end.fd, 1 );
     async_wake_up( &pipe->waiters, STATUS_SUCCESS );
     return server;
@@ -1398,6 +1794,7 @@ static struct object *named_pipe_open_file( struct object *obj, unsigned int acc
         server->pipe_end.client_pid = client->client_pid;
         client->server_pid = server->pipe_end.server_pid;
         list_remove( &server->entry );
+        pipe_end_create_socket( &server->pipe_end, client );
     }
     return &client->obj;
 }
@@ -432,7 +432,8 @@ struct object *grab_object( void *ptr )
 {
     struct object *obj = (struct object *)ptr;
     assert( obj->refcount < INT_MAX );
-    obj->refcount++;
+    /* atomic since read-only requests may grab objects from several request workers */
+    __atomic_add_fetch( &obj->refcount, 1, __ATOMIC_RELAXED );
     return obj;
 }
 
@@ -441,7 +442,7 @@ void release_object( void *ptr )
 {
     struct object *obj = (struct object *)ptr;
     assert( obj->refcount );
-    if (!--obj->refcount)
+    if (!__atomic_sub_fetch( &obj->refcount, 1, __ATOMIC_ACQ_REL ))
     {
         assert( !obj->handle_count );
         /* if the refcount is 0, nobody can be in the wait queue */
@@ -486,6 +486,116 @@ static void kill_all_processes(void);
 static unsigned int index_from_ptid(unsigned int id) { return id / 4; }
 static unsigned int ptid_from_index(unsigned int index) { return index * 4; }
 
+static struct object *ptid_shm_mapping;   /* thread and process information shared with all clients */
+static ptid_shm_t *ptid_shm;              /* server view of the mapping */
+
+#if defined(__i386__) || defined(__x86_64__)
+#define __SHARED_INCREMENT_SEQ( x ) ++(x)
+#else
+#define __SHARED_INCREMENT_SEQ( x ) __atomic_add_fetch( &(x), 1, __ATOMIC_RELEASE )
+#endif
+
+#define SHARED_WRITE_BEGIN( ptr )                                    \
+    do {                                                             \
+        ptid_shm_t *shared = (ptr);                                  \
+        unsigned int __seq = __SHARED_INCREMENT_SEQ( shared->seq );  \
+        assert( (__seq & 1) != 0 );                                  \
+        do
+
+#define SHARED_WRITE_END                                             \
+        while(0);                                                    \
+        __seq = __SHARED_INCREMENT_SEQ( shared->seq ) - __seq;       \
+        assert( __seq == 1 );                                        \
+    } while(0);
+
+/* retrieve the shared memory entry of a process or thread id */
+static ptid_shm_t *get_ptid_shared_memory( unsigned int id )
+{
+    static int failed;
+    unsigned int index = PTID_SHM_INDEX( id );
+
+    assert( index_from_ptid( id ) - PTID_OFFSET == index );
+    if (index >= PTID_SHM_COUNT) return NULL;
+    if (!ptid_shm_mapping)
+    {
+        static const WCHAR nameW[] = {'p','t','i','d','s'};
+        static const struct unicode_str name = {nameW, sizeof(nameW)};
+        struct object *dir;
+
+        if (failed) return NULL;
+        if ((dir = create_thread_map_directory()))
+        {
+            ptid_shm_mapping = create_shared_mapping( dir, &name, PTID_SHM_COUNT * sizeof(*ptid_shm),
+                                                      OBJ_OPENIF, NULL, (void **)&ptid_shm );
+            release_object( dir );
+        }
+        if (!ptid_shm_mapping)
+        {
+            clear_error();
+            failed = 1;
+            return NULL;
+        }
+        memset( (void *)ptid_shm, 0, PTID_SHM_COUNT * sizeof(*ptid_shm) );
+    }
+    return &ptid_shm[index];
+}
+
+/* publish the information returned by get_process_info */
+void update_process_shared_info( struct process *process )
+{
+    ptid_shm_t *ptr;
+
+    if (!process->id || !(ptr = get_ptid_shared_memory( process->id ))) return;
+
+    SHARED_WRITE_BEGIN( ptr )
+    {
+        shared->id            = process->id;
+        shared->start_time    = process->start_time;
+        shared->end_time      = process->end_time;
+        shared->base          = process->peb;
+        shared->affinity      = process->affinity;
+        shared->pid           = process->parent_id;
+        shared->exit_code     = process->exit_code;
+        shared->priority      = process->priority;
+        shared->flags         = 0;
+        shared->suspend_count = 0;
+        shared->unix_pid      = process->unix_pid;
+        shared->unix_tid      = -1;
+        shared->session_id    = process->session_id;
+        shared->machine       = process->machine;
+    }
+    SHARED_WRITE_END;
+}
+
+/* publish the information returned by get_thread_info and get_thread_times */
+void update_thread_shared_info( struct thread *thread )
+{
+    ptid_shm_t *ptr;
+
+    if (!thread->id || !(ptr = get_ptid_shared_memory( thread->id ))) return;
+
+    SHARED_WRITE_BEGIN( ptr )
+    {
+        shared->id            = thread->id;
+        shared->start_time    = thread->creation_time;
+        shared->end_time      = thread->exit_time;
+        shared->base          = thread->teb;
+        shared->affinity      = thread->affinity;
+        shared->pid           = thread->process->id;
+        shared->exit_code     = (thread->state == TERMINATED) ? thread->exit_code : STATUS_PENDING;
+        shared->priority      = thread->priority;
+        shared->flags         = 0;
+        if (thread->dbg_hidden) shared->flags |= GET_THREAD_INFO_FLAG_DBG_HIDDEN;
+        if (thread->state == TERMINATED) shared->flags |= GET_THREAD_INFO_FLAG_TERMINATED;
+        shared->suspend_count = thread->suspend;
+        shared->unix_pid      = thread->unix_pid;
+        shared->unix_tid      = thread->unix_tid;
+        shared->session_id    = 0;
+        shared->machine       = 0;
+    }
+    SHARED_WRITE_END;
+}
+
 /* allocate a new process or thread id */
 unsigned int alloc_ptid( void *ptr )
 {
@@ -528,6 +638,16 @@ void free_ptid( unsigned int id )
 {
     unsigned int index = index_from_ptid( id );
     struct ptid_entry *entry = &ptid_entries[index - PTID_OFFSET];
+    ptid_shm_t *ptr;
+
+    if ((ptr = get_ptid_shared_memory( id )))
+    {
+        SHARED_WRITE_BEGIN( ptr )
+        {
+            shared->id = 0;
+        }
+        SHARED_WRITE_END;
+    }
 
     entry->ptr  = NULL;
     entry->next = 0;
@@ -760,6 +880,7 @@ struct process *create_process( int fd, struct process *parent, unsigned int fla
         process->esync_fd = esync_create_fd( 0, 0 );
 
     set_fd_events( process->msg_fd, POLLIN );  /* start listening to events */
+    update_process_shared_info( process );
     return process;
 
  error:
@@ -1020,6 +1141,7 @@ static void process_killed( struct process *process )
     finish_process_tracing( process );
     release_job_process( process );
     start_sigkill_timer( process );
+    update_process_shared_info( process );
     wake_up( &process->obj, 0 );
 }
 
@@ -1338,6 +1460,7 @@ DECL_HANDLER(new_process)
 
     process->machine = req->machine;
     process->startup_info = (struct startup_info *)grab_object( info );
+    update_process_shared_info( process );
 
     job = parent->job;
     while (job)
@@ -1495,6 +1618,8 @@ DECL_HANDLER(init_process_done)
 
     process->start_time = current_time;
     current->entry_point = base + image_info->entry_point;
+    update_process_shared_info( process );
+    update_thread_shared_info( current );
 
     init_process_tracing( process );
     generate_startup_debug_events( process );
@@ -1687,6 +1812,7 @@ static void set_process_affinity( struct process *process, affinity_t affinity )
     }
 
     process->affinity = affinity;
+    update_process_shared_info( process );
 
     LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
     {
@@ -1701,7 +1827,11 @@ DECL_HANDLER(set_process_info)
 
     if ((process = get_process_from_handle( req->handle, PROCESS_SET_INFORMATION )))
     {
-        if (req->mask & SET_PROCESS_INFO_PRIORITY) process->priority = req->priority;
+        if (req->mask & SET_PROCESS_INFO_PRIORITY)
+        {
+            process->priority = req->priority;
+            update_process_shared_info( process );
+        }
         if (req->mask & SET_PROCESS_INFO_AFFINITY) set_process_affinity( process, req->affinity );
         release_object( process );
     }
@@ -96,6 +96,8 @@ struct process
 extern unsigned int alloc_ptid( void *ptr );
 extern void free_ptid( unsigned int id );
 extern void *get_ptid_entry( unsigned int id );
+extern void update_process_shared_info( struct process *process );
+extern void update_thread_shared_info( struct thread *thread );
 extern struct process *create_process( int fd, struct process *parent, unsigned int flags, const startup_info_t *info,
                                        const struct security_descriptor *sd, const obj_handle_t *handles,
                                        unsigned int handle_count, struct token *token );
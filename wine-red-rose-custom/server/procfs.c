@@ -61,6 +61,7 @@ static int open_proc_as( struct process *process, int flags )
         if (errno == ENOENT)  /* probably got killed */
         {
             process->unix_pid = -1;
+            update_process_shared_info( process );
             set_error( STATUS_ACCESS_DENIED );
         }
         else file_set_error();
@@ -79,7 +80,10 @@ static int open_proc_lwpctl( struct thread *thread )
     if ((fd = open( buffer, O_WRONLY )) == -1)
     {
         if (errno == ENOENT)  /* probably got killed */
+        {
             thread->unix_pid = thread->unix_tid = -1;
+            update_thread_shared_info( thread );
+        }
         else
             file_set_error();
     }
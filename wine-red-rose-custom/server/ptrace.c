@@ -120,6 +120,7 @@ static int handle_child_status( struct thread *thread, int pid, int status, int
     {
         thread->unix_pid = -1;
         thread->unix_tid = -1;
+        update_thread_shared_info( thread );
         if (debug_level)
         {
             if (WIFSIGNALED(status))
@@ -186,6 +187,7 @@ static int waitpid_thread( struct thread *thread, int signal )
             {
                 thread->unix_pid = -1;
                 thread->unix_tid = -1;
+                update_thread_shared_info( thread );
             }
             else perror( "waitpid" );
             stop_watchdog();
@@ -248,6 +250,7 @@ int send_thread_signal( struct thread *thread, int sig )
         {
             thread->unix_pid = -1;
             thread->unix_tid = -1;
+            update_thread_shared_info( thread );
         }
     }
     if (debug_level && ret != -1)
@@ -261,7 +264,11 @@ static void resume_after_ptrace( struct thread *thread )
     if (thread->unix_pid == -1) return;
     if (ptrace( PTRACE_DETACH, get_ptrace_pid(thread), (caddr_t)1, 0 ) == -1)
     {
-        if (errno == ESRCH) thread->unix_pid = thread->unix_tid = -1;  /* thread got killed */
+        if (errno == ESRCH)  /* thread got killed */
+        {
+            thread->unix_pid = thread->unix_tid = -1;
+            update_thread_shared_info( thread );
+        }
     }
 }
 
@@ -275,7 +282,11 @@ static int suspend_for_ptrace( struct thread *thread )
     /* this may fail if the client is already being debugged */
     if (ptrace( PTRACE_ATTACH, get_ptrace_pid(thread), 0, 0 ) == -1)
     {
-        if (errno == ESRCH) thread->unix_pid = thread->unix_tid = -1;  /* thread got killed */
+        if (errno == ESRCH)  /* thread got killed */
+        {
+            thread->unix_pid = thread->unix_tid = -1;
+            update_thread_shared_info( thread );
+        }
         goto error;
     }
     if (waitpid_thread( thread, SIGSTOP )) return 1;
@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #ifdef HAVE_PWD_H
 #include <pwd.h>
 #endif
@@ -119,9 +120,58 @@ static const struct fd_ops master_socket_fd_ops =
     NULL                           /* reselect_async */
 };
 
+/* pipe used by the request workers to wake up the main loop */
+struct worker_wakeup
+{
+    struct object        obj;        /* object header */
+    struct fd           *fd;         /* file descriptor for the pipe read side */
+    int                  pipe_write; /* unix fd for the pipe write side */
+};
 
-struct thread *current = NULL;  /* thread handling the current request */
-unsigned int global_error = 0;  /* global error code for when no thread is current */
+static void worker_wakeup_dump( struct object *obj, int verbose );
+static void worker_wakeup_destroy( struct object *obj );
+static void worker_wakeup_poll_event( struct fd *fd, int event );
+
+static const struct object_ops worker_wakeup_ops =
+{
+    sizeof(struct worker_wakeup),  /* size */
+    &no_type,                      /* type */
+    worker_wakeup_dump,            /* dump */
+    no_add_queue,                  /* add_queue */
+    NULL,                          /* remove_queue */
+    NULL,                          /* signaled */
+    NULL,                          /* get_esync_fd */
+    NULL,                          /* get_fsync_idx */
+    NULL,                          /* satisfied */
+    no_signal,                     /* signal */
+    no_get_fd,                     /* get_fd */
+    default_map_access,            /* map_access */
+    default_get_sd,                /* get_sd */
+    default_set_sd,                /* set_sd */
+    no_get_full_name,              /* get_full_name */
+    no_lookup_name,                /* lookup_name */
+    no_link_name,                  /* link_name */
+    NULL,                          /* unlink_name */
+    no_open_file,                  /* open_file */
+    no_kernel_obj_list,            /* get_kernel_obj_list */
+    no_close_handle,               /* close_handle */
+    worker_wakeup_destroy          /* destroy */
+};
+
+static const struct fd_ops worker_wakeup_fd_ops =
+{
+    NULL,                          /* get_poll_events */
+    worker_wakeup_poll_event,      /* poll_event */
+    NULL,                          /* flush */
+    NULL,                          /* get_fd_type */
+    NULL,                          /* ioctl */
+    NULL,                          /* queue_async */
+    NULL                           /* reselect_async */
+};
+
+
+__thread struct thread *current = NULL;  /* thread handling the current request */
+__thread unsigned int global_error = 0;  /* global error code for when no thread is current */
 timeout_t server_start_time = 0;  /* server startup time */
 char *server_dir = NULL;   /* server directory */
 int server_dir_fd = -1;    /* file descriptor for the server dir */
@@ -248,46 +298,264 @@ void write_reply( struct thread *thread )
         fatal_protocol_error( thread, "reply write: %s\n", strerror( errno ));
 }
 
+/* write a reply to a thread, returning the write() result */
+static int write_reply_data( struct thread *thread, union generic_reply *reply )
+{
+    struct iovec vec[2];
+
+    if (!thread->reply_size) return write( get_unix_fd( thread->reply_fd ), reply, sizeof(*reply) );
+
+    vec[0].iov_base = (void *)reply;
+    vec[0].iov_len  = sizeof(*reply);
+    vec[1].iov_base = thread->reply_data;
+    vec[1].iov_len  = thread->reply_size;
+    return writev( get_unix_fd( thread->reply_fd ), vec, 2 );
+}
+
+/* handle the result of writing a reply to a thread */
+static void finish_reply( struct thread *thread, int ret, int err )
+{
+    if (ret >= (int)sizeof(union generic_reply))
+    {
+        if ((thread->reply_towrite = thread->reply_size - (ret - sizeof(union generic_reply))))
+        {
+            /* couldn't write it all, wait for POLLOUT */
+            set_fd_events( thread->reply_fd, POLLOUT );
+            set_fd_events( thread->request_fd, 0 );
+            return;
+        }
+        free( thread->reply_data );
+        thread->reply_data = NULL;
+        return;
+    }
+
+    if (ret >= 0)
+        fatal_protocol_error( thread, "partial write %d\n", ret );
+    else if (err == EPIPE)
+        kill_thread( thread, 0 );  /* normal death */
+    else
+        fatal_protocol_error( thread, "reply write: %s\n", strerror( err ));
+}
+
 /* send a reply to the current thread */
 static void send_reply( union generic_reply *reply )
 {
+    int ret = write_reply_data( current, reply );
+    finish_reply( current, ret, errno );
+}
+
+/* request workers
+ *
+ * Requests whose handlers only look at the server state can be handled on worker
+ * threads, in parallel with each other. The main loop owns the server state while
+ * it processes events; it lets the workers run only while it is waiting for new
+ * events, and waits for all queued requests to be handled before it touches the
+ * state again. So the workers behave as readers and the main loop as the writer
+ * of a reader-writer lock.
+ */
+
+static unsigned int request_worker_count;  /* number of worker threads, 0 if disabled */
+static __thread int is_request_worker;     /* set on the worker threads */
+static int request_workers_allowed;        /* the main loop is waiting, the server state is read-only */
+static unsigned int request_workers_busy;  /* number of requests being handled by workers */
+static struct list request_worker_queue = LIST_INIT( request_worker_queue );  /* threads with a queued request */
+static struct list request_worker_done = LIST_INIT( request_worker_done );    /* threads with a handled request */
+static pthread_mutex_t request_worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t request_worker_cond = PTHREAD_COND_INITIALIZER;  /* requests can be handled */
+static pthread_cond_t request_idle_cond = PTHREAD_COND_INITIALIZER;    /* all requests have been handled */
+static struct worker_wakeup *worker_wakeup;
+
+/* check if a request only reads the server state; handlers must not modify any object
+ * except for grabbing and releasing references, and must not use request data */
+static int is_read_only_request( enum request req )
+{
+    switch (req)
+    {
+    case REQ_get_handle_fd:
+    case REQ_get_handle_unix_name:
+    case REQ_get_object_info:
+    case REQ_get_thread_times:
+    case REQ_get_window_info:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* queue a request to be handled by a worker once the main loop is waiting */
+static int queue_worker_request( struct thread *thread )
+{
+    enum request req = thread->req.request_header.req;
+
+    if (!request_worker_count || debug_level) return 0;
+    if (thread->req.request_header.request_size || !is_read_only_request( req )) return 0;
+
+    grab_object( thread );
+    pthread_mutex_lock( &request_worker_mutex );
+    list_add_tail( &request_worker_queue, &thread->worker_entry );
+    pthread_mutex_unlock( &request_worker_mutex );
+    return 1;
+}
+
+/* handle a request on a worker thread; anything that needs the main loop is left for finish_reply */
+static void handle_worker_request( struct thread *thread )
+{
+    union generic_reply reply;
+    enum request req = thread->req.request_header.req;
     int ret;
 
-    if (!current->reply_size)
+    thread->worker_ret = 0;
+    if (thread->state == TERMINATED || !thread->reply_fd) return;
+
+    current = thread;
+    current->reply_size = 0;
+    clear_error();
+    memset( &reply, 0, sizeof(reply) );
+
+    req_handlers[req]( &current->req, &reply );
+
+    reply.reply_header.error = current->error;
+    reply.reply_header.reply_size = current->reply_size;
+    ret = write_reply_data( current, &reply );
+    if (ret == sizeof(reply) + current->reply_size)
     {
-        if ((ret = write( get_unix_fd( current->reply_fd ),
-                          reply, sizeof(*reply) )) != sizeof(*reply)) goto error;
+        free( current->reply_data );
+        current->reply_data = NULL;
     }
     else
     {
-        struct iovec vec[2];
+        thread->worker_ret = ret;
+        thread->worker_errno = errno;
+    }
+    current = NULL;
+}
 
-        vec[0].iov_base = (void *)reply;
-        vec[0].iov_len  = sizeof(*reply);
-        vec[1].iov_base = current->reply_data;
-        vec[1].iov_len  = current->reply_size;
+static void *request_worker( void *arg )
+{
+    struct thread *thread;
+    char dummy = 0;
 
-        if ((ret = writev( get_unix_fd( current->reply_fd ), vec, 2 )) < sizeof(*reply)) goto error;
+    is_request_worker = 1;
+    pthread_mutex_lock( &request_worker_mutex );
+    for (;;)
+    {
+        while (!request_workers_allowed || list_empty( &request_worker_queue ))
+            pthread_cond_wait( &request_worker_cond, &request_worker_mutex );
+
+        thread = LIST_ENTRY( list_head( &request_worker_queue ), struct thread, worker_entry );
+        list_remove( &thread->worker_entry );
+        request_workers_busy++;
+        pthread_mutex_unlock( &request_worker_mutex );
+
+        handle_worker_request( thread );
+        /* wake up the main loop to finish the reply */
+        if (thread->worker_ret) write( worker_wakeup->pipe_write, &dummy, 1 );
+
+        pthread_mutex_lock( &request_worker_mutex );
+        list_add_tail( &request_worker_done, &thread->worker_entry );
+        if (!--request_workers_busy && list_empty( &request_worker_queue ))
+            pthread_cond_signal( &request_idle_cond );
+    }
+    return NULL;
+}
 
-        if ((current->reply_towrite = current->reply_size - (ret - sizeof(*reply))))
-        {
-            /* couldn't write it all, wait for POLLOUT */
-            set_fd_events( current->reply_fd, POLLOUT );
-            set_fd_events( current->request_fd, 0 );
-            return;
-        }
+/* start the request worker threads if enabled */
+void init_request_workers(void)
+{
+    const char *env = getenv( "WINESERVERWORKERS" );
+    unsigned int i, count = env ? atoi( env ) : 0;
+    sigset_t sigset, old_sigset;
+    pthread_t thread;
+    int fd[2];
+
+    if (!count) return;
+    if (pipe( fd ) == -1) return;
+    fcntl( fd[0], F_SETFL, O_NONBLOCK );
+    fcntl( fd[1], F_SETFL, O_NONBLOCK );
+    if (!(worker_wakeup = alloc_object( &worker_wakeup_ops )))
+    {
+        close( fd[0] );
+        close( fd[1] );
+        return;
     }
-    free( current->reply_data );
-    current->reply_data = NULL;
-    return;
+    worker_wakeup->pipe_write = fd[1];
+    if (!(worker_wakeup->fd = create_anonymous_fd( &worker_wakeup_fd_ops, fd[0], &worker_wakeup->obj, 0 )))
+    {
+        release_object( worker_wakeup );
+        worker_wakeup = NULL;
+        return;
+    }
+    set_fd_events( worker_wakeup->fd, POLLIN );
+    make_object_permanent( &worker_wakeup->obj );
 
- error:
-    if (ret >= 0)
-        fatal_protocol_error( current, "partial write %d\n", ret );
-    else if (errno == EPIPE)
-        kill_thread( current, 0 );  /* normal death */
-    else
-        fatal_protocol_error( current, "reply write: %s\n", strerror( errno ));
+    /* signals are handled by the main loop */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_BLOCK, &sigset, &old_sigset );
+    for (i = 0; i < count; i++)
+    {
+        if (pthread_create( &thread, NULL, request_worker, NULL )) break;
+        pthread_detach( thread );
+    }
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+    request_worker_count = i;
+    if (debug_level) fprintf( stderr, "wineserver: using %u request workers\n", request_worker_count );
+}
+
+/* let the workers handle the queued requests while the main loop waits for events */
+void allow_request_workers(void)
+{
+    if (!request_worker_count) return;
+
+    pthread_mutex_lock( &request_worker_mutex );
+    request_workers_allowed = 1;
+    if (!list_empty( &request_worker_queue )) pthread_cond_broadcast( &request_worker_cond );
+    pthread_mutex_unlock( &request_worker_mutex );
+}
+
+/* wait for the workers to handle all the queued requests before modifying the server state */
+void wait_for_request_workers(void)
+{
+    struct list done = LIST_INIT( done );
+    struct thread *thread;
+
+    if (!request_worker_count) return;
+
+    pthread_mutex_lock( &request_worker_mutex );
+    while (request_workers_busy || !list_empty( &request_worker_queue ))
+        pthread_cond_wait( &request_idle_cond, &request_worker_mutex );
+    request_workers_allowed = 0;
+    list_move_tail( &done, &request_worker_done );
+    pthread_mutex_unlock( &request_worker_mutex );
+
+    while (!list_empty( &done ))
+    {
+        thread = LIST_ENTRY( list_head( &done ), struct thread, worker_entry );
+        list_remove( &thread->worker_entry );
+        if (thread->worker_ret && thread->state != TERMINATED)
+            finish_reply( thread, thread->worker_ret, thread->worker_errno );
+        release_object( thread );
+    }
+}
+
+static void worker_wakeup_dump( struct object *obj, int verbose )
+{
+    fprintf( stderr, "Request worker wakeup pipe\n" );
+}
+
+static void worker_wakeup_destroy( struct object *obj )
+{
+    struct worker_wakeup *wakeup = (struct worker_wakeup *)obj;
+    assert( obj->ops == &worker_wakeup_ops );
+    release_object( wakeup->fd );
+    close( wakeup->pipe_write );
+}
+
+static void worker_wakeup_poll_event( struct fd *fd, int event )
+{
+    char buffer[64];
+
+    /* the replies have already been finished by wait_for_request_workers, just drain the pipe */
+    while (read( get_unix_fd( fd ), buffer, sizeof(buffer) ) > 0);
 }
 
 /* call a request handler */
@@ -296,6 +564,8 @@ static void call_req_handler( struct thread *thread )
     union generic_reply reply;
     enum request req = thread->req.request_header.req;
 
+    if (queue_worker_request( thread )) return;
+
     current = thread;
     current->reply_size = 0;
     clear_error();
@@ -501,6 +771,12 @@ int send_client_fd( struct process *process, int fd, obj_handle_t handle )
 
     if (ret == sizeof(handle)) return 0;
 
+    if (is_request_worker)
+    {
+        /* the main loop will kill the process when it notices the shut down socket */
+        shutdown( get_unix_fd( process->msg_fd ), SHUT_RDWR );
+        return -1;
+    }
     if (ret >= 0)
     {
         fprintf( stderr, "Protocol error: process %04x: partial sendmsg %d\n", process->id, ret );
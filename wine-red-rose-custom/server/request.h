@@ -52,6 +52,9 @@ extern const struct object_attributes *get_req_object_attributes( const struct s
 extern const void *get_req_data_after_objattr( const struct object_attributes *attr, data_size_t *len );
 extern int receive_fd( struct process *process );
 extern int send_client_fd( struct process *process, int fd, obj_handle_t handle );
+extern void init_request_workers(void);
+extern void allow_request_workers(void);
+extern void wait_for_request_workers(void);
 extern void read_request( struct thread *thread );
 extern void write_reply( struct thread *thread );
 extern timeout_t monotonic_counter(void);
@@ -175,6 +178,7 @@ DECL_HANDLER(lock_file);
 DECL_HANDLER(unlock_file);
 DECL_HANDLER(recv_socket);
 DECL_HANDLER(send_socket);
+DECL_HANDLER(socket_get_shm_slot);
 DECL_HANDLER(socket_get_events);
 DECL_HANDLER(socket_send_icmp_id);
 DECL_HANDLER(socket_get_icmp_id);
@@ -267,6 +271,7 @@ DECL_HANDLER(get_window_info);
 DECL_HANDLER(set_window_info);
 DECL_HANDLER(set_parent);
 DECL_HANDLER(get_window_parents);
+DECL_HANDLER(get_window_list);
 DECL_HANDLER(get_window_children);
 DECL_HANDLER(get_window_children_from_point);
 DECL_HANDLER(get_window_tree);
@@ -420,6 +425,7 @@ DECL_HANDLER(get_fsync_idx);
 DECL_HANDLER(fsync_msgwait);
 DECL_HANDLER(get_fsync_apc_idx);
 DECL_HANDLER(fsync_free_shm_idx);
+DECL_HANDLER(get_completion_ring);
 
 #ifdef WANT_REQUEST_HANDLERS
 
@@ -482,6 +488,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_unlock_file,
     (req_handler)req_recv_socket,
     (req_handler)req_send_socket,
+    (req_handler)req_socket_get_shm_slot,
     (req_handler)req_socket_get_events,
     (req_handler)req_socket_send_icmp_id,
     (req_handler)req_socket_get_icmp_id,
@@ -574,6 +581,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_window_info,
     (req_handler)req_set_parent,
     (req_handler)req_get_window_parents,
+    (req_handler)req_get_window_list,
     (req_handler)req_get_window_children,
     (req_handler)req_get_window_children_from_point,
     (req_handler)req_get_window_tree,
@@ -727,6 +735,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_fsync_msgwait,
     (req_handler)req_get_fsync_apc_idx,
     (req_handler)req_fsync_free_shm_idx,
+    (req_handler)req_get_completion_ring,
 };
 
 C_ASSERT( sizeof(abstime_t) == 8 );
@@ -1130,6 +1139,11 @@ C_ASSERT( FIELD_OFFSET(struct send_socket_reply, wait) == 8 );
 C_ASSERT( FIELD_OFFSET(struct send_socket_reply, options) == 12 );
 C_ASSERT( FIELD_OFFSET(struct send_socket_reply, nonblocking) == 16 );
 C_ASSERT( sizeof(struct send_socket_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct socket_get_shm_slot_request, handle) == 12 );
+C_ASSERT( sizeof(struct socket_get_shm_slot_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct socket_get_shm_slot_reply, shm_slot) == 8 );
+C_ASSERT( FIELD_OFFSET(struct socket_get_shm_slot_reply, shm_seq) == 12 );
+C_ASSERT( sizeof(struct socket_get_shm_slot_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct socket_get_events_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct socket_get_events_request, event) == 16 );
 C_ASSERT( sizeof(struct socket_get_events_request) == 24 );
@@ -1634,6 +1648,13 @@ C_ASSERT( FIELD_OFFSET(struct get_window_parents_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_window_parents_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_window_parents_reply, count) == 8 );
 C_ASSERT( sizeof(struct get_window_parents_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_window_list_request, desktop) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_window_list_request, handle) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_window_list_request, tid) == 20 );
+C_ASSERT( FIELD_OFFSET(struct get_window_list_request, children) == 24 );
+C_ASSERT( sizeof(struct get_window_list_request) == 32 );
+C_ASSERT( FIELD_OFFSET(struct get_window_list_reply, count) == 8 );
+C_ASSERT( sizeof(struct get_window_list_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_window_children_request, desktop) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_window_children_request, parent) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_window_children_request, atom) == 20 );
@@ -2280,6 +2301,7 @@ C_ASSERT( FIELD_OFFSET(struct add_completion_request, status) == 40 );
 C_ASSERT( sizeof(struct add_completion_request) == 48 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_request, alertable) == 16 );
+C_ASSERT( FIELD_OFFSET(struct remove_completion_request, ring) == 20 );
 C_ASSERT( sizeof(struct remove_completion_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, ckey) == 8 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
@@ -2466,6 +2488,10 @@ C_ASSERT( sizeof(struct get_fsync_apc_idx_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct fsync_free_shm_idx_request, shm_idx) == 12 );
 C_ASSERT( sizeof(struct fsync_free_shm_idx_request) == 16 );
 C_ASSERT( sizeof(struct fsync_free_shm_idx_reply) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_completion_ring_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_completion_ring_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_completion_ring_reply, ring_idx) == 8 );
+C_ASSERT( sizeof(struct get_completion_ring_reply) == 16 );
 
 #endif  /* WANT_REQUEST_HANDLERS */
 
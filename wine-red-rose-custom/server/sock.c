@@ -279,6 +279,7 @@ struct sock
     icmp_fixup_data[MAX_ICMP_HISTORY_LENGTH]; /* Sent ICMP packets history used to fixup reply id. */
     struct bound_addr  *bound_addr[2]; /* Links to the entries in bound addresses tree. */
     unsigned int        icmp_fixup_data_len;  /* Sent ICMP packets history length. */
+    unsigned int        shm_slot;    /* slot in the socket shared mapping */
     unsigned int        rd_shutdown : 1; /* is the read end shut down? */
     unsigned int        wr_shutdown : 1; /* is the write end shut down? */
     unsigned int        wr_shutdown_pending : 1; /* is a write shutdown pending? */
@@ -296,6 +297,92 @@ static int is_tcp_socket( struct sock *sock )
     return sock->type == WS_SOCK_STREAM && (sock->family == WS_AF_INET || sock->family == WS_AF_INET6);
 }
 
+static struct object *socket_shm_mapping;                 /* mapping shared with all clients */
+static socket_shm_t *socket_shm;                          /* server view of the mapping */
+static unsigned int socket_shm_used;                      /* number of slots ever handed out */
+static unsigned int socket_shm_free[SOCKET_SHM_COUNT];    /* stack of released slots */
+static unsigned int socket_shm_free_count;
+
+static unsigned int alloc_socket_shm_slot(void)
+{
+    unsigned int slot;
+
+    if (!socket_shm_mapping)
+    {
+        static const WCHAR nameW[] = {'s','o','c','k','e','t','s'};
+        static const struct unicode_str name = {nameW, sizeof(nameW)};
+        struct object *dir = create_thread_map_directory();
+
+        if (!dir) return SOCKET_SHM_NO_SLOT;
+        socket_shm_mapping = create_shared_mapping( dir, &name, SOCKET_SHM_COUNT * sizeof(*socket_shm),
+                                                    OBJ_OPENIF, NULL, (void **)&socket_shm );
+        release_object( dir );
+        if (!socket_shm_mapping)
+        {
+            clear_error();
+            return SOCKET_SHM_NO_SLOT;
+        }
+        memset( (void *)socket_shm, 0, SOCKET_SHM_COUNT * sizeof(*socket_shm) );
+    }
+
+    if (socket_shm_free_count) slot = socket_shm_free[--socket_shm_free_count];
+    else if (socket_shm_used < SOCKET_SHM_COUNT) slot = socket_shm_used++;
+    else return SOCKET_SHM_NO_SLOT;
+
+    socket_shm[slot].flags = 0;
+    socket_shm[slot].seq++;
+    return slot;
+}
+
+static void free_socket_shm_slot( unsigned int slot )
+{
+    if (slot == SOCKET_SHM_NO_SLOT) return;
+    /* clear the flags before bumping the sequence, so that a client which
+     * still sees the old sequence number never sees stale flags */
+    socket_shm[slot].flags = 0;
+    __atomic_fetch_add( &socket_shm[slot].seq, 1, __ATOMIC_RELEASE );
+    socket_shm_free[socket_shm_free_count++] = slot;
+}
+
+/* publish whether the client may bypass the server for recv() and send()
+ * calls that complete immediately; this is only allowed when the server
+ * would neither queue the request nor update any socket state for it */
+static void sock_update_shared( struct sock *sock )
+{
+    unsigned int i, flags = 0;
+
+    if (sock->shm_slot == SOCKET_SHM_NO_SLOT) return;
+
+    if ((sock->type == WS_SOCK_STREAM || sock->type == WS_SOCK_DGRAM) && !sock->mask && !sock->window)
+    {
+        /* a poll only has side effects when it observes a state change or
+         * an error, or when asyncs are waiting for the same events */
+        if ((sock->state == SOCK_CONNECTED || sock->state == SOCK_CONNECTIONLESS) &&
+            !sock->reset && !sock->hangup && !sock->aborted &&
+            !async_queued( &sock->read_q ) && !async_queued( &sock->write_q ))
+        {
+            for (i = 0; i < AFD_POLL_BIT_COUNT; ++i) if (sock->errors[i]) break;
+            if (i == AFD_POLL_BIT_COUNT) flags |= SOCKET_SHM_POLL;
+        }
+        if (sock->state == SOCK_CONNECTED) flags |= SOCKET_SHM_CONNECTED;
+        if (sock->type == WS_SOCK_STREAM) flags |= SOCKET_SHM_STREAM;
+
+        if (!sock->rd_shutdown && !sock->reset && !sock->accept_recv_req &&
+            !async_queued( &sock->read_q ) &&
+            !((sock->pending_events | sock->reported_events) & (AFD_POLL_READ | AFD_POLL_OOB)))
+            flags |= SOCKET_SHM_RECV;
+
+        if (!sock->wr_shutdown && !sock->wr_shutdown_pending &&
+            (sock->bound || sock->type != WS_SOCK_DGRAM) &&
+            !async_queued( &sock->write_q ) &&
+            !((sock->pending_events | sock->reported_events) & AFD_POLL_WRITE))
+            flags |= SOCKET_SHM_SEND;
+    }
+
+    if (socket_shm[sock->shm_slot].flags != flags)
+        __atomic_store_n( &socket_shm[sock->shm_slot].flags, flags, __ATOMIC_RELEASE );
+}
+
 static int addr_compare( const void *key, const struct wine_rb_entry *entry )
 {
     const struct bound_addr *bound_addr = RB_ENTRY_VALUE(entry, struct bound_addr, entry);
@@ -788,6 +875,7 @@ static void sock_reselect( struct sock *sock )
         fprintf(stderr,"sock_reselect(%p): new mask %x\n", sock, ev);
 
     set_fd_events( sock->fd, ev );
+    sock_update_shared( sock );
 }
 
 static unsigned int afd_poll_flag_to_win32( unsigned int flags )
@@ -897,6 +985,7 @@ static void free_accept_req( void *private )
     if (req->acceptsock)
     {
         req->acceptsock->accept_recv_req = NULL;
+        sock_update_shared( req->acceptsock );
         release_object( req->acceptsock );
     }
     release_object( req->async );
@@ -1316,6 +1405,7 @@ static void post_socket_event( struct sock *sock, enum afd_poll_bit event_bit )
     {
         sock->pending_events |= event;
         sock->reported_events |= event;
+        sock_update_shared( sock );
 
         if ((sock->mask & event) && sock->event)
             set_event( sock->event );
@@ -1737,6 +1827,7 @@ static void sock_destroy( struct object *obj )
     free_async_queue( &sock->poll_q );
     if (sock->event) release_object( sock->event );
     if (sock->fd) release_object( sock->fd );
+    free_socket_shm_slot( sock->shm_slot );
 }
 
 static struct sock *create_socket(void)
@@ -1782,6 +1873,7 @@ static struct sock *create_socket(void)
     sock->sndtimeo = 0;
     sock->icmp_fixup_data_len = 0;
     sock->bound_addr[0] = sock->bound_addr[1] = NULL;
+    sock->shm_slot = alloc_socket_shm_slot();
     init_async_queue( &sock->read_q );
     init_async_queue( &sock->write_q );
     init_async_queue( &sock->ifchange_q );
@@ -2163,6 +2255,7 @@ static int accept_into_socket( struct sock *sock, struct sock *acceptsock )
     fd_copy_completion( acceptsock->fd, newfd );
     release_object( acceptsock->fd );
     acceptsock->fd = newfd;
+    sock_update_shared( acceptsock );
 
     unix_len = sizeof(unix_addr);
     if (!getsockname( get_unix_fd( newfd ), &unix_addr.addr, &unix_len ))
@@ -2615,6 +2708,7 @@ static void sock_ioctl( struct fd *fd, ioctl_code_t code, struct async *async )
         }
         list_add_tail( &sock->accept_list, &req->entry );
         acceptsock->accept_recv_req = req;
+        sock_update_shared( acceptsock );
         release_object( acceptsock );
 
         acceptsock->wparam = params->accept_handle;
@@ -2848,6 +2942,7 @@ static void sock_ioctl( struct fd *fd, ioctl_code_t code, struct async *async )
                 sock->state = SOCK_CONNECTED;
                 sock->connect_time = current_time;
             }
+            sock_update_shared( sock );
 
             if (!send_len) return;
         }
@@ -3206,6 +3301,7 @@ static void sock_ioctl( struct fd *fd, ioctl_code_t code, struct async *async )
         }
 
         sock->bound = 1;
+        sock_update_shared( sock );
 
         unix_len = sizeof(bind_addr);
         if (!getsockname( unix_fd, &bind_addr.addr, &unix_len ))
@@ -4249,6 +4345,7 @@ DECL_HANDLER(send_socket)
             queue_async( &sock->write_q, async );
             sock_reselect( sock );
         }
+        else sock_update_shared( sock );
 
         reply->wait = async_handoff( async, NULL, 0 );
         reply->options = get_fd_options( fd );
@@ -4258,6 +4355,17 @@ DECL_HANDLER(send_socket)
     release_object( sock );
 }
 
+DECL_HANDLER(socket_get_shm_slot)
+{
+    struct sock *sock = (struct sock *)get_handle_obj( current->process, req->handle, 0, &sock_ops );
+
+    if (!sock) return;
+
+    reply->shm_slot = sock->shm_slot;
+    reply->shm_seq = sock->shm_slot != SOCKET_SHM_NO_SLOT ? socket_shm[sock->shm_slot].seq : 0;
+    release_object( sock );
+}
+
 DECL_HANDLER(socket_get_events)
 {
     struct sock *sock = (struct sock *)get_handle_obj( current->process, req->handle, 0, &sock_ops );
@@ -498,6 +498,8 @@ struct thread *create_thread( int fd, struct process *process, const struct secu
         thread->esync_apc_fd = esync_create_fd( 0, 0 );
     }
 
+    update_thread_shared_info( thread );
+
     set_fd_events( thread->request_fd, POLLIN );  /* start listening to events */
     add_process_thread( thread->process, thread );
     return thread;
@@ -746,7 +748,11 @@ int set_thread_affinity( struct thread *thread, affinity_t affinity )
         ret = sched_setaffinity( thread->unix_tid, sizeof(set), &set );
     }
 #endif
-    if (!ret) thread->affinity = affinity;
+    if (!ret)
+    {
+        thread->affinity = affinity;
+        update_thread_shared_info( thread );
+    }
     return ret;
 }
 
@@ -844,6 +850,7 @@ int set_thread_priority( struct thread *thread, int priority_class, int priority
         thread->priority == priority)
         return 0;
     thread->priority = priority;
+    update_thread_shared_info( thread );
 
     apply_thread_priority( thread, priority_class, priority );
     return 0;
@@ -872,7 +879,10 @@ static void set_thread_info( struct thread *thread,
     if (req->mask & SET_THREAD_INFO_ENTRYPOINT)
         thread->entry_point = req->entry_point;
     if (req->mask & SET_THREAD_INFO_DBG_HIDDEN)
+    {
         thread->dbg_hidden = 1;
+        update_thread_shared_info( thread );
+    }
     if (req->mask & SET_THREAD_INFO_DESCRIPTION)
     {
         WCHAR *desc;
@@ -912,7 +922,10 @@ int suspend_thread( struct thread *thread )
     int old_count = thread->suspend;
     if (thread->suspend < MAXIMUM_SUSPEND_COUNT)
     {
-        if (!(thread->process->suspend + thread->suspend++))
+        int count = thread->process->suspend + thread->suspend++;
+
+        update_thread_shared_info( thread );
+        if (!count)
         {
             stop_thread( thread );
             if (thread == current) return old_count | 0x80000000;
@@ -929,6 +942,7 @@ int resume_thread( struct thread *thread )
     if (thread->suspend > 0)
     {
         if (!(--thread->suspend)) resume_delayed_debug_events( thread );
+        update_thread_shared_info( thread );
         if (!(thread->suspend + thread->process->suspend)) wake_thread( thread );
     }
     return old_count;
@@ -1529,6 +1543,7 @@ void kill_thread( struct thread *thread, int violent_death )
     if (thread->state == TERMINATED) return;  /* already killed */
     thread->state = TERMINATED;
     thread->exit_time = current_time;
+    update_thread_shared_info( thread );
     if (current == thread) current = NULL;
     if (debug_level)
         fprintf( stderr,"%04x: *killed* exit_code=%d\n",
@@ -1618,6 +1633,7 @@ DECL_HANDLER(new_thread)
         thread->system_regs = current->system_regs;
         if (req->flags & THREAD_CREATE_FLAGS_CREATE_SUSPENDED) thread->suspend++;
         thread->dbg_hidden = !!(req->flags & THREAD_CREATE_FLAGS_HIDE_FROM_DEBUGGER);
+        update_thread_shared_info( thread );
         reply->tid = get_thread_id( thread );
         if ((reply->handle = alloc_handle_no_access_check( current->process, thread,
                                                            req->access, objattr->attributes )))
@@ -1679,6 +1695,8 @@ DECL_HANDLER(init_first_thread)
         set_thread_priority( current, current->process->priority, current->priority );
         set_thread_affinity( current, current->affinity );
     }
+    update_process_shared_info( process );
+    update_thread_shared_info( current );
 
     debug_level = max( debug_level, req->debug_level );
 
@@ -1711,6 +1729,7 @@ DECL_HANDLER(init_thread)
     generate_debug_event( current, DbgCreateThreadStateChange, &req->entry );
     apply_thread_priority( current, current->process->priority, current->priority );
     set_thread_affinity( current, current->affinity );
+    update_thread_shared_info( current );
 
     reply->suspend = (current->suspend || current->process->suspend || current->context != NULL);
 }
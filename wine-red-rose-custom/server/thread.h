@@ -100,9 +100,12 @@ struct thread
     struct object         *input_shared_mapping; /* thread input shared memory mapping */
     input_shm_t           *input_shared;  /* thread input shared memory ptr */
     struct completion_wait *completion_wait; /* completion port wait object the thread is associated with */
+    struct list            worker_entry;  /* entry in the request worker queues */
+    int                    worker_ret;    /* reply write result to complete after a request worker */
+    int                    worker_errno;  /* errno of the reply write */
 };
 
-extern struct thread *current;
+extern __thread struct thread *current;
 
 /* thread functions */
 
@@ -144,7 +147,7 @@ extern int send_thread_signal( struct thread *thread, int sig );
 extern void get_selector_entry( struct thread *thread, int entry, unsigned int *base,
                                 unsigned int *limit, unsigned char *flags );
 
-extern unsigned int global_error;  /* global error code for when no thread is current */
+extern __thread unsigned int global_error;  /* global error code for when no thread is current */
 
 static inline unsigned int get_error(void)       { return current ? current->error : global_error; }
 static inline void set_error( unsigned int err ) { global_error = err; if (current) current->error = err; }
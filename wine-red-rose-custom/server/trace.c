@@ -2246,6 +2246,17 @@ static void dump_send_socket_reply( const struct send_socket_reply *req )
     fprintf( stderr, ", nonblocking=%d", req->nonblocking );
 }
 
+static void dump_socket_get_shm_slot_request( const struct socket_get_shm_slot_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_socket_get_shm_slot_reply( const struct socket_get_shm_slot_reply *req )
+{
+    fprintf( stderr, " shm_slot=%08x", req->shm_slot );
+    fprintf( stderr, ", shm_seq=%08x", req->shm_seq );
+}
+
 static void dump_socket_get_events_request( const struct socket_get_events_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -3251,6 +3262,20 @@ static void dump_get_window_parents_reply( const struct get_window_parents_reply
     dump_varargs_user_handles( ", parents=", cur_size );
 }
 
+static void dump_get_window_list_request( const struct get_window_list_request *req )
+{
+    fprintf( stderr, " desktop=%04x", req->desktop );
+    fprintf( stderr, ", handle=%08x", req->handle );
+    fprintf( stderr, ", tid=%04x", req->tid );
+    fprintf( stderr, ", children=%d", req->children );
+}
+
+static void dump_get_window_list_reply( const struct get_window_list_reply *req )
+{
+    fprintf( stderr, " count=%d", req->count );
+    dump_varargs_user_handles( ", windows=", cur_size );
+}
+
 static void dump_get_window_children_request( const struct get_window_children_request *req )
 {
     fprintf( stderr, " desktop=%04x", req->desktop );
@@ -4585,6 +4610,7 @@ static void dump_remove_completion_request( const struct remove_completion_reque
 {
     fprintf( stderr, " handle=%04x", req->handle );
     fprintf( stderr, ", alertable=%d", req->alertable );
+    fprintf( stderr, ", ring=%d", req->ring );
 }
 
 static void dump_remove_completion_reply( const struct remove_completion_reply *req )
@@ -4953,6 +4979,16 @@ static void dump_fsync_free_shm_idx_request( const struct fsync_free_shm_idx_req
     fprintf( stderr, " shm_idx=%08x", req->shm_idx );
 }
 
+static void dump_get_completion_ring_request( const struct get_completion_ring_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_get_completion_ring_reply( const struct get_completion_ring_reply *req )
+{
+    fprintf( stderr, " ring_idx=%08x", req->ring_idx );
+}
+
 static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_new_process_request,
     (dump_func)dump_get_new_process_info_request,
@@ -5010,6 +5046,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_unlock_file_request,
     (dump_func)dump_recv_socket_request,
     (dump_func)dump_send_socket_request,
+    (dump_func)dump_socket_get_shm_slot_request,
     (dump_func)dump_socket_get_events_request,
     (dump_func)dump_socket_send_icmp_id_request,
     (dump_func)dump_socket_get_icmp_id_request,
@@ -5102,6 +5139,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_window_info_request,
     (dump_func)dump_set_parent_request,
     (dump_func)dump_get_window_parents_request,
+    (dump_func)dump_get_window_list_request,
     (dump_func)dump_get_window_children_request,
     (dump_func)dump_get_window_children_from_point_request,
     (dump_func)dump_get_window_tree_request,
@@ -5255,6 +5293,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_fsync_msgwait_request,
     (dump_func)dump_get_fsync_apc_idx_request,
     (dump_func)dump_fsync_free_shm_idx_request,
+    (dump_func)dump_get_completion_ring_request,
 };
 
 static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
@@ -5314,6 +5353,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_recv_socket_reply,
     (dump_func)dump_send_socket_reply,
+    (dump_func)dump_socket_get_shm_slot_reply,
     (dump_func)dump_socket_get_events_reply,
     NULL,
     (dump_func)dump_socket_get_icmp_id_reply,
@@ -5406,6 +5446,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_window_info_reply,
     (dump_func)dump_set_parent_reply,
     (dump_func)dump_get_window_parents_reply,
+    (dump_func)dump_get_window_list_reply,
     (dump_func)dump_get_window_children_reply,
     (dump_func)dump_get_window_children_from_point_reply,
     (dump_func)dump_get_window_tree_reply,
@@ -5559,6 +5600,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_get_fsync_apc_idx_reply,
     NULL,
+    (dump_func)dump_get_completion_ring_reply,
 };
 
 static const char * const req_names[REQ_NB_REQUESTS] = {
@@ -5618,6 +5660,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "unlock_file",
     "recv_socket",
     "send_socket",
+    "socket_get_shm_slot",
     "socket_get_events",
     "socket_send_icmp_id",
     "socket_get_icmp_id",
@@ -5710,6 +5753,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_window_info",
     "set_parent",
     "get_window_parents",
+    "get_window_list",
     "get_window_children",
     "get_window_children_from_point",
     "get_window_tree",
@@ -5863,6 +5907,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "fsync_msgwait",
     "get_fsync_apc_idx",
     "fsync_free_shm_idx",
+    "get_completion_ring",
 };
 
 static const struct